@@ -0,0 +1,81 @@
+#include "aria/aria.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures how long it takes to compile a batch of modules (like loading every script at startup)
+// with an increasing amount of worker threads
+//
+// Usage: AriaBench [module count] [functions per module] [max workers]
+
+static std::string GenerateModule(size_t index, size_t functionCount) {
+    std::string source = fmt::format("int g{} = {};\n", index, index);
+
+    for (size_t i = 0; i < functionCount; i++) {
+        source += fmt::format("int fn{}(int a, int b, int c) {{\n", i);
+        source += "    int x = a + b * c;\n";
+        source += "    {\n";
+        source += "        int y = x - a;\n";
+        source += "        x = y * 2 + c;\n";
+        source += "    }\n";
+        source += fmt::format("    return x + {};\n", i);
+        source += "}\n";
+    }
+
+    return source;
+}
+
+static double CompileBatch(const std::vector<Aria::ModuleSource>& modules, size_t workerCount) {
+    Aria::Context ctx;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Aria::ModuleCompileResult> results = ctx.CompileModules(modules, workerCount);
+    auto end = std::chrono::steady_clock::now();
+
+    for (const Aria::ModuleCompileResult& r : results) {
+        if (!r.Success) {
+            fmt::print(stderr, "Module {} failed to compile!\n", r.Module);
+        }
+    }
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t moduleCount = argc > 1 ? std::stoul(argv[1]) : 200;
+    size_t functionCount = argc > 2 ? std::stoul(argv[2]) : 50;
+
+    std::vector<Aria::ModuleSource> modules;
+    modules.reserve(moduleCount);
+
+    for (size_t i = 0; i < moduleCount; i++) {
+        modules.push_back({ fmt::format("module{}", i), {}, GenerateModule(i, functionCount) });
+    }
+
+    size_t maxWorkers = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+    if (maxWorkers == 0) { maxWorkers = 1; }
+
+    fmt::print("Compiling {} modules with {} functions each\n", moduleCount, functionCount);
+
+    // Warm up the system allocator and page cache before measuring
+    CompileBatch(modules, maxWorkers);
+
+    double baseline = 0.0;
+    for (size_t workers = 1; workers <= maxWorkers; workers *= 2) {
+        double best = 0.0;
+
+        for (size_t run = 0; run < 5; run++) {
+            double time = CompileBatch(modules, workers);
+            if (run == 0 || time < best) { best = time; }
+        }
+
+        if (workers == 1) { baseline = best; }
+        fmt::print("{:>3} workers: {:>9.2f} ms ({:.2f}x)\n", workers, best, baseline / best);
+
+        if (workers < maxWorkers && workers * 2 > maxWorkers) {
+            workers = maxWorkers / 2; // Make sure the last run uses every hardware thread
+        }
+    }
+}
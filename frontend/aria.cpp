@@ -2,7 +2,12 @@
 
 void PrintHelp(const char* appName) {
     fmt::println("Help:");
-    fmt::println("  {} <file>", appName);
+    fmt::println("  {} <file>                       Compiles and runs the file", appName);
+    fmt::println("  {} <file> --emit-image <output> Compiles the file into a bytecode image", appName);
+    fmt::println("  {} <file> --emit-c <output.c>   Translates the file into C, build it with cc -O2 -shared -fPIC <output.c> -o <output.so> -lm", appName);
+    fmt::println("  {} --emit-c <file>              Same as above, writing <file>.c", appName);
+    fmt::println("  {} <file.ariac>                 Runs a bytecode image", appName);
+    fmt::println("  {} <file.so>                    Runs a native module built from --emit-c", appName);
 }
 
 void AriaFN(Aria::Context* ctx) {
@@ -20,12 +25,39 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    if (argc == 3 && strcmp(argv[1], "--emit-c") == 0) {
+        Aria::Context ctx;
+        ctx.CompileFile(argv[2], argv[2]);
+        return ctx.EmitC(argv[2], std::string(argv[2]) + ".c") ? 0 : 1;
+    }
+
     std::string fileName = argv[1];
     Aria::Context ctx;
-    ctx.CompileFile(fileName, fileName);
+
+    if (fileName.ends_with(".ariac")) {
+        if (!ctx.LoadImage(fileName, fileName)) {
+            return 1;
+        }
+    } else if (fileName.ends_with(".so")) {
+        if (!ctx.LoadNative(fileName, fileName)) {
+            return 1;
+        }
+    } else {
+        ctx.CompileFile(fileName, fileName);
+
+        if (argc == 4 && strcmp(argv[2], "--emit-image") == 0) {
+            return ctx.SaveImage(fileName, argv[3]) ? 0 : 1;
+        }
+
+        if (argc == 4 && strcmp(argv[2], "--emit-c") == 0) {
+            return ctx.EmitC(fileName, argv[3]) ? 0 : 1;
+        }
+    }
+
     ctx.AddExternalFunction("add()", AriaFN, fileName);
     fmt::print("{}", ctx.DumpAST(fileName));
     fmt::print("{}", ctx.Disassemble(fileName));
+    fmt::print("{}", ctx.DumpCompilerMemoryStats(fileName));
     ctx.Run(fileName);
     ctx.FreeModule(fileName);
 }
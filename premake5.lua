@@ -1,3 +1,13 @@
+newoption {
+    trigger = "disable-jit",
+    description = "Build without the x86-64 JIT, every script function runs in the interpreter"
+}
+
+newoption {
+    trigger = "disable-feedback",
+    description = "Build without the invocation, branch and call site counters of the VM"
+}
+
 workspace "Aria"
     configurations { "Debug", "Release" }
 
@@ -13,6 +23,12 @@ workspace "Aria"
 
         includedirs { "src/", "src/vendor/fmt/include/" }
 
+        filter "options:disable-jit"
+            defines { "ARIA_DISABLE_JIT" }
+
+        filter "options:disable-feedback"
+            defines { "ARIA_DISABLE_FEEDBACK" }
+
         filter "configurations:Debug"
             symbols "On"
 
@@ -33,6 +49,9 @@ workspace "Aria"
 
         links { "AriaLib", "fmt" }
 
+        filter "system:linux"
+            links { "dl" } -- Native modules get loaded with dlopen()
+
         filter "configurations:Debug"
             symbols "On"
 
@@ -53,6 +72,32 @@ workspace "Aria"
 
         links { "AriaLib", "fmt" }
 
+        filter "system:linux"
+            links { "dl" } -- Native modules get loaded with dlopen()
+
+        filter "configurations:Debug"
+            symbols "On"
+
+        filter "configurations:Release"
+            optimize "On"
+
+    project "AriaBench"
+        language "C++"
+        cppdialect "C++20"
+        kind "ConsoleApp"
+
+        targetdir("build/bin/%{cfg.buildcfg}/")
+        objdir("build/obj/%{cfg.buildcfg}/")
+
+        files { "benchmarks/**.cpp", "benchmarks/**.hpp" }
+
+        includedirs { "src/", "src/vendor/fmt/include/" }
+
+        links { "AriaLib", "fmt" }
+
+        filter "system:linux"
+            links { "dl" } -- Native modules get loaded with dlopen()
+
         filter "configurations:Debug"
             symbols "On"
 
@@ -1,89 +1,518 @@
 #include "aria/context.hpp"
 #include "aria/internal/compiler/compilation_context.hpp"
 #include "aria/internal/compiler/codegen/disassembler.hpp"
+#include "aria/internal/compiler/codegen/c_emitter.hpp"
+#include "aria/internal/compiler/ir/ir_dumper.hpp"
 #include "aria/internal/compiler/ast/ast_dumper.hpp"
 #include "aria/internal/compiler/reflection/compiler_reflection.hpp"
-#include "aria/internal/stdlib/array.hpp"
-#include "aria/internal/stdlib/string.hpp"
 #include "aria/internal/vm/vm.hpp"
-
+#include "aria/internal/vm/bytecode_image.hpp"
+#include "aria/internal/vm/module_diff.hpp"
+#include "aria/internal/vm/native_module.hpp"
+#include "aria/internal/parallel_for.hpp"
+#include "aria/internal/mapped_file.hpp"
+#include "aria/internal/compile_cache.hpp"
+
+#include <algorithm>
 #include <fstream>
-#include <sstream>
+#include <memory>
 
 namespace Aria {
 
     struct CompiledSource {
-        CompiledSource(Context* ctx, const std::string& sourceCode)
-            : VM(ctx), CompilationContext(sourceCode) {}
+        CompiledSource(Context* ctx, std::string sourceCode)
+            : VM(ctx), CompilationContext(std::move(sourceCode)) {}
 
         Internal::CompilationContext CompilationContext;
         std::string Module;
 
+        std::unique_ptr<Internal::MappedFile> Image; // Only set for modules loaded from a bytecode image
+        std::unique_ptr<Internal::NativeLibrary> Native; // Only set for modules loaded with Context::LoadNative()
+
+        // Staged by Context::ReloadModule() until the next Run()
+        std::unique_ptr<CompiledSource> PendingReload;
+        std::vector<std::string> PendingKeptGlobals;
+        std::vector<std::string> PendingRemovedGlobals;
+
         Internal::VM VM;
     };
 
-    Context::Context() {}
+    Context::Context()
+        : m_ModuleMutex(std::make_unique<std::mutex>()) {}
 
     Context Context::Create() {
         Context ctx{};
         return ctx;
     }
 
-    void Context::CompileFile(const std::string& path, const std::string& module) {
-        std::ifstream file(path);
+    static bool ReadFile(const std::string& path, std::string& contents) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
         if (!file.is_open()) {
+            return false;
+        }
+
+        contents.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+
+        return true;
+    }
+
+    void Context::CompileFile(const std::string& path, const std::string& module) {
+        std::string contents;
+        if (!ReadFile(path, contents)) {
             fmt::print(stderr, "Failed to open file: {}!\n", path);
             return;
         }
 
-        std::stringstream ss;
-        ss << file.rdbuf();
-        std::string contents = ss.str();
-        ss.flush();
+        CompiledSource* src = CompileSourceCached(std::move(contents));
+        src->Module = module;
 
-        CompileString(contents, module);
+        AddModule(module, src);
     }
 
     void Context::CompileString(const std::string& source, const std::string& module) {
-        bool valid = true;
+        CompiledSource* src = CompileSource(source);
+        src->Module = module;
+
+        AddModule(module, src);
+    }
+
+    std::vector<ModuleCompileResult> Context::CompileModules(const std::vector<ModuleSource>& modules, size_t workerCount) {
+        std::vector<ModuleCompileResult> results(modules.size());
+        std::vector<CompiledSource*> sources(modules.size(), nullptr);
+
+        Internal::ParallelFor(modules.size(), workerCount, [&](size_t i) {
+            const ModuleSource& m = modules[i];
+            ModuleCompileResult& result = results[i];
+            result.Module = m.Module;
+
+            std::string contents;
+            if (!m.Path.empty() && !ReadFile(m.Path, contents)) {
+                result.Errors.push_back({ 0, 0, fmt::format("Failed to open file: {}!", m.Path) });
+                return;
+            }
+
+            CompiledSource* src = m.Path.empty() ? CompileSource(m.Source) : CompileSourceCached(std::move(contents));
+            src->Module = m.Module;
+
+            for (const Internal::CompilerError& e : src->CompilationContext.GetCompilerErrors()) {
+                result.Errors.push_back({ e.Line, e.Column, e.Error });
+            }
+
+            result.Success = result.Errors.empty();
+            sources[i] = src;
+        });
+
+        bool success = true;
+
+        for (size_t i = 0; i < modules.size(); i++) {
+            ModuleCompileResult& result = results[i];
+
+            bool loaded = false;
+            {
+                std::lock_guard<std::mutex> lock(*m_ModuleMutex);
+                loaded = m_Modules.contains(result.Module);
+            }
+
+            if (loaded) {
+                result.Success = false;
+                result.Errors.push_back({ 0, 0, fmt::format("Module \"{}\" is already loaded!", result.Module) });
+            }
+
+            for (size_t j = 0; j < i; j++) {
+                if (modules[j].Module == result.Module) {
+                    result.Success = false;
+                    result.Errors.push_back({ 0, 0, fmt::format("Module \"{}\" appears more than once!", result.Module) });
+                    break;
+                }
+            }
+
+            for (const ModuleError& e : result.Errors) {
+                if (m_CompilerErrorHandler) {
+                    m_CompilerErrorHandler(e.Line, e.Column, e.Line, e.Column, e.Line, e.Column, modules[i].Path, e.Error);
+                } else {
+                    fmt::print(stderr, "{}:{}:{}: {}\n", result.Module, e.Line, e.Column, e.Error);
+                }
+            }
+
+            success = success && result.Success;
+        }
 
-        CompiledSource* src = new CompiledSource(this, source);
-        m_CurrentCompiledSource = src;
+        // Either every module becomes visible at once or none of them do
+        std::lock_guard<std::mutex> lock(*m_ModuleMutex);
+        for (size_t i = 0; i < modules.size(); i++) {
+            if (success) {
+                m_Modules[modules[i].Module] = sources[i];
+            } else {
+                delete sources[i];
+            }
+        }
+
+        return results;
+    }
+
+    bool Context::SaveImage(const std::string& module, const std::string& path) {
+        CompiledSource* src = GetCompiledSource(module);
+        src->CompilationContext.EmitRemainingFunctions(); // An image always holds the whole module
+
+        Internal::BytecodeImageWriter w(&src->CompilationContext.GetOpCodes());
+        const std::vector<Internal::u8>& image = w.GetImage();
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            fmt::print(stderr, "Failed to open file: {}!\n", path);
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+        return file.good();
+    }
+
+    bool Context::LoadImage(const std::string& path, const std::string& module) {
+        std::string error;
+        CompiledSource* src = LoadImageSource(path, error);
+
+        if (!src) {
+            fmt::print(stderr, "Failed to load bytecode image {}: {}!\n", path, error);
+            return false;
+        }
+
+        src->Module = module;
+
+        AddModule(module, src);
+        return true;
+    }
+
+    bool Context::EmitC(const std::string& module, const std::string& path) {
+        CompiledSource* src = GetCompiledSource(module);
+        src->CompilationContext.EmitRemainingFunctions(); // The C always holds the whole module
+
+        Internal::CEmitter e(&src->CompilationContext.GetOpCodes());
+        if (!e.GetError().empty()) {
+            fmt::print(stderr, "Failed to translate module {} to C: {}!\n", module, e.GetError());
+            return false;
+        }
+
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) {
+            fmt::print(stderr, "Failed to open file: {}!\n", path);
+            return false;
+        }
+
+        file << e.GetOutput();
+        return file.good();
+    }
+
+    bool Context::LoadNative(const std::string& path, const std::string& module) {
+        std::unique_ptr<Internal::NativeLibrary> library = std::make_unique<Internal::NativeLibrary>();
+
+        std::string error;
+        if (!library->Open(path, error)) {
+            fmt::print(stderr, "Failed to load native module {}: {}!\n", path, error);
+            return false;
+        }
+
+        if (!library->GetFunction("_start$()")) {
+            fmt::print(stderr, "Failed to load native module {}: Missing _start$() function!\n", path);
+            return false;
+        }
+
+        CompiledSource* src = new CompiledSource(this, {});
+        src->Native = std::move(library);
+        src->Module = module;
+
+        AddModule(module, src);
+        return true;
+    }
+
+    void Context::SetLazyCodeGen(bool lazy) {
+        m_LazyCodeGen = lazy;
+    }
+
+    void Context::EnableDeadCodeElimination(const std::vector<std::string>& entryPoints) {
+        m_DeadCodeElimination = true;
+        m_EntryPoints = entryPoints;
+    }
+
+    void Context::DisableDeadCodeElimination() {
+        m_DeadCodeElimination = false;
+        m_EntryPoints.clear();
+    }
+
+    void Context::SetSSAOptimization(bool enabled) {
+        m_SSAOptimization = enabled;
+    }
+
+    void Context::SetInlineBudget(size_t budget) {
+        m_InlineBudget = budget;
+    }
+
+    void Context::SetJitMode(JitMode mode) {
+        m_JitMode = mode;
+    }
+
+    void Context::SetJitThreshold(size_t calls) {
+        m_JitThreshold = calls;
+    }
+
+    bool Context::IsJitAvailable() {
+        return Internal::JitCompiler::IsAvailable();
+    }
+
+    bool Context::IsFeedbackAvailable() {
+        #ifdef ARIA_FEEDBACK
+            return true;
+        #else
+            return false;
+        #endif
+    }
+
+    void Context::SetArrayAllocator(const ArrayAllocator& allocator) {
+        m_ArrayAllocator = allocator;
+    }
+
+    ArrayStats Context::GetArrayStats(const std::string& module) {
+        return GetCompiledSource(module)->VM.GetArrayStats();
+    }
+
+    StringStats Context::GetStringStats(const std::string& module) {
+        return GetCompiledSource(module)->VM.GetStringStats();
+    }
+
+    HeapStats Context::GetHeapStats(const std::string& module) {
+        return GetCompiledSource(module)->VM.GetHeapStats();
+    }
+
+    void Context::SetInvocationArena(bool enabled) {
+        m_InvocationArena = enabled;
+    }
+
+    void Context::PersistGlobal(const std::string& global, PersistentType type, const std::string& module) {
+        GetCompiledSource(module)->VM.PersistGlobal(global, type);
+    }
+
+    void Context::EnableCompileCache(const std::string& directory, size_t maxBytes) {
+        m_CompileCache = std::make_shared<Internal::CompileCache>(directory, maxBytes);
+    }
+
+    void Context::DisableCompileCache() {
+        m_CompileCache.reset();
+    }
+
+    CompileCacheStats Context::GetCompileCacheStats() const {
+        if (!m_CompileCache) { return {}; }
+
+        CompileCacheStats stats;
+        stats.Hits = m_CompileCache->GetHits();
+        stats.Misses = m_CompileCache->GetMisses();
+        stats.Writes = m_CompileCache->GetWrites();
+        stats.Evictions = m_CompileCache->GetEvictions();
+        return stats;
+    }
+
+    CompiledSource* Context::LoadImageSource(const std::string& path, std::string& error) {
+        std::unique_ptr<Internal::MappedFile> image = std::make_unique<Internal::MappedFile>();
+        if (!image->Open(path)) {
+            error = "Failed to open file";
+            return nullptr;
+        }
+
+        CompiledSource* src = new CompiledSource(this, {});
+
+        Internal::BytecodeImageReader r(&src->CompilationContext, image->Data(), image->Size());
+        if (!r.IsValid()) {
+            error = r.GetError();
+            delete src;
+            return nullptr;
+        }
+
+        src->Image = std::move(image);
+
+        return src;
+    }
+
+    CompiledSource* Context::CompileSourceCached(std::string source) {
+        if (!m_CompileCache) { return CompileSource(std::move(source)); }
+
+        std::string key = m_CompileCache->GetKey(source, GetCompileFlags());
+        std::string path;
+
+        if (m_CompileCache->Lookup(key, path)) {
+            std::string error;
+            if (CompiledSource* src = LoadImageSource(path, error)) {
+                return src;
+            }
+
+            // The entry is unusable (eg. corrupted on disk), compiling again overwrites it
+        }
+
+        CompiledSource* src = CompileSource(std::move(source));
+
+        // Storing a lazily compiled module would mean emitting every function right away, which is what lazy code generation avoids
+        if (src->CompilationContext.GetCompilerErrors().empty() && !m_LazyCodeGen) {
+            Internal::BytecodeImageWriter w(&src->CompilationContext.GetOpCodes());
+            m_CompileCache->Store(key, w.GetImage());
+        }
+
+        return src;
+    }
 
+    uint64_t Context::GetCompileFlags() const {
+        // Images are stored in the host's byte order and pointer size
+        uint64_t flags = sizeof(void*);
+
+        uint16_t endianness = 1;
+        if (*reinterpret_cast<uint8_t*>(&endianness) == 1) {
+            flags |= 1 << 8;
+        }
+
+        if (m_DeadCodeElimination) {
+            flags |= 1 << 9;
+
+            // Different entry points keep different functions alive, FNV-1a keeps the key stable across runs
+            uint64_t hash = 14695981039346656037ull;
+            for (const std::string& entry : m_EntryPoints) {
+                for (char c : entry) { hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull; }
+                hash = (hash ^ 0xff) * 1099511628211ull; // Separator so {"ab"} and {"a", "b"} differ
+            }
+
+            flags ^= hash << 16;
+        }
+
+        if (m_SSAOptimization) {
+            flags |= 1 << 10;
+            flags ^= static_cast<uint64_t>(m_InlineBudget) << 11; // Inlining never changes what the code does, so a rare collision is harmless
+        }
+
+        return flags;
+    }
+
+    CompiledSource* Context::CompileSource(std::string source) {
+        CompiledSource* src = new CompiledSource(this, std::move(source));
+
+        src->CompilationContext.SetLazyCodeGen(m_LazyCodeGen);
+        src->CompilationContext.SetDeadCodeElimination(m_DeadCodeElimination, m_EntryPoints);
+        src->CompilationContext.SetSSAOptimization(m_SSAOptimization);
+        src->CompilationContext.SetInlineBudget(m_InlineBudget);
         src->CompilationContext.Compile();
 
-        src->VM.AddExtern("bl__array__init__", Aria::Internal::bl__array__init__);
-        src->VM.AddExtern("bl__array__destruct__", Aria::Internal::bl__array__destruct__);
-        src->VM.AddExtern("bl__array__copy__", Aria::Internal::bl__array__copy__);
+        return src;
+    }
+
+    ModuleReloadReport Context::ReloadModule(const std::string& module, const std::string& newSource) {
+        ModuleReloadReport report;
+        report.Module = module;
+
+        // Compiling doesn't touch the loaded module at all so it happens outside of the lock
+        std::unique_ptr<CompiledSource> newSrc(CompileSource(newSource));
+        newSrc->CompilationContext.EmitRemainingFunctions(); // The diff needs every function, even with lazy code generation
+        newSrc->Module = module;
 
-        src->VM.AddExtern("bl__array__append__", Aria::Internal::bl__array__append__);
-        src->VM.AddExtern("bl__array__index__", Aria::Internal::bl__array__index__);
+        for (const Internal::CompilerError& e : newSrc->CompilationContext.GetCompilerErrors()) {
+            report.Errors.push_back({ e.Line, e.Column, e.Error });
+        }
 
-        src->VM.AddExtern("bl__string__construct__", Aria::Internal::bl__string__construct__);
-        src->VM.AddExtern("bl__string__construct_from_literal__", Aria::Internal::bl__string__construct_from_literal__);
+        if (!report.Errors.empty()) { return report; }
 
-        src->VM.AddExtern("bl__string__copy__", Aria::Internal::bl__string__copy__);
-        src->VM.AddExtern("bl__string__assign__", Aria::Internal::bl__string__assign__);
+        std::lock_guard<std::mutex> lock(*m_ModuleMutex);
 
-        m_Modules[module] = src;
+        ARIA_ASSERT(m_Modules.contains(module), "Current context does not contain the requested module!");
+        CompiledSource* src = m_Modules.at(module);
+
+        // Always diff against the module that is actually loaded, since that is what the VM state belongs to
+        // A Run() on another thread may be appending lazily emitted functions to it, which the code generation lock keeps out
+        std::unique_lock<std::mutex> codeGenLock(src->CompilationContext.GetCodeGenMutex());
+        Internal::ModuleDiff diff(&src->CompilationContext, &newSrc->CompilationContext);
+        codeGenLock.unlock();
+
+        report.Success = true;
+        report.ChangedFunctions = diff.GetChangedFunctions();
+        report.AddedFunctions = diff.GetAddedFunctions();
+        report.RemovedFunctions = diff.GetRemovedFunctions();
+        report.KeptGlobals = diff.GetKeptGlobals();
+        report.ResetGlobals = diff.GetResetGlobals();
+        report.AddedGlobals = diff.GetAddedGlobals();
+        report.RemovedGlobals = diff.GetRemovedGlobals();
+
+        if (!diff.HasChanges()) {
+            src->PendingReload.reset(); // The source matches what is loaded, so an older pending reload would only undo that
+            return report;
+        }
+
+        src->PendingReload = std::move(newSrc);
+        src->PendingKeptGlobals = diff.GetKeptGlobals();
+        src->PendingRemovedGlobals = diff.GetRemovedGlobals();
+
+        return report;
+    }
+
+    CompiledSource* Context::ApplyPendingReload(CompiledSource* src) {
+        std::lock_guard<std::mutex> lock(*m_ModuleMutex);
+        if (!src->PendingReload) { return src; }
+
+        CompiledSource* newSrc = src->PendingReload.release();
+
+        // The VM holds the globals and the registered extern functions, so it moves over as a whole
+        newSrc->VM = std::move(src->VM);
+
+        for (const std::string& global : src->PendingRemovedGlobals) {
+            newSrc->VM.RemoveGlobal(global);
+        }
+        newSrc->VM.PreserveGlobals(src->PendingKeptGlobals);
+
+        m_Modules[src->Module] = newSrc;
+        if (m_CurrentCompiledSource == src) {
+            m_CurrentCompiledSource = newSrc;
+        }
+
+        delete src;
+        return newSrc;
     }
 
     void Context::FreeModule(const std::string& module) {
         CompiledSource* src = GetCompiledSource(module);
 
-        delete src;
+        std::lock_guard<std::mutex> lock(*m_ModuleMutex);
         m_Modules.erase(module);
+        if (m_CurrentCompiledSource == src) { m_CurrentCompiledSource = nullptr; }
+
+        delete src;
     }
 
     void Context::Run(const std::string& module) {
-        CompiledSource* src = GetCompiledSource(module);
+        // In between two runs nothing is executing, which makes it the safe point for swapping in reloaded byte code
+        CompiledSource* src = ApplyPendingReload(GetCompiledSource(module));
 
         m_CurrentCompiledSource = src;
-        m_CurrentCompiledSource->VM.RunByteCode(src->CompilationContext.GetOpCodes().data(), src->CompilationContext.GetOpCodes().size());
+
+        Internal::CompilationContext* lazyCtx = src->CompilationContext.IsLazyCodeGen() ? &src->CompilationContext : nullptr;
+        m_CurrentCompiledSource->VM.SetLazyCompilationContext(lazyCtx);
+
+        switch (m_JitMode) {
+            case JitMode::Disabled: m_CurrentCompiledSource->VM.SetJitThreshold(SIZE_MAX); break;
+            case JitMode::Tiered:   m_CurrentCompiledSource->VM.SetJitThreshold(std::max<size_t>(m_JitThreshold, 1)); break;
+            case JitMode::Eager:    m_CurrentCompiledSource->VM.SetJitThreshold(0); break;
+        }
+
+        m_CurrentCompiledSource->VM.SetArrayAllocator(m_ArrayAllocator);
+
+        // Decided once per invocation, changing the setting from inside one must not leave the arena half open
+        bool arena = m_InvocationArena;
+        if (arena) { m_CurrentCompiledSource->VM.BeginInvocationArena(); }
+
+        if (src->Native) {
+            m_CurrentCompiledSource->VM.RunNative(src->Native->GetFunction("_start$()"));
+        } else {
+            m_CurrentCompiledSource->VM.RunByteCode(src->CompilationContext.GetOpCodes().data(), src->CompilationContext.GetOpCodes().size());
+        }
+
+        if (arena) { src->VM.EndInvocationArena(); }
     }
 
     std::string Context::DumpAST(const std::string& module) {
         CompiledSource* src = GetCompiledSource(module);
+        if (!src->CompilationContext.GetRootASTNode()) { return {}; } // Modules loaded from a bytecode image have no AST
 
         Internal::ASTDumper d(src->CompilationContext.GetRootASTNode());
         return d.GetOutput();
@@ -96,6 +525,99 @@ namespace Aria {
         return d.GetDisassembly();
     }
 
+    std::string Context::DumpIR(const std::string& module) {
+        CompiledSource* src = GetCompiledSource(module);
+        if (!src->CompilationContext.GetIRModule()) { return {}; }
+
+        Internal::IRDumper d(src->CompilationContext.GetIRModule());
+        return d.GetDump();
+    }
+
+    std::string Context::DumpCompilerMemoryStats(const std::string& module) {
+        CompiledSource* src = GetCompiledSource(module);
+
+        std::string output;
+        for (const Internal::CompilationPhaseStats& phase : src->CompilationContext.GetPhaseStats()) {
+            output += fmt::format("{:<8} used: {} bytes, wasted: {} bytes, allocations: {}, new chunks: {}\n",
+                                  phase.Phase, phase.BytesUsed, phase.BytesWasted, phase.AllocationCount, phase.ChunksAdded);
+        }
+
+        const AllocatorStats& total = src->CompilationContext.GetAllocator()->GetStats();
+        output += fmt::format("{:<8} used: {} bytes, wasted: {} bytes, reserved: {} bytes, chunks: {}\n",
+                              "Total", total.BytesUsed, total.BytesWasted, total.BytesReserved, total.ChunkCount);
+
+        return output;
+    }
+
+    std::string Context::DumpCodeSizeStats(const std::string& module) {
+        CompiledSource* src = GetCompiledSource(module);
+        if (!src->CompilationContext.IsDeadCodeEliminationEnabled() || src->CompilationContext.IsLazyCodeGen()) { return {}; }
+
+        const Internal::CodeSizeStats& stats = src->CompilationContext.GetCodeSizeStats();
+        std::string output;
+        output += fmt::format("{:<10} before: {}, after: {}\n", "Op codes", stats.OpCodesBefore, stats.OpCodesAfter);
+        output += fmt::format("{:<10} before: {}, after: {}\n", "Functions", stats.FunctionsBefore, stats.FunctionsAfter);
+        output += fmt::format("{:<10} before: {}, after: {}\n", "Globals", stats.GlobalsBefore, stats.GlobalsAfter);
+
+        return output;
+    }
+
+    std::string Context::DumpJitStats(const std::string& module) {
+        CompiledSource* src = GetCompiledSource(module);
+
+        std::vector<std::pair<std::string, size_t>> compiled;
+        for (const auto& [signature, fn] : src->VM.GetFunctions()) {
+            if (fn.NativeCode) { compiled.emplace_back(signature, fn.NativeCodeSize); }
+        }
+
+        std::sort(compiled.begin(), compiled.end());
+
+        std::string output;
+        for (const auto& [signature, size] : compiled) {
+            output += fmt::format("{:<24} native: {} bytes\n", signature, size);
+        }
+
+        return output;
+    }
+
+    std::string Context::DumpFeedback(const std::string& module) {
+        CompiledSource* src = GetCompiledSource(module);
+
+        const Internal::ExecutionFeedback* feedback = src->VM.GetFeedback();
+        if (!feedback) { return {}; }
+
+        const std::vector<Internal::OpCode>& opcodes = src->CompilationContext.GetOpCodes();
+
+        std::vector<std::pair<std::string, uint32_t>> invocations;
+        for (const auto& [signature, fn] : src->VM.GetFunctions()) {
+            if (fn.Entry < feedback->Invocations.size() && feedback->Invocations[fn.Entry] > 0) {
+                invocations.emplace_back(signature, feedback->Invocations[fn.Entry]);
+            }
+        }
+
+        std::sort(invocations.begin(), invocations.end());
+
+        std::string output;
+        for (const auto& [signature, count] : invocations) {
+            output += fmt::format("{:<24} invocations: {}\n", signature, count);
+        }
+
+        for (size_t pc = 0; pc < feedback->Taken.size(); pc++) {
+            if (feedback->Taken[pc] > 0 || feedback->NotTaken[pc] > 0) {
+                output += fmt::format("{:<24} taken: {}, not taken: {}\n", fmt::format("branch {}", pc), feedback->Taken[pc], feedback->NotTaken[pc]);
+            }
+        }
+
+        for (size_t pc = 0; pc < feedback->CallTargets.size(); pc++) {
+            if (feedback->CallTargets[pc] > 0) {
+                const Internal::OpCodeCall& call = std::get<Internal::OpCodeCall>(opcodes[pc].Data);
+                output += fmt::format("{:<24} {}: {}\n", fmt::format("call {}", pc), call.Function.GetFunction().Signature, feedback->CallTargets[pc]);
+            }
+        }
+
+        return output;
+    }
+
     void Context::PushBool(bool b, const std::string& module) {
         CompiledSource* src = GetCompiledSource(module);
         src->VM.Alloca(sizeof(b), Internal::TypeInfo::Create(&src->CompilationContext, Internal::PrimitiveType::Bool));
@@ -144,6 +666,14 @@ namespace Aria {
         src->VM.StorePointer({ Internal::StackSlotRef(-1, sizeof(p)) }, p);
     }
 
+    void Context::PushString(std::string_view str, const std::string& module) {
+        CompiledSource* src = GetCompiledSource(module);
+        Internal::String* string = src->VM.CreateString(str);
+
+        src->VM.Alloca(sizeof(string), Internal::TypeInfo::Create(&src->CompilationContext, Internal::PrimitiveType::String));
+        src->VM.StorePointer({ Internal::StackSlotRef(-1, sizeof(string)) }, string);
+    }
+
     void Context::StoreBool(size_t index, bool b, const std::string& module) {
         CompiledSource* src = GetCompiledSource(module);
         src->VM.StoreBool({ Internal::StackSlotRef(index, sizeof(b)) }, b);
@@ -186,12 +716,7 @@ namespace Aria {
 
     void Context::PushGlobal(const std::string& str, const std::string& module) {
         CompiledSource* src = GetCompiledSource(module);
-
-        // ARIA_ASSERT(src->ReflectionData.Declarations.contains(str), "Trying to push an unknown global variable");
-        // ARIA_ASSERT(src->ReflectionData.Declarations.at(str).Type == Internal::ReflectionType::Variable, "Trying to push a non-variable global (perhaps a function)");
-
-        // src->VM.Ref(std::get<int32_t>(src->ReflectionData.Declarations.at(str).Data), src->ReflectionData.Declarations.at(str).ResolvedType);
-        ARIA_ASSERT(false, "todo: add Context::PushGlobal()");
+        src->VM.Dup({ Internal::GlobalVarRef(str) });
     }
 
     void Context::PushField(int32_t index, const std::string& name, const std::string& module) {
@@ -252,6 +777,11 @@ namespace Aria {
         return src->VM.GetPointer({ Internal::StackSlotRef(index, sizeof(void*)) });
     }
 
+    std::string_view Context::GetString(int32_t index, const std::string& module) {
+        CompiledSource* src = GetCompiledSource(module);
+        return Internal::GetStringView(reinterpret_cast<Internal::String*>(src->VM.GetPointer({ Internal::StackSlotRef(index, sizeof(void*)) })));
+    }
+
     StackSlot Context::GetStackSlot(int32_t index, const std::string& module) {
         CompiledSource* src = GetCompiledSource(module);
         Internal::VMSlice slice = src->VM.GetVMSlice({ Internal::StackSlotRef(index, 0, 0) });
@@ -264,8 +794,7 @@ namespace Aria {
     }
 
     void Context::Call(const std::string& str, const std::string& module) {
-        ARIA_ASSERT(m_Modules.contains(module), "Current context does not contain the requested module!");
-        CompiledSource* src = m_Modules.at(module);
+        CompiledSource* src = GetCompiledSource(module);
 
         ARIA_ASSERT(false, "Add Context::Call()");
         // ARIA_ASSERT(src->ReflectionData.Declarations.contains(str), "Trying to call an unknown function");
@@ -291,10 +820,18 @@ namespace Aria {
             return m_CurrentCompiledSource;
         }
 
+        std::lock_guard<std::mutex> lock(*m_ModuleMutex);
         ARIA_ASSERT(m_Modules.contains(module), "Current context does not contain the requested module!");
         return m_Modules.at(module);
     }
 
+    void Context::AddModule(const std::string& module, CompiledSource* src) {
+        std::lock_guard<std::mutex> lock(*m_ModuleMutex);
+
+        m_CurrentCompiledSource = src;
+        m_Modules[module] = src;
+    }
+
     void Context::ReportRuntimeError(const std::string& error) {
         if (m_RuntimeErrorHandler) {
             m_RuntimeErrorHandler(error);
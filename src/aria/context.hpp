@@ -4,9 +4,14 @@
 #include <cstddef>
 #include <unordered_map>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
 
 namespace Aria::Internal {
     class VM;
+    class CompileCache;
 }
 
 namespace Aria {
@@ -28,6 +33,130 @@ namespace Aria {
         size_t Size = 0;
     };
 
+    // A module to compile with Context::CompileModules()
+    // If Path is not empty the source code gets read from that file, otherwise Source is used
+    struct ModuleSource {
+        std::string Module;
+        std::string Path;
+        std::string Source;
+    };
+
+    struct ModuleError {
+        size_t Line = 0;
+        size_t Column = 0;
+        std::string Error;
+    };
+
+    struct CompileCacheStats {
+        size_t Hits = 0;
+        size_t Misses = 0;
+        size_t Writes = 0;
+        size_t Evictions = 0;
+    };
+
+    // Where the memory of script arrays comes from, see Context::SetArrayAllocator()
+    // Allocate has to return memory aligned to at least 8 bytes, Free gets passed the size that was allocated
+    // Leaving both functions nullptr uses the heap of the module, see Context::GetHeapStats()
+    struct ArrayAllocator {
+        void* (*Allocate)(size_t bytes, void* userData) = nullptr;
+        void (*Free)(void* memory, size_t bytes, void* userData) = nullptr;
+        void* UserData = nullptr;
+    };
+
+    struct ArrayStats {
+        size_t GrowthFactor = 0; // What the capacity gets multiplied by once an append runs out of room
+        size_t InlineBytes = 0; // How many bytes of elements fit into the same allocation as the array itself
+
+        size_t Arrays = 0;
+        size_t InlineArrays = 0; // Arrays whose elements still live in their inline storage
+
+        size_t Allocations = 0; // Calls to ArrayAllocator::Allocate, one per array plus one per grow or shrink outside of the inline storage
+        size_t Frees = 0;
+        size_t Grows = 0;
+        size_t Shrinks = 0;
+
+        size_t BytesAllocated = 0;
+        size_t PeakBytesAllocated = 0;
+    };
+
+    struct StringStats {
+        size_t InlineBytes = 0; // How many characters fit into the same allocation as the string itself
+        size_t GrowthFactor = 0; // How much room a concatenation that has to copy leaves for the following ones
+
+        size_t Literals = 0; // Interned once per module, loading a literal never creates a string
+        size_t Strings = 0; // Every other string, created by concatenations or the host
+        size_t InlineStrings = 0;
+
+        size_t Buffers = 0; // The character buffers of the strings that don't fit inline
+        size_t InPlaceConcats = 0; // Concatenations that appended to the buffer of their left hand side instead of copying it
+
+        size_t BytesAllocated = 0;
+    };
+
+    // The heap every module gets its array and string memory from, see Context::GetHeapStats()
+    struct HeapStats {
+        size_t SizeClasses = 0; // Small objects get rounded up to one of these and share chunks with the objects of the same size
+        size_t LargeObjectThreshold = 0; // Objects bigger than this get a mapping of their own
+        size_t ChunkSize = 0;
+
+        size_t Chunks = 0;
+        size_t LargeObjects = 0;
+        size_t Objects = 0; // Live objects, small and large
+
+        size_t Allocations = 0;
+        size_t Frees = 0;
+        size_t FreeListHits = 0; // Allocations that reused a freed object instead of taking fresh chunk memory
+
+        size_t BytesInUse = 0; // Small objects count with the size of their size class
+        size_t PeakBytesInUse = 0;
+        size_t BytesReserved = 0; // Every chunk and large mapping
+
+        // The invocation arena, see Context::SetInvocationArena()
+        size_t ArenaChunks = 0;
+        size_t ArenaAllocations = 0;
+        size_t ArenaResets = 0;
+        size_t ArenaBytesInUse = 0; // 0 whenever no invocation is running
+        size_t PeakArenaBytesInUse = 0;
+        size_t ArenaBytesReserved = 0; // Arena chunks are kept across resets and reused by the next invocation
+        size_t PersistedObjects = 0; // Arrays and strings copied out of the arena for globals registered with Context::PersistGlobal()
+    };
+
+    // What a global passed to Context::PersistGlobal() holds
+    enum class PersistentType {
+        Array,
+        String
+    };
+
+    // When script functions get compiled to native code, only x86-64 Linux has a JIT (see Context::IsJitAvailable())
+    enum class JitMode {
+        Disabled,
+        Tiered, // Functions get compiled once they have been called often enough, see Context::SetJitThreshold()
+        Eager, // Every function gets compiled before it first runs, mostly useful to test the JIT
+    };
+
+    struct ModuleCompileResult {
+        std::string Module;
+        bool Success = false;
+        std::vector<ModuleError> Errors;
+    };
+
+    // What Context::ReloadModule() found when comparing the new source against the loaded module
+    // If the new source fails to compile the reload is rejected: Success is false and the module is left untouched
+    struct ModuleReloadReport {
+        std::string Module;
+        bool Success = false;
+        std::vector<ModuleError> Errors;
+
+        std::vector<std::string> ChangedFunctions;
+        std::vector<std::string> AddedFunctions;
+        std::vector<std::string> RemovedFunctions;
+
+        std::vector<std::string> KeptGlobals; // Same name and type, these keep their current value
+        std::vector<std::string> ResetGlobals; // The type changed so the current value is thrown away and the global gets initialized again
+        std::vector<std::string> AddedGlobals;
+        std::vector<std::string> RemovedGlobals;
+    };
+
     struct Context {
         Context();
         static Context Create();
@@ -35,6 +164,86 @@ namespace Aria {
         void CompileFile(const std::string& path, const std::string& module);
         void CompileString(const std::string& source, const std::string& module);
 
+        // Only emit the byte code of a function the first time it gets called, instead of emitting every function up front
+        // Type checking still happens for the whole module at compile time, only affects modules compiled afterwards
+        // Note that Disassemble() of such a module only shows the functions that have been called so far
+        void SetLazyCodeGen(bool lazy);
+
+        // Drops every function that neither the top level code nor one of the entry points can reach, as well as globals nothing refers to
+        // Entry points are the function signatures (eg. "Update()") and global names the host still needs, only affects modules compiled afterwards
+        void EnableDeadCodeElimination(const std::vector<std::string>& entryPoints = {});
+        void DisableDeadCodeElimination();
+
+        // Compiles through the SSA intermediate representation, which gets optimized (copy propagation, sparse conditional constant propagation,
+        // common subexpression elimination, loop invariant code motion, strength reduction, dead code elimination and inlining) before being lowered
+        // to byte code, only affects modules compiled afterwards
+        void SetSSAOptimization(bool enabled);
+        // Calls to non recursive script functions costing at most budget IR instructions get inlined by the SSA pipeline, 0 disables inlining
+        void SetInlineBudget(size_t budget);
+
+        // Controls the JIT, takes effect on the next Run() of a module
+        // Functions the JIT can't compile keep running in the interpreter, native and interpreted functions call each other freely
+        void SetJitMode(JitMode mode);
+        // How many calls it takes for a function to get compiled with JitMode::Tiered
+        void SetJitThreshold(size_t calls);
+        // False if the library was built without a JIT, either because the platform isn't supported or ARIA_DISABLE_JIT was defined
+        static bool IsJitAvailable();
+        // False if the library was built with ARIA_DISABLE_FEEDBACK, the VM then records no counters for DumpFeedback()
+        static bool IsFeedbackAvailable();
+
+        // Makes the arrays of a module get their memory from the given allocator, takes effect on the next Run() of a module
+        // A module which already created arrays keeps the allocator it started out with, its arrays get freed together with the module
+        void SetArrayAllocator(const ArrayAllocator& allocator);
+        ArrayStats GetArrayStats(const std::string& module);
+        StringStats GetStringStats(const std::string& module);
+        // The arrays (unless they use an ArrayAllocator) and strings of a module all come from a heap owned by the module
+        // Freeing the module releases that heap as a whole, whatever objects are still alive in it
+        HeapStats GetHeapStats(const std::string& module);
+
+        // Makes every array and string a Run() creates come from an arena that gets reset as soon as Run() returns,
+        // which frees all of them at once no matter how many there were, takes effect on the next Run() of a module
+        // Nothing created during the invocation survives it except for the globals registered with PersistGlobal(),
+        // any other global still holding an array or string of the invocation is left dangling
+        // Literals and arrays using an ArrayAllocator never come from the arena
+        void SetInvocationArena(bool enabled);
+        // Copies the array or string the global holds out of the arena into the heap of the module whenever an invocation ends
+        // The global has to hold what type says, globals holding something that isn't from the arena are left alone
+        void PersistGlobal(const std::string& global, PersistentType type, const std::string& module);
+
+        // Makes CompileFile() (and CompileModules() for file modules) look up compiled bytecode images in the given directory
+        // The images are keyed by a hash of the source code, the compiler version and the compile flags
+        // Once the directory grows past maxBytes the least recently used images get deleted
+        void EnableCompileCache(const std::string& directory, size_t maxBytes = 256 * 1024 * 1024);
+        void DisableCompileCache();
+        CompileCacheStats GetCompileCacheStats() const;
+
+        // Writes the compiled byte code of a module to a bytecode image (.ariac), returns false if the file couldn't be written
+        bool SaveImage(const std::string& module, const std::string& path);
+        // Maps a bytecode image created with SaveImage() and registers it as a module, the compiler is not involved at all
+        // Returns false if the file is missing, corrupt or was written by an incompatible version
+        bool LoadImage(const std::string& path, const std::string& module);
+
+        // Translates the byte code of a module into C, returns false if the file couldn't be written
+        // Build the C into a shared object with the system compiler (eg. cc -O2 -shared -fPIC module.c -o module.so -lm) and load it with LoadNative()
+        bool EmitC(const std::string& module, const std::string& path);
+        // Loads a shared object built from the output of EmitC() and registers it as a module, Run() then runs native code only
+        // Extern functions and globals work exactly like they do for compiled modules
+        // Returns false if the library is missing, isn't an Aria module or was built against an incompatible version
+        bool LoadNative(const std::string& path, const std::string& module);
+
+        // Compiles every module in parallel using workerCount threads (0 picks one per hardware thread)
+        // The modules are registered all at once, and only if every single one of them compiled without errors
+        // Compiler errors are collected per module and also passed to the compiler error handler
+        std::vector<ModuleCompileResult> CompileModules(const std::vector<ModuleSource>& modules, size_t workerCount = 0);
+
+        // Recompiles a loaded module from new source code while keeping the state of its VM
+        // Nothing gets swapped right away, the new byte code replaces the old one at the start of the next Run() of the module,
+        // which runs the new top level code but does not touch the globals listed in ModuleReloadReport::KeptGlobals
+        // This may be called from a background thread, even while the module is running
+        // Reloading again before the next Run() replaces the pending reload
+        // With lazy code generation the functions of the loaded module that were never called show up as added
+        ModuleReloadReport ReloadModule(const std::string& module, const std::string& newSource);
+
         // Deallocates the given module
         void FreeModule(const std::string& module);
 
@@ -45,6 +254,18 @@ namespace Aria {
         std::string DumpAST(const std::string& module);
         // Returns a string containing the disassembled byte code
         std::string Disassemble(const std::string& module);
+        // Returns a string containing the optimized SSA IR, empty if the module wasn't compiled with SetSSAOptimization()
+        std::string DumpIR(const std::string& module);
+        // Returns a string containing how much compiler memory each phase of compilation used
+        std::string DumpCompilerMemoryStats(const std::string& module);
+        // Returns a string containing the size of the byte code before and after dead code elimination
+        std::string DumpCodeSizeStats(const std::string& module);
+        // Returns a string containing every function the JIT compiled so far together with the size of its native code
+        std::string DumpJitStats(const std::string& module);
+        // Returns a string containing the invocation, branch and call site counts the VM recorded so far
+        // They add up over every run of the module just like the call counts the JIT tiers up on, a reload starts them over
+        // Empty if feedback isn't available, see Context::IsFeedbackAvailable()
+        std::string DumpFeedback(const std::string& module);
 
         void PushBool(bool b,     const std::string& module = {});
         void PushChar(int8_t c,   const std::string& module = {});
@@ -54,6 +275,8 @@ namespace Aria {
         void PushFloat(float f,   const std::string& module = {});
         void PushDouble(double f, const std::string& module = {});
         void PushPointer(void* p, const std::string& module = {});
+        // Copies the characters into a new string owned by the module
+        void PushString(std::string_view str, const std::string& module = {});
 
         void StoreBool(size_t index, bool b,     const std::string& module = {});
         void StoreChar(size_t index, int8_t c,   const std::string& module = {});
@@ -75,6 +298,8 @@ namespace Aria {
         float     GetFloat(int32_t index,   const std::string& module = {});
         double    GetDouble(int32_t index,  const std::string& module = {});
         void*     GetPointer(int32_t index, const std::string& module = {});
+        // Only valid for as long as the module is loaded
+        std::string_view GetString(int32_t index, const std::string& module = {});
         StackSlot GetStackSlot(int32_t index, const std::string& module = {});
 
         void AddExternalFunction(const std::string& name, ExternFn fn, const std::string& module);
@@ -84,7 +309,20 @@ namespace Aria {
         void SetCompilerErrorHandler(CompilerErrorHandlerFn fn);
 
     private:
+        // Compiles the source without registering it, this only touches the returned CompiledSource so it is safe to call from any thread
+        CompiledSource* CompileSource(std::string source);
+        // Same as CompileSource() but goes through the compile cache if it is enabled
+        CompiledSource* CompileSourceCached(std::string source);
+        // Returns nullptr and sets error if the image couldn't be loaded
+        CompiledSource* LoadImageSource(const std::string& path, std::string& error);
+        // Everything besides the source code which affects the compiled byte code
+        uint64_t GetCompileFlags() const;
+
         CompiledSource* GetCompiledSource(const std::string& module);
+        // Makes src the module's CompiledSource (and the current one)
+        void AddModule(const std::string& module, CompiledSource* src);
+        // Swaps in the byte code staged by ReloadModule() (if there is any) and returns the module's new CompiledSource
+        CompiledSource* ApplyPendingReload(CompiledSource* src);
 
         void ReportRuntimeError(const std::string& error);
 
@@ -98,6 +336,19 @@ namespace Aria {
 
         RuntimeErrorHandlerFn m_RuntimeErrorHandler = nullptr;
         CompilerErrorHandlerFn m_CompilerErrorHandler = nullptr;
+
+        std::shared_ptr<Internal::CompileCache> m_CompileCache;
+        bool m_LazyCodeGen = false;
+        bool m_DeadCodeElimination = false;
+        std::vector<std::string> m_EntryPoints;
+        bool m_SSAOptimization = false;
+        size_t m_InlineBudget = 16;
+        JitMode m_JitMode = JitMode::Tiered;
+        size_t m_JitThreshold = 1000;
+        ArrayAllocator m_ArrayAllocator;
+        bool m_InvocationArena = false;
+
+        std::unique_ptr<std::mutex> m_ModuleMutex; // Guards m_Modules and pending reloads, a pointer so contexts can still be moved
     };
 
 } // namespace Aria
@@ -4,6 +4,9 @@
 #include "fmt/printf.h"
 #include "fmt/color.h"
 
+// Bump this whenever the compiler output changes, cached bytecode images are keyed on it
+#define ARIA_VERSION "0.1.0"
+
 #ifdef _WIN32
     #define ARIA_DEBUGBREAK() __debugbreak();
 #elif __linux__
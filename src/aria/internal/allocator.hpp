@@ -3,23 +3,60 @@
 #include "aria/core.hpp"
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
 #include <utility>
 
 namespace Aria {
 
+    struct AllocatorStats {
+        size_t BytesUsed = 0; // Bytes handed out by Allocate()
+        size_t BytesWasted = 0; // Alignment padding and the unused tails of full chunks
+        size_t BytesReserved = 0; // The total capacity of all the chunks
+
+        size_t ChunkCount = 0;
+        size_t AllocationCount = 0;
+    };
+
     // The allocator which gets used internally
     // NOTE: This allocator WON'T call destructors, so NEVER store std::string, std::vector, etc in the compiler!
-    // If you don't provide an allocator you must call Aria::SetupDefaultAllocator() to set up a default one
+    // Memory is handed out from a list of chunks, when a chunk is full a bigger one gets allocated,
+    // so small scripts only reserve a few kilobytes while big ones never run out
     class Allocator {
+    private:
+        struct Chunk {
+            Chunk* Previous = nullptr;
+            size_t Capacity = 0;
+            size_t Offset = 0;
+
+            inline uint8_t* GetData() { return reinterpret_cast<uint8_t*>(this + 1); }
+        };
+
     public:
-        inline Allocator(size_t bytes)
-            : m_Capacity(bytes), m_Data(new uint8_t[bytes]) {}
+        inline static constexpr size_t MinChunkSize = 16 * 1024;
+        inline static constexpr size_t MaxChunkSize = 1024 * 1024;
+        inline static constexpr size_t DefaultAlignment = alignof(std::max_align_t);
+
+        // A position in the allocator which can later be rewound to
+        struct Marker {
+            Chunk* ActiveChunk = nullptr;
+            size_t Offset = 0;
+
+            size_t BytesUsed = 0;
+            size_t BytesWasted = 0;
+            size_t AllocationCount = 0;
+        };
+
+        Allocator() = default;
 
         inline ~Allocator() {
-            delete[] m_Data;
-            m_Data = nullptr;
-            m_Capacity = 0;
-            m_Index = 0;
+            FreeChunks(nullptr);
+
+            if (m_SpareChunk) {
+                ::operator delete(m_SpareChunk);
+                m_SpareChunk = nullptr;
+            }
         }
 
         // Copying/moving an allocator is not valid
@@ -29,18 +66,59 @@ namespace Aria {
         void operator=(const Allocator& other) = delete;
         void operator=(Allocator&& other) = delete;
 
-        [[nodiscard]] inline void* Allocate(size_t bytes) {
-            ARIA_ASSERT(m_Index + bytes < m_Capacity, "Too much memory allocated!");
-            uint8_t* mem = &m_Data[m_Index];
+        // NOTE: alignment must be a power of two
+        [[nodiscard]] inline void* Allocate(size_t bytes, size_t alignment = DefaultAlignment) {
+            ARIA_ASSERT((alignment & (alignment - 1)) == 0, "Allocator::Allocate() alignment must be a power of two!");
+
+            size_t padding = m_ActiveChunk ? GetPadding(m_ActiveChunk, alignment) : 0;
 
-            m_Index += bytes;
+            if (!m_ActiveChunk || m_ActiveChunk->Offset + padding + bytes > m_ActiveChunk->Capacity) {
+                AddChunk(bytes + alignment);
+                padding = GetPadding(m_ActiveChunk, alignment);
+            }
+
+            uint8_t* mem = m_ActiveChunk->GetData() + m_ActiveChunk->Offset + padding;
+            m_ActiveChunk->Offset += padding + bytes;
+
+            m_Stats.BytesUsed += bytes;
+            m_Stats.BytesWasted += padding;
+            m_Stats.AllocationCount++;
 
             return reinterpret_cast<void*>(mem);
         }
 
+        // Resizes a block returned by Allocate()
+        // If the block is the most recent allocation it gets grown (or shrunk) in place,
+        // otherwise a new block is allocated, the contents get copied over and the old block is counted as wasted
+        [[nodiscard]] inline void* Reallocate(void* ptr, size_t oldBytes, size_t newBytes, size_t alignment = DefaultAlignment) {
+            if (!ptr) { return Allocate(newBytes, alignment); }
+
+            uint8_t* mem = reinterpret_cast<uint8_t*>(ptr);
+            uint8_t* top = m_ActiveChunk->GetData() + m_ActiveChunk->Offset;
+
+            if (mem + oldBytes == top) {
+                size_t start = static_cast<size_t>(mem - m_ActiveChunk->GetData());
+
+                if (start + newBytes <= m_ActiveChunk->Capacity) {
+                    m_ActiveChunk->Offset = start + newBytes;
+                    m_Stats.BytesUsed = m_Stats.BytesUsed - oldBytes + newBytes;
+                    return ptr;
+                }
+            }
+
+            void* newMem = Allocate(newBytes, alignment);
+            memcpy(newMem, ptr, oldBytes < newBytes ? oldBytes : newBytes);
+
+            m_Stats.BytesUsed -= oldBytes;
+            m_Stats.BytesWasted += oldBytes;
+            m_Stats.AllocationCount--; // This is still the same allocation from the user's point of view
+
+            return newMem;
+        }
+
         template <typename T>
         [[nodiscard]] inline T* AllocateNamed() {
-            T* mem = reinterpret_cast<T*>(Allocate(sizeof(T)));
+            T* mem = reinterpret_cast<T*>(Allocate(sizeof(T), alignof(T)));
 
             // return mem;
             return new (mem) T{};
@@ -48,15 +126,122 @@ namespace Aria {
 
         template <typename T, typename... Args>
         [[nodiscard]] inline T* AllocateNamed(Args&&... args) {
-            T* mem = reinterpret_cast<T*>(Allocate(sizeof(T)));
+            T* mem = reinterpret_cast<T*>(Allocate(sizeof(T), alignof(T)));
 
             return new (mem) T{std::forward<Args>(args)...};
         }
 
+        inline Marker GetMarker() const {
+            Marker m;
+            m.ActiveChunk = m_ActiveChunk;
+            m.Offset = m_ActiveChunk ? m_ActiveChunk->Offset : 0;
+            m.BytesUsed = m_Stats.BytesUsed;
+            m.BytesWasted = m_Stats.BytesWasted;
+            m.AllocationCount = m_Stats.AllocationCount;
+            return m;
+        }
+
+        // Frees everything that was allocated after the marker was taken
+        // Any pointer handed out after that point becomes invalid
+        inline void Rewind(const Marker& marker) {
+            FreeChunks(marker.ActiveChunk);
+
+            if (m_ActiveChunk) {
+                ARIA_ASSERT(m_ActiveChunk->Offset >= marker.Offset, "Allocator::Rewind() called with a marker that was already rewound past!");
+                m_ActiveChunk->Offset = marker.Offset;
+            }
+
+            m_Stats.BytesUsed = marker.BytesUsed;
+            m_Stats.BytesWasted = marker.BytesWasted;
+            m_Stats.AllocationCount = marker.AllocationCount;
+        }
+
+        // Frees every allocation, keeping at most one chunk around for reuse
+        inline void Reset() {
+            Rewind(Marker{});
+        }
+
+        inline const AllocatorStats& GetStats() const { return m_Stats; }
+
+    private:
+        inline static size_t GetPadding(Chunk* chunk, size_t alignment) {
+            uintptr_t address = reinterpret_cast<uintptr_t>(chunk->GetData() + chunk->Offset);
+            return (alignment - (address & (alignment - 1))) & (alignment - 1);
+        }
+
+        inline void AddChunk(size_t minimumSize) {
+            if (m_ActiveChunk) {
+                // Whatever is left in the current chunk can never be used again
+                m_Stats.BytesWasted += m_ActiveChunk->Capacity - m_ActiveChunk->Offset;
+            }
+
+            size_t capacity = m_NextChunkSize;
+            while (capacity < minimumSize) {
+                capacity *= 2;
+            }
+
+            m_NextChunkSize = (m_NextChunkSize * 2 > MaxChunkSize) ? MaxChunkSize : m_NextChunkSize * 2;
+
+            Chunk* chunk = nullptr;
+            if (m_SpareChunk && m_SpareChunk->Capacity >= capacity) {
+                chunk = m_SpareChunk;
+                m_SpareChunk = nullptr;
+            } else {
+                chunk = reinterpret_cast<Chunk*>(::operator new(sizeof(Chunk) + capacity));
+                chunk->Capacity = capacity;
+            }
+
+            chunk->Previous = m_ActiveChunk;
+            chunk->Offset = 0;
+            m_ActiveChunk = chunk;
+
+            m_Stats.BytesReserved += chunk->Capacity;
+            m_Stats.ChunkCount++;
+        }
+
+        // Frees every chunk allocated after "last" (pass nullptr to free all of them)
+        // The biggest freed chunk gets kept as a spare so rewinding in a loop does not hit the system allocator
+        inline void FreeChunks(Chunk* last) {
+            while (m_ActiveChunk && m_ActiveChunk != last) {
+                Chunk* chunk = m_ActiveChunk;
+                m_ActiveChunk = chunk->Previous;
+
+                m_Stats.BytesReserved -= chunk->Capacity;
+                m_Stats.ChunkCount--;
+
+                if (!m_SpareChunk || m_SpareChunk->Capacity < chunk->Capacity) {
+                    std::swap(chunk, m_SpareChunk);
+                }
+
+                if (chunk) {
+                    ::operator delete(chunk);
+                }
+            }
+        }
+
+    private:
+        Chunk* m_ActiveChunk = nullptr;
+        Chunk* m_SpareChunk = nullptr;
+        size_t m_NextChunkSize = MinChunkSize;
+
+        AllocatorStats m_Stats;
+    };
+
+    // Rewinds the allocator once it goes out of scope
+    // Useful for temporary data which is only needed during a single step of compilation
+    class AllocatorScope {
+    public:
+        inline explicit AllocatorScope(Allocator* allocator)
+            : m_Allocator(allocator), m_Marker(allocator->GetMarker()) {}
+
+        inline ~AllocatorScope() { m_Allocator->Rewind(m_Marker); }
+
+        AllocatorScope(const AllocatorScope& other) = delete;
+        void operator=(const AllocatorScope& other) = delete;
+
     private:
-        uint8_t* m_Data = nullptr;
-        size_t m_Capacity = 0;
-        size_t m_Index = 0;
+        Allocator* m_Allocator = nullptr;
+        Allocator::Marker m_Marker;
     };
 
 } // namespace Aria
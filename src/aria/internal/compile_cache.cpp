@@ -0,0 +1,149 @@
+#include "aria/internal/compile_cache.hpp"
+#include "aria/internal/vm/bytecode_image.hpp"
+#include "aria/core.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace Aria::Internal {
+
+    // Two unrelated 64 bit hashes, together they make an accidental collision (and loading the wrong module) practically impossible
+    inline static u64 HashFNV1a(const u8* data, size_t size, u64 hash) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    inline static u64 HashMix(const u8* data, size_t size, u64 hash) {
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ data[i]) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        }
+
+        // Murmur3 finalizer
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ull;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    CompileCache::CompileCache(const std::string& directory, size_t maxBytes)
+        : m_Directory(directory), m_MaxBytes(maxBytes) {
+        std::error_code ec;
+        fs::create_directories(m_Directory, ec);
+    }
+
+    std::string CompileCache::GetKey(const std::string& source, u64 flags) const {
+        std::string header = fmt::format("{}|{}|{}|{}|", ARIA_VERSION, BytecodeImageVersion, flags, source.size());
+
+        u64 a = 14695981039346656037ull;
+        u64 b = 0x243F6A8885A308D3ull;
+
+        a = HashFNV1a(reinterpret_cast<const u8*>(header.data()), header.size(), a);
+        a = HashFNV1a(reinterpret_cast<const u8*>(source.data()), source.size(), a);
+        b = HashMix(reinterpret_cast<const u8*>(header.data()), header.size(), b);
+        b = HashMix(reinterpret_cast<const u8*>(source.data()), source.size(), b);
+
+        return fmt::format("{:016x}{:016x}", a, b);
+    }
+
+    bool CompileCache::Lookup(const std::string& key, std::string& path) {
+        path = GetPath(key);
+
+        std::error_code ec;
+        if (!fs::is_regular_file(path, ec)) {
+            m_Misses++;
+            return false;
+        }
+
+        // Mark the entry as recently used
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+
+        m_Hits++;
+        return true;
+    }
+
+    void CompileCache::Store(const std::string& key, const std::vector<u8>& image) {
+        std::string path = GetPath(key);
+        std::string tempPath = fmt::format("{}.{}.{}.tmp", path, std::hash<std::thread::id>{}(std::this_thread::get_id()), m_TempCounter++);
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) { return; }
+
+            file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+            if (!file.good()) {
+                file.close();
+
+                std::error_code ec;
+                fs::remove(tempPath, ec);
+                return;
+            }
+        }
+
+        // Renaming is atomic, so readers either see the complete image or nothing at all
+        std::error_code ec;
+        fs::rename(tempPath, path, ec);
+        if (ec) {
+            fs::remove(tempPath, ec);
+            return;
+        }
+
+        m_Writes++;
+        Evict(path);
+    }
+
+    std::string CompileCache::GetPath(const std::string& key) const {
+        return (fs::path(m_Directory) / (key + ".ariac")).string();
+    }
+
+    void CompileCache::Evict(const std::string& keep) {
+        std::lock_guard<std::mutex> lock(m_EvictionMutex);
+
+        struct Entry {
+            fs::path Path;
+            fs::file_time_type LastUse;
+            size_t Size = 0;
+        };
+
+        std::vector<Entry> entries;
+        size_t totalSize = 0;
+
+        std::error_code ec;
+        for (const fs::directory_entry& e : fs::directory_iterator(m_Directory, ec)) {
+            if (!e.is_regular_file(ec) || e.path().extension() != ".ariac") { continue; }
+
+            Entry entry;
+            entry.Path = e.path();
+            entry.LastUse = e.last_write_time(ec);
+            entry.Size = static_cast<size_t>(e.file_size(ec));
+
+            totalSize += entry.Size;
+            entries.push_back(entry);
+        }
+
+        if (totalSize <= m_MaxBytes) { return; }
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.LastUse < rhs.LastUse; });
+
+        for (const Entry& e : entries) {
+            if (totalSize <= m_MaxBytes) { break; }
+            if (e.Path == fs::path(keep)) { continue; } // Never evict the entry that was just written
+
+            if (fs::remove(e.Path, ec)) {
+                totalSize -= e.Size;
+                m_Evictions++;
+            }
+        }
+    }
+
+} // namespace Aria::Internal
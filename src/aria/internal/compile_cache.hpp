@@ -0,0 +1,53 @@
+#pragma once
+
+#include "aria/internal/types.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // A content-addressed cache of bytecode images on disk
+    // The key of an entry is a hash of the source code, the compiler version and the compile flags,
+    // so an entry never has to be invalidated, stale ones simply stop being used and eventually get evicted
+    //
+    // The last write time of an entry doubles as its last use time, which makes eviction least recently used
+    // This state lives entirely on disk so multiple processes can share a single cache directory
+    class CompileCache {
+    public:
+        CompileCache(const std::string& directory, size_t maxBytes);
+
+        std::string GetKey(const std::string& source, u64 flags) const;
+
+        // Returns true and the path of the cached image if the key is present
+        bool Lookup(const std::string& key, std::string& path);
+
+        // Atomically stores an image (written to a temporary file which then gets renamed),
+        // then evicts the least recently used entries until the cache fits in its size limit
+        void Store(const std::string& key, const std::vector<u8>& image);
+
+        inline size_t GetHits() const { return m_Hits; }
+        inline size_t GetMisses() const { return m_Misses; }
+        inline size_t GetWrites() const { return m_Writes; }
+        inline size_t GetEvictions() const { return m_Evictions; }
+
+    private:
+        std::string GetPath(const std::string& key) const;
+        void Evict(const std::string& keep);
+
+    private:
+        std::string m_Directory;
+        size_t m_MaxBytes = 0;
+
+        std::atomic<size_t> m_Hits = 0;
+        std::atomic<size_t> m_Misses = 0;
+        std::atomic<size_t> m_Writes = 0;
+        std::atomic<size_t> m_Evictions = 0;
+        std::atomic<size_t> m_TempCounter = 0;
+
+        std::mutex m_EvictionMutex;
+    };
+
+} // namespace Aria::Internal
@@ -36,7 +36,7 @@ namespace Aria::Internal {
         } else if (StringConstantExpr* sc = GetNode<StringConstantExpr>(expr)) {
             m_Output += fmt::format("StringConstantExpr \"{}\" '{}' {}\n", sc->GetValue(), TypeInfoToString(sc->GetResolvedType()), ExprValueTypeToString(sc->GetValueType())); return;
         } else if (DeclRefExpr* declRef = GetNode<DeclRefExpr>(expr)) {
-            m_Output += fmt::format("DeclRefExpr '{}' '{}' {}\n", declRef->GetRawIdentifier(), TypeInfoToString(declRef->GetResolvedType()), ExprValueTypeToString(declRef->GetValueType())); return;
+            m_Output += fmt::format("DeclRefExpr '{}' '{}' {}\n", declRef->GetIdentifier(), TypeInfoToString(declRef->GetResolvedType()), ExprValueTypeToString(declRef->GetValueType())); return;
         } else if (CallExpr* call = GetNode<CallExpr>(expr)) {
             m_Output += fmt::format("CallExpr '{}' {}\n", TypeInfoToString(call->GetResolvedType()), ExprValueTypeToString(call->GetValueType()));
             for (Expr* e : call->GetArguments()) {
@@ -44,6 +44,18 @@ namespace Aria::Internal {
             }
             DumpExpr(call->GetCallee(), indentation + 4);
             return;
+        } else if (MethodCallExpr* method = GetNode<MethodCallExpr>(expr)) {
+            m_Output += fmt::format("MethodCallExpr '{}' <{}> '{}' {}\n", method->GetMethodName(), MethodTypeToString(method->GetMethodType()), TypeInfoToString(method->GetResolvedType()), ExprValueTypeToString(method->GetValueType()));
+            DumpExpr(method->GetBase(), indentation + 4);
+            for (Expr* e : method->GetArguments()) {
+                DumpExpr(e, indentation + 4);
+            }
+            return;
+        } else if (ArraySubscriptExpr* subscript = GetNode<ArraySubscriptExpr>(expr)) {
+            m_Output += fmt::format("ArraySubscriptExpr '{}' {}\n", TypeInfoToString(subscript->GetResolvedType()), ExprValueTypeToString(subscript->GetValueType()));
+            DumpExpr(subscript->GetBase(), indentation + 4);
+            DumpExpr(subscript->GetIndex(), indentation + 4);
+            return;
         } else if (ParenExpr* paren = GetNode<ParenExpr>(expr)) {
             m_Output += fmt::format("ParenExpr '{}' {}\n", TypeInfoToString(paren->GetResolvedType()), ExprValueTypeToString(paren->GetValueType()));
             DumpExpr(paren->GetChildExpr(), indentation + 4);
@@ -85,16 +97,16 @@ namespace Aria::Internal {
             }
             return;
         } else if (VarDecl* varDecl = GetNode<VarDecl>(decl)) {
-            m_Output += fmt::format("VarDecl '{}' '{}'\n", varDecl->GetRawIdentifier(), TypeInfoToString(varDecl->GetResolvedType()));
+            m_Output += fmt::format("VarDecl '{}' '{}'\n", varDecl->GetIdentifier(), TypeInfoToString(varDecl->GetResolvedType()));
             if (varDecl->GetDefaultValue()) {
                 DumpExpr(varDecl->GetDefaultValue(), indentation + 4);
             }
             return;
         } else if (ParamDecl* paramDecl = GetNode<ParamDecl>(decl)) {
-            m_Output += fmt::format("ParamDecl '{}' '{}'\n", paramDecl->GetRawIdentifier(), TypeInfoToString(paramDecl->GetResolvedType()));
+            m_Output += fmt::format("ParamDecl '{}' '{}'\n", paramDecl->GetIdentifier(), TypeInfoToString(paramDecl->GetResolvedType()));
             return;
         } else if (FunctionDecl* fnDecl = GetNode<FunctionDecl>(decl)) {
-            m_Output += fmt::format("FunctionDecl '{}' '{}' {}\n", fnDecl->GetRawIdentifier(), TypeInfoToString(fnDecl->GetResolvedType()), fnDecl->IsExtern() ? "extern" : "");
+            m_Output += fmt::format("FunctionDecl '{}' '{}' {}\n", fnDecl->GetIdentifier(), TypeInfoToString(fnDecl->GetResolvedType()), fnDecl->IsExtern() ? "extern" : "");
             for (Decl* p : fnDecl->GetParameters()) {
                 DumpDecl(p, indentation + 4);
             }
@@ -24,11 +24,11 @@ namespace Aria::Internal {
     };
 
     struct VarDecl final : public Decl {
-        VarDecl(CompilationContext* ctx, StringView identifier, StringView parsedType, Expr* defaultValue)
+        VarDecl(CompilationContext* ctx, SymbolId identifier, StringView parsedType, Expr* defaultValue)
             : Decl(ctx), m_Identifier(identifier), m_ParsedType(parsedType), m_DefaultValue(defaultValue) {}
 
-        inline std::string GetIdentifier() const { return fmt::format("{}", m_Identifier); }
-        inline StringView GetRawIdentifier() const { return m_Identifier; }
+        inline SymbolId GetSymbol() const { return m_Identifier; }
+        inline StringView GetIdentifier() const { return m_Context->GetSymbolTable().GetString(m_Identifier); }
 
         inline StringView GetParsedType() const { return m_ParsedType; }
 
@@ -41,7 +41,7 @@ namespace Aria::Internal {
         inline void SetResolvedType(TypeInfo* type) { m_ResolvedType = type; }
 
     private:
-        StringView m_Identifier;
+        SymbolId m_Identifier = InvalidSymbol;
         StringView m_ParsedType;
         Expr* m_DefaultValue = nullptr;
 
@@ -49,11 +49,11 @@ namespace Aria::Internal {
     };
 
     struct ParamDecl final : public Decl {
-        ParamDecl(CompilationContext* ctx, StringView identifier, StringView parsedType)
+        ParamDecl(CompilationContext* ctx, SymbolId identifier, StringView parsedType)
             : Decl(ctx), m_Identifier(identifier), m_ParsedType(parsedType) {}
 
-        inline std::string GetIdentifier() const { return fmt::format("{}", m_Identifier); }
-        inline StringView GetRawIdentifier() const { return m_Identifier; }
+        inline SymbolId GetSymbol() const { return m_Identifier; }
+        inline StringView GetIdentifier() const { return m_Context->GetSymbolTable().GetString(m_Identifier); }
 
         inline StringView GetParsedType() const { return m_ParsedType; }
 
@@ -62,18 +62,18 @@ namespace Aria::Internal {
         inline void SetResolvedType(TypeInfo* type) { m_ResolvedType = type; }
 
     private:
-        StringView m_Identifier;
+        SymbolId m_Identifier = InvalidSymbol;
         StringView m_ParsedType;
 
         TypeInfo* m_ResolvedType = nullptr;
     };
 
     struct FunctionDecl final : public Decl {
-        FunctionDecl(CompilationContext* ctx, StringView identifier, StringView parsedType, TinyVector<ParamDecl*> params, bool external, CompoundStmt* body)
+        FunctionDecl(CompilationContext* ctx, SymbolId identifier, StringView parsedType, TinyVector<ParamDecl*> params, bool external, CompoundStmt* body)
             : Decl(ctx), m_Identifier(identifier), m_ParsedType(parsedType), m_Parameters(params), m_Extern(external), m_Body(body) {}
 
-        inline std::string GetIdentifier() const { return fmt::format("{}", m_Identifier); }
-        inline StringView GetRawIdentifier() const { return m_Identifier; }
+        inline SymbolId GetSymbol() const { return m_Identifier; }
+        inline StringView GetIdentifier() const { return m_Context->GetSymbolTable().GetString(m_Identifier); }
 
         inline StringView GetParsedType() const { return m_ParsedType; }
 
@@ -88,7 +88,7 @@ namespace Aria::Internal {
         inline void SetResolvedType(TypeInfo* type) { m_ResolvedType = type; }
 
     private:
-        StringView m_Identifier;
+        SymbolId m_Identifier = InvalidSymbol;
         StringView m_ParsedType;
         TinyVector<ParamDecl*> m_Parameters;
         bool m_Extern = false;
@@ -99,42 +99,42 @@ namespace Aria::Internal {
     };
 
     struct StructDecl final : public Decl {
-        StructDecl(CompilationContext* ctx, StringView identifier, TinyVector<Decl> fields)
+        StructDecl(CompilationContext* ctx, SymbolId identifier, TinyVector<Decl> fields)
             : Decl(ctx), m_Identifier(identifier), m_Fields(fields) {}
 
-        inline std::string GetIdentifier() const { return fmt::format("{}", m_Identifier); }
-        inline StringView GetRawIdentifier() const { return m_Identifier; }
+        inline SymbolId GetSymbol() const { return m_Identifier; }
+        inline StringView GetIdentifier() const { return m_Context->GetSymbolTable().GetString(m_Identifier); }
 
         inline TinyVector<Decl> GetFields() const { return m_Fields; }
 
     private:
-        StringView m_Identifier;
+        SymbolId m_Identifier = InvalidSymbol;
         TinyVector<Decl> m_Fields;
     };
 
     struct FieldDecl final : public Decl {
-        FieldDecl(CompilationContext* ctx, StringView identifier)
+        FieldDecl(CompilationContext* ctx, SymbolId identifier)
             : Decl(ctx), m_Identifier(identifier) {}
 
-        inline std::string GetIdentifier() const { return fmt::format("{}", m_Identifier); }
-        inline StringView GetRawIdentifier() const { return m_Identifier; }
+        inline SymbolId GetSymbol() const { return m_Identifier; }
+        inline StringView GetIdentifier() const { return m_Context->GetSymbolTable().GetString(m_Identifier); }
 
         inline TypeInfo* GetResolvedType() { return m_ResolvedType; }
         inline const TypeInfo* GetResolvedType() const { return m_ResolvedType; }
         inline void SetResolvedType(TypeInfo* type) { m_ResolvedType = type; }
 
     private:
-        StringView m_Identifier;
+        SymbolId m_Identifier = InvalidSymbol;
         
         TypeInfo* m_ResolvedType = nullptr;
     };
 
     struct MethodDecl final : public Decl {
-        MethodDecl(CompilationContext* ctx, StringView identifier, TinyVector<ParamDecl> parameters)
+        MethodDecl(CompilationContext* ctx, SymbolId identifier, TinyVector<ParamDecl> parameters)
             : Decl(ctx), m_Identifier(identifier), m_Parameters(parameters) {}
 
-        inline std::string GetIdentifier() const { return fmt::format("{}", m_Identifier); }
-        inline StringView GetRawIdentifier() const { return m_Identifier; }
+        inline SymbolId GetSymbol() const { return m_Identifier; }
+        inline StringView GetIdentifier() const { return m_Context->GetSymbolTable().GetString(m_Identifier); }
 
         inline TinyVector<ParamDecl> GetParameters() const { return m_Parameters; }
 
@@ -143,7 +143,7 @@ namespace Aria::Internal {
         inline void SetResolvedType(TypeInfo* type) { m_ResolvedType = type; }
 
     private:
-        StringView m_Identifier;
+        SymbolId m_Identifier = InvalidSymbol;
         TinyVector<ParamDecl> m_Parameters;
 
         TypeInfo* m_ResolvedType = nullptr;
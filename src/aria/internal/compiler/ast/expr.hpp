@@ -11,6 +11,8 @@
 
 namespace Aria::Internal {
 
+    struct Decl;
+
 #pragma region DeclRefType
 
     enum class DeclRefType {
@@ -141,6 +143,41 @@ namespace Aria::Internal {
 
 #pragma endregion
 
+#pragma region MethodType
+
+    // The built in methods, resolved by the semantic analyzer
+    enum class MethodType {
+        Invalid,
+
+        ArrayAppend,
+        ArrayLength,
+        ArrayReserve,
+        ArrayShrinkToFit,
+        ArrayClear,
+
+        StringLength,
+        StringHash
+    };
+
+    inline const char* MethodTypeToString(MethodType type) {
+        switch (type) {
+            case MethodType::Invalid: return "Invalid";
+
+            case MethodType::ArrayAppend: return "ArrayAppend";
+            case MethodType::ArrayLength: return "ArrayLength";
+            case MethodType::ArrayReserve: return "ArrayReserve";
+            case MethodType::ArrayShrinkToFit: return "ArrayShrinkToFit";
+            case MethodType::ArrayClear: return "ArrayClear";
+
+            case MethodType::StringLength: return "StringLength";
+            case MethodType::StringHash: return "StringHash";
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+#pragma endregion
+
 #pragma region ExprValueType
 
     enum class ExprValueType {
@@ -243,8 +280,8 @@ namespace Aria::Internal {
 
         inline StringView GetValue() const { return m_Value; }
 
-        inline virtual TypeInfo* GetResolvedType() override { return TypeInfo::Create(m_Context, PrimitiveType::StringLiteral, m_Value.Size()); }
-        inline virtual const TypeInfo* GetResolvedType() const override { return TypeInfo::Create(m_Context, PrimitiveType::StringLiteral, m_Value.Size()); }
+        inline virtual TypeInfo* GetResolvedType() override { return TypeInfo::Create(m_Context, PrimitiveType::String); }
+        inline virtual const TypeInfo* GetResolvedType() const override { return TypeInfo::Create(m_Context, PrimitiveType::String); }
 
         inline virtual ExprValueType GetValueType() const override { return ExprValueType::RValue; }
 
@@ -253,15 +290,20 @@ namespace Aria::Internal {
     };
 
     struct DeclRefExpr final : public Expr {
-        DeclRefExpr(CompilationContext* ctx, StringView identifier)
+        DeclRefExpr(CompilationContext* ctx, SymbolId identifier)
             : Expr(ctx), m_Identifier(identifier) {}
 
-        inline std::string GetIdentifier() const { return fmt::format("{}", m_Identifier); }
-        inline StringView GetRawIdentifier() const { return m_Identifier; }
+        inline SymbolId GetSymbol() const { return m_Identifier; }
+        inline StringView GetIdentifier() const { return m_Context->GetSymbolTable().GetString(m_Identifier); }
 
         inline DeclRefType GetType() const { return m_Type; }
         inline void SetType(DeclRefType type) { m_Type = type; }
 
+        // The declaration this expression refers to, set by the semantic analyzer
+        inline Decl* GetReferencedDecl() { return m_ReferencedDecl; }
+        inline const Decl* GetReferencedDecl() const { return m_ReferencedDecl; }
+        inline void SetReferencedDecl(Decl* decl) { m_ReferencedDecl = decl; }
+
         inline virtual TypeInfo* GetResolvedType() override { return m_ResolvedType; }
         inline virtual const TypeInfo* GetResolvedType() const override { return m_ResolvedType; }
         inline void SetResolvedType(TypeInfo* type) { m_ResolvedType = type; }
@@ -269,9 +311,10 @@ namespace Aria::Internal {
         inline virtual ExprValueType GetValueType() const override { return ExprValueType::LValue; }
 
     private:
-        StringView m_Identifier;
+        SymbolId m_Identifier = InvalidSymbol;
 
         DeclRefType m_Type = DeclRefType::LocalVar;
+        Decl* m_ReferencedDecl = nullptr;
         TypeInfo* m_ResolvedType = nullptr;
     };
 
@@ -316,6 +359,67 @@ namespace Aria::Internal {
         TypeInfo* m_ResolvedType = nullptr;
     };
     
+    // MethodCallExpr
+    // A call to one of the methods built into a type, there are no user defined methods yet
+    // eg. arr.Append(5)
+    struct MethodCallExpr final : public Expr {
+        MethodCallExpr(CompilationContext* ctx, Expr* base, SymbolId method, TinyVector<Expr*> args)
+            : Expr(ctx), m_Base(base), m_Method(method), m_Arguments(args) {}
+
+        inline Expr* GetBase() { return m_Base; }
+        inline const Expr* GetBase() const { return m_Base; }
+
+        inline SymbolId GetMethod() const { return m_Method; }
+        inline StringView GetMethodName() const { return m_Context->GetSymbolTable().GetString(m_Method); }
+
+        inline TinyVector<Expr*> GetArguments() const { return m_Arguments; }
+        inline void SetArgument(size_t index, Expr* expr) { m_Arguments.Items[index] = expr; }
+
+        inline MethodType GetMethodType() const { return m_MethodType; }
+        inline void SetMethodType(MethodType type) { m_MethodType = type; }
+
+        inline virtual TypeInfo* GetResolvedType() override { return m_ResolvedType; }
+        inline virtual const TypeInfo* GetResolvedType() const override { return m_ResolvedType; }
+        inline void SetResolvedType(TypeInfo* type) { m_ResolvedType = type; }
+
+        inline virtual ExprValueType GetValueType() const override { return ExprValueType::RValue; }
+
+    private:
+        Expr* m_Base = nullptr;
+        SymbolId m_Method = InvalidSymbol;
+        TinyVector<Expr*> m_Arguments;
+
+        MethodType m_MethodType = MethodType::Invalid;
+        TypeInfo* m_ResolvedType = nullptr;
+    };
+
+    // ArraySubscriptExpr
+    // An element of an array, the index always gets converted to an int
+    // eg. arr[5]
+    struct ArraySubscriptExpr final : public Expr {
+        ArraySubscriptExpr(CompilationContext* ctx, Expr* base, Expr* index)
+            : Expr(ctx), m_Base(base), m_Index(index) {}
+
+        inline Expr* GetBase() { return m_Base; }
+        inline const Expr* GetBase() const { return m_Base; }
+
+        inline Expr* GetIndex() { return m_Index; }
+        inline const Expr* GetIndex() const { return m_Index; }
+        inline void SetIndex(Expr* expr) { m_Index = expr; }
+
+        inline virtual TypeInfo* GetResolvedType() override { return m_ResolvedType; }
+        inline virtual const TypeInfo* GetResolvedType() const override { return m_ResolvedType; }
+        inline void SetResolvedType(TypeInfo* type) { m_ResolvedType = type; }
+
+        inline virtual ExprValueType GetValueType() const override { return ExprValueType::LValue; }
+
+    private:
+        Expr* m_Base = nullptr;
+        Expr* m_Index = nullptr;
+
+        TypeInfo* m_ResolvedType = nullptr;
+    };
+
     // ParenExpr
     // At its core it just wraps an expression
     // These kinds of expressions are usually from the actual source code
@@ -326,6 +430,7 @@ namespace Aria::Internal {
 
         inline Expr* GetChildExpr() { return m_Expression; }
         inline const Expr* GetChildExpr() const { return m_Expression; }
+        inline void SetChildExpr(Expr* expr) { m_Expression = expr; }
 
         inline virtual TypeInfo* GetResolvedType() override { return m_Expression->GetResolvedType(); }
         inline virtual const TypeInfo* GetResolvedType() const override { return m_Expression->GetResolvedType(); }
@@ -346,6 +451,7 @@ namespace Aria::Internal {
 
         inline Expr* GetChildExpr() { return m_Expression; }
         inline const Expr* GetChildExpr() const { return m_Expression; }
+        inline void SetChildExpr(Expr* expr) { m_Expression = expr; }
 
         inline StringView GetParsedType() const { return m_ParsedDestinationType; }
 
@@ -375,6 +481,7 @@ namespace Aria::Internal {
 
         inline Expr* GetChildExpr() { return m_Expression; }
         inline const Expr* GetChildExpr() const { return m_Expression; }
+        inline void SetChildExpr(Expr* expr) { m_Expression = expr; }
 
         inline CastType GetCastType() const { return m_ResolvedCastType; }
         inline void SetCastType(CastType type) { m_ResolvedCastType = type; }
@@ -397,6 +504,7 @@ namespace Aria::Internal {
 
         inline Expr* GetChildExpr() { return m_Expression; }
         inline const Expr* GetChildExpr() const { return m_Expression; }
+        inline void SetChildExpr(Expr* expr) { m_Expression = expr; }
 
         inline UnaryOperatorType GetUnaryOperator() const { return m_Operator; }
 
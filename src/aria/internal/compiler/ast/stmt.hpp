@@ -38,6 +38,7 @@ namespace Aria::Internal {
 
         inline Expr* GetCondition() { return m_Condition; }
         inline const Expr* GetCondition() const { return m_Condition; }
+        inline void SetCondition(Expr* expr) { m_Condition = expr; }
 
         inline Stmt* GetBody() { return m_Body; }
         inline const Stmt* GetBody() const { return m_Body; }
@@ -53,6 +54,7 @@ namespace Aria::Internal {
 
         inline Expr* GetCondition() { return m_Condition; }
         inline const Expr* GetCondition() const { return m_Condition; }
+        inline void SetCondition(Expr* expr) { m_Condition = expr; }
 
         inline Stmt* GetBody() { return m_Body; }
         inline const Stmt* GetBody() const { return m_Body; }
@@ -71,9 +73,11 @@ namespace Aria::Internal {
 
         inline Expr* GetCondition() { return m_Condition; }
         inline const Expr* GetCondition() const { return m_Condition; }
+        inline void SetCondition(Expr* expr) { m_Condition = expr; }
 
         inline Expr* GetEpilogue() { return m_Epilogue; }
         inline const Expr* GetEpilogue() const { return m_Epilogue; }
+        inline void SetEpilogue(Expr* expr) { m_Epilogue = expr; }
 
         inline Stmt* GetBody() { return m_Body; }
         inline const Stmt* GetBody() const { return m_Body; }
@@ -91,6 +95,7 @@ namespace Aria::Internal {
 
         inline Expr* GetCondition() { return m_Condition; }
         inline const Expr* GetCondition() const { return m_Condition; }
+        inline void SetCondition(Expr* expr) { m_Condition = expr; }
 
         inline Stmt* GetBody() { return m_Body; }
         inline const Stmt* GetBody() const { return m_Body; }
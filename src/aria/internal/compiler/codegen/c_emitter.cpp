@@ -0,0 +1,478 @@
+#include "aria/internal/compiler/codegen/c_emitter.hpp"
+#include "aria/internal/vm/native_module.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
+
+#include <bit>
+#include <optional>
+
+namespace Aria::Internal {
+
+    // Has to match the structs in native_module.hpp
+    static constexpr const char* s_Prelude = R"(#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(_WIN32)
+    #define ARIA_EXPORT __declspec(dllexport)
+#else
+    #define ARIA_EXPORT __attribute__((visibility("default")))
+#endif
+
+typedef struct AriaMemRef {
+    int32_t slot;
+    size_t size;
+    size_t offset;
+    const char* global;
+} AriaMemRef;
+
+typedef struct AriaNativeApi {
+    void  (*allocate)(void* vm, size_t size);
+    void  (*push)(void* vm, const void* data, size_t size);
+    void* (*address)(void* vm, const AriaMemRef* ref);
+    void  (*copy)(void* vm, const AriaMemRef* dst, const AriaMemRef* src);
+    void  (*dup)(void* vm, const AriaMemRef* ref);
+    void  (*push_frame)(void* vm);
+    void  (*pop_frame)(void* vm);
+    void  (*pop)(void* vm, int32_t slot);
+    void  (*replace_frame)(void* vm, size_t argCount, size_t retCount);
+    void  (*set_global)(void* vm, const char* name);
+    void  (*call_extern)(void* vm, const char* signature, size_t argCount, size_t retCount);
+} AriaNativeApi;
+
+typedef struct AriaNativeFunction {
+    const char* signature;
+    void (*function)(void* vm);
+} AriaNativeFunction;
+
+ARIA_EXPORT const AriaNativeApi* aria_native_api = 0;
+
+#define ARIA_API aria_native_api
+#define ARIA_REF(ref) (&aria_refs[ref])
+#define ARIA_READ(T, name, ref) T name; memcpy(&name, ARIA_API->address(vm, ARIA_REF(ref)), sizeof(T))
+#define ARIA_PUSH(T, value) do { T aria_value = (T)(value); ARIA_API->push(vm, &aria_value, sizeof(T)); } while (0)
+
+#define ARIA_BINARY(T, expr, lhs, rhs) do { ARIA_READ(T, l, lhs); ARIA_READ(T, r, rhs); ARIA_PUSH(T, expr); } while (0)
+#define ARIA_COMPARE(T, expr, lhs, rhs) do { ARIA_READ(T, l, lhs); ARIA_READ(T, r, rhs); ARIA_PUSH(uint8_t, (expr) ? 1 : 0); } while (0)
+#define ARIA_NEGATE(T, ref) do { ARIA_READ(T, x, ref); ARIA_PUSH(T, -x); } while (0)
+#define ARIA_CAST(S, D, ref) do { ARIA_READ(S, x, ref); ARIA_PUSH(D, x); } while (0)
+#define ARIA_IMM(T, B, name, bits) T name; { B aria_bits = (bits); memcpy(&name, &aria_bits, sizeof(T)); }
+#define ARIA_BINARY_IMM(T, B, expr, lhs, bits) do { ARIA_READ(T, l, lhs); ARIA_IMM(T, B, r, bits); ARIA_PUSH(T, expr); } while (0)
+#define ARIA_COMPARE_IMM(T, B, expr, lhs, bits) do { ARIA_READ(T, l, lhs); ARIA_IMM(T, B, r, bits); ARIA_PUSH(uint8_t, (expr) ? 1 : 0); } while (0)
+#define ARIA_STORE_IMM(B, ref, bits) do { B aria_bits = (bits); memcpy(ARIA_API->address(vm, ARIA_REF(ref)), &aria_bits, sizeof(B)); } while (0)
+#define ARIA_JUMP_IF(value, ref, label) do { ARIA_READ(uint8_t, c, ref); if ((c != 0) == (value)) { goto label; } } while (0)
+#define ARIA_JUMP_COMPARE(T, expr, lhs, rhs, label) do { ARIA_READ(T, l, lhs); ARIA_READ(T, r, rhs); if (expr) { goto label; } } while (0)
+#define ARIA_JUMP_COMPARE_IMM(T, B, expr, lhs, bits, label) do { ARIA_READ(T, l, lhs); ARIA_IMM(T, B, r, bits); if (expr) { goto label; } } while (0)
+
+static inline float aria_mod_f32(float l, float r) {
+    float m = fmodf(l, r);
+    if (m < 0) { m += fabsf(r); }
+    return m;
+}
+
+static inline double aria_mod_f64(double l, double r) {
+    double m = fmod(l, r);
+    if (m < 0) { m += fabs(r); }
+    return m;
+}
+)";
+
+    // In the order of GetVMTypeIndex()
+    static constexpr const char* s_CTypes[] = { "int8_t", "int16_t", "int32_t", "int64_t", "uint8_t", "uint16_t", "uint32_t", "uint64_t", "float", "double" };
+
+    struct CTypedOp {
+        OpCodeType Base;
+        std::optional<OpCodeType> Immediate; // The first op code of the immediate form, if there is one
+        size_t Count;
+        const char* Macro;
+        const char* Expr;
+    };
+
+    static constexpr CTypedOp s_TypedOps[] = {
+        { OpCodeType::AddI8,  OpCodeType::AddImmI8,  10, "ARIA_BINARY",  "l + r"  },
+        { OpCodeType::SubI8,  OpCodeType::SubImmI8,  10, "ARIA_BINARY",  "l - r"  },
+        { OpCodeType::MulI8,  OpCodeType::MulImmI8,  10, "ARIA_BINARY",  "l * r"  },
+        { OpCodeType::DivI8,  OpCodeType::DivImmI8,  10, "ARIA_BINARY",  "l / r"  },
+        { OpCodeType::ModI8,  OpCodeType::ModImmI8,  8,  "ARIA_BINARY",  "l % r"  },
+        { OpCodeType::AndI8,  std::nullopt,          8,  "ARIA_BINARY",  "l & r"  },
+        { OpCodeType::OrI8,   std::nullopt,          8,  "ARIA_BINARY",  "l | r"  },
+        { OpCodeType::XorI8,  std::nullopt,          8,  "ARIA_BINARY",  "l ^ r"  },
+        { OpCodeType::CmpI8,  OpCodeType::CmpImmI8,  10, "ARIA_COMPARE", "l == r" },
+        { OpCodeType::NcmpI8, OpCodeType::NcmpImmI8, 10, "ARIA_COMPARE", "l != r" },
+        { OpCodeType::LtI8,   OpCodeType::LtImmI8,   10, "ARIA_COMPARE", "l < r"  },
+        { OpCodeType::LteI8,  OpCodeType::LteImmI8,  10, "ARIA_COMPARE", "l <= r" },
+        { OpCodeType::GtI8,   OpCodeType::GtImmI8,   10, "ARIA_COMPARE", "l > r"  },
+        { OpCodeType::GteI8,  OpCodeType::GteImmI8,  10, "ARIA_COMPARE", "l >= r" },
+    };
+
+    // Constants are written as unsigned integers of the same size, which keeps floats bit exact
+    static constexpr const char* s_CBitTypes[] = { "uint8_t", "uint16_t", "uint32_t", "uint64_t", "uint8_t", "uint16_t", "uint32_t", "uint64_t", "uint32_t", "uint64_t" };
+
+    // Returns true if type is one of the count op codes starting at base
+    static bool GetTypedIndex(OpCodeType type, OpCodeType base, size_t count, size_t& index) {
+        size_t t = static_cast<size_t>(type);
+        size_t b = static_cast<size_t>(base);
+        if (t < b || t >= b + count) { return false; }
+
+        index = t - b;
+        return true;
+    }
+
+    // The raw bits of a constant as an unsigned C literal of the same width
+    template <typename T>
+    static std::string GetConstantBits(T value) {
+        if constexpr (sizeof(T) == 1) { return fmt::format("0x{:x}u", std::bit_cast<u8>(value)); }
+        else if constexpr (sizeof(T) == 2) { return fmt::format("0x{:x}u", std::bit_cast<u16>(value)); }
+        else if constexpr (sizeof(T) == 4) { return fmt::format("0x{:x}u", std::bit_cast<u32>(value)); }
+        else { return fmt::format("UINT64_C(0x{:x})", std::bit_cast<u64>(value)); }
+    }
+
+    CEmitter::CEmitter(const std::vector<OpCode>* opcodes) {
+        m_OpCodes = opcodes;
+
+        EmitImpl();
+    }
+
+    std::string& CEmitter::GetOutput() {
+        return m_Output;
+    }
+
+    const std::string& CEmitter::GetError() const {
+        return m_Error;
+    }
+
+    void CEmitter::EmitImpl() {
+        const std::vector<OpCode>& opcodes = *m_OpCodes;
+
+        for (size_t i = 0; i < opcodes.size(); i++) {
+            if (opcodes[i].Type != OpCodeType::Function) { continue; }
+
+            Function fn;
+            fn.Signature = std::get<std::string>(opcodes[i].Data);
+            fn.Start = i;
+            fn.Entry = i;
+
+            size_t end = i + 1;
+            for (; end < opcodes.size() && opcodes[end].Type != OpCodeType::Function; end++) {
+                if (opcodes[end].Type != OpCodeType::Label) { continue; }
+
+                const std::string& label = std::get<std::string>(opcodes[end].Data);
+                fn.Labels[label] = end;
+                if (label == "_entry$") { fn.Entry = end; }
+            }
+
+            fn.End = end;
+            m_FunctionIndices[fn.Signature] = m_Functions.size();
+            m_Functions.push_back(std::move(fn));
+        }
+
+        if (!m_FunctionIndices.contains("_start$()")) {
+            m_Error = "Byte code does not contain _start$() function";
+            return;
+        }
+
+        for (size_t i = 0; i < m_Functions.size(); i++) {
+            if (!EmitFunction(i)) { return; }
+        }
+
+        m_Output += "// Generated from Aria byte code, build it into a shared object and load it with Context::LoadNative()\n";
+        m_Output += s_Prelude;
+        m_Output += fmt::format("\nARIA_EXPORT const uint32_t aria_native_api_version = {};\n\n", NativeApiVersion);
+
+        m_Output += "static const AriaMemRef aria_refs[] = {\n";
+        for (const std::string& ref : m_MemRefs) {
+            m_Output += fmt::format("    {},\n", ref);
+        }
+        m_Output += "    { 0, 0, 0, 0 }\n};\n\n";
+
+        for (size_t i = 0; i < m_Functions.size(); i++) {
+            m_Output += fmt::format("static void aria_fn_{}(void* vm);\n", i);
+        }
+
+        m_Output += m_Body;
+
+        m_Output += "\nARIA_EXPORT const AriaNativeFunction aria_native_functions[] = {\n";
+        for (size_t i = 0; i < m_Functions.size(); i++) {
+            const std::string& sig = m_Functions[i].Signature;
+            m_Output += fmt::format("    {{ {}, aria_fn_{} }},\n", EscapeString(sig.data(), sig.size()), i);
+        }
+        m_Output += "    { 0, 0 }\n};\n";
+    }
+
+    bool CEmitter::EmitFunction(size_t index) {
+        const Function& fn = m_Functions[index];
+        const std::vector<OpCode>& opcodes = *m_OpCodes;
+
+        // Only the op codes something jumps to need a label
+        std::vector<bool> targets(fn.End + 1, false);
+        bool selfTailCall = false;
+
+        for (size_t pc = fn.Entry + 1; pc < fn.End; pc++) {
+            const OpCode& op = opcodes[pc];
+
+            if (op.Type == OpCodeType::TailCall) {
+                const MemRef& callee = std::get<OpCodeCall>(op.Data).Function;
+                selfTailCall |= callee.ContainsFunction() && callee.GetFunction().Signature == fn.Signature;
+            }
+
+            if (!IsJumpOpCode(op.Type)) { continue; }
+
+            size_t target = 0;
+            if (!GetJumpIndex(fn, std::get<OpCodeConditionalJump>(op.Data), target)) {
+                m_Error = fmt::format("Unresolved jump in {}", fn.Signature);
+                return false;
+            }
+
+            targets[target] = true;
+        }
+
+        m_Body += fmt::format("\n// {}\nstatic void aria_fn_{}(void* vm) {{\n", fn.Signature, index);
+        if (selfTailCall) { m_Body += "aria_entry:;\n"; }
+
+        for (size_t pc = fn.Entry + 1; pc < fn.End; pc++) {
+            if (targets[pc]) { m_Body += fmt::format("aria_{}:;\n", pc); }
+            if (!EmitOpCode(fn, index, pc)) { return false; }
+        }
+
+        if (targets[fn.End]) { m_Body += fmt::format("aria_{}:;\n", fn.End); }
+        m_Body += "}\n";
+        return true;
+    }
+
+    bool CEmitter::EmitOpCode(const Function& fn, size_t fnIndex, size_t pc) {
+        const OpCode& op = (*m_OpCodes)[pc];
+        size_t t = 0;
+
+        switch (op.Type) {
+            case OpCodeType::Nop:
+            case OpCodeType::Label: return true;
+
+            case OpCodeType::Alloca: {
+                m_Body += fmt::format("    ARIA_API->allocate(vm, {});\n", std::get<OpCodeAlloca>(op.Data).Size);
+                return true;
+            }
+
+            case OpCodeType::Copy: {
+                const OpCodeCopy& copy = std::get<OpCodeCopy>(op.Data);
+                m_Body += fmt::format("    ARIA_API->copy(vm, ARIA_REF({}), ARIA_REF({}));\n", EmitMemRef(copy.DstMem), EmitMemRef(copy.SrcMem));
+                return true;
+            }
+
+            case OpCodeType::Dup: {
+                m_Body += fmt::format("    ARIA_API->dup(vm, ARIA_REF({}));\n", EmitMemRef(std::get<MemRef>(op.Data)));
+                return true;
+            }
+
+            case OpCodeType::PushSF: m_Body += "    ARIA_API->push_frame(vm);\n"; return true;
+            case OpCodeType::PopSF:  m_Body += "    ARIA_API->pop_frame(vm);\n"; return true;
+
+            case OpCodeType::Pop: {
+                m_Body += fmt::format("    ARIA_API->pop(vm, {});\n", std::get<MemRef>(op.Data).GetStackSlot().Slot);
+                return true;
+            }
+
+            case OpCodeType::SetGlobal: {
+                const std::string& name = std::get<OpCodeSetGlobal>(op.Data).Name;
+                m_Body += fmt::format("    ARIA_API->set_global(vm, {});\n", EscapeString(name.data(), name.size()));
+                return true;
+            }
+
+            case OpCodeType::Function: ARIA_UNREACHABLE(); return false;
+
+            case OpCodeType::Jmp: {
+                GetJumpIndex(fn, std::get<OpCodeConditionalJump>(op.Data), t);
+                m_Body += fmt::format("    goto aria_{};\n", t);
+                return true;
+            }
+
+            case OpCodeType::Jt:
+            case OpCodeType::Jf: {
+                const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
+                GetJumpIndex(fn, jump, t);
+                m_Body += fmt::format("    ARIA_JUMP_IF({}, {}, aria_{});\n", op.Type == OpCodeType::Jt ? 1 : 0, EmitMemRef(jump.Mem), t);
+                return true;
+            }
+
+            case OpCodeType::Call:
+            case OpCodeType::TailCall:
+            case OpCodeType::CallExtern: {
+                const OpCodeCall& call = std::get<OpCodeCall>(op.Data);
+                if (!call.Function.ContainsFunction()) {
+                    m_Error = fmt::format("Indirect call in {}", fn.Signature);
+                    return false;
+                }
+
+                const std::string& sig = call.Function.GetFunction().Signature;
+                if (op.Type == OpCodeType::CallExtern) {
+                    m_Body += fmt::format("    ARIA_API->call_extern(vm, {}, {}, {});\n", EscapeString(sig.data(), sig.size()), call.ArgCount, call.RetCount);
+                    return true;
+                }
+
+                auto it = m_FunctionIndices.find(sig);
+                if (it == m_FunctionIndices.end()) {
+                    m_Error = fmt::format("Call to {} which isn't part of the module", sig);
+                    return false;
+                }
+
+                if (op.Type == OpCodeType::Call) {
+                    m_Body += fmt::format("    aria_fn_{}(vm);\n", it->second);
+                    return true;
+                }
+
+                // A tail call to the function itself turns into a loop, any other one relies on the C compiler's sibling call optimization
+                m_Body += fmt::format("    ARIA_API->replace_frame(vm, {}, {});\n", call.ArgCount, call.RetCount);
+                if (it->second == fnIndex) {
+                    m_Body += "    goto aria_entry;\n";
+                } else {
+                    m_Body += fmt::format("    aria_fn_{}(vm);\n    return;\n", it->second);
+                }
+
+                return true;
+            }
+
+            case OpCodeType::Ret: m_Body += "    return;\n"; return true;
+
+            default: break;
+        }
+
+        if (GetTypedIndex(op.Type, OpCodeType::LoadI8, 10, t)) {
+            std::string bits;
+            std::visit([&](auto value) {
+                if constexpr (std::is_arithmetic_v<decltype(value)>) { bits = GetConstantBits(value); }
+            }, std::get<OpCodeLoad>(op.Data).Data);
+
+            m_Body += fmt::format("    ARIA_PUSH({}, {});\n", s_CBitTypes[t], bits);
+            return true;
+        }
+
+        if (op.Type >= OpCodeType::AddImmI8 && op.Type <= OpCodeType::StoreImmF64) {
+            const OpCodeImmediate& m = std::get<OpCodeImmediate>(op.Data);
+            std::string bits = std::visit([](auto value) { return GetConstantBits(value); }, m.Value);
+
+            if (GetTypedIndex(op.Type, OpCodeType::StoreImmI8, 10, t)) {
+                m_Body += fmt::format("    ARIA_STORE_IMM({}, {}, {});\n", s_CBitTypes[t], EmitMemRef(m.Mem), bits);
+                return true;
+            }
+
+            if (GetTypedIndex(op.Type, OpCodeType::ModImmF32, 2, t)) {
+                m_Body += fmt::format("    ARIA_BINARY_IMM({}, {}, aria_mod_{}(l, r), {}, {});\n", s_CTypes[8 + t], s_CBitTypes[8 + t], t == 0 ? "f32" : "f64", EmitMemRef(m.Mem), bits);
+                return true;
+            }
+
+            for (const CTypedOp& typed : s_TypedOps) {
+                if (!typed.Immediate || !GetTypedIndex(op.Type, typed.Immediate.value(), typed.Count, t)) { continue; }
+
+                m_Body += fmt::format("    {}_IMM({}, {}, {}, {}, {});\n", typed.Macro, s_CTypes[t], s_CBitTypes[t], typed.Expr, EmitMemRef(m.Mem), bits);
+                return true;
+            }
+        }
+
+        if (op.Type >= OpCodeType::JcmpI8 && op.Type <= OpCodeType::JgteImmF64) {
+            const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
+            size_t target = 0;
+            GetJumpIndex(fn, jump, target);
+
+            for (const CTypedOp& typed : s_TypedOps) {
+                OpCodeType base = OpCodeType::Nop;
+
+                if (GetCompareJumpOpCode(typed.Base, base) && GetTypedIndex(op.Type, base, typed.Count, t)) {
+                    m_Body += fmt::format("    ARIA_JUMP_COMPARE({}, {}, {}, {}, aria_{});\n", s_CTypes[t], typed.Expr, EmitMemRef(jump.Mem), EmitMemRef(jump.RHSMem), target);
+                    return true;
+                }
+
+                if (typed.Immediate && GetCompareJumpOpCode(typed.Immediate.value(), base) && GetTypedIndex(op.Type, base, typed.Count, t)) {
+                    std::string bits = std::visit([](auto value) { return GetConstantBits(value); }, jump.Value);
+                    m_Body += fmt::format("    ARIA_JUMP_COMPARE_IMM({}, {}, {}, {}, {}, aria_{});\n", s_CTypes[t], s_CBitTypes[t], typed.Expr, EmitMemRef(jump.Mem), bits, target);
+                    return true;
+                }
+            }
+        }
+
+        if (GetTypedIndex(op.Type, OpCodeType::NegateI8, 10, t)) {
+            m_Body += fmt::format("    ARIA_NEGATE({}, {});\n", s_CTypes[t], EmitMemRef(std::get<MemRef>(op.Data)));
+            return true;
+        }
+
+        if (GetTypedIndex(op.Type, OpCodeType::CastI8ToI8, 100, t)) {
+            m_Body += fmt::format("    ARIA_CAST({}, {}, {});\n", s_CTypes[t / 10], s_CTypes[t % 10], EmitMemRef(std::get<OpCodeCast>(op.Data).Mem));
+            return true;
+        }
+
+        if (GetTypedIndex(op.Type, OpCodeType::ModF32, 2, t)) {
+            const OpCodeMath& m = std::get<OpCodeMath>(op.Data);
+            m_Body += fmt::format("    ARIA_BINARY({}, aria_mod_{}(l, r), {}, {});\n", s_CTypes[8 + t], t == 0 ? "f32" : "f64", EmitMemRef(m.LHSMem), EmitMemRef(m.RHSMem));
+            return true;
+        }
+
+        for (const CTypedOp& typed : s_TypedOps) {
+            if (!GetTypedIndex(op.Type, typed.Base, typed.Count, t)) { continue; }
+
+            const OpCodeMath& m = std::get<OpCodeMath>(op.Data);
+            m_Body += fmt::format("    {}({}, {}, {}, {});\n", typed.Macro, s_CTypes[t], typed.Expr, EmitMemRef(m.LHSMem), EmitMemRef(m.RHSMem));
+            return true;
+        }
+
+        m_Error = fmt::format("Op code {} in {} can't be translated", static_cast<size_t>(op.Type), fn.Signature);
+        return false;
+    }
+
+    bool CEmitter::GetJumpIndex(const Function& fn, const OpCodeConditionalJump& jump, size_t& index) {
+        size_t target = jump.Target;
+
+        if (target == SIZE_MAX) {
+            auto it = fn.Labels.find(jump.Label);
+            if (it == fn.Labels.end()) { return false; }
+            target = it->second;
+        }
+
+        // Just like the VM, execution continues right after the target
+        if (target + 1 <= fn.Entry || target + 1 > fn.End) { return false; }
+
+        index = target + 1;
+        return true;
+    }
+
+    std::string CEmitter::EmitMemRef(const MemRef& mem) {
+        std::string ref;
+
+        if (mem.ContainsStackSlot()) {
+            const StackSlotRef& slot = mem.GetStackSlot();
+            ref = fmt::format("{{ {}, {}, {}, 0 }}", slot.Slot, slot.Size, slot.Offset);
+        } else if (mem.ContainsGlobalVar()) {
+            const std::string& name = mem.GetGlobalVar().Name;
+            ref = fmt::format("{{ 0, 0, 0, {} }}", EscapeString(name.data(), name.size()));
+        } else {
+            ARIA_UNREACHABLE();
+        }
+
+        auto it = m_MemRefIndices.find(ref);
+        if (it != m_MemRefIndices.end()) { return std::to_string(it->second); }
+
+        size_t index = m_MemRefs.size();
+        m_MemRefIndices[ref] = index;
+        m_MemRefs.push_back(std::move(ref));
+        return std::to_string(index);
+    }
+
+    std::string CEmitter::EscapeString(const char* data, size_t size) {
+        std::string str = "\"";
+
+        for (size_t i = 0; i < size; i++) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+
+            // Octal escapes always use three digits so a following digit can't become part of them, '?' is escaped because of trigraphs
+            if (c == '"' || c == '\\' || c == '?') {
+                str += '\\';
+                str += static_cast<char>(c);
+            } else if (c >= 0x20 && c < 0x7F) {
+                str += static_cast<char>(c);
+            } else {
+                str += fmt::format("\\{:03o}", c);
+            }
+        }
+
+        str += '"';
+        return str;
+    }
+
+} // namespace Aria::Internal
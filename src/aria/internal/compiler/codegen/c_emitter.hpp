@@ -0,0 +1,56 @@
+#pragma once
+
+#include "aria/internal/vm/op_codes.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Translates the byte code of a whole module into portable C, see Context::EmitC()
+    // Every script function becomes a C function, jumps become gotos and calls between script functions direct calls
+    // The arithmetic is done in C with the semantics of arithmetic.hpp, everything touching the VM stack goes through NativeApi
+    class CEmitter {
+    public:
+        CEmitter(const std::vector<OpCode>* opcodes);
+
+        // Empty if the byte code couldn't be translated, GetError() then says why
+        std::string& GetOutput();
+        const std::string& GetError() const;
+
+    private:
+        struct Function {
+            std::string Signature;
+            size_t Start = 0; // The function op code
+            size_t Entry = 0; // Execution starts right after this
+            size_t End = 0;
+            std::unordered_map<std::string, size_t> Labels;
+        };
+
+        void EmitImpl();
+        bool EmitFunction(size_t index);
+        bool EmitOpCode(const Function& fn, size_t fnIndex, size_t pc);
+
+        // The op code a jump continues at
+        bool GetJumpIndex(const Function& fn, const OpCodeConditionalJump& jump, size_t& index);
+        // The name of the entry in the ref table
+        std::string EmitMemRef(const MemRef& mem);
+
+        static std::string EscapeString(const char* data, size_t size);
+
+    private:
+        const std::vector<OpCode>* m_OpCodes;
+
+        std::vector<Function> m_Functions;
+        std::unordered_map<std::string, size_t> m_FunctionIndices;
+
+        std::vector<std::string> m_MemRefs;
+        std::unordered_map<std::string, size_t> m_MemRefIndices;
+
+        std::string m_Body;
+        std::string m_Output;
+        std::string m_Error;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,177 @@
+#include "aria/internal/compiler/codegen/dead_code_eliminator.hpp"
+
+#include <unordered_map>
+
+namespace Aria::Internal {
+
+    template <typename F>
+    void DeadCodeEliminator::ForEachMemRef(const OpCode& op, F&& fn) {
+        std::visit([&](const auto& data) {
+            using T = std::decay_t<decltype(data)>;
+
+            if constexpr (std::is_same_v<T, MemRef>) {
+                fn(data);
+            } else if constexpr (std::is_same_v<T, OpCodeCopy>) {
+                fn(data.DstMem);
+                fn(data.SrcMem);
+            } else if constexpr (std::is_same_v<T, OpCodeCast> || std::is_same_v<T, OpCodeImmediate>) {
+                fn(data.Mem);
+            } else if constexpr (std::is_same_v<T, OpCodeConditionalJump>) {
+                fn(data.Mem);
+                fn(data.RHSMem);
+            } else if constexpr (std::is_same_v<T, OpCodeCall>) {
+                fn(data.Function);
+            } else if constexpr (std::is_same_v<T, OpCodeMath>) {
+                fn(data.LHSMem);
+                fn(data.RHSMem);
+            } else if constexpr (std::is_same_v<T, OpCodeArray>) {
+                fn(data.Mem);
+                fn(data.IndexMem);
+                fn(data.ValueMem);
+            }
+
+            // SetGlobal doesn't count as a reference to its global, that is what makes unused globals removable
+        }, op.Data);
+    }
+
+    DeadCodeEliminator::DeadCodeEliminator(CompilationContext* ctx, const std::vector<std::string>& entryPoints)
+        : m_Context(ctx), m_EntryPoints(entryPoints) {
+        EliminateImpl();
+    }
+
+    void DeadCodeEliminator::EliminateImpl() {
+        CodeSizeStats stats;
+        stats.OpCodesBefore = m_Context->GetOpCodes().size();
+
+        CollectFunctions();
+        MarkReachable();
+
+        stats.FunctionsBefore = m_Functions.size();
+        stats.GlobalsBefore = m_GlobalCount;
+
+        Rebuild();
+
+        stats.OpCodesAfter = m_Context->GetOpCodes().size();
+        for (const FunctionRange& fn : m_Functions) {
+            if (fn.Reachable) { stats.FunctionsAfter++; }
+        }
+        for (const OpCode& op : m_Context->GetOpCodes()) {
+            if (op.Type == OpCodeType::SetGlobal) { stats.GlobalsAfter++; }
+        }
+
+        m_Context->SetCodeSizeStats(stats);
+    }
+
+    void DeadCodeEliminator::CollectFunctions() {
+        const std::vector<OpCode>& opcodes = m_Context->GetOpCodes();
+
+        for (size_t i = 0; i < opcodes.size(); i++) {
+            const OpCode& op = opcodes[i];
+
+            if (op.Type == OpCodeType::Function) {
+                if (!m_Functions.empty()) { m_Functions.back().End = i; }
+
+                m_Functions.push_back({ std::get<std::string>(op.Data), i, opcodes.size() });
+            } else if (op.Type == OpCodeType::SetGlobal) {
+                m_GlobalCount++;
+            }
+        }
+    }
+
+    void DeadCodeEliminator::MarkReachable() {
+        const std::vector<OpCode>& opcodes = m_Context->GetOpCodes();
+
+        std::unordered_map<std::string, size_t> functionIndices;
+        for (size_t i = 0; i < m_Functions.size(); i++) {
+            functionIndices[m_Functions[i].Name] = i;
+        }
+
+        std::vector<size_t> worklist;
+        auto markFunction = [&](const std::string& name) {
+            auto it = functionIndices.find(name);
+            if (it == functionIndices.end() || m_Functions[it->second].Reachable) { return; }
+
+            m_Functions[it->second].Reachable = true;
+            worklist.push_back(it->second);
+        };
+
+        markFunction("_start$()");
+        for (const std::string& entry : m_EntryPoints) {
+            markFunction(entry);
+            m_ReferencedGlobals.insert(entry); // Globals can be entry points too, it doesn't matter if the name is a function
+        }
+
+        while (!worklist.empty()) {
+            const FunctionRange& fn = m_Functions[worklist.back()];
+            worklist.pop_back();
+
+            for (size_t i = fn.Start; i < fn.End; i++) {
+                ForEachMemRef(opcodes[i], [&](const MemRef& mem) {
+                    if (mem.ContainsFunction()) {
+                        markFunction(mem.GetFunction().Signature);
+                    } else if (mem.ContainsGlobalVar()) {
+                        m_ReferencedGlobals.insert(mem.GetGlobalVar().Name);
+                    }
+                });
+            }
+        }
+    }
+
+    void DeadCodeEliminator::Rebuild() {
+        const std::vector<OpCode>& opcodes = m_Context->GetOpCodes();
+
+        std::vector<OpCode> result;
+        result.reserve(opcodes.size());
+
+        for (const FunctionRange& fn : m_Functions) {
+            if (!fn.Reachable) { continue; }
+
+            // For every old op code the index of the last op code that got kept at or before it
+            // Jumping there continues with whatever follows, which is exactly where a dropped label used to point
+            std::vector<size_t> remap(fn.End - fn.Start);
+            std::unordered_map<std::string, size_t> labels;
+            std::vector<size_t> jumps;
+
+            for (size_t i = fn.Start; i < fn.End; i++) {
+                const OpCode& op = opcodes[i];
+
+                bool keep = true;
+                if (op.Type == OpCodeType::Label) {
+                    labels[std::get<std::string>(op.Data)] = i;
+                    keep = false;
+                } else if (op.Type == OpCodeType::Nop) {
+                    keep = false;
+                } else if (op.Type == OpCodeType::SetGlobal) {
+                    keep = m_ReferencedGlobals.contains(std::get<OpCodeSetGlobal>(op.Data).Name);
+                }
+
+                if (keep) {
+                    if (IsJumpOpCode(op.Type)) {
+                        jumps.push_back(result.size());
+                    }
+
+                    result.push_back(op);
+                }
+
+                // The function op code itself is always kept, so there is always an op code to point at
+                remap[i - fn.Start] = result.size() - 1;
+            }
+
+            for (size_t j : jumps) {
+                OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(result[j].Data);
+                size_t target = jump.Target;
+
+                if (target == SIZE_MAX) {
+                    ARIA_ASSERT(labels.contains(jump.Label), "Jump to a label outside of its function!");
+                    target = labels.at(jump.Label);
+                }
+
+                ARIA_ASSERT(target >= fn.Start && target < fn.End, "Jump target outside of its function!");
+                jump.Target = remap[target - fn.Start];
+            }
+        }
+
+        m_Context->SetOpCodes(std::move(result));
+    }
+
+} // namespace Aria::Internal
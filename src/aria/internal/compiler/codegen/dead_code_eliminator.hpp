@@ -0,0 +1,48 @@
+#pragma once
+
+#include "aria/internal/compiler/compilation_context.hpp"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Runs on the emitted byte code of a whole module
+    // Every function that can't be reached from _start$() or one of the entry points gets dropped,
+    // along with the SetGlobal of every global that nothing reachable refers to (the initializer still runs, it might have side effects)
+    // Afterwards all jumps get resolved to op code indices so no Label or Nop has to be dispatched by the VM anymore
+    class DeadCodeEliminator {
+    public:
+        // entryPoints are the function signatures (eg. "Update()") and global names the host needs, on top of _start$()
+        DeadCodeEliminator(CompilationContext* ctx, const std::vector<std::string>& entryPoints);
+
+    private:
+        struct FunctionRange {
+            std::string Name;
+            size_t Start = 0;
+            size_t End = 0; // One past the last op code
+
+            bool Reachable = false;
+        };
+
+        void EliminateImpl();
+
+        void CollectFunctions();
+        void MarkReachable();
+        void Rebuild();
+
+        // Calls fn for every memory reference an op code makes
+        template <typename F>
+        static void ForEachMemRef(const OpCode& op, F&& fn);
+
+    private:
+        CompilationContext* m_Context = nullptr;
+        const std::vector<std::string>& m_EntryPoints;
+
+        std::vector<FunctionRange> m_Functions;
+        std::unordered_set<std::string> m_ReferencedGlobals;
+        size_t m_GlobalCount = 0;
+    };
+
+} // namespace Aria::Internal
@@ -73,6 +73,68 @@ namespace Aria::Internal {
             CASE_BINEXPR(mathop##F32, str, "f32") \
             CASE_BINEXPR(mathop##F64, str, "f64")
 
+        #define CASE_IMMEXPR(_enum, opStr, str) case OpCodeType::_enum: { \
+            const OpCodeImmediate& m = std::get<OpCodeImmediate>(op.Data); \
+            std::string value = std::visit([](auto v) { return fmt::format("{}", v); }, m.Value); \
+            m_Output += fmt::format("{}{}{} {} {}\n", m_Indentation, opStr, str, DisassembleMemRef(m.Mem), value); \
+            break; \
+        }
+
+        #define CASE_IMMEXPR_GROUP(mathop, str) \
+            CASE_IMMEXPR(mathop##I8,  str, "i8") \
+            CASE_IMMEXPR(mathop##I16, str, "i16") \
+            CASE_IMMEXPR(mathop##I32, str, "i32") \
+            CASE_IMMEXPR(mathop##I64, str, "i64") \
+            CASE_IMMEXPR(mathop##U8,  str, "u8") \
+            CASE_IMMEXPR(mathop##U16, str, "u16") \
+            CASE_IMMEXPR(mathop##U32, str, "u32") \
+            CASE_IMMEXPR(mathop##U64, str, "u64") \
+            CASE_IMMEXPR(mathop##F32, str, "f32") \
+            CASE_IMMEXPR(mathop##F64, str, "f64")
+
+        #define CASE_CMPJUMP(_enum, opStr, str) case OpCodeType::_enum: { \
+            const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data); \
+            m_Output += fmt::format("{}{}{} {} {} {}\n", m_Indentation, opStr, str, DisassembleMemRef(jump.Mem), DisassembleMemRef(jump.RHSMem), DisassembleJumpTarget(jump)); \
+            break; \
+        }
+
+        #define CASE_CMPJUMP_IMM(_enum, opStr, str) case OpCodeType::_enum: { \
+            const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data); \
+            std::string value = std::visit([](auto v) { return fmt::format("{}", v); }, jump.Value); \
+            m_Output += fmt::format("{}{}{} {} {} {}\n", m_Indentation, opStr, str, DisassembleMemRef(jump.Mem), value, DisassembleJumpTarget(jump)); \
+            break; \
+        }
+
+        #define CASE_TYPED_GROUP(typedop, macro, str) \
+            macro(typedop##I8,  str, "i8") \
+            macro(typedop##I16, str, "i16") \
+            macro(typedop##I32, str, "i32") \
+            macro(typedop##I64, str, "i64") \
+            macro(typedop##U8,  str, "u8") \
+            macro(typedop##U16, str, "u16") \
+            macro(typedop##U32, str, "u32") \
+            macro(typedop##U64, str, "u64") \
+            macro(typedop##F32, str, "f32") \
+            macro(typedop##F64, str, "f64")
+
+        #define CASE_ARRAYLOAD(_enum, opStr, str) case OpCodeType::_enum: { \
+            const OpCodeArray& arr = std::get<OpCodeArray>(op.Data); \
+            m_Output += fmt::format("{}{}{} {} {}\n", m_Indentation, opStr, str, DisassembleMemRef(arr.Mem), DisassembleMemRef(arr.IndexMem)); \
+            break; \
+        }
+
+        #define CASE_ARRAYSTORE(_enum, opStr, str) case OpCodeType::_enum: { \
+            const OpCodeArray& arr = std::get<OpCodeArray>(op.Data); \
+            m_Output += fmt::format("{}{}{} {} {} {}\n", m_Indentation, opStr, str, DisassembleMemRef(arr.Mem), DisassembleMemRef(arr.IndexMem), DisassembleMemRef(arr.ValueMem)); \
+            break; \
+        }
+
+        #define CASE_ARRAYAPPEND(_enum, opStr, str) case OpCodeType::_enum: { \
+            const OpCodeArray& arr = std::get<OpCodeArray>(op.Data); \
+            m_Output += fmt::format("{}{}{} {} {}\n", m_Indentation, opStr, str, DisassembleMemRef(arr.Mem), DisassembleMemRef(arr.ValueMem)); \
+            break; \
+        }
+
         #define CASE_CAST(_enum, opStr, str) case OpCodeType::_enum: { \
             OpCodeCast c = std::get<OpCodeCast>(op.Data); \
             m_Output += fmt::format("{}cast {} {} {}\n", m_Indentation, opStr, str, DisassembleMemRef(c.Mem)); \
@@ -118,6 +180,11 @@ namespace Aria::Internal {
                 m_Output += fmt::format("{}popsf\n", m_Indentation);
                 break;
             }
+            case OpCodeType::Pop: {
+                MemRef mem = std::get<MemRef>(op.Data);
+                m_Output += fmt::format("{}pop {}\n", m_Indentation, DisassembleMemRef(mem));
+                break;
+            }
 
             case OpCodeType::Copy: {
                 OpCodeCopy c = std::get<OpCodeCopy>(op.Data);
@@ -172,23 +239,23 @@ namespace Aria::Internal {
             }
 
             case OpCodeType::Jmp: {
-                const std::string& name = std::get<std::string>(op.Data);
+                const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
 
-                m_Output += fmt::format("{}jmp {}\n", m_Indentation, name);
+                m_Output += fmt::format("{}jmp {}\n", m_Indentation, DisassembleJumpTarget(jump));
                 break;
             }
 
             case OpCodeType::Jt: {
                 const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
 
-                m_Output += fmt::format("{}jt {}\n", m_Indentation, DisassembleMemRef(jump.Mem), jump.Label);
+                m_Output += fmt::format("{}jt {} {}\n", m_Indentation, DisassembleMemRef(jump.Mem), DisassembleJumpTarget(jump));
                 break;
             }
 
             case OpCodeType::Jf: {
                 const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
 
-                m_Output += fmt::format("{}jf {}\n", m_Indentation, DisassembleMemRef(jump.Mem), jump.Label);
+                m_Output += fmt::format("{}jf {} {}\n", m_Indentation, DisassembleMemRef(jump.Mem), DisassembleJumpTarget(jump));
                 break;
             }
 
@@ -199,6 +266,13 @@ namespace Aria::Internal {
                 break;
             }
 
+            case OpCodeType::TailCall: {
+                const OpCodeCall& call = std::get<OpCodeCall>(op.Data);
+
+                m_Output += fmt::format("{}tailcall {}\n", m_Indentation, DisassembleMemRef(call.Function));
+                break;
+            }
+
             case OpCodeType::CallExtern: {
                 const OpCodeCall& call = std::get<OpCodeCall>(op.Data);
 
@@ -237,16 +311,110 @@ namespace Aria::Internal {
             CASE_CAST_GROUP(U64, "u64");
             CASE_CAST_GROUP(F32, "f32");
             CASE_CAST_GROUP(F64, "f64");
+
+            CASE_IMMEXPR_GROUP(AddImm, "addimm")
+            CASE_IMMEXPR_GROUP(SubImm, "subimm")
+            CASE_IMMEXPR_GROUP(MulImm, "mulimm")
+            CASE_IMMEXPR_GROUP(DivImm, "divimm")
+            CASE_IMMEXPR_GROUP(ModImm, "modimm")
+
+            CASE_IMMEXPR_GROUP(CmpImm, "cmpimm")
+            CASE_IMMEXPR_GROUP(NcmpImm, "ncmpimm")
+            CASE_IMMEXPR_GROUP(LtImm, "ltimm")
+            CASE_IMMEXPR_GROUP(LteImm, "lteimm")
+            CASE_IMMEXPR_GROUP(GtImm, "gtimm")
+            CASE_IMMEXPR_GROUP(GteImm, "gteimm")
+
+            CASE_IMMEXPR_GROUP(StoreImm, "storeimm")
+
+            CASE_TYPED_GROUP(Jcmp, CASE_CMPJUMP, "jcmp")
+            CASE_TYPED_GROUP(Jncmp, CASE_CMPJUMP, "jncmp")
+            CASE_TYPED_GROUP(Jlt, CASE_CMPJUMP, "jlt")
+            CASE_TYPED_GROUP(Jlte, CASE_CMPJUMP, "jlte")
+            CASE_TYPED_GROUP(Jgt, CASE_CMPJUMP, "jgt")
+            CASE_TYPED_GROUP(Jgte, CASE_CMPJUMP, "jgte")
+
+            CASE_TYPED_GROUP(JcmpImm, CASE_CMPJUMP_IMM, "jcmpimm")
+            CASE_TYPED_GROUP(JncmpImm, CASE_CMPJUMP_IMM, "jncmpimm")
+            CASE_TYPED_GROUP(JltImm, CASE_CMPJUMP_IMM, "jltimm")
+            CASE_TYPED_GROUP(JlteImm, CASE_CMPJUMP_IMM, "jlteimm")
+            CASE_TYPED_GROUP(JgtImm, CASE_CMPJUMP_IMM, "jgtimm")
+            CASE_TYPED_GROUP(JgteImm, CASE_CMPJUMP_IMM, "jgteimm")
+
+            case OpCodeType::ArrayNew: {
+                const OpCodeArray& arr = std::get<OpCodeArray>(op.Data);
+                m_Output += fmt::format("{}arraynew {}\n", m_Indentation, arr.ElementSize);
+                break;
+            }
+
+            case OpCodeType::ArrayLength: {
+                const OpCodeArray& arr = std::get<OpCodeArray>(op.Data);
+                m_Output += fmt::format("{}arraylen {}\n", m_Indentation, DisassembleMemRef(arr.Mem));
+                break;
+            }
+
+            case OpCodeType::ArrayReserve: {
+                const OpCodeArray& arr = std::get<OpCodeArray>(op.Data);
+                m_Output += fmt::format("{}arrayreserve {} {}\n", m_Indentation, DisassembleMemRef(arr.Mem), DisassembleMemRef(arr.IndexMem));
+                break;
+            }
+
+            case OpCodeType::ArrayShrinkToFit: {
+                const OpCodeArray& arr = std::get<OpCodeArray>(op.Data);
+                m_Output += fmt::format("{}arrayshrink {}\n", m_Indentation, DisassembleMemRef(arr.Mem));
+                break;
+            }
+
+            case OpCodeType::ArrayClear: {
+                const OpCodeArray& arr = std::get<OpCodeArray>(op.Data);
+                m_Output += fmt::format("{}arrayclear {}\n", m_Indentation, DisassembleMemRef(arr.Mem));
+                break;
+            }
+
+            CASE_BINEXPR(StrConcat, "strconcat", "")
+            CASE_BINEXPR(StrCmp, "strcmp", "")
+            CASE_BINEXPR(StrNcmp, "strncmp", "")
+            CASE_BINEXPR(StrLt, "strlt", "")
+            CASE_BINEXPR(StrLte, "strlte", "")
+            CASE_BINEXPR(StrGt, "strgt", "")
+            CASE_BINEXPR(StrGte, "strgte", "")
+
+            case OpCodeType::StrLength: {
+                m_Output += fmt::format("{}strlen {}\n", m_Indentation, DisassembleMemRef(std::get<OpCodeMath>(op.Data).LHSMem));
+                break;
+            }
+
+            case OpCodeType::StrHash: {
+                m_Output += fmt::format("{}strhash {}\n", m_Indentation, DisassembleMemRef(std::get<OpCodeMath>(op.Data).LHSMem));
+                break;
+            }
+
+            CASE_TYPED_GROUP(ArrayLoad, CASE_ARRAYLOAD, "arrayload")
+            CASE_TYPED_GROUP(ArrayStore, CASE_ARRAYSTORE, "arraystore")
+            CASE_TYPED_GROUP(ArrayAppend, CASE_ARRAYAPPEND, "arrayappend")
         }
 
         #undef CASE_UNARYEXPR
         #undef CASE_UNARYEXPR_GROUP
         #undef CASE_BINEXPR
         #undef CASE_BINEXPR_GROUP
+        #undef CASE_IMMEXPR
+        #undef CASE_IMMEXPR_GROUP
+        #undef CASE_CMPJUMP
+        #undef CASE_CMPJUMP_IMM
+        #undef CASE_TYPED_GROUP
+        #undef CASE_ARRAYLOAD
+        #undef CASE_ARRAYSTORE
+        #undef CASE_ARRAYAPPEND
         #undef CASE_CAST
         #undef CASE_CAST_GROUP
     }
 
+    std::string Disassembler::DisassembleJumpTarget(const OpCodeConditionalJump& jump) {
+        if (jump.Target == SIZE_MAX) { return jump.Label; }
+        return fmt::format("{} (@{})", jump.Label, jump.Target);
+    }
+
     std::string Disassembler::DisassembleMemRef(const MemRef& mem) {
         if (mem.ContainsStackSlot()) {
             StackSlotRef slot = mem.GetStackSlot();
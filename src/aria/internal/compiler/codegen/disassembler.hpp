@@ -17,6 +17,7 @@ namespace Aria::Internal {
         void DisassembleOpCode(const OpCode& op);
 
         std::string DisassembleMemRef(const MemRef& mem);
+        std::string DisassembleJumpTarget(const OpCodeConditionalJump& jump);
 
     private:
         const std::vector<OpCode>* m_OpCodes;
@@ -1,5 +1,6 @@
 #include "aria/internal/compiler/codegen/emitter.hpp"
 #include "aria/internal/compiler/ast/ast.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
 
 namespace Aria::Internal {
 
@@ -10,6 +11,7 @@ namespace Aria::Internal {
     Emitter::Emitter(CompilationContext* ctx) {
         m_Context = ctx;
         m_RootASTNode = ctx->GetRootASTNode();
+        m_Locals.Reset(ctx->GetSymbolTable().Size());
 
         EmitImpl();
     }
@@ -26,7 +28,31 @@ namespace Aria::Internal {
 
         EmitFunctions();
 
-        m_Context->SetOpCodes(m_OpCodes);
+        m_Context->SetOpCodes(std::move(m_OpCodes));
+        m_OpCodes.clear();
+    }
+
+    bool Emitter::EmitLazyFunction(const std::string& signature) {
+        auto it = m_FunctionsToDeclare.find(signature);
+        if (it == m_FunctionsToDeclare.end()) { return false; }
+
+        Decl* decl = it->second;
+        m_FunctionsToDeclare.erase(it);
+
+        EmitFunction(signature, decl);
+
+        std::vector<OpCode>& opcodes = m_Context->GetOpCodes();
+        opcodes.insert(opcodes.end(), std::make_move_iterator(m_OpCodes.begin()), std::make_move_iterator(m_OpCodes.end()));
+        m_OpCodes.clear();
+
+        return true;
+    }
+
+    void Emitter::EmitRemainingFunctions() {
+        while (!m_FunctionsToDeclare.empty()) {
+            std::string signature = m_FunctionsToDeclare.begin()->first;
+            EmitLazyFunction(signature);
+        }
     }
 
     Emitter::CompileMemRef Emitter::EmitBooleanConstantExpr(Expr* expr) {
@@ -91,25 +117,23 @@ namespace Aria::Internal {
         DeclRefExpr* declRef = GetNode<DeclRefExpr>(expr);
 
         if (declRef->GetType() == DeclRefType::LocalVar) {
-            for (size_t i = m_ActiveStackFrame.Scopes.size(); i > 0; i--) {
-                Scope& s = m_ActiveStackFrame.Scopes[i - 1];
-                if (s.DeclaredSymbolMap.contains(declRef->GetIdentifier())) {
-                    Declaration& decl = s.DeclaredSymbols[s.DeclaredSymbolMap.at(declRef->GetIdentifier())];
-                    return CompileMemRef(decl.Mem);
-                }
+            if (Declaration* decl = m_Locals.Find(declRef->GetSymbol())) {
+                return CompileMemRef(decl->Mem);
             }
         } else if (declRef->GetType() == DeclRefType::GlobalVar) {
-            return CompileMemRef(GlobalVarRef(declRef->GetIdentifier()));
+            return CompileMemRef(GlobalVarRef(fmt::format("{}", declRef->GetIdentifier())));
         } else if (declRef->GetType() == DeclRefType::Function) {
-            return CompileMemRef(FunctionRef(fmt::format("{}()", declRef->GetRawIdentifier())));
+            return CompileMemRef(FunctionRef(fmt::format("{}()", declRef->GetIdentifier())));
         }
 
         ARIA_UNREACHABLE();
     }
 
     Emitter::CompileMemRef Emitter::EmitCallExpr(Expr* expr) {
-        CallExpr* call = GetNode<CallExpr>(expr);
+        return EmitCall(GetNode<CallExpr>(expr), false);
+    }
 
+    Emitter::CompileMemRef Emitter::EmitCall(CallExpr* call, bool tail) {
         std::vector<CompileMemRef> args;
         for (Expr* arg : call->GetArguments()) {
             args.push_back(EmitExpr(arg));
@@ -123,14 +147,20 @@ namespace Aria::Internal {
         bool retCount = 0;
         TypeInfo* retType = call->GetResolvedType();
         if (retType->Type != PrimitiveType::Void) {
-            m_OpCodes.emplace_back(OpCodeType::Alloca, OpCodeAlloca(retType->GetSize(), retType));
-            IncrementStackSlotCount();
             retCount = 1;
+
+            // A tail call returns through the return slot of the active function instead
+            if (!tail) {
+                m_OpCodes.emplace_back(OpCodeType::Alloca, OpCodeAlloca(retType->GetSize(), retType));
+                IncrementStackSlotCount();
+            }
         }
 
         CompileMemRef callee = EmitExpr(call->GetCallee());
 
-        if (call->IsExtern()) {
+        if (tail) {
+            m_OpCodes.emplace_back(OpCodeType::TailCall, OpCodeCall(CompileToRuntimeMemRef(callee), args.size(), retCount));
+        } else if (call->IsExtern()) {
             m_OpCodes.emplace_back(OpCodeType::CallExtern, OpCodeCall(CompileToRuntimeMemRef(callee), args.size(), retCount));
         } else {
             m_OpCodes.emplace_back(OpCodeType::Call, OpCodeCall(CompileToRuntimeMemRef(callee), args.size(), retCount));
@@ -138,6 +168,144 @@ namespace Aria::Internal {
         return GetStackTop(retType->GetSize());
     }
 
+    Emitter::CompileMemRef Emitter::EmitMethodCallExpr(Expr* expr) {
+        MethodCallExpr* method = GetNode<MethodCallExpr>(expr);
+        CompileMemRef base = EmitExpr(method->GetBase());
+
+        if (method->GetMethodType() == MethodType::StringLength || method->GetMethodType() == MethodType::StringHash) {
+            OpCodeType type = method->GetMethodType() == MethodType::StringLength ? OpCodeType::StrLength : OpCodeType::StrHash;
+
+            m_OpCodes.emplace_back(type, OpCodeMath(CompileToRuntimeMemRef(base), {}, method->GetResolvedType()));
+            IncrementStackSlotCount();
+            return GetStackTop(method->GetResolvedType()->GetSize());
+        }
+
+        TypeInfo* arrayType = method->GetBase()->GetResolvedType();
+        TypeInfo* elementType = std::get<ArrayDeclaration>(arrayType->Data).Type;
+
+        switch (method->GetMethodType()) {
+            case MethodType::ArrayAppend: {
+                CompileMemRef value = EmitExpr(method->GetArguments().Items[0]);
+                m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::ArrayAppendI8, elementType), OpCodeArray(CompileToRuntimeMemRef(base), {}, CompileToRuntimeMemRef(value), elementType->GetSize(), elementType));
+                return base;
+            }
+
+            case MethodType::ArrayLength: {
+                m_OpCodes.emplace_back(OpCodeType::ArrayLength, OpCodeArray(CompileToRuntimeMemRef(base), {}, {}, elementType->GetSize(), method->GetResolvedType()));
+                IncrementStackSlotCount();
+                return GetStackTop(method->GetResolvedType()->GetSize());
+            }
+
+            case MethodType::ArrayReserve: {
+                CompileMemRef capacity = EmitExpr(method->GetArguments().Items[0]);
+                m_OpCodes.emplace_back(OpCodeType::ArrayReserve, OpCodeArray(CompileToRuntimeMemRef(base), CompileToRuntimeMemRef(capacity), {}, elementType->GetSize(), elementType));
+                return base;
+            }
+
+            case MethodType::ArrayShrinkToFit: {
+                m_OpCodes.emplace_back(OpCodeType::ArrayShrinkToFit, OpCodeArray(CompileToRuntimeMemRef(base), {}, {}, elementType->GetSize(), elementType));
+                return base;
+            }
+
+            case MethodType::ArrayClear: {
+                m_OpCodes.emplace_back(OpCodeType::ArrayClear, OpCodeArray(CompileToRuntimeMemRef(base), {}, {}, elementType->GetSize(), elementType));
+                return base;
+            }
+
+            case MethodType::StringLength:
+            case MethodType::StringHash:
+            case MethodType::Invalid: break;
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+    Emitter::CompileMemRef Emitter::EmitArraySubscriptExpr(Expr* expr) {
+        ArraySubscriptExpr* subscript = GetNode<ArraySubscriptExpr>(expr);
+        TypeInfo* type = subscript->GetResolvedType();
+
+        // Elements live outside of the stack, so unlike other lvalues a subscript always produces a copy of its value
+        m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::ArrayLoadI8, type), EmitArrayElement(subscript));
+        IncrementStackSlotCount();
+        return GetStackTop(type->GetSize());
+    }
+
+    OpCodeArray Emitter::EmitArrayElement(ArraySubscriptExpr* subscript) {
+        CompileMemRef base = EmitExpr(subscript->GetBase());
+        CompileMemRef index = EmitExpr(subscript->GetIndex());
+
+        TypeInfo* type = subscript->GetResolvedType();
+        return OpCodeArray(CompileToRuntimeMemRef(base), CompileToRuntimeMemRef(index), {}, type->GetSize(), type);
+    }
+
+    Emitter::CompileMemRef Emitter::EmitArrayElementAssignment(BinaryOperatorExpr* binop) {
+        ArraySubscriptExpr* subscript = GetNode<ArraySubscriptExpr>(binop->GetLHS());
+        TypeInfo* type = subscript->GetResolvedType();
+
+        OpCodeArray element = EmitArrayElement(subscript);
+        CompileMemRef value;
+
+        if (binop->GetBinaryOperator() == BinaryOperatorType::Eq) {
+            value = EmitExpr(binop->GetRHS());
+        } else {
+            OpCodeType base = OpCodeType::Nop;
+
+            switch (binop->GetBinaryOperator()) {
+                case BinaryOperatorType::AddInPlace: base = OpCodeType::AddI8; break;
+                case BinaryOperatorType::SubInPlace: base = OpCodeType::SubI8; break;
+                case BinaryOperatorType::MulInPlace: base = OpCodeType::MulI8; break;
+                case BinaryOperatorType::DivInPlace: base = OpCodeType::DivI8; break;
+                case BinaryOperatorType::ModInPlace: base = OpCodeType::ModI8; break;
+
+                default: ARIA_UNREACHABLE();
+            }
+
+            m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::ArrayLoadI8, type), element);
+            IncrementStackSlotCount();
+            CompileMemRef current = GetStackTop(type->GetSize());
+
+            CompileMemRef RHS = EmitExpr(binop->GetRHS());
+            m_OpCodes.emplace_back(GetTypedOpCode(base, type), OpCodeMath(CompileToRuntimeMemRef(current), CompileToRuntimeMemRef(RHS)));
+            IncrementStackSlotCount();
+            value = GetStackTop(type->GetSize());
+        }
+
+        element.ValueMem = CompileToRuntimeMemRef(value);
+        m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::ArrayStoreI8, type), element);
+        return value;
+    }
+
+    Emitter::CompileMemRef Emitter::EmitStringBinaryOperator(BinaryOperatorExpr* binop) {
+        OpCodeType type = OpCodeType::Nop;
+
+        switch (binop->GetBinaryOperator()) {
+            case BinaryOperatorType::Add:
+            case BinaryOperatorType::AddInPlace:  type = OpCodeType::StrConcat; break;
+            case BinaryOperatorType::Less:        type = OpCodeType::StrLt; break;
+            case BinaryOperatorType::LessOrEq:    type = OpCodeType::StrLte; break;
+            case BinaryOperatorType::Greater:     type = OpCodeType::StrGt; break;
+            case BinaryOperatorType::GreaterOrEq: type = OpCodeType::StrGte; break;
+            case BinaryOperatorType::IsEq:        type = OpCodeType::StrCmp; break;
+            case BinaryOperatorType::IsNotEq:     type = OpCodeType::StrNcmp; break;
+
+            default: ARIA_UNREACHABLE();
+        }
+
+        CompileMemRef LHS = EmitExpr(binop->GetLHS());
+        CompileMemRef RHS = EmitExpr(binop->GetRHS());
+
+        m_OpCodes.emplace_back(type, OpCodeMath(CompileToRuntimeMemRef(LHS), CompileToRuntimeMemRef(RHS), binop->GetResolvedType()));
+        IncrementStackSlotCount();
+        CompileMemRef result = GetStackTop(binop->GetResolvedType()->GetSize());
+
+        if (binop->GetBinaryOperator() == BinaryOperatorType::AddInPlace) {
+            m_OpCodes.emplace_back(OpCodeType::Copy, OpCodeCopy(CompileToRuntimeMemRef(LHS), CompileToRuntimeMemRef(result)));
+            return LHS;
+        }
+
+        return result;
+    }
+
     Emitter::CompileMemRef Emitter::EmitParenExpr(Expr* expr) {
         ParenExpr* paren = GetNode<ParenExpr>(expr);
         return EmitExpr(paren->GetChildExpr());
@@ -148,48 +316,88 @@ namespace Aria::Internal {
         CompileMemRef child = EmitExpr(cast->GetChildExpr());
 
         // The concept of an lvalue to rvalue cast is essentially to just load whatever value an lvalue holds
-        // Here this is done via a dup
+        // Here this is done via a dup, array elements already got loaded by their subscript
         if (cast->GetCastType() == CastType::LValueToRValue) {
+            if (GetNode<ArraySubscriptExpr>(cast->GetChildExpr())) { return child; }
+
             m_OpCodes.emplace_back(OpCodeType::Dup, CompileToRuntimeMemRef(child));
             IncrementStackSlotCount();
             return GetStackTop(cast->GetResolvedType()->GetSize());
         }
 
-        ARIA_ASSERT(false, "todo");
+        // Every other cast converts between two primitive types, the cast op codes are laid out source type major
+        size_t index = GetVMTypeIndex(cast->GetChildExpr()->GetResolvedType()) * 10 + GetVMTypeIndex(cast->GetResolvedType());
+        OpCodeType type = static_cast<OpCodeType>(static_cast<size_t>(OpCodeType::CastI8ToI8) + index);
+
+        m_OpCodes.emplace_back(type, OpCodeCast(CompileToRuntimeMemRef(child), cast->GetResolvedType()));
+        IncrementStackSlotCount();
+        return GetStackTop(cast->GetResolvedType()->GetSize());
+    }
+
+    Emitter::CompileMemRef Emitter::EmitUnaryOperatorExpr(Expr* expr) {
+        UnaryOperatorExpr* unary = GetNode<UnaryOperatorExpr>(expr);
+        CompileMemRef child = EmitExpr(unary->GetChildExpr());
+
+        // The analyzer only lets negation of numbers through
+        m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::NegateI8, unary->GetResolvedType()), CompileToRuntimeMemRef(child));
+        IncrementStackSlotCount();
+        return GetStackTop(unary->GetResolvedType()->GetSize());
     }
 
     Emitter::CompileMemRef Emitter::EmitBinaryOperatorExpr(Expr* expr) {
         BinaryOperatorExpr* binop = GetNode<BinaryOperatorExpr>(expr);
+
+        // Only assignments keep a subscript as their LHS, every other operator loads it through an lvalue to rvalue cast
+        if (GetNode<ArraySubscriptExpr>(binop->GetLHS())) {
+            return EmitArrayElementAssignment(binop);
+        }
+
+        if (binop->GetLHS()->GetResolvedType()->Type == PrimitiveType::String && binop->GetBinaryOperator() != BinaryOperatorType::Eq) {
+            return EmitStringBinaryOperator(binop);
+        }
+
+        // A constant operand goes straight into the op code instead of being loaded into a slot of its own
+        if (CompileMemRef result; EmitImmediateBinaryOperator(binop, result)) {
+            return result;
+        }
        
-        #define BINOP(baseOp, type, _enum) \
+        // In place operators store the result back into their LHS
+        #define BINOP(baseOp, type, _enum, resultSize, inPlace) \
             if (binop->GetLHS()->GetResolvedType()->Type == PrimitiveType::_enum) { \
                 auto LHS = EmitExpr(binop->GetLHS()); \
                 auto RHS = EmitExpr(binop->GetRHS()); \
                 m_OpCodes.emplace_back(OpCodeType::baseOp##type, OpCodeMath(CompileToRuntimeMemRef(LHS), CompileToRuntimeMemRef(RHS))); \
                 IncrementStackSlotCount(); \
-                return GetStackTop(binop->GetResolvedType()->GetSize()); \
+                if (inPlace) { \
+                    m_OpCodes.emplace_back(OpCodeType::Copy, OpCodeCopy(CompileToRuntimeMemRef(LHS), CompileToRuntimeMemRef(GetStackTop(resultSize)))); \
+                    return LHS; \
+                } \
+                return GetStackTop(resultSize); \
             }
             
-        #define BINOP_GROUP(binExpr, op) case BinaryOperatorType::binExpr: { \
-            if (binop->GetLHS()->GetResolvedType()->IsSigned()) { \
-                BINOP(op, I8, Bool) \
-                BINOP(op, I8, Char) \
-                BINOP(op, I16, Short) \
-                BINOP(op, I32, Int) \
-                BINOP(op, I64, Long) \
+        #define BINOP_GROUP_IMPL(binExpr, op, resultSize, inPlace) case BinaryOperatorType::binExpr: { \
+            if (!binop->GetLHS()->GetResolvedType()->IsIntegral() || binop->GetLHS()->GetResolvedType()->IsSigned()) { \
+                BINOP(op, I8, Bool, resultSize, inPlace) \
+                BINOP(op, I8, Char, resultSize, inPlace) \
+                BINOP(op, I16, Short, resultSize, inPlace) \
+                BINOP(op, I32, Int, resultSize, inPlace) \
+                BINOP(op, I64, Long, resultSize, inPlace) \
             } else { \
-                BINOP(op, U8, Bool) \
-                BINOP(op, U8, Char) \
-                BINOP(op, U16, Short) \
-                BINOP(op, U32, Int) \
-                BINOP(op, U64, Long) \
+                BINOP(op, U8, Bool, resultSize, inPlace) \
+                BINOP(op, U8, Char, resultSize, inPlace) \
+                BINOP(op, U16, Short, resultSize, inPlace) \
+                BINOP(op, U32, Int, resultSize, inPlace) \
+                BINOP(op, U64, Long, resultSize, inPlace) \
             } \
             \
-            BINOP(op, F32, Float) \
-            BINOP(op, F64, Double) \
+            BINOP(op, F32, Float, resultSize, inPlace) \
+            BINOP(op, F64, Double, resultSize, inPlace) \
             break; \
         }
 
+        #define BINOP_GROUP(binExpr, op) BINOP_GROUP_IMPL(binExpr, op, binop->GetResolvedType()->GetSize(), false)
+        #define INPLACE_GROUP(binExpr, op) BINOP_GROUP_IMPL(binExpr##InPlace, op, binop->GetResolvedType()->GetSize(), true)
+
         switch (binop->GetBinaryOperator()) {
             BINOP_GROUP(Add, Add)
             BINOP_GROUP(Sub, Sub)
@@ -197,6 +405,19 @@ namespace Aria::Internal {
             BINOP_GROUP(Div, Div)
             BINOP_GROUP(Mod, Mod)
 
+            INPLACE_GROUP(Add, Add)
+            INPLACE_GROUP(Sub, Sub)
+            INPLACE_GROUP(Mul, Mul)
+            INPLACE_GROUP(Div, Div)
+            INPLACE_GROUP(Mod, Mod)
+
+            BINOP_GROUP(Less, Lt)
+            BINOP_GROUP(LessOrEq, Lte)
+            BINOP_GROUP(Greater, Gt)
+            BINOP_GROUP(GreaterOrEq, Gte)
+            BINOP_GROUP(IsEq, Cmp)
+            BINOP_GROUP(IsNotEq, Ncmp)
+
             case BinaryOperatorType::Eq: {
                 auto LHS = EmitExpr(binop->GetLHS());
                 auto RHS = EmitExpr(binop->GetRHS());
@@ -209,6 +430,87 @@ namespace Aria::Internal {
         ARIA_UNREACHABLE();
     }
 
+    bool Emitter::EmitImmediateBinaryOperator(BinaryOperatorExpr* binop, CompileMemRef& result) {
+        TypeInfo* type = binop->GetLHS()->GetResolvedType();
+        ImmediateValue value;
+
+        if (binop->GetBinaryOperator() == BinaryOperatorType::Eq) {
+            if (!GetImmediate(binop->GetRHS(), type, value)) { return false; }
+
+            result = EmitExpr(binop->GetLHS());
+            m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::StoreImmI8, type), OpCodeImmediate(CompileToRuntimeMemRef(result), value, type));
+            return true;
+        }
+
+        OpCodeType base = OpCodeType::Nop;
+        bool inPlace = false;
+
+        switch (binop->GetBinaryOperator()) {
+            case BinaryOperatorType::Add: base = OpCodeType::AddI8; break;
+            case BinaryOperatorType::Sub: base = OpCodeType::SubI8; break;
+            case BinaryOperatorType::Mul: base = OpCodeType::MulI8; break;
+            case BinaryOperatorType::Div: base = OpCodeType::DivI8; break;
+            case BinaryOperatorType::Mod: base = OpCodeType::ModI8; break;
+
+            case BinaryOperatorType::AddInPlace: base = OpCodeType::AddI8; inPlace = true; break;
+            case BinaryOperatorType::SubInPlace: base = OpCodeType::SubI8; inPlace = true; break;
+            case BinaryOperatorType::MulInPlace: base = OpCodeType::MulI8; inPlace = true; break;
+            case BinaryOperatorType::DivInPlace: base = OpCodeType::DivI8; inPlace = true; break;
+            case BinaryOperatorType::ModInPlace: base = OpCodeType::ModI8; inPlace = true; break;
+
+            case BinaryOperatorType::Less:        base = OpCodeType::LtI8; break;
+            case BinaryOperatorType::LessOrEq:    base = OpCodeType::LteI8; break;
+            case BinaryOperatorType::Greater:     base = OpCodeType::GtI8; break;
+            case BinaryOperatorType::GreaterOrEq: base = OpCodeType::GteI8; break;
+            case BinaryOperatorType::IsEq:        base = OpCodeType::CmpI8; break;
+            case BinaryOperatorType::IsNotEq:     base = OpCodeType::NcmpI8; break;
+
+            default: return false;
+        }
+
+        Expr* operand = binop->GetLHS();
+
+        // With the constant on the left the operands have to be swapped, which only works if the order doesn't matter
+        if (!GetImmediate(binop->GetRHS(), type, value)) {
+            if (inPlace || !GetSwappedOpCode(base, base) || !GetImmediate(binop->GetLHS(), type, value)) { return false; }
+            operand = binop->GetRHS();
+        }
+
+        OpCodeType immediate = OpCodeType::Nop;
+        if (!GetImmediateOpCode(base, immediate)) { return false; }
+
+        size_t resultSize = binop->GetResolvedType()->GetSize();
+
+        CompileMemRef mem = EmitExpr(operand);
+        m_OpCodes.emplace_back(GetTypedOpCode(immediate, type), OpCodeImmediate(CompileToRuntimeMemRef(mem), value, binop->GetResolvedType()));
+        IncrementStackSlotCount();
+
+        if (inPlace) {
+            m_OpCodes.emplace_back(OpCodeType::Copy, OpCodeCopy(CompileToRuntimeMemRef(mem), CompileToRuntimeMemRef(GetStackTop(resultSize))));
+            result = mem;
+            return true;
+        }
+
+        result = GetStackTop(resultSize);
+        return true;
+    }
+
+    bool Emitter::GetImmediate(Expr* expr, const TypeInfo* type, ImmediateValue& value) {
+        if (BooleanConstantExpr* bc = GetNode<BooleanConstantExpr>(expr)) {
+            value = static_cast<i8>(bc->GetValue());
+        } else if (CharacterConstantExpr* cc = GetNode<CharacterConstantExpr>(expr)) {
+            value = cc->GetValue();
+        } else if (IntegerConstantExpr* ic = GetNode<IntegerConstantExpr>(expr)) {
+            std::visit([&value](auto v) { value = v; }, ic->GetValue());
+        } else if (FloatingConstantExpr* fc = GetNode<FloatingConstantExpr>(expr)) {
+            std::visit([&value](auto v) { value = v; }, fc->GetValue());
+        } else {
+            return false;
+        }
+
+        return IsImmediateOfType(value, type);
+    }
+
     Emitter::CompileMemRef Emitter::EmitExpr(Expr* expr) {
         if (GetNode<BooleanConstantExpr>(expr)) {
             return EmitBooleanConstantExpr(expr);
@@ -224,10 +526,16 @@ namespace Aria::Internal {
             return EmitDeclRefExpr(expr);
         } else if (GetNode<CallExpr>(expr)) {
             return EmitCallExpr(expr);
+        } else if (GetNode<MethodCallExpr>(expr)) {
+            return EmitMethodCallExpr(expr);
+        } else if (GetNode<ArraySubscriptExpr>(expr)) {
+            return EmitArraySubscriptExpr(expr);
         } else if (GetNode<ParenExpr>(expr)) {
             return EmitParenExpr(expr);
         } else if (GetNode<ImplicitCastExpr>(expr)) {
             return EmitImplicitCastExpr(expr);
+        } else if (GetNode<UnaryOperatorExpr>(expr)) {
+            return EmitUnaryOperatorExpr(expr);
         } else if (GetNode<BinaryOperatorExpr>(expr)) {
             return EmitBinaryOperatorExpr(expr);
         }
@@ -248,6 +556,14 @@ namespace Aria::Internal {
 
         if (varDecl->GetDefaultValue()) {
             EmitExpr(varDecl->GetDefaultValue());
+        } else if (varDecl->GetResolvedType()->Type == PrimitiveType::Array) {
+            TypeInfo* elementType = std::get<ArrayDeclaration>(varDecl->GetResolvedType()->Data).Type;
+            m_OpCodes.emplace_back(OpCodeType::ArrayNew, OpCodeArray({}, {}, {}, elementType->GetSize(), varDecl->GetResolvedType()));
+            IncrementStackSlotCount();
+        } else if (varDecl->GetResolvedType()->Type == PrimitiveType::String) {
+            // The stack isn't zeroed, so a string without a value starts out as the empty literal
+            m_OpCodes.emplace_back(OpCodeType::LoadStr, OpCodeLoad(StringView(""), varDecl->GetResolvedType()));
+            IncrementStackSlotCount();
         } else {
             m_OpCodes.emplace_back(OpCodeType::Alloca, OpCodeAlloca(varDecl->GetResolvedType()->GetSize(), varDecl->GetResolvedType()));
             IncrementStackSlotCount();
@@ -258,13 +574,12 @@ namespace Aria::Internal {
         d.Type = varDecl->GetResolvedType();
 
         if (IsGlobalScope()) {
-            m_OpCodes.emplace_back(OpCodeType::SetGlobal, OpCodeSetGlobal(varDecl->GetIdentifier()));
+            m_OpCodes.emplace_back(OpCodeType::SetGlobal, OpCodeSetGlobal(fmt::format("{}", varDecl->GetIdentifier())));
 
             m_GlobalScope.DeclaredSymbols.push_back(d);
-            m_GlobalScope.DeclaredSymbolMap[varDecl->GetIdentifier()] = m_GlobalScope.DeclaredSymbols.size() - 1;
         } else {
             m_ActiveStackFrame.Scopes.back().DeclaredSymbols.push_back(d);
-            m_ActiveStackFrame.Scopes.back().DeclaredSymbolMap[varDecl->GetIdentifier()] = m_ActiveStackFrame.Scopes.back().DeclaredSymbols.size() - 1;
+            m_Locals.Declare(varDecl->GetSymbol(), d);
         }
     }
     
@@ -278,7 +593,7 @@ namespace Aria::Internal {
         d.Mem = GetStackTop(paramDecl->GetResolvedType()->GetSize());
         d.Type = paramDecl->GetResolvedType();
         m_ActiveStackFrame.Scopes.back().DeclaredSymbols.push_back(d);
-        m_ActiveStackFrame.Scopes.back().DeclaredSymbolMap[paramDecl->GetIdentifier()] = m_ActiveStackFrame.Scopes.back().DeclaredSymbols.size() - 1;
+        m_Locals.Declare(paramDecl->GetSymbol(), d);
     }
 
     void Emitter::EmitFunctionDecl(Decl* decl) {
@@ -286,7 +601,7 @@ namespace Aria::Internal {
 
         if (fnDecl->IsExtern()) { return; }
 
-        m_FunctionsToDeclare[fmt::format("{}()", fnDecl->GetRawIdentifier())] = decl;
+        m_FunctionsToDeclare[fmt::format("{}()", fnDecl->GetIdentifier())] = decl;
     }
 
     void Emitter::EmitDecl(Decl* decl) {
@@ -312,21 +627,238 @@ namespace Aria::Internal {
         }
     }
 
-    void Emitter::EmitWhileStmt(Stmt* stmt) { ARIA_ASSERT(false, "todo: Emitter::EmitWhileStmt()"); }
-    void Emitter::EmitDoWhileStmt(Stmt* stmt) { ARIA_ASSERT(false, "todo: Emitter::EmitDoWhileStmt()"); }
-    void Emitter::EmitForStmt(Stmt* stmt) { ARIA_ASSERT(false, "todo: Emitter::EmitForStmt()"); }
-    void Emitter::EmitIfStmt(Stmt* stmt) { ARIA_ASSERT(false, "todo: Emitter::EmitIfStmt()"); }
+    void Emitter::EmitWhileStmt(Stmt* stmt) {
+        WhileStmt* wh = GetNode<WhileStmt>(stmt);
+        EmitLoop(wh->GetCondition(), wh->GetBody(), nullptr);
+    }
+
+    void Emitter::EmitDoWhileStmt(Stmt* stmt) {
+        DoWhileStmt* doWh = GetNode<DoWhileStmt>(stmt);
+
+        std::string bodyLabel = CreateLabel("body");
+        size_t height = m_ActiveStackFrame.SlotCount;
+
+        // The body is entered by falling through the first time, so only the jump back needs the condition popped
+        m_OpCodes.emplace_back(OpCodeType::Label, bodyLabel);
+        EmitPop(height);
+
+        EmitStmt(doWh->GetBody());
+
+        EmitConditionalJump(doWh->GetCondition(), true, bodyLabel);
+    }
+
+    void Emitter::EmitForStmt(Stmt* stmt) {
+        ForStmt* fs = GetNode<ForStmt>(stmt);
+
+        // Whatever the prologue declares is only visible inside of the loop
+        PushScope();
+
+        if (fs->GetPrologue()) {
+            EmitStmt(fs->GetPrologue());
+        }
+
+        EmitLoop(fs->GetCondition(), fs->GetBody(), fs->GetEpilogue());
+
+        PopScope();
+    }
+
+    void Emitter::EmitIfStmt(Stmt* stmt) {
+        IfStmt* ifStmt = GetNode<IfStmt>(stmt);
+
+        std::string elseLabel = CreateLabel("else");
+        std::string endLabel = CreateLabel("endif");
+
+        EmitConditionalJump(ifStmt->GetCondition(), false, ifStmt->GetElseBody() ? elseLabel : endLabel);
+        size_t height = m_ActiveStackFrame.SlotCount;
+
+        EmitStmt(ifStmt->GetBody());
+
+        if (ifStmt->GetElseBody()) {
+            m_OpCodes.emplace_back(OpCodeType::Jmp, OpCodeConditionalJump(MemRef(), endLabel));
+
+            // Only the conditional jump gets here, which leaves the stack exactly at the height of the condition
+            m_OpCodes.emplace_back(OpCodeType::Label, elseLabel);
+            m_ActiveStackFrame.SlotCount = height;
+            EmitStmt(ifStmt->GetElseBody());
+        }
+
+        // Both branches leave with whatever they declared still on the stack, which gets dropped so the code after the if has a single stack layout
+        m_OpCodes.emplace_back(OpCodeType::Label, endLabel);
+        EmitPop(height);
+    }
+
+    // Loops are emitted bottom tested, one conditional jump per iteration instead of a conditional jump and a jump back:
+    //     jmp cond
+    //   body:
+    //     <body> <epilogue>
+    //   cond:
+    //     pop <height>
+    //     <condition>
+    //     jt body
+    void Emitter::EmitLoop(Expr* condition, Stmt* body, Expr* epilogue) {
+        std::string bodyLabel = CreateLabel("body");
+        std::string condLabel = CreateLabel("cond");
+        size_t height = m_ActiveStackFrame.SlotCount;
+
+        // Without a condition there is nothing to jump over, the body just jumps back to itself
+        if (!condition) {
+            m_OpCodes.emplace_back(OpCodeType::Label, bodyLabel);
+            EmitPop(height);
+
+            EmitStmt(body);
+            if (epilogue) { EmitExpr(epilogue); }
+
+            m_OpCodes.emplace_back(OpCodeType::Jmp, OpCodeConditionalJump(MemRef(), bodyLabel));
+            return;
+        }
+
+        // The condition gets emitted first, the body starts above the slots it leaves behind
+        // That way the pop before the condition is the only one an iteration runs
+        size_t condStart = m_OpCodes.size();
+
+        m_OpCodes.emplace_back(OpCodeType::Label, condLabel);
+        EmitPop(height);
+
+        EmitConditionalJump(condition, true, bodyLabel);
+
+        std::vector<OpCode> condCode(std::make_move_iterator(m_OpCodes.begin() + condStart), std::make_move_iterator(m_OpCodes.end()));
+        m_OpCodes.resize(condStart);
+
+        size_t bodyHeight = m_ActiveStackFrame.SlotCount;
+
+        m_OpCodes.emplace_back(OpCodeType::Jmp, OpCodeConditionalJump(MemRef(), condLabel));
+        m_OpCodes.emplace_back(OpCodeType::Label, bodyLabel);
+
+        EmitStmt(body);
+        if (epilogue) { EmitExpr(epilogue); }
+
+        m_OpCodes.insert(m_OpCodes.end(), std::make_move_iterator(condCode.begin()), std::make_move_iterator(condCode.end()));
+        m_ActiveStackFrame.SlotCount = bodyHeight;
+    }
+
+    MemRef Emitter::EmitCondition(Expr* condition) {
+        CompileMemRef mem = EmitExpr(condition);
+
+        // Comparisons already produce the single byte conditional jumps test
+        if (BinaryOperatorExpr* binop = GetNode<BinaryOperatorExpr>(condition)) {
+            switch (binop->GetBinaryOperator()) {
+                case BinaryOperatorType::Less:
+                case BinaryOperatorType::LessOrEq:
+                case BinaryOperatorType::Greater:
+                case BinaryOperatorType::GreaterOrEq:
+                case BinaryOperatorType::IsEq:
+                case BinaryOperatorType::IsNotEq:
+                    return CompileToRuntimeMemRef(mem);
+
+                default: break;
+            }
+        }
+
+        TypeInfo* type = condition->GetResolvedType();
+        if (type->GetSize() == 1) { return CompileToRuntimeMemRef(mem); }
+
+        // Everything else is compared against zero
+        OpCodeLoad zero;
+        zero.ResolvedType = type;
+        VisitVMType(type, [&](auto tag) { zero.Data = decltype(tag){}; });
+
+        m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::LoadI8, type), zero);
+        IncrementStackSlotCount();
+        CompileMemRef zeroMem = GetStackTop(type->GetSize());
+
+        m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::NcmpI8, type), OpCodeMath(CompileToRuntimeMemRef(mem), CompileToRuntimeMemRef(zeroMem)));
+        IncrementStackSlotCount();
+        return CompileToRuntimeMemRef(GetStackTop(1));
+    }
+
+    void Emitter::EmitConditionalJump(Expr* condition, bool jumpIfTrue, const std::string& label) {
+        if (EmitCompareJump(condition, jumpIfTrue, label)) { return; }
+
+        MemRef mem = EmitCondition(condition);
+        m_OpCodes.emplace_back(jumpIfTrue ? OpCodeType::Jt : OpCodeType::Jf, OpCodeConditionalJump(mem, label));
+    }
+
+    bool Emitter::EmitCompareJump(Expr* condition, bool jumpIfTrue, const std::string& label) {
+        BinaryOperatorExpr* binop = GetNode<BinaryOperatorExpr>(condition);
+        if (!binop) { return false; }
+
+        OpCodeType base = OpCodeType::Nop;
+
+        switch (binop->GetBinaryOperator()) {
+            case BinaryOperatorType::Less:        base = OpCodeType::LtI8; break;
+            case BinaryOperatorType::LessOrEq:    base = OpCodeType::LteI8; break;
+            case BinaryOperatorType::Greater:     base = OpCodeType::GtI8; break;
+            case BinaryOperatorType::GreaterOrEq: base = OpCodeType::GteI8; break;
+            case BinaryOperatorType::IsEq:        base = OpCodeType::CmpI8; break;
+            case BinaryOperatorType::IsNotEq:     base = OpCodeType::NcmpI8; break;
+
+            default: return false;
+        }
+
+        // Like the comparison itself, the op code is picked from the type of the left hand side
+        TypeInfo* type = binop->GetLHS()->GetResolvedType();
+        if (!VisitVMType(type, [](auto) {})) { return false; }
+
+        // The fused op codes only jump if their comparison holds, a jf jumps on the opposite comparison instead
+        if (!jumpIfTrue && !GetNegatedCompareOpCode(base, type, base)) { return false; }
+
+        OpCodeConditionalJump jump;
+        jump.Label = label;
+
+        Expr* operand = binop->GetLHS();
+        bool immediate = GetImmediate(binop->GetRHS(), type, jump.Value);
+
+        // Every comparison has a mirrored one, so a constant on the left works too
+        if (!immediate && GetImmediate(binop->GetLHS(), type, jump.Value)) {
+            GetSwappedOpCode(base, base);
+            operand = binop->GetRHS();
+            immediate = true;
+        }
+
+        if (immediate) {
+            GetImmediateOpCode(base, base);
+            jump.Mem = CompileToRuntimeMemRef(EmitExpr(operand));
+        } else {
+            jump.Mem = CompileToRuntimeMemRef(EmitExpr(binop->GetLHS()));
+            jump.RHSMem = CompileToRuntimeMemRef(EmitExpr(binop->GetRHS()));
+        }
+
+        GetCompareJumpOpCode(base, base);
+        m_OpCodes.emplace_back(GetTypedOpCode(base, type), jump);
+        return true;
+    }
+
+    void Emitter::EmitPop(size_t slotCount) {
+        m_OpCodes.emplace_back(OpCodeType::Pop, MemRef(StackSlotRef(static_cast<i32>(slotCount), 0)));
+        m_ActiveStackFrame.SlotCount = slotCount;
+    }
 
     void Emitter::EmitReturnStmt(Stmt* stmt) {
         ReturnStmt* ret = GetNode<ReturnStmt>(stmt);
-        if (ret->GetValue()) {
-            CompileMemRef val = EmitExpr(ret->GetValue());
-            MemRef retMem = { StackSlotRef(-(m_ActiveStackFrame.SlotCount + 1), ret->GetValue()->GetResolvedType()->GetSize()) };
 
-            m_OpCodes.emplace_back(OpCodeType::Copy, OpCodeCopy(retMem, CompileToRuntimeMemRef(val)));
+        // Returning what another function returns can just hand the stack frame over to it, which is what keeps deep recursion from growing the stack
+        if (CallExpr* call = GetTailCall(ret->GetValue())) {
+            EmitCall(call, true);
+            return;
+        }
+
+        if (ret->GetValue()) {
+            TypeInfo* type = ret->GetValue()->GetResolvedType();
+            ImmediateValue value;
+
+            // The return slot is addressed from the top of the stack, so it has to be computed after the value got emitted
+            if (GetImmediate(ret->GetValue(), type, value)) {
+                MemRef retMem = { StackSlotRef(-(m_ActiveStackFrame.SlotCount + 1), type->GetSize()) };
+                m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::StoreImmI8, type), OpCodeImmediate(retMem, value, type));
+            } else {
+                CompileMemRef val = EmitExpr(ret->GetValue());
+                MemRef retMem = { StackSlotRef(-(m_ActiveStackFrame.SlotCount + 1), type->GetSize()) };
+                m_OpCodes.emplace_back(OpCodeType::Copy, OpCodeCopy(retMem, CompileToRuntimeMemRef(val)));
+            }
         }
         
-        PopStackFrame();
+        // NOTE: We only emit the pop here, the compile time stack frame must stay alive for any code following the return
+        m_OpCodes.emplace_back(OpCodeType::PopSF);
         m_OpCodes.emplace_back(OpCodeType::Ret);
     }
 
@@ -362,10 +894,32 @@ namespace Aria::Internal {
         ARIA_UNREACHABLE();
     }
 
+    CallExpr* Emitter::GetTailCall(Expr* value) {
+        CallExpr* call = GetNode<CallExpr>(value);
+        if (!call || call->IsExtern() || !m_ActiveStackFrame.Type) { return nullptr; }
+
+        // The callee takes over the argument and return slots the caller of the active function set up, so they have to match exactly
+        const FunctionDeclaration& active = std::get<FunctionDeclaration>(m_ActiveStackFrame.Type->Data);
+        const FunctionDeclaration& callee = std::get<FunctionDeclaration>(call->GetCallee()->GetResolvedType()->Data);
+
+        if (active.ParamTypes.Size != callee.ParamTypes.Size) { return nullptr; }
+        if (active.ReturnType->GetSize() != callee.ReturnType->GetSize()) { return nullptr; }
+
+        for (size_t i = 0; i < active.ParamTypes.Size; i++) {
+            if (active.ParamTypes.Items[i]->GetSize() != callee.ParamTypes.Items[i]->GetSize()) { return nullptr; }
+        }
+
+        return call;
+    }
+
     MemRef Emitter::CompileToRuntimeMemRef(CompileMemRef slot) {
         return slot.Mem;
     }
 
+    std::string Emitter::CreateLabel(const char* name) {
+        return fmt::format("_{}{}$", name, m_LabelCount++);
+    }
+
     bool Emitter::IsStartStackFrame() {
         return m_ActiveStackFrame.Name == "_start$()";
     }
@@ -397,47 +951,63 @@ namespace Aria::Internal {
 
     void Emitter::PushStackFrame(const std::string& name) {
         m_OpCodes.emplace_back(OpCodeType::PushSF);
+        m_ActiveStackFrame.SlotCount = 0;
         m_ActiveStackFrame.Scopes.clear();
         m_ActiveStackFrame.Scopes.emplace_back();
         m_ActiveStackFrame.Name = name;
+        m_ActiveStackFrame.Type = nullptr;
+
+        m_Locals.PopAllScopes();
+        m_Locals.PushScope();
     }
 
     void Emitter::PopStackFrame() {
         m_OpCodes.emplace_back(OpCodeType::PopSF);
         m_ActiveStackFrame.Scopes.clear();
         m_ActiveStackFrame.Name.clear();
+
+        m_Locals.PopAllScopes();
     }
 
     void Emitter::PushScope() {
         m_ActiveStackFrame.Scopes.emplace_back();
+        m_Locals.PushScope();
     }
 
     void Emitter::PopScope() {
         m_ActiveStackFrame.Scopes.pop_back();
+        m_Locals.PopScope();
     }
 
     void Emitter::EmitFunctions() {
+        if (m_Context->IsLazyCodeGen()) { return; } // Functions get emitted by the VM calling EmitLazyFunction()
+
         for (const auto&[name, decl] : m_FunctionsToDeclare) {
-            if (FunctionDecl* fnDecl = GetNode<FunctionDecl>(decl)) {
-                if (fnDecl->GetBody()) {
-                    m_OpCodes.emplace_back(OpCodeType::Function, name);
-                    m_OpCodes.emplace_back(OpCodeType::Label, "_entry$");
-
-                    PushStackFrame(name);
-                    
-                    size_t returnSlot = (fnDecl->GetResolvedType()->Type == PrimitiveType::Void) ? 0 : 1;
-                    
-                    for (ParamDecl* p : fnDecl->GetParameters()) {
-                        int32_t argSlot = -static_cast<int32_t>(fnDecl->GetParameters().Size + returnSlot); // The slot where the argument gets passed from
-                        EmitParamDecl(p, { StackSlotRef(argSlot, p->GetResolvedType()->GetSize()) });
-                    }
-                    
-                    EmitCompoundStmt(fnDecl->GetBody());
-
-                    if (m_OpCodes.back().Type != OpCodeType::Ret) {
-                        PopStackFrame();
-                        m_OpCodes.emplace_back(OpCodeType::Ret);
-                    }
+            EmitFunction(name, decl);
+        }
+    }
+
+    void Emitter::EmitFunction(const std::string& name, Decl* decl) {
+        if (FunctionDecl* fnDecl = GetNode<FunctionDecl>(decl)) {
+            if (fnDecl->GetBody()) {
+                m_OpCodes.emplace_back(OpCodeType::Function, name);
+                m_OpCodes.emplace_back(OpCodeType::Label, "_entry$");
+
+                PushStackFrame(name);
+                m_ActiveStackFrame.Type = fnDecl->GetResolvedType();
+
+                size_t returnSlot = (fnDecl->GetResolvedType()->Type == PrimitiveType::Void) ? 0 : 1;
+                
+                for (ParamDecl* p : fnDecl->GetParameters()) {
+                    int32_t argSlot = -static_cast<int32_t>(fnDecl->GetParameters().Size + returnSlot); // The slot where the argument gets passed from
+                    EmitParamDecl(p, { StackSlotRef(argSlot, p->GetResolvedType()->GetSize()) });
+                }
+                
+                EmitCompoundStmt(fnDecl->GetBody());
+
+                if (m_OpCodes.back().Type != OpCodeType::Ret && m_OpCodes.back().Type != OpCodeType::TailCall) {
+                    PopStackFrame();
+                    m_OpCodes.emplace_back(OpCodeType::Ret);
                 }
             }
         }
@@ -5,6 +5,7 @@
 #include "aria/internal/compiler/ast/decl.hpp"
 #include "aria/internal/vm/vm.hpp"
 #include "aria/internal/compiler/reflection/compiler_reflection.hpp"
+#include "aria/internal/compiler/core/symbol_table.hpp"
 
 namespace Aria::Internal {
 
@@ -28,19 +29,25 @@ namespace Aria::Internal {
         };
 
         struct Scope {
-            std::unordered_map<std::string, size_t> DeclaredSymbolMap;
-            std::vector<Declaration> DeclaredSymbols;
+            std::vector<Declaration> DeclaredSymbols; // In order of declaration, lookups go through m_Locals
         };
 
         struct StackFrame {
             size_t SlotCount = 0;
             std::vector<Scope> Scopes;
             std::string Name;
+            TypeInfo* Type = nullptr; // The type of the function, nullptr for _start$()
         };
 
     public:
         Emitter(CompilationContext* ctx);
 
+        // Only used with lazy code generation, appends the byte code of a function that hasn't been emitted yet to the compilation context
+        // Returns false if there is no such function
+        bool EmitLazyFunction(const std::string& signature);
+        // Emits every function that hasn't been called so far
+        void EmitRemainingFunctions();
+
     private:
         void EmitImpl();
 
@@ -51,6 +58,8 @@ namespace Aria::Internal {
         CompileMemRef EmitStringConstantExpr(Expr* expr);
         CompileMemRef EmitDeclRefExpr(Expr* expr);
         CompileMemRef EmitCallExpr(Expr* expr);
+        CompileMemRef EmitMethodCallExpr(Expr* expr);
+        CompileMemRef EmitArraySubscriptExpr(Expr* expr);
         CompileMemRef EmitParenExpr(Expr* expr);
         CompileMemRef EmitImplicitCastExpr(Expr* expr);
         CompileMemRef EmitCastExpr(Expr* expr);
@@ -58,6 +67,20 @@ namespace Aria::Internal {
         CompileMemRef EmitBinaryOperatorExpr(Expr* expr);
 
         CompileMemRef EmitExpr(Expr* expr);
+        CompileMemRef EmitCall(CallExpr* call, bool tail);
+
+        // Emits the array and the index of a subscript, the element itself stays in the array
+        OpCodeArray EmitArrayElement(ArraySubscriptExpr* subscript);
+        // Assignments (plain and in place) to an array element, those load and store through the array op codes
+        CompileMemRef EmitArrayElementAssignment(BinaryOperatorExpr* binop);
+        // Concatenations and comparisons of strings, plain assignments are copies of the handle like for every other type
+        CompileMemRef EmitStringBinaryOperator(BinaryOperatorExpr* binop);
+
+        // Emits a binary operator with a constant operand using the immediate form of its op code
+        // Returns false if there is no constant operand (or no immediate form), nothing has been emitted then
+        bool EmitImmediateBinaryOperator(BinaryOperatorExpr* binop, CompileMemRef& result);
+        // Returns false if expr isn't a constant of exactly the type the VM uses for type
+        bool GetImmediate(Expr* expr, const TypeInfo* type, ImmediateValue& value);
 
         void EmitTranslationUnitDecl(Decl* decl);
         void EmitVarDecl(Decl* decl);
@@ -73,12 +96,26 @@ namespace Aria::Internal {
         void EmitIfStmt(Stmt* stmt);
         void EmitReturnStmt(Stmt* stmt);
 
+        void EmitLoop(Expr* condition, Stmt* body, Expr* epilogue); // Shared by while and for loops, condition may be nullptr
+        MemRef EmitCondition(Expr* condition); // Returns the single byte jt and jf test
+        // Jumps to label if the condition is (not) met, comparisons become a single fused compare and branch
+        void EmitConditionalJump(Expr* condition, bool jumpIfTrue, const std::string& label);
+        // Returns false if the condition isn't a comparison the VM has a fused op code for, nothing has been emitted then
+        bool EmitCompareJump(Expr* condition, bool jumpIfTrue, const std::string& label);
+        void EmitPop(size_t slotCount); // Drops every stack slot above the first slotCount ones of the active stack frame
+
         void EmitStmt(Stmt* stmt);
 
-        void EmitFunctions(); // Emits all the defined functions
+        void EmitFunctions(); // Emits all the defined functions (unless code generation is lazy)
+        void EmitFunction(const std::string& name, Decl* decl);
 
         MemRef CompileToRuntimeMemRef(CompileMemRef mem);
 
+        // Returns the call if the value returned is a call that can reuse the active stack frame, nullptr otherwise
+        CallExpr* GetTailCall(Expr* value);
+
+        std::string CreateLabel(const char* name); // Labels created by this are unique within the module
+
         bool IsStartStackFrame();
         bool IsGlobalScope();
         void IncrementStackSlotCount();
@@ -100,8 +137,11 @@ namespace Aria::Internal {
 
         StackFrame m_ActiveStackFrame;
         Scope m_GlobalScope;
+        ScopedSymbolMap<Declaration> m_Locals; // The local variables visible in the active stack frame
+
+        size_t m_LabelCount = 0;
 
-        std::unordered_map<std::string, Decl*> m_FunctionsToDeclare; // We do not immediately declare functions, we actually do them last
+        std::unordered_map<std::string, Decl*> m_FunctionsToDeclare; // We do not immediately declare functions, we actually do them last (or on their first call when lazy)
     
         CompilationContext* m_Context = nullptr;
     };
@@ -2,20 +2,156 @@
 #include "aria/internal/compiler/lexer/lexer.hpp"
 #include "aria/internal/compiler/parser/parser.hpp"
 #include "aria/internal/compiler/semantic_analyzer/semantic_analyzer.hpp"
+#include "aria/internal/compiler/optimizer/constant_folder.hpp"
 #include "aria/internal/compiler/codegen/emitter.hpp"
+#include "aria/internal/compiler/codegen/dead_code_eliminator.hpp"
+#include "aria/internal/compiler/ir/ir_builder.hpp"
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+#include "aria/internal/compiler/ir/ir_emitter.hpp"
 
 namespace Aria::Internal {
 
+    // Records how much the arena grew between construction and destruction
+    class CompilationPhaseScope {
+    public:
+        inline CompilationPhaseScope(const char* phase, const Allocator* allocator, std::vector<CompilationPhaseStats>& stats)
+            : m_Phase(phase), m_Allocator(allocator), m_Start(allocator->GetStats()), m_Stats(stats) {}
+
+        inline ~CompilationPhaseScope() {
+            const AllocatorStats& end = m_Allocator->GetStats();
+
+            CompilationPhaseStats s;
+            s.Phase = m_Phase;
+            s.BytesUsed = end.BytesUsed - m_Start.BytesUsed;
+            s.BytesWasted = end.BytesWasted - m_Start.BytesWasted;
+            s.ChunksAdded = end.ChunkCount - m_Start.ChunkCount;
+            s.AllocationCount = end.AllocationCount - m_Start.AllocationCount;
+            m_Stats.push_back(s);
+        }
+
+    private:
+        const char* m_Phase = nullptr;
+        const Allocator* m_Allocator = nullptr;
+        AllocatorStats m_Start;
+        std::vector<CompilationPhaseStats>& m_Stats;
+    };
+
+    CompilationContext::~CompilationContext() {
+        delete m_Emitter;
+        delete m_IRModule;
+        delete m_Allocator;
+    }
+
     void CompilationContext::Compile() {
-        Lex();
-        Parse();
-        Analyze();
-        Emit();
+        m_PhaseStats.clear();
+
+        { CompilationPhaseScope s("Lex", m_Allocator, m_PhaseStats); Lex(); }
+        { CompilationPhaseScope s("Parse", m_Allocator, m_PhaseStats); Parse(); }
+        { CompilationPhaseScope s("Analyze", m_Allocator, m_PhaseStats); Analyze(); }
+
+        // Nothing past the semantic analyzer can deal with an ill-formed AST
+        if (!m_CompilerErrors.empty()) { return; }
+
+        { CompilationPhaseScope s("Optimize", m_Allocator, m_PhaseStats); Optimize(); }
+
+        if (m_SSAOptimization) {
+            { CompilationPhaseScope s("Build IR", m_Allocator, m_PhaseStats); BuildIR(); }
+            { CompilationPhaseScope s("Optimize IR", m_Allocator, m_PhaseStats); OptimizeIR(); }
+            { CompilationPhaseScope s("Emit IR", m_Allocator, m_PhaseStats); EmitIR(); }
+        } else {
+            { CompilationPhaseScope s("Emit", m_Allocator, m_PhaseStats); Emit(); }
+        }
+
+        if (m_CompilerErrors.empty()) {
+            ResolveJumpTargets(0);
+        }
+
+        if (m_DeadCodeElimination && !m_LazyCodeGen && m_CompilerErrors.empty()) {
+            EliminateDeadCode();
+        }
     }
 
     void CompilationContext::Lex() { Lexer l(this); }
     void CompilationContext::Parse() { Parser p(this); }
     void CompilationContext::Analyze() { SemanticAnalyzer s(this); }
-    void CompilationContext::Emit() { Emitter e(this); }
+    void CompilationContext::Optimize() { ConstantFolder f(this); }
+    void CompilationContext::Emit() {
+        if (m_LazyCodeGen) {
+            delete m_Emitter;
+            m_Emitter = new Emitter(this);
+        } else {
+            Emitter e(this);
+        }
+    }
+
+    void CompilationContext::BuildIR() {
+        delete m_IRModule;
+        m_IRModule = new IRModule();
+
+        IRBuilder b(this, m_IRModule);
+    }
+
+    void CompilationContext::OptimizeIR() {
+        IRPassManager pm = IRPassManager::CreateDefault(m_InlineBudget);
+        pm.Run(*m_IRModule);
+    }
+
+    void CompilationContext::EmitIR() { IREmitter e(this, m_IRModule); }
+
+    void CompilationContext::EliminateDeadCode() { DeadCodeEliminator d(this, m_EntryPoints); }
+
+    void CompilationContext::ResolveJumpTargets(size_t start) {
+        std::unordered_map<std::string, size_t> labels;
+        std::vector<size_t> jumps;
+
+        // Labels are only unique within their function
+        auto resolve = [&]() {
+            for (size_t i : jumps) {
+                OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(m_OpCodes[i].Data);
+
+                auto it = labels.find(jump.Label);
+                if (it != labels.end()) { jump.Target = it->second; }
+            }
+
+            labels.clear();
+            jumps.clear();
+        };
+
+        for (size_t i = start; i < m_OpCodes.size(); i++) {
+            const OpCode& op = m_OpCodes[i];
+
+            if (op.Type == OpCodeType::Function) {
+                resolve();
+            } else if (op.Type == OpCodeType::Label) {
+                labels[std::get<std::string>(op.Data)] = i;
+            } else if (IsJumpOpCode(op.Type)) {
+                jumps.push_back(i);
+            }
+        }
+
+        resolve();
+    }
+
+    bool CompilationContext::EmitFunction(const std::string& signature) {
+        if (!m_Emitter) { return false; }
+
+        std::lock_guard<std::mutex> lock(m_CodeGenMutex);
+
+        size_t start = m_OpCodes.size();
+        if (!m_Emitter->EmitLazyFunction(signature)) { return false; }
+
+        ResolveJumpTargets(start);
+        return true;
+    }
+
+    void CompilationContext::EmitRemainingFunctions() {
+        if (!m_Emitter) { return; }
+
+        std::lock_guard<std::mutex> lock(m_CodeGenMutex);
+
+        size_t start = m_OpCodes.size();
+        m_Emitter->EmitRemainingFunctions();
+        ResolveJumpTargets(start);
+    }
 
 } // namespace Aria::Internal
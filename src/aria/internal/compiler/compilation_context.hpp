@@ -5,9 +5,13 @@
 #include "aria/internal/compiler/lexer/tokens.hpp"
 #include "aria/internal/vm/op_codes.hpp"
 
+#include <mutex>
+
 namespace Aria::Internal {
 
     struct Stmt;
+    class Emitter;
+    class IRModule;
 
     struct CompilerError {
         size_t Line = 0; size_t Column = 0;
@@ -16,15 +20,35 @@ namespace Aria::Internal {
         std::string Error;
     };
 
+    // How much the arena grew during a single phase of compilation (lexing, parsing, ...)
+    struct CompilationPhaseStats {
+        const char* Phase = nullptr;
+
+        size_t BytesUsed = 0;
+        size_t BytesWasted = 0;
+        size_t ChunksAdded = 0;
+        size_t AllocationCount = 0;
+    };
+
+    // The size of the byte code before and after dead code elimination
+    struct CodeSizeStats {
+        size_t OpCodesBefore = 0;
+        size_t OpCodesAfter = 0;
+        size_t FunctionsBefore = 0;
+        size_t FunctionsAfter = 0;
+        size_t GlobalsBefore = 0;
+        size_t GlobalsAfter = 0;
+    };
+
     class CompilationContext {
     public:
-        inline CompilationContext(const std::string& source)
-            : m_Allocator(new Allocator(10 * 1024 * 1024)), m_SourceCode(source) {}
+        inline CompilationContext(std::string source)
+            : m_Allocator(new Allocator()), m_SourceCode(std::move(source)) {}
 
         inline CompilationContext(const CompilationContext& other) = delete; // Disallow copying
         inline CompilationContext(const CompilationContext&& other) = delete; // Disallow moving
 
-        inline ~CompilationContext() { delete m_Allocator; }
+        ~CompilationContext();
 
         template <typename T>
         inline T* Allocate() {
@@ -36,10 +60,19 @@ namespace Aria::Internal {
             return m_Allocator->AllocateNamed<T>(std::forward<Args>(args)...);
         }
 
-        inline void* AllocateSized(size_t size) {
-            return m_Allocator->Allocate(size);
+        inline void* AllocateSized(size_t size, size_t alignment = Allocator::DefaultAlignment) {
+            return m_Allocator->Allocate(size, alignment);
         }
 
+        inline void* ReallocateSized(void* ptr, size_t oldSize, size_t newSize, size_t alignment = Allocator::DefaultAlignment) {
+            return m_Allocator->Reallocate(ptr, oldSize, newSize, alignment);
+        }
+
+        inline Allocator* GetAllocator() { return m_Allocator; }
+        inline const Allocator* GetAllocator() const { return m_Allocator; }
+
+        inline const std::vector<CompilationPhaseStats>& GetPhaseStats() const { return m_PhaseStats; }
+
         inline std::string& GetSourceCode() { return m_SourceCode; }
         inline const std::string& GetSourceCode() const { return m_SourceCode; }
 
@@ -47,13 +80,56 @@ namespace Aria::Internal {
         inline const Tokens& GetTokens() const { return m_Tokens; }
         inline void SetTokens(const Tokens& tokens) { m_Tokens = tokens; }
 
+        inline SymbolTable& GetSymbolTable() { return m_SymbolTable; }
+        inline const SymbolTable& GetSymbolTable() const { return m_SymbolTable; }
+
         inline Stmt* GetRootASTNode() { return m_RootASTNode; }
         inline const Stmt* GetRootASTNode() const { return m_RootASTNode; }
         inline void SetRootASTNode(Stmt* node) { m_RootASTNode = node; }
 
         inline std::vector<OpCode>& GetOpCodes() { return m_OpCodes; }
         inline const std::vector<OpCode>& GetOpCodes() const { return m_OpCodes; }
-        inline void SetOpCodes(const std::vector<OpCode>& opcodes) { m_OpCodes = opcodes; }
+        inline void SetOpCodes(std::vector<OpCode> opcodes) { m_OpCodes = std::move(opcodes); }
+
+        // With lazy code generation only _start$() gets emitted by Compile(), every other function is emitted by EmitFunction() once it's needed
+        // Type checking still covers the whole source up front, so compiler errors don't depend on what code runs
+        inline bool IsLazyCodeGen() const { return m_LazyCodeGen; }
+        inline void SetLazyCodeGen(bool lazy) { m_LazyCodeGen = lazy; }
+
+        // Held by EmitFunction() and EmitRemainingFunctions() while they append to the op codes
+        // Anything reading the op codes of a module that may be running on another thread has to hold it too
+        inline std::mutex& GetCodeGenMutex() { return m_CodeGenMutex; }
+
+        // Removes unreachable functions and unused globals after emitting, see DeadCodeEliminator
+        // This does nothing with lazy code generation, which never emits unreachable functions in the first place
+        inline bool IsDeadCodeEliminationEnabled() const { return m_DeadCodeElimination; }
+        inline const std::vector<std::string>& GetEntryPoints() const { return m_EntryPoints; }
+        inline void SetDeadCodeElimination(bool enabled, std::vector<std::string> entryPoints = {}) {
+            m_DeadCodeElimination = enabled;
+            m_EntryPoints = std::move(entryPoints);
+        }
+
+        // Lowers the typed AST into SSA form and runs the IR passes on it (see IRPassManager) instead of emitting byte code straight from the AST
+        // Every function gets emitted up front, even with lazy code generation
+        inline bool IsSSAOptimizationEnabled() const { return m_SSAOptimization; }
+        inline void SetSSAOptimization(bool enabled) { m_SSAOptimization = enabled; }
+
+        // The largest function (in IR instructions) the SSA pipeline inlines, see InlinerPass
+        inline size_t GetInlineBudget() const { return m_InlineBudget; }
+        inline void SetInlineBudget(size_t budget) { m_InlineBudget = budget; }
+
+        // Only valid if the SSA pipeline ran, nullptr otherwise
+        inline IRModule* GetIRModule() { return m_IRModule; }
+        inline const IRModule* GetIRModule() const { return m_IRModule; }
+
+        // Only valid if dead code elimination ran
+        inline const CodeSizeStats& GetCodeSizeStats() const { return m_CodeSizeStats; }
+        inline void SetCodeSizeStats(const CodeSizeStats& stats) { m_CodeSizeStats = stats; }
+
+        // Appends the byte code of a function that hasn't been emitted yet, returns false if there is no such function
+        bool EmitFunction(const std::string& signature);
+        // Emits every function that hasn't been emitted yet, so the op codes contain the whole module
+        void EmitRemainingFunctions();
 
         inline std::vector<CompilerError>& GetCompilerErrors() { return m_CompilerErrors; }
         inline const std::vector<CompilerError>& GetCompilerErrors() const { return m_CompilerErrors; }
@@ -66,6 +142,7 @@ namespace Aria::Internal {
             e.StartColumn = range.Start.Column;
             e.EndLine = range.End.Line;
             e.EndColumn = range.End.Column;
+            e.Error = error;
             m_CompilerErrors.push_back(e);
         }
     
@@ -74,7 +151,15 @@ namespace Aria::Internal {
         void Lex();
         void Parse();
         void Analyze();
+        void Optimize();
         void Emit();
+        void BuildIR();
+        void OptimizeIR();
+        void EmitIR();
+        void EliminateDeadCode();
+
+        // Points every jump emitted from start onwards at the index of its label, so the VM doesn't have to look labels up while running
+        void ResolveJumpTargets(size_t start);
 
     private:
         Allocator* m_Allocator = nullptr;
@@ -82,10 +167,24 @@ namespace Aria::Internal {
         // Data for this compilation unit
         std::string m_SourceCode;
         Tokens m_Tokens;
-        Stmt* m_RootASTNode;
+        SymbolTable m_SymbolTable;
+        Stmt* m_RootASTNode = nullptr;
         std::vector<OpCode> m_OpCodes;
 
+        bool m_LazyCodeGen = false;
+        Emitter* m_Emitter = nullptr; // Kept alive with lazy code generation to emit the functions later on
+        std::mutex m_CodeGenMutex;
+
+        bool m_SSAOptimization = false;
+        size_t m_InlineBudget = 0;
+        IRModule* m_IRModule = nullptr;
+
+        bool m_DeadCodeElimination = false;
+        std::vector<std::string> m_EntryPoints;
+        CodeSizeStats m_CodeSizeStats;
+
         std::vector<CompilerError> m_CompilerErrors;
+        std::vector<CompilationPhaseStats> m_PhaseStats;
     };
 
 } // namespace Aria::Internal
@@ -25,20 +25,31 @@ namespace Aria::Internal {
         inline const char* Data() const { return m_Str; }
 
         inline void Append(CompilationContext* ctx, const StringView str) {
-            m_Capacity += str.Size();
-            char* newStr = reinterpret_cast<char*>(ctx->AllocateSized(m_Capacity));
-            if (m_Str) {
-                memcpy(newStr, m_Str, m_Size);
+            if (m_Size + str.Size() > m_Capacity) {
+                size_t newCapacity = m_Capacity * 2;
+                if (newCapacity < m_Size + str.Size()) {
+                    newCapacity = m_Size + str.Size();
+                }
+
+                Reserve(ctx, newCapacity);
             }
-            
-            for (size_t i = 0; i < str.Size(); i++) {
-                newStr[m_Size + i] = *(str.Data() + i);
+
+            if (str.Size() > 0) {
+                memcpy(m_Str + m_Size, str.Data(), str.Size());
             }
 
-            m_Str = newStr;
             m_Size += str.Size();
         }
 
+        // Makes sure there is room for at least newCapacity characters
+        // Use this when the final size is known up front so the string gets allocated exactly once
+        inline void Reserve(CompilationContext* ctx, size_t newCapacity) {
+            if (newCapacity <= m_Capacity) { return; }
+
+            m_Str = reinterpret_cast<char*>(ctx->ReallocateSized(m_Str, m_Capacity, newCapacity, alignof(char)));
+            m_Capacity = newCapacity;
+        }
+
     private:
         char* m_Str = nullptr;
         size_t m_Capacity = 0;
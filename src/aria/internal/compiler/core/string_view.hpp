@@ -24,12 +24,14 @@ namespace Aria::Internal {
         inline StringView(const StringView& other)
             : m_Str(other.m_Str), m_Size(other.m_Size) {}
 
+        StringView& operator=(const StringView& other) = default;
+
         inline void operator=(const char* str) {
             m_Str = str;
             m_Size = std::strlen(str);
         }
 
-        inline bool operator==(const StringView other) {
+        inline bool operator==(const StringView other) const {
             if (m_Size != other.m_Size) { return false; }
             return std::strncmp(m_Str, other.m_Str, m_Size) == 0;
         }
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "aria/internal/compiler/core/string_view.hpp"
+#include "aria/internal/types.hpp"
+
+#include <vector>
+
+namespace Aria::Internal {
+
+    // A dense integer handle for an interned identifier
+    // Two identifiers with the same spelling always share the same SymbolId
+    using SymbolId = u32;
+    inline constexpr SymbolId InvalidSymbol = UINT32_MAX;
+
+    // Interns every identifier of a compilation unit, handing out ids in order of first appearance (0, 1, 2, ...)
+    // The strings are NOT copied, they must outlive the table (they usually point into the source code)
+    class SymbolTable {
+    public:
+        SymbolTable() = default;
+
+        inline SymbolId Intern(StringView str) {
+            if ((m_Symbols.size() + 1) * 2 > m_Buckets.size()) {
+                Grow();
+            }
+
+            u32 hash = Hash(str);
+            size_t mask = m_Buckets.size() - 1;
+
+            for (size_t i = hash & mask;; i = (i + 1) & mask) {
+                SymbolId id = m_Buckets[i];
+
+                if (id == InvalidSymbol) {
+                    id = static_cast<SymbolId>(m_Symbols.size());
+                    m_Symbols.push_back(str);
+                    m_Hashes.push_back(hash);
+                    m_Buckets[i] = id;
+                    return id;
+                }
+
+                if (m_Hashes[id] == hash && m_Symbols[id] == str) {
+                    return id;
+                }
+            }
+        }
+
+        // Returns InvalidSymbol if the string was never interned
+        inline SymbolId Find(StringView str) const {
+            if (m_Buckets.empty()) { return InvalidSymbol; }
+
+            u32 hash = Hash(str);
+            size_t mask = m_Buckets.size() - 1;
+
+            for (size_t i = hash & mask;; i = (i + 1) & mask) {
+                SymbolId id = m_Buckets[i];
+
+                if (id == InvalidSymbol) { return InvalidSymbol; }
+                if (m_Hashes[id] == hash && m_Symbols[id] == str) { return id; }
+            }
+        }
+
+        inline StringView GetString(SymbolId id) const {
+            ARIA_ASSERT(id < m_Symbols.size(), "SymbolTable::GetString() called with an unknown symbol!");
+            return m_Symbols[id];
+        }
+
+        inline size_t Size() const { return m_Symbols.size(); }
+
+    private:
+        // FNV-1a, identifiers are short so anything fancier is not worth it
+        inline static u32 Hash(StringView str) {
+            u32 hash = 2166136261u;
+
+            for (size_t i = 0; i < str.Size(); i++) {
+                hash ^= static_cast<u8>(str.Data()[i]);
+                hash *= 16777619u;
+            }
+
+            return hash;
+        }
+
+        inline void Grow() {
+            size_t newSize = m_Buckets.empty() ? 64 : m_Buckets.size() * 2;
+            m_Buckets.assign(newSize, InvalidSymbol);
+
+            size_t mask = newSize - 1;
+            for (SymbolId id = 0; id < m_Symbols.size(); id++) {
+                size_t i = m_Hashes[id] & mask;
+                while (m_Buckets[i] != InvalidSymbol) {
+                    i = (i + 1) & mask;
+                }
+
+                m_Buckets[i] = id;
+            }
+        }
+
+    private:
+        std::vector<StringView> m_Symbols; // Indexed by SymbolId
+        std::vector<u32> m_Hashes; // Indexed by SymbolId
+        std::vector<SymbolId> m_Buckets; // Open addressing, the size is always a power of two
+    };
+
+    // A scoped map from symbols to values, used by the compiler passes for name lookup
+    // Instead of a hash map per scope, there is one flat table indexed by SymbolId that always holds the innermost binding
+    // Declaring a symbol that is already bound records the old binding, which gets restored when the scope is popped
+    template <typename T>
+    class ScopedSymbolMap {
+    private:
+        struct Binding {
+            T Value{};
+            size_t Depth = 0;
+            bool Bound = false;
+        };
+
+        struct ShadowedBinding {
+            SymbolId Symbol = InvalidSymbol;
+            Binding Previous;
+        };
+
+    public:
+        // Clears all bindings and makes room for symbolCount symbols
+        inline void Reset(size_t symbolCount) {
+            m_Bindings.clear();
+            m_Bindings.resize(symbolCount);
+            m_ShadowedBindings.clear();
+            m_ScopeStarts.clear();
+        }
+
+        inline void PushScope() {
+            m_ScopeStarts.push_back(m_ShadowedBindings.size());
+        }
+
+        inline void PopScope() {
+            ARIA_ASSERT(m_ScopeStarts.size() > 0, "ScopedSymbolMap::PopScope() called with no active scopes");
+
+            size_t start = m_ScopeStarts.back();
+            m_ScopeStarts.pop_back();
+
+            while (m_ShadowedBindings.size() > start) {
+                ShadowedBinding& s = m_ShadowedBindings.back();
+                m_Bindings[s.Symbol] = s.Previous;
+                m_ShadowedBindings.pop_back();
+            }
+        }
+
+        // Pops every scope, leaving only the outermost (depth 0) bindings
+        inline void PopAllScopes() {
+            while (m_ScopeStarts.size() > 0) {
+                PopScope();
+            }
+        }
+
+        inline void Declare(SymbolId symbol, const T& value) {
+            ARIA_ASSERT(symbol < m_Bindings.size(), "ScopedSymbolMap::Declare() called with an unknown symbol!");
+
+            // Bindings in the outermost scope are never popped so there is nothing to restore
+            if (m_ScopeStarts.size() > 0) {
+                m_ShadowedBindings.push_back({ symbol, m_Bindings[symbol] });
+            }
+
+            m_Bindings[symbol] = { value, m_ScopeStarts.size(), true };
+        }
+
+        // Returns the innermost binding of the symbol, or nullptr if it isn't bound
+        inline T* Find(SymbolId symbol) {
+            if (symbol >= m_Bindings.size() || !m_Bindings[symbol].Bound) { return nullptr; }
+            return &m_Bindings[symbol].Value;
+        }
+
+        inline bool IsDeclaredInCurrentScope(SymbolId symbol) const {
+            if (symbol >= m_Bindings.size() || !m_Bindings[symbol].Bound) { return false; }
+            return m_Bindings[symbol].Depth == m_ScopeStarts.size();
+        }
+
+        // 0 means the outermost scope
+        inline size_t GetDepth() const { return m_ScopeStarts.size(); }
+
+    private:
+        std::vector<Binding> m_Bindings; // Indexed by SymbolId
+        std::vector<ShadowedBinding> m_ShadowedBindings;
+        std::vector<size_t> m_ScopeStarts;
+    };
+
+} // namespace Aria::Internal
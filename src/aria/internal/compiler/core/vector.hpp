@@ -14,23 +14,23 @@ namespace Aria::Internal {
         size_t Size = 0;
     
         inline void Append(CompilationContext* ctx, T t) {
-            if (Capacity == 0) {
-                Items = reinterpret_cast<T*>(ctx->AllocateSized(sizeof(T) * 1));
-                Capacity = 1;
-            }
-    
             if (Size >= Capacity) {
-                Capacity *= 2;
-    
-                T* newItems = reinterpret_cast<T*>(ctx->AllocateSized(sizeof(T) * Capacity));
-                memcpy(newItems, Items, sizeof(T) * Size);
-                Items = newItems;
+                Reserve(ctx, Capacity == 0 ? 1 : Capacity * 2);
             }
     
             Items[Size] = t;
             Size++;
         }
 
+        // Makes sure there is room for at least newCapacity items
+        // When the buffer is the last thing in the arena it grows in place instead of leaving the old one behind
+        inline void Reserve(CompilationContext* ctx, size_t newCapacity) {
+            if (newCapacity <= Capacity) { return; }
+
+            Items = reinterpret_cast<T*>(ctx->ReallocateSized(Items, sizeof(T) * Capacity, sizeof(T) * newCapacity, alignof(T)));
+            Capacity = newCapacity;
+        }
+
         inline iterator begin() { return Items; }
         inline const_iterator begin() const { return Items; }
 
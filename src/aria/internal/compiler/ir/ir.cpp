@@ -0,0 +1,368 @@
+#include "aria/internal/compiler/ir/ir.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Aria::Internal {
+
+    const char* IROpCodeToString(IROpCode op) {
+        switch (op) {
+            case IROpCode::Param: return "param";
+            case IROpCode::Const: return "const";
+            case IROpCode::Copy: return "copy";
+            case IROpCode::Phi: return "phi";
+            case IROpCode::Negate: return "neg";
+            case IROpCode::Add: return "add";
+            case IROpCode::Sub: return "sub";
+            case IROpCode::Mul: return "mul";
+            case IROpCode::Div: return "div";
+            case IROpCode::Mod: return "mod";
+            case IROpCode::Cmp: return "cmp";
+            case IROpCode::Ncmp: return "ncmp";
+            case IROpCode::Lt: return "lt";
+            case IROpCode::Lte: return "lte";
+            case IROpCode::Gt: return "gt";
+            case IROpCode::Gte: return "gte";
+            case IROpCode::Cast: return "cast";
+            case IROpCode::LoadGlobal: return "loadglobal";
+            case IROpCode::StoreGlobal: return "storeglobal";
+            case IROpCode::DeclareGlobal: return "declareglobal";
+            case IROpCode::Call: return "call";
+            case IROpCode::ArrayNew: return "arraynew";
+            case IROpCode::ArrayLoad: return "arrayload";
+            case IROpCode::ArrayStore: return "arraystore";
+            case IROpCode::ArrayAppend: return "arrayappend";
+            case IROpCode::ArrayLength: return "arraylength";
+            case IROpCode::ArrayReserve: return "arrayreserve";
+            case IROpCode::ArrayShrinkToFit: return "arrayshrinktofit";
+            case IROpCode::ArrayClear: return "arrayclear";
+            case IROpCode::StrConcat: return "strconcat";
+            case IROpCode::StrCmp: return "strcmp";
+            case IROpCode::StrNcmp: return "strncmp";
+            case IROpCode::StrLt: return "strlt";
+            case IROpCode::StrLte: return "strlte";
+            case IROpCode::StrGt: return "strgt";
+            case IROpCode::StrGte: return "strgte";
+            case IROpCode::StrLength: return "strlength";
+            case IROpCode::StrHash: return "strhash";
+            case IROpCode::Ret: return "ret";
+            case IROpCode::Br: return "br";
+            case IROpCode::CondBr: return "condbr";
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+    bool IRInstruction::HasValue() const {
+        return Type != nullptr && Type->Type != PrimitiveType::Void;
+    }
+
+    bool IRInstruction::IsTerminator() const {
+        return Op == IROpCode::Ret || Op == IROpCode::Br || Op == IROpCode::CondBr;
+    }
+
+    bool IRInstruction::HasSideEffects() const {
+        switch (Op) {
+            case IROpCode::StoreGlobal:
+            case IROpCode::DeclareGlobal:
+            case IROpCode::Call:
+            case IROpCode::ArrayStore:
+            case IROpCode::ArrayAppend:
+            case IROpCode::ArrayReserve:
+            case IROpCode::ArrayShrinkToFit:
+            case IROpCode::ArrayClear:
+            case IROpCode::Ret:
+            case IROpCode::Br:
+            case IROpCode::CondBr: return true;
+
+            default: return false;
+        }
+    }
+
+    bool IRInstruction::IsPure() const {
+        switch (Op) {
+            case IROpCode::Const:
+            case IROpCode::Copy:
+            case IROpCode::Negate:
+            case IROpCode::Add:
+            case IROpCode::Sub:
+            case IROpCode::Mul:
+            case IROpCode::Div:
+            case IROpCode::Mod:
+            case IROpCode::Cmp:
+            case IROpCode::Ncmp:
+            case IROpCode::Lt:
+            case IROpCode::Lte:
+            case IROpCode::Gt:
+            case IROpCode::Gte:
+            case IROpCode::Cast:
+            case IROpCode::StrCmp:
+            case IROpCode::StrNcmp:
+            case IROpCode::StrLt:
+            case IROpCode::StrLte:
+            case IROpCode::StrGt:
+            case IROpCode::StrGte:
+            case IROpCode::StrLength:
+            case IROpCode::StrHash: return true;
+
+            default: return false; // Phis depend on the path taken, globals and array elements can change between loads, every concatenation creates a new string
+        }
+    }
+
+    IRInstruction* IRBlock::GetTerminator() {
+        if (Instructions.empty() || !Instructions.back()->IsTerminator()) { return nullptr; }
+        return Instructions.back();
+    }
+
+    std::vector<IRBlock*> IRBlock::GetSuccessors() {
+        IRInstruction* term = GetTerminator();
+        if (!term) { return {}; }
+
+        return term->Targets;
+    }
+
+    void IRBlock::Append(IRInstruction* inst) {
+        inst->Parent = this;
+        Instructions.push_back(inst);
+    }
+
+    void IRBlock::InsertPhi(IRInstruction* phi) {
+        phi->Parent = this;
+
+        auto it = std::find_if(Instructions.begin(), Instructions.end(), [](IRInstruction* inst) { return inst->Op != IROpCode::Phi; });
+        Instructions.insert(it, phi);
+    }
+
+    void IRBlock::InsertBeforeTerminator(IRInstruction* inst) {
+        inst->Parent = this;
+
+        auto it = Instructions.end();
+        if (GetTerminator()) { it--; }
+        Instructions.insert(it, inst);
+    }
+
+    bool IRBlock::Dominates(const IRBlock* block) const {
+        for (; block; block = block->ImmediateDominator) {
+            if (block == this) { return true; }
+        }
+
+        return false;
+    }
+
+    IRFunction::IRFunction(const std::string& name, TypeInfo* returnType, std::vector<TypeInfo*> paramTypes)
+        : m_Name(name), m_ReturnType(returnType), m_ParamTypes(std::move(paramTypes)) {}
+
+    IRBlock* IRFunction::CreateBlock() {
+        m_BlockStorage.push_back(std::make_unique<IRBlock>());
+        IRBlock* block = m_BlockStorage.back().get();
+        block->Id = m_BlockStorage.size() - 1;
+
+        m_Blocks.push_back(block);
+        return block;
+    }
+
+    IRInstruction* IRFunction::CreateInstruction(IROpCode op, TypeInfo* type) {
+        m_InstructionStorage.push_back(std::make_unique<IRInstruction>());
+        IRInstruction* inst = m_InstructionStorage.back().get();
+        inst->Op = op;
+        inst->Type = type;
+        inst->Id = m_InstructionStorage.size() - 1;
+
+        return inst;
+    }
+
+    void IRFunction::RecomputePredecessors() {
+        for (IRBlock* block : m_Blocks) {
+            block->Predecessors.clear();
+        }
+
+        for (IRBlock* block : m_Blocks) {
+            for (IRBlock* succ : block->GetSuccessors()) {
+                // A conditional branch with the same target twice is still a single edge
+                if (std::find(succ->Predecessors.begin(), succ->Predecessors.end(), block) == succ->Predecessors.end()) {
+                    succ->Predecessors.push_back(block);
+                }
+            }
+        }
+    }
+
+    bool IRFunction::RemoveUnreachableBlocks() {
+        std::unordered_set<IRBlock*> reachable;
+        std::vector<IRBlock*> worklist = { GetEntryBlock() };
+        reachable.insert(GetEntryBlock());
+
+        while (!worklist.empty()) {
+            IRBlock* block = worklist.back();
+            worklist.pop_back();
+
+            for (IRBlock* succ : block->GetSuccessors()) {
+                if (reachable.insert(succ).second) { worklist.push_back(succ); }
+            }
+        }
+
+        if (reachable.size() == m_Blocks.size()) { return false; }
+
+        std::erase_if(m_Blocks, [&](IRBlock* block) { return !reachable.contains(block); });
+
+        for (IRBlock* block : m_Blocks) {
+            for (IRInstruction* inst : block->Instructions) {
+                if (inst->Op != IROpCode::Phi) { break; }
+
+                for (size_t i = inst->IncomingBlocks.size(); i-- > 0;) {
+                    if (!reachable.contains(inst->IncomingBlocks[i])) {
+                        inst->IncomingBlocks.erase(inst->IncomingBlocks.begin() + i);
+                        inst->Operands.erase(inst->Operands.begin() + i);
+                    }
+                }
+            }
+        }
+
+        RecomputePredecessors();
+        return true;
+    }
+
+    std::vector<IRBlock*> IRFunction::GetReversePostOrder() {
+        std::vector<IRBlock*> postOrder;
+        std::unordered_set<IRBlock*> visited;
+
+        // Iterative depth first search, each entry remembers how many successors were already visited
+        std::vector<std::pair<IRBlock*, size_t>> stack = { { GetEntryBlock(), 0 } };
+        visited.insert(GetEntryBlock());
+
+        while (!stack.empty()) {
+            auto& [block, next] = stack.back();
+            std::vector<IRBlock*> succs = block->GetSuccessors();
+
+            if (next < succs.size()) {
+                IRBlock* succ = succs[next++];
+                if (visited.insert(succ).second) { stack.push_back({ succ, 0 }); }
+            } else {
+                postOrder.push_back(block);
+                stack.pop_back();
+            }
+        }
+
+        std::reverse(postOrder.begin(), postOrder.end());
+        return postOrder;
+    }
+
+    void IRFunction::ComputeDominators() {
+        // Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+        RecomputePredecessors();
+
+        std::vector<IRBlock*> rpo = GetReversePostOrder();
+        std::unordered_map<IRBlock*, size_t> order;
+        for (size_t i = 0; i < rpo.size(); i++) {
+            order[rpo[i]] = i;
+        }
+
+        for (IRBlock* block : m_Blocks) {
+            block->ImmediateDominator = nullptr;
+            block->DominatedBlocks.clear();
+        }
+
+        IRBlock* entry = GetEntryBlock();
+        entry->ImmediateDominator = entry;
+
+        auto intersect = [&](IRBlock* a, IRBlock* b) {
+            while (a != b) {
+                while (order.at(a) > order.at(b)) { a = a->ImmediateDominator; }
+                while (order.at(b) > order.at(a)) { b = b->ImmediateDominator; }
+            }
+
+            return a;
+        };
+
+        bool changed = true;
+        while (changed) {
+            changed = false;
+
+            for (IRBlock* block : rpo) {
+                if (block == entry) { continue; }
+
+                IRBlock* newIdom = nullptr;
+                for (IRBlock* pred : block->Predecessors) {
+                    if (!pred->ImmediateDominator) { continue; }
+                    newIdom = newIdom ? intersect(pred, newIdom) : pred;
+                }
+
+                if (newIdom != block->ImmediateDominator) {
+                    block->ImmediateDominator = newIdom;
+                    changed = true;
+                }
+            }
+        }
+
+        entry->ImmediateDominator = nullptr;
+        for (IRBlock* block : rpo) {
+            if (block->ImmediateDominator) { block->ImmediateDominator->DominatedBlocks.push_back(block); }
+        }
+    }
+
+    std::vector<IRLoop> IRFunction::FindLoops() {
+        ComputeDominators();
+
+        std::vector<IRLoop> loops;
+
+        for (IRBlock* header : GetReversePostOrder()) {
+            IRLoop loop;
+            loop.Header = header;
+            loop.Blocks.insert(header);
+
+            for (IRBlock* pred : header->Predecessors) {
+                if (!header->Dominates(pred)) { continue; }
+                loop.Latches.push_back(pred);
+
+                // Walk backwards from the latch, the header stops the walk since it's already part of the loop
+                std::vector<IRBlock*> worklist = { pred };
+                while (!worklist.empty()) {
+                    IRBlock* block = worklist.back();
+                    worklist.pop_back();
+
+                    if (!loop.Blocks.insert(block).second) { continue; }
+                    worklist.insert(worklist.end(), block->Predecessors.begin(), block->Predecessors.end());
+                }
+            }
+
+            if (loop.Latches.empty()) { continue; }
+
+            std::vector<IRBlock*> outside;
+            for (IRBlock* pred : header->Predecessors) {
+                if (!loop.Blocks.contains(pred)) { outside.push_back(pred); }
+            }
+
+            if (outside.size() == 1) {
+                IRInstruction* term = outside[0]->GetTerminator();
+                if (term && term->Op == IROpCode::Br) { loop.Preheader = outside[0]; }
+            }
+
+            loops.push_back(std::move(loop));
+        }
+
+        // An inner loop has fewer blocks than any loop containing it
+        std::stable_sort(loops.begin(), loops.end(), [](const IRLoop& lhs, const IRLoop& rhs) { return lhs.Blocks.size() < rhs.Blocks.size(); });
+        return loops;
+    }
+
+    void IRFunction::ReplaceAllUsesWith(IRInstruction* from, IRInstruction* to) {
+        for (IRBlock* block : m_Blocks) {
+            for (IRInstruction* inst : block->Instructions) {
+                std::replace(inst->Operands.begin(), inst->Operands.end(), from, to);
+            }
+        }
+    }
+
+    void IRFunction::RemoveInstruction(IRInstruction* inst) {
+        if (!inst->Parent) { return; }
+
+        std::erase(inst->Parent->Instructions, inst);
+        inst->Parent = nullptr;
+    }
+
+    IRFunction* IRModule::CreateFunction(const std::string& name, TypeInfo* returnType, std::vector<TypeInfo*> paramTypes) {
+        m_Functions.push_back(std::make_unique<IRFunction>(name, returnType, std::move(paramTypes)));
+        return m_Functions.back().get();
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "aria/internal/compiler/types/type_info.hpp"
+#include "aria/internal/compiler/core/string_view.hpp"
+#include "aria/internal/types.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+
+namespace Aria::Internal {
+
+    enum class IROpCode {
+        Param, // The argument at ParamIndex
+        Const,
+        Copy,
+        Phi, // Picks the operand belonging to the predecessor control came from
+
+        Negate,
+
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Mod,
+
+        Cmp,
+        Ncmp,
+        Lt,
+        Lte,
+        Gt,
+        Gte,
+
+        Cast, // Converts the operand to the type of the instruction
+
+        LoadGlobal,
+        StoreGlobal,
+        DeclareGlobal, // Creates a global, from the operand if there is one (only in _start$())
+
+        Call,
+
+        // Arrays are handles, the array is always the first operand
+        ArrayNew,
+        ArrayLoad, // The element at the index operand
+        ArrayStore, // Stores the value (last operand) into the element at the index operand
+        ArrayAppend,
+        ArrayLength,
+        ArrayReserve,
+        ArrayShrinkToFit,
+        ArrayClear,
+
+        // Strings are handles too, concatenation creates a new string and never changes its operands
+        StrConcat,
+        StrCmp,
+        StrNcmp,
+        StrLt,
+        StrLte,
+        StrGt,
+        StrGte,
+        StrLength,
+        StrHash,
+
+        Ret,
+        Br,
+        CondBr
+    };
+
+    const char* IROpCodeToString(IROpCode op);
+
+    using IRConstant = std::variant<i8, u8, i16, u16, i32, u32, i64, u64, f32, f64, StringView>;
+
+    struct IRBlock;
+
+    // Every instruction that produces something is also the SSA value it produces
+    struct IRInstruction {
+        IROpCode Op = IROpCode::Const;
+        size_t Id = 0; // Unique within its function
+        TypeInfo* Type = nullptr; // The type of the value, nullptr if the instruction doesn't produce one
+
+        std::vector<IRInstruction*> Operands;
+        std::vector<IRBlock*> IncomingBlocks; // Only used by phis, parallel to the operands
+        std::vector<IRBlock*> Targets; // Br has one target, CondBr has the true and then the false target
+
+        IRConstant Constant{};
+        std::string Name; // The global or function signature
+        size_t ParamIndex = 0;
+        bool Extern = false;
+
+        IRBlock* Parent = nullptr;
+
+        bool HasValue() const;
+        bool IsTerminator() const;
+        // Instructions without side effects can be removed once nothing uses them
+        bool HasSideEffects() const;
+        // Pure instructions always produce the same value from the same operands
+        bool IsPure() const;
+    };
+
+    struct IRBlock {
+        size_t Id = 0;
+        std::vector<IRInstruction*> Instructions; // Phis first, the terminator last
+        std::vector<IRBlock*> Predecessors;
+
+        // Only valid after IRFunction::ComputeDominators()
+        IRBlock* ImmediateDominator = nullptr;
+        std::vector<IRBlock*> DominatedBlocks;
+
+        IRInstruction* GetTerminator();
+        std::vector<IRBlock*> GetSuccessors();
+
+        void Append(IRInstruction* inst);
+        void InsertPhi(IRInstruction* phi);
+        // Inserts the instruction right in front of the terminator
+        void InsertBeforeTerminator(IRInstruction* inst);
+
+        // Only valid after IRFunction::ComputeDominators(), a block dominates itself
+        bool Dominates(const IRBlock* block) const;
+    };
+
+    // A natural loop, all the blocks that can reach one of the back edges to the header without going through the header
+    struct IRLoop {
+        IRBlock* Header = nullptr;
+        IRBlock* Preheader = nullptr; // The only block entering the loop, if all it does is branch to the header, nullptr otherwise
+        std::vector<IRBlock*> Latches; // The blocks with a back edge to the header
+        std::unordered_set<IRBlock*> Blocks;
+
+        inline bool Contains(const IRInstruction* inst) const { return Blocks.contains(inst->Parent); }
+    };
+
+    class IRFunction {
+    public:
+        IRFunction(const std::string& name, TypeInfo* returnType, std::vector<TypeInfo*> paramTypes);
+
+        inline const std::string& GetName() const { return m_Name; }
+        inline TypeInfo* GetReturnType() const { return m_ReturnType; }
+        inline size_t GetParamCount() const { return m_ParamTypes.size(); }
+        inline const std::vector<TypeInfo*>& GetParamTypes() const { return m_ParamTypes; }
+
+        // The first block is always the entry
+        inline std::vector<IRBlock*>& GetBlocks() { return m_Blocks; }
+        inline const std::vector<IRBlock*>& GetBlocks() const { return m_Blocks; }
+        inline IRBlock* GetEntryBlock() { return m_Blocks.front(); }
+
+        IRBlock* CreateBlock();
+        IRInstruction* CreateInstruction(IROpCode op, TypeInfo* type = nullptr);
+
+        // Rebuilds the predecessor lists from the terminators
+        void RecomputePredecessors();
+        // Drops the blocks that can't be reached from the entry, together with the phi operands coming from them
+        bool RemoveUnreachableBlocks();
+        std::vector<IRBlock*> GetReversePostOrder();
+        void ComputeDominators();
+        // Computes the dominators as well, inner loops come before the loops containing them
+        std::vector<IRLoop> FindLoops();
+
+        void ReplaceAllUsesWith(IRInstruction* from, IRInstruction* to);
+        // Unlinks the instruction from its block, it stays alive until the function is destroyed
+        void RemoveInstruction(IRInstruction* inst);
+
+    private:
+        std::string m_Name;
+        TypeInfo* m_ReturnType = nullptr;
+        std::vector<TypeInfo*> m_ParamTypes;
+
+        std::vector<IRBlock*> m_Blocks;
+
+        std::vector<std::unique_ptr<IRBlock>> m_BlockStorage;
+        std::vector<std::unique_ptr<IRInstruction>> m_InstructionStorage;
+    };
+
+    // The IR of a whole compilation unit, _start$() is always the first function
+    class IRModule {
+    public:
+        IRFunction* CreateFunction(const std::string& name, TypeInfo* returnType, std::vector<TypeInfo*> paramTypes);
+
+        inline std::vector<std::unique_ptr<IRFunction>>& GetFunctions() { return m_Functions; }
+        inline const std::vector<std::unique_ptr<IRFunction>>& GetFunctions() const { return m_Functions; }
+
+    private:
+        std::vector<std::unique_ptr<IRFunction>> m_Functions;
+    };
+
+} // namespace Aria::Internal
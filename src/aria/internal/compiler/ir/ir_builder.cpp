@@ -0,0 +1,615 @@
+#include "aria/internal/compiler/ir/ir_builder.hpp"
+#include "aria/internal/compiler/ast/ast.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
+
+namespace Aria::Internal {
+
+    static Expr* StripParens(Expr* expr) {
+        while (ParenExpr* paren = GetNode<ParenExpr>(expr)) { expr = paren->GetChildExpr(); }
+        return expr;
+    }
+
+    IRBuilder::IRBuilder(CompilationContext* ctx, IRModule* module) {
+        m_Context = ctx;
+        m_Module = module;
+
+        BuildImpl();
+    }
+
+    void IRBuilder::BuildImpl() {
+        m_Function = m_Module->CreateFunction("_start$()", TypeInfo::Create(m_Context, PrimitiveType::Void), {});
+        m_Block = m_Function->CreateBlock();
+        SealBlock(m_Block);
+
+        if (TranslationUnitDecl* tu = GetNode<TranslationUnitDecl>(m_Context->GetRootASTNode())) {
+            for (Stmt* stmt : tu->GetStmts()) {
+                BuildStmt(stmt);
+            }
+        }
+
+        Append(IROpCode::Ret, nullptr);
+        m_Function->RemoveUnreachableBlocks();
+
+        for (FunctionDecl* fnDecl : m_Functions) {
+            BuildFunctionDecl(fnDecl);
+        }
+    }
+
+    IRInstruction* IRBuilder::BuildBooleanConstantExpr(Expr* expr) {
+        BooleanConstantExpr* bc = GetNode<BooleanConstantExpr>(expr);
+        return CreateConstant(static_cast<i8>(bc->GetValue()), bc->GetResolvedType());
+    }
+
+    IRInstruction* IRBuilder::BuildCharacterConstantExpr(Expr* expr) {
+        CharacterConstantExpr* cc = GetNode<CharacterConstantExpr>(expr);
+        return CreateConstant(cc->GetValue(), cc->GetResolvedType());
+    }
+
+    IRInstruction* IRBuilder::BuildIntegerConstantExpr(Expr* expr) {
+        IntegerConstantExpr* ic = GetNode<IntegerConstantExpr>(expr);
+        return CreateConstant(std::visit([](auto v) { return IRConstant(v); }, ic->GetValue()), ic->GetResolvedType());
+    }
+
+    IRInstruction* IRBuilder::BuildFloatingConstantExpr(Expr* expr) {
+        FloatingConstantExpr* fc = GetNode<FloatingConstantExpr>(expr);
+        return CreateConstant(std::visit([](auto v) { return IRConstant(v); }, fc->GetValue()), fc->GetResolvedType());
+    }
+
+    IRInstruction* IRBuilder::BuildStringConstantExpr(Expr* expr) {
+        StringConstantExpr* sc = GetNode<StringConstantExpr>(expr);
+        return CreateConstant(sc->GetValue(), sc->GetResolvedType());
+    }
+
+    IRInstruction* IRBuilder::BuildDeclRefExpr(Expr* expr) {
+        DeclRefExpr* ref = GetNode<DeclRefExpr>(expr);
+
+        if (ref->GetType() == DeclRefType::LocalVar) {
+            return Append(IROpCode::Copy, ref->GetResolvedType(), { ReadVariable(ref->GetReferencedDecl(), m_Block) });
+        } else if (ref->GetType() == DeclRefType::GlobalVar) {
+            IRInstruction* load = Append(IROpCode::LoadGlobal, ref->GetResolvedType());
+            load->Name = fmt::format("{}", ref->GetIdentifier());
+            return load;
+        }
+
+        ARIA_ASSERT(false, "todo: IRBuilder::BuildDeclRefExpr() for functions as values");
+        return nullptr;
+    }
+
+    IRInstruction* IRBuilder::BuildCallExpr(Expr* expr) {
+        CallExpr* call = GetNode<CallExpr>(expr);
+
+        std::vector<IRInstruction*> args;
+        for (Expr* arg : call->GetArguments()) {
+            args.push_back(BuildExpr(arg));
+        }
+
+        IRInstruction* inst = Append(IROpCode::Call, call->GetResolvedType(), std::move(args));
+        inst->Name = fmt::format("{}()", call->GetCallee()->GetIdentifier());
+        inst->Extern = call->IsExtern();
+        return inst;
+    }
+
+    IRInstruction* IRBuilder::BuildMethodCallExpr(Expr* expr) {
+        MethodCallExpr* method = GetNode<MethodCallExpr>(expr);
+        IRInstruction* array = BuildExpr(method->GetBase());
+
+        switch (method->GetMethodType()) {
+            case MethodType::StringLength: return Append(IROpCode::StrLength, method->GetResolvedType(), { array });
+            case MethodType::StringHash: return Append(IROpCode::StrHash, method->GetResolvedType(), { array });
+
+            case MethodType::ArrayAppend: return Append(IROpCode::ArrayAppend, method->GetResolvedType(), { array, BuildExpr(method->GetArguments().Items[0]) });
+            case MethodType::ArrayLength: return Append(IROpCode::ArrayLength, method->GetResolvedType(), { array });
+            case MethodType::ArrayReserve: return Append(IROpCode::ArrayReserve, method->GetResolvedType(), { array, BuildExpr(method->GetArguments().Items[0]) });
+            case MethodType::ArrayShrinkToFit: return Append(IROpCode::ArrayShrinkToFit, method->GetResolvedType(), { array });
+            case MethodType::ArrayClear: return Append(IROpCode::ArrayClear, method->GetResolvedType(), { array });
+
+            case MethodType::Invalid: break;
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+    IRInstruction* IRBuilder::BuildArraySubscriptExpr(Expr* expr) {
+        ArraySubscriptExpr* subscript = GetNode<ArraySubscriptExpr>(expr);
+
+        IRInstruction* array = BuildExpr(subscript->GetBase());
+        IRInstruction* index = BuildExpr(subscript->GetIndex());
+        return Append(IROpCode::ArrayLoad, subscript->GetResolvedType(), { array, index });
+    }
+
+    IRInstruction* IRBuilder::BuildParenExpr(Expr* expr) {
+        ParenExpr* paren = GetNode<ParenExpr>(expr);
+        return BuildExpr(paren->GetChildExpr());
+    }
+
+    IRInstruction* IRBuilder::BuildImplicitCastExpr(Expr* expr) {
+        ImplicitCastExpr* cast = GetNode<ImplicitCastExpr>(expr);
+        IRInstruction* child = BuildExpr(cast->GetChildExpr());
+
+        // Reading a variable already produces its value
+        if (cast->GetCastType() == CastType::LValueToRValue) {
+            return child;
+        }
+
+        return Append(IROpCode::Cast, cast->GetResolvedType(), { child });
+    }
+
+    IRInstruction* IRBuilder::BuildUnaryOperatorExpr(Expr* expr) {
+        UnaryOperatorExpr* unary = GetNode<UnaryOperatorExpr>(expr);
+        IRInstruction* child = BuildExpr(unary->GetChildExpr());
+
+        if (unary->GetUnaryOperator() == UnaryOperatorType::Negate) {
+            return Append(IROpCode::Negate, unary->GetResolvedType(), { child });
+        }
+
+        ARIA_ASSERT(false, "todo: IRBuilder::BuildUnaryOperatorExpr()");
+        return nullptr;
+    }
+
+    IRInstruction* IRBuilder::BuildBinaryOperatorExpr(Expr* expr) {
+        BinaryOperatorExpr* binop = GetNode<BinaryOperatorExpr>(expr);
+        TypeInfo* type = binop->GetResolvedType();
+
+        // Only assignments keep a subscript as their LHS, every other operator loads it through an lvalue to rvalue cast
+        if (ArraySubscriptExpr* subscript = GetNode<ArraySubscriptExpr>(StripParens(binop->GetLHS()))) {
+            return AssignElement(binop, subscript);
+        }
+
+        auto arithmetic = [&](IROpCode op) {
+            IRInstruction* lhs = BuildExpr(binop->GetLHS());
+            IRInstruction* rhs = BuildExpr(binop->GetRHS());
+            return Append(op, type, { lhs, rhs });
+        };
+
+        auto inPlace = [&](IROpCode op) {
+            IRInstruction* lhs = BuildExpr(binop->GetLHS());
+            IRInstruction* rhs = BuildExpr(binop->GetRHS());
+            return Assign(binop->GetLHS(), Append(op, type, { lhs, rhs }));
+        };
+
+        // Strings have op codes of their own
+        if (binop->GetLHS()->GetResolvedType()->Type == PrimitiveType::String) {
+            switch (binop->GetBinaryOperator()) {
+                case BinaryOperatorType::Add: return arithmetic(IROpCode::StrConcat);
+                case BinaryOperatorType::AddInPlace: return inPlace(IROpCode::StrConcat);
+
+                case BinaryOperatorType::Less: return arithmetic(IROpCode::StrLt);
+                case BinaryOperatorType::LessOrEq: return arithmetic(IROpCode::StrLte);
+                case BinaryOperatorType::Greater: return arithmetic(IROpCode::StrGt);
+                case BinaryOperatorType::GreaterOrEq: return arithmetic(IROpCode::StrGte);
+                case BinaryOperatorType::IsEq: return arithmetic(IROpCode::StrCmp);
+                case BinaryOperatorType::IsNotEq: return arithmetic(IROpCode::StrNcmp);
+
+                default: break;
+            }
+        }
+
+        switch (binop->GetBinaryOperator()) {
+            case BinaryOperatorType::Add: return arithmetic(IROpCode::Add);
+            case BinaryOperatorType::Sub: return arithmetic(IROpCode::Sub);
+            case BinaryOperatorType::Mul: return arithmetic(IROpCode::Mul);
+            case BinaryOperatorType::Div: return arithmetic(IROpCode::Div);
+            case BinaryOperatorType::Mod: return arithmetic(IROpCode::Mod);
+
+            case BinaryOperatorType::AddInPlace: return inPlace(IROpCode::Add);
+            case BinaryOperatorType::SubInPlace: return inPlace(IROpCode::Sub);
+            case BinaryOperatorType::MulInPlace: return inPlace(IROpCode::Mul);
+            case BinaryOperatorType::DivInPlace: return inPlace(IROpCode::Div);
+            case BinaryOperatorType::ModInPlace: return inPlace(IROpCode::Mod);
+
+            case BinaryOperatorType::Less: return arithmetic(IROpCode::Lt);
+            case BinaryOperatorType::LessOrEq: return arithmetic(IROpCode::Lte);
+            case BinaryOperatorType::Greater: return arithmetic(IROpCode::Gt);
+            case BinaryOperatorType::GreaterOrEq: return arithmetic(IROpCode::Gte);
+            case BinaryOperatorType::IsEq: return arithmetic(IROpCode::Cmp);
+            case BinaryOperatorType::IsNotEq: return arithmetic(IROpCode::Ncmp);
+
+            case BinaryOperatorType::Eq: return Assign(binop->GetLHS(), BuildExpr(binop->GetRHS()));
+
+            default: break;
+        }
+
+        ARIA_ASSERT(false, "todo: IRBuilder::BuildBinaryOperatorExpr()");
+        return nullptr;
+    }
+
+    IRInstruction* IRBuilder::BuildExpr(Expr* expr) {
+        if (GetNode<BooleanConstantExpr>(expr)) {
+            return BuildBooleanConstantExpr(expr);
+        } else if (GetNode<CharacterConstantExpr>(expr)) {
+            return BuildCharacterConstantExpr(expr);
+        } else if (GetNode<IntegerConstantExpr>(expr)) {
+            return BuildIntegerConstantExpr(expr);
+        } else if (GetNode<FloatingConstantExpr>(expr)) {
+            return BuildFloatingConstantExpr(expr);
+        } else if (GetNode<StringConstantExpr>(expr)) {
+            return BuildStringConstantExpr(expr);
+        } else if (GetNode<DeclRefExpr>(expr)) {
+            return BuildDeclRefExpr(expr);
+        } else if (GetNode<CallExpr>(expr)) {
+            return BuildCallExpr(expr);
+        } else if (GetNode<MethodCallExpr>(expr)) {
+            return BuildMethodCallExpr(expr);
+        } else if (GetNode<ArraySubscriptExpr>(expr)) {
+            return BuildArraySubscriptExpr(expr);
+        } else if (GetNode<ParenExpr>(expr)) {
+            return BuildParenExpr(expr);
+        } else if (GetNode<ImplicitCastExpr>(expr)) {
+            return BuildImplicitCastExpr(expr);
+        } else if (GetNode<UnaryOperatorExpr>(expr)) {
+            return BuildUnaryOperatorExpr(expr);
+        } else if (GetNode<BinaryOperatorExpr>(expr)) {
+            return BuildBinaryOperatorExpr(expr);
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+    IRInstruction* IRBuilder::BuildCondition(Expr* expr) {
+        IRInstruction* value = BuildExpr(expr);
+
+        if (value->Type->GetSize() == 1) { return value; }
+
+        return Append(IROpCode::Ncmp, TypeInfo::Create(m_Context, PrimitiveType::Bool, true), { value, CreateZero(value->Type) });
+    }
+
+    void IRBuilder::BuildVarDecl(Decl* decl) {
+        VarDecl* varDecl = GetNode<VarDecl>(decl);
+        IRInstruction* value = varDecl->GetDefaultValue() ? BuildExpr(varDecl->GetDefaultValue()) : nullptr;
+
+        // An array declared without a value starts out empty, never as a null handle
+        if (!value && varDecl->GetResolvedType()->Type == PrimitiveType::Array) {
+            value = Append(IROpCode::ArrayNew, varDecl->GetResolvedType());
+        }
+
+        // Same for strings, which start out as the empty literal
+        if (!value && varDecl->GetResolvedType()->Type == PrimitiveType::String) {
+            value = CreateZero(varDecl->GetResolvedType());
+        }
+
+        if (m_InGlobalScope) {
+            IRInstruction* global = Append(IROpCode::DeclareGlobal, varDecl->GetResolvedType());
+            global->Name = fmt::format("{}", varDecl->GetIdentifier());
+            if (value) { global->Operands.push_back(value); }
+
+            return;
+        }
+
+        WriteVariable(decl, m_Block, value ? value : CreateZero(varDecl->GetResolvedType()));
+    }
+
+    void IRBuilder::BuildFunctionDecl(Decl* decl) {
+        FunctionDecl* fnDecl = GetNode<FunctionDecl>(decl);
+        FunctionDeclaration& fd = std::get<FunctionDeclaration>(fnDecl->GetResolvedType()->Data);
+
+        m_CurrentDefs.clear();
+        m_IncompletePhis.clear();
+        m_SealedBlocks.clear();
+        m_InGlobalScope = false;
+
+        std::vector<TypeInfo*> paramTypes(fd.ParamTypes.Items, fd.ParamTypes.Items + fd.ParamTypes.Size);
+        m_Function = m_Module->CreateFunction(fmt::format("{}()", fnDecl->GetIdentifier()), fd.ReturnType, std::move(paramTypes));
+        m_Block = m_Function->CreateBlock();
+        SealBlock(m_Block);
+
+        for (size_t i = 0; i < fnDecl->GetParameters().Size; i++) {
+            ParamDecl* p = fnDecl->GetParameters().Items[i];
+
+            IRInstruction* param = Append(IROpCode::Param, p->GetResolvedType());
+            param->ParamIndex = i;
+            WriteVariable(p, m_Block, param);
+        }
+
+        BuildCompoundStmt(fnDecl->GetBody());
+
+        if (!IsTerminated()) {
+            Append(IROpCode::Ret, nullptr);
+        }
+
+        m_Function->RemoveUnreachableBlocks();
+        m_Function->RecomputePredecessors();
+    }
+
+    void IRBuilder::BuildCompoundStmt(Stmt* stmt) {
+        CompoundStmt* compound = GetNode<CompoundStmt>(stmt);
+
+        for (Stmt* s : compound->GetStmts()) {
+            BuildStmt(s);
+        }
+    }
+
+    void IRBuilder::BuildIfStmt(Stmt* stmt) {
+        IfStmt* ifs = GetNode<IfStmt>(stmt);
+
+        IRInstruction* condition = BuildCondition(ifs->GetCondition());
+
+        IRBlock* thenBlock = m_Function->CreateBlock();
+        IRBlock* elseBlock = ifs->GetElseBody() ? m_Function->CreateBlock() : nullptr;
+        IRBlock* mergeBlock = m_Function->CreateBlock();
+
+        CondBranch(condition, thenBlock, elseBlock ? elseBlock : mergeBlock);
+
+        SealBlock(thenBlock);
+        m_Block = thenBlock;
+        BuildStmt(ifs->GetBody());
+        Branch(mergeBlock);
+
+        if (elseBlock) {
+            SealBlock(elseBlock);
+            m_Block = elseBlock;
+            BuildStmt(ifs->GetElseBody());
+            Branch(mergeBlock);
+        }
+
+        SealBlock(mergeBlock);
+        m_Block = mergeBlock;
+    }
+
+    void IRBuilder::BuildWhileStmt(Stmt* stmt) {
+        WhileStmt* wh = GetNode<WhileStmt>(stmt);
+        BuildLoop(wh->GetCondition(), wh->GetBody(), nullptr, true);
+    }
+
+    void IRBuilder::BuildDoWhileStmt(Stmt* stmt) {
+        DoWhileStmt* doWh = GetNode<DoWhileStmt>(stmt);
+        BuildLoop(doWh->GetCondition(), doWh->GetBody(), nullptr, false);
+    }
+
+    void IRBuilder::BuildForStmt(Stmt* stmt) {
+        ForStmt* fs = GetNode<ForStmt>(stmt);
+
+        // The prologue declares locals, never globals
+        bool global = m_InGlobalScope;
+        m_InGlobalScope = false;
+
+        if (fs->GetPrologue()) {
+            BuildStmt(fs->GetPrologue());
+        }
+
+        BuildLoop(fs->GetCondition(), fs->GetBody(), fs->GetEpilogue(), true);
+        m_InGlobalScope = global;
+    }
+
+    // Loops are built rotated, the condition is tested once in front of the loop and then again at the bottom of the body:
+    //   guard: condbr <condition> preheader exit
+    //   preheader: br body
+    //   body: ... condbr <condition> body exit
+    // The body is entered from the preheader only, which gives the loop passes a single place to hoist to
+    void IRBuilder::BuildLoop(Expr* condition, Stmt* body, Expr* epilogue, bool testFirst) {
+        IRBlock* bodyBlock = m_Function->CreateBlock();
+        IRBlock* exitBlock = m_Function->CreateBlock();
+
+        if (testFirst && condition) {
+            IRBlock* preheader = m_Function->CreateBlock();
+            CondBranch(BuildCondition(condition), preheader, exitBlock);
+
+            SealBlock(preheader);
+            m_Block = preheader;
+        }
+
+        Branch(bodyBlock);
+
+        // The body stays unsealed until the back edge is known
+        m_Block = bodyBlock;
+        BuildStmt(body);
+
+        if (epilogue) {
+            BuildExpr(epilogue);
+        }
+
+        if (condition) {
+            CondBranch(BuildCondition(condition), bodyBlock, exitBlock);
+        } else {
+            Branch(bodyBlock);
+        }
+
+        SealBlock(bodyBlock);
+        SealBlock(exitBlock);
+        m_Block = exitBlock;
+    }
+
+    void IRBuilder::BuildReturnStmt(Stmt* stmt) {
+        ReturnStmt* ret = GetNode<ReturnStmt>(stmt);
+
+        if (ret->GetValue()) {
+            Append(IROpCode::Ret, nullptr, { BuildExpr(ret->GetValue()) });
+        } else {
+            Append(IROpCode::Ret, nullptr);
+        }
+
+        // Anything following the return still needs a block, it gets dropped once the function is built
+        m_Block = m_Function->CreateBlock();
+        SealBlock(m_Block);
+    }
+
+    void IRBuilder::BuildStmt(Stmt* stmt) {
+        if (GetNode<CompoundStmt>(stmt)) {
+            bool global = m_InGlobalScope;
+            m_InGlobalScope = false;
+            BuildCompoundStmt(stmt);
+            m_InGlobalScope = global;
+            return;
+        } else if (GetNode<WhileStmt>(stmt)) {
+            BuildWhileStmt(stmt);
+            return;
+        } else if (GetNode<DoWhileStmt>(stmt)) {
+            BuildDoWhileStmt(stmt);
+            return;
+        } else if (GetNode<ForStmt>(stmt)) {
+            BuildForStmt(stmt);
+            return;
+        } else if (GetNode<IfStmt>(stmt)) {
+            BuildIfStmt(stmt);
+            return;
+        } else if (GetNode<ReturnStmt>(stmt)) {
+            BuildReturnStmt(stmt);
+            return;
+        } else if (Expr* expr = GetNode<Expr>(stmt)) {
+            BuildExpr(expr);
+            return;
+        } else if (GetNode<VarDecl>(stmt)) {
+            BuildVarDecl(GetNode<VarDecl>(stmt));
+            return;
+        } else if (FunctionDecl* fnDecl = GetNode<FunctionDecl>(stmt)) {
+            // Functions are built after _start$(), extern ones have nothing to build
+            if (fnDecl->GetBody() && !fnDecl->IsExtern()) { m_Functions.push_back(fnDecl); }
+            return;
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+    IRInstruction* IRBuilder::Append(IROpCode op, TypeInfo* type, std::vector<IRInstruction*> operands) {
+        IRInstruction* inst = m_Function->CreateInstruction(op, type);
+        inst->Operands = std::move(operands);
+
+        m_Block->Append(inst);
+        return inst;
+    }
+
+    IRInstruction* IRBuilder::CreateConstant(const IRConstant& value, TypeInfo* type) {
+        IRInstruction* inst = Append(IROpCode::Const, type);
+        inst->Constant = value;
+        return inst;
+    }
+
+    IRInstruction* IRBuilder::CreateZero(TypeInfo* type) {
+        if (type->Type == PrimitiveType::String) { return CreateConstant(StringView(""), type); }
+
+        IRInstruction* zero = nullptr;
+        bool visited = VisitVMType(type, [&](auto tag) {
+            using T = decltype(tag);
+            zero = CreateConstant(T{}, type);
+        });
+
+        ARIA_ASSERT(visited, "todo: IRBuilder::CreateZero() for non primitive types");
+        return zero;
+    }
+
+    IRInstruction* IRBuilder::Assign(Expr* target, IRInstruction* value) {
+        DeclRefExpr* ref = GetNode<DeclRefExpr>(StripParens(target));
+        ARIA_ASSERT(ref, "todo: IRBuilder::Assign() to anything but a variable");
+
+        if (ref->GetType() == DeclRefType::LocalVar) {
+            WriteVariable(ref->GetReferencedDecl(), m_Block, value);
+        } else {
+            IRInstruction* store = Append(IROpCode::StoreGlobal, nullptr, { value });
+            store->Name = fmt::format("{}", ref->GetIdentifier());
+        }
+
+        return value;
+    }
+
+    IRInstruction* IRBuilder::AssignElement(BinaryOperatorExpr* binop, ArraySubscriptExpr* subscript) {
+        TypeInfo* type = subscript->GetResolvedType();
+
+        IRInstruction* array = BuildExpr(subscript->GetBase());
+        IRInstruction* index = BuildExpr(subscript->GetIndex());
+
+        IROpCode op = IROpCode::Copy;
+        switch (binop->GetBinaryOperator()) {
+            case BinaryOperatorType::Eq: break;
+
+            case BinaryOperatorType::AddInPlace: op = IROpCode::Add; break;
+            case BinaryOperatorType::SubInPlace: op = IROpCode::Sub; break;
+            case BinaryOperatorType::MulInPlace: op = IROpCode::Mul; break;
+            case BinaryOperatorType::DivInPlace: op = IROpCode::Div; break;
+            case BinaryOperatorType::ModInPlace: op = IROpCode::Mod; break;
+
+            default: ARIA_UNREACHABLE();
+        }
+
+        IRInstruction* value = nullptr;
+        if (op == IROpCode::Copy) {
+            value = BuildExpr(binop->GetRHS());
+        } else {
+            IRInstruction* current = Append(IROpCode::ArrayLoad, type, { array, index });
+            value = Append(op, type, { current, BuildExpr(binop->GetRHS()) });
+        }
+
+        Append(IROpCode::ArrayStore, nullptr, { array, index, value });
+        return value;
+    }
+
+    void IRBuilder::Branch(IRBlock* target) {
+        if (IsTerminated()) { return; }
+
+        IRInstruction* br = Append(IROpCode::Br, nullptr);
+        br->Targets = { target };
+        target->Predecessors.push_back(m_Block);
+    }
+
+    void IRBuilder::CondBranch(IRInstruction* condition, IRBlock* trueTarget, IRBlock* falseTarget) {
+        IRInstruction* br = Append(IROpCode::CondBr, nullptr, { condition });
+        br->Targets = { trueTarget, falseTarget };
+        trueTarget->Predecessors.push_back(m_Block);
+        falseTarget->Predecessors.push_back(m_Block);
+    }
+
+    bool IRBuilder::IsTerminated() {
+        return m_Block->GetTerminator() != nullptr;
+    }
+
+    void IRBuilder::WriteVariable(Decl* decl, IRBlock* block, IRInstruction* value) {
+        m_CurrentDefs[decl][block] = value;
+    }
+
+    IRInstruction* IRBuilder::ReadVariable(Decl* decl, IRBlock* block) {
+        auto& defs = m_CurrentDefs[decl];
+
+        auto it = defs.find(block);
+        if (it != defs.end()) { return it->second; }
+
+        return ReadVariableRecursive(decl, block);
+    }
+
+    IRInstruction* IRBuilder::ReadVariableRecursive(Decl* decl, IRBlock* block) {
+        IRInstruction* value = nullptr;
+
+        if (!m_SealedBlocks.contains(block)) {
+            // Not every predecessor is known yet, the operands get filled in once the block is sealed
+            value = m_Function->CreateInstruction(IROpCode::Phi, GetDeclType(decl));
+            block->InsertPhi(value);
+            m_IncompletePhis[block].push_back({ decl, value });
+        } else if (block->Predecessors.size() == 1) {
+            value = ReadVariable(decl, block->Predecessors[0]);
+        } else {
+            value = m_Function->CreateInstruction(IROpCode::Phi, GetDeclType(decl));
+            block->InsertPhi(value);
+
+            // Written before the operands are read to break cycles
+            WriteVariable(decl, block, value);
+            AddPhiOperands(decl, value);
+        }
+
+        WriteVariable(decl, block, value);
+        return value;
+    }
+
+    void IRBuilder::AddPhiOperands(Decl* decl, IRInstruction* phi) {
+        for (IRBlock* pred : phi->Parent->Predecessors) {
+            phi->Operands.push_back(ReadVariable(decl, pred));
+            phi->IncomingBlocks.push_back(pred);
+        }
+    }
+
+    void IRBuilder::SealBlock(IRBlock* block) {
+        for (auto& [decl, phi] : m_IncompletePhis[block]) {
+            AddPhiOperands(decl, phi);
+        }
+
+        m_IncompletePhis.erase(block);
+        m_SealedBlocks.insert(block);
+    }
+
+    TypeInfo* IRBuilder::GetDeclType(Decl* decl) {
+        if (VarDecl* varDecl = GetNode<VarDecl>(decl)) {
+            return varDecl->GetResolvedType();
+        } else if (ParamDecl* paramDecl = GetNode<ParamDecl>(decl)) {
+            return paramDecl->GetResolvedType();
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+} // namespace Aria::Internal
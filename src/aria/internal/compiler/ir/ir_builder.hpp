@@ -0,0 +1,91 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/ir.hpp"
+#include "aria/internal/compiler/ast/expr.hpp"
+#include "aria/internal/compiler/ast/stmt.hpp"
+#include "aria/internal/compiler/ast/decl.hpp"
+#include "aria/internal/compiler/compilation_context.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Lowers the typed AST into SSA form
+    // Locals and parameters never get any storage, every assignment just defines a new value for the variable
+    // Phis are placed while building (Braun et al., "Simple and Efficient Construction of Static Single Assignment Form"),
+    // trivial ones are left for the copy propagation pass to clean up
+    class IRBuilder {
+    public:
+        IRBuilder(CompilationContext* ctx, IRModule* module);
+
+    private:
+        void BuildImpl();
+
+        IRInstruction* BuildBooleanConstantExpr(Expr* expr);
+        IRInstruction* BuildCharacterConstantExpr(Expr* expr);
+        IRInstruction* BuildIntegerConstantExpr(Expr* expr);
+        IRInstruction* BuildFloatingConstantExpr(Expr* expr);
+        IRInstruction* BuildStringConstantExpr(Expr* expr);
+        IRInstruction* BuildDeclRefExpr(Expr* expr);
+        IRInstruction* BuildCallExpr(Expr* expr);
+        IRInstruction* BuildMethodCallExpr(Expr* expr);
+        IRInstruction* BuildArraySubscriptExpr(Expr* expr);
+        IRInstruction* BuildParenExpr(Expr* expr);
+        IRInstruction* BuildImplicitCastExpr(Expr* expr);
+        IRInstruction* BuildUnaryOperatorExpr(Expr* expr);
+        IRInstruction* BuildBinaryOperatorExpr(Expr* expr);
+
+        IRInstruction* BuildExpr(Expr* expr);
+        // Conditions always end up as a single byte, which is what conditional jumps test
+        IRInstruction* BuildCondition(Expr* expr);
+
+        void BuildVarDecl(Decl* decl);
+        void BuildFunctionDecl(Decl* decl);
+
+        void BuildCompoundStmt(Stmt* stmt);
+        void BuildWhileStmt(Stmt* stmt);
+        void BuildDoWhileStmt(Stmt* stmt);
+        void BuildForStmt(Stmt* stmt);
+        void BuildIfStmt(Stmt* stmt);
+        void BuildReturnStmt(Stmt* stmt);
+
+        void BuildStmt(Stmt* stmt);
+        void BuildLoop(Expr* condition, Stmt* body, Expr* epilogue, bool testFirst); // condition may be nullptr
+
+        IRInstruction* Append(IROpCode op, TypeInfo* type, std::vector<IRInstruction*> operands = {});
+        IRInstruction* CreateConstant(const IRConstant& value, TypeInfo* type);
+        IRInstruction* CreateZero(TypeInfo* type);
+        IRInstruction* Assign(Expr* target, IRInstruction* value);
+        // Assignments (plain and in place) to an array element, the array and the index are only built once
+        IRInstruction* AssignElement(BinaryOperatorExpr* binop, ArraySubscriptExpr* subscript);
+
+        void Branch(IRBlock* target);
+        void CondBranch(IRInstruction* condition, IRBlock* trueTarget, IRBlock* falseTarget);
+        bool IsTerminated();
+
+        void WriteVariable(Decl* decl, IRBlock* block, IRInstruction* value);
+        IRInstruction* ReadVariable(Decl* decl, IRBlock* block);
+        IRInstruction* ReadVariableRecursive(Decl* decl, IRBlock* block);
+        void AddPhiOperands(Decl* decl, IRInstruction* phi);
+        void SealBlock(IRBlock* block);
+
+        TypeInfo* GetDeclType(Decl* decl);
+
+    private:
+        CompilationContext* m_Context = nullptr;
+        IRModule* m_Module = nullptr;
+
+        IRFunction* m_Function = nullptr;
+        IRBlock* m_Block = nullptr;
+        bool m_InGlobalScope = true; // Only the top level of _start$() declares globals
+
+        std::unordered_map<Decl*, std::unordered_map<IRBlock*, IRInstruction*>> m_CurrentDefs;
+        std::unordered_map<IRBlock*, std::vector<std::pair<Decl*, IRInstruction*>>> m_IncompletePhis;
+        std::unordered_set<IRBlock*> m_SealedBlocks;
+
+        std::vector<FunctionDecl*> m_Functions; // Built after _start$(), in the order they were declared in
+    };
+
+} // namespace Aria::Internal
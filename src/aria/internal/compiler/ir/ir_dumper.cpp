@@ -0,0 +1,100 @@
+#include "aria/internal/compiler/ir/ir_dumper.hpp"
+
+namespace Aria::Internal {
+
+    IRDumper::IRDumper(const IRModule* module) {
+        m_Module = module;
+
+        DumpImpl();
+    }
+
+    std::string& IRDumper::GetDump() {
+        return m_Output;
+    }
+
+    void IRDumper::DumpImpl() {
+        for (const auto& fn : m_Module->GetFunctions()) {
+            DumpFunction(fn.get());
+        }
+    }
+
+    void IRDumper::DumpFunction(const IRFunction* fn) {
+        m_Output += fmt::format(".function {}:\n", fn->GetName());
+
+        for (const IRBlock* block : fn->GetBlocks()) {
+            m_Output += fmt::format("bb{}:", block->Id);
+
+            if (!block->Predecessors.empty()) {
+                m_Output += " ; preds:";
+                for (const IRBlock* pred : block->Predecessors) {
+                    m_Output += fmt::format(" bb{}", pred->Id);
+                }
+            }
+
+            m_Output += "\n";
+
+            for (const IRInstruction* inst : block->Instructions) {
+                DumpInstruction(inst);
+            }
+        }
+
+        m_Output += "\n";
+    }
+
+    void IRDumper::DumpInstruction(const IRInstruction* inst) {
+        std::string line = "    ";
+
+        if (inst->HasValue()) {
+            line += fmt::format("%{} = {} {}", inst->Id, IROpCodeToString(inst->Op), TypeInfoToString(inst->Type));
+        } else {
+            line += IROpCodeToString(inst->Op);
+        }
+
+        switch (inst->Op) {
+            case IROpCode::Param: line += fmt::format(" {}", inst->ParamIndex); break;
+            case IROpCode::Const: line += fmt::format(" {}", DumpConstant(inst->Constant)); break;
+
+            case IROpCode::LoadGlobal:
+            case IROpCode::StoreGlobal:
+            case IROpCode::DeclareGlobal: line += fmt::format(" {}", inst->Name); break;
+
+            case IROpCode::Call: line += fmt::format("{} {}", inst->Extern ? " extern" : "", inst->Name); break;
+
+            default: break;
+        }
+
+        for (size_t i = 0; i < inst->Operands.size(); i++) {
+            bool first = i == 0 && (inst->Op != IROpCode::StoreGlobal && inst->Op != IROpCode::DeclareGlobal);
+            line += first ? " " : ", ";
+
+            if (inst->Op == IROpCode::Phi) {
+                line += fmt::format("[%{}, bb{}]", inst->Operands[i]->Id, inst->IncomingBlocks[i]->Id);
+            } else {
+                line += fmt::format("%{}", inst->Operands[i]->Id);
+            }
+        }
+
+        for (size_t i = 0; i < inst->Targets.size(); i++) {
+            line += (i == 0 && inst->Operands.empty()) ? " " : ", ";
+            line += fmt::format("bb{}", inst->Targets[i]->Id);
+        }
+
+        m_Output += line;
+        m_Output += "\n";
+    }
+
+    std::string IRDumper::DumpConstant(const IRConstant& constant) {
+        return std::visit([](auto v) -> std::string {
+            using T = decltype(v);
+
+            if constexpr (std::is_same_v<T, StringView>) {
+                return fmt::format("\"{}\"", v);
+            } else if constexpr (sizeof(T) == 1) {
+                return fmt::format("{}", static_cast<int>(v));
+            } else {
+                return fmt::format("{}", v);
+            }
+        }, constant);
+    }
+
+} // namespace Aria::Internal
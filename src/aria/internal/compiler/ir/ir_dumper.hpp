@@ -0,0 +1,30 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/ir.hpp"
+
+#include <string>
+
+namespace Aria::Internal {
+
+    // Produces a textual form of the IR, the IR equivalent of the Disassembler
+    // eg. "%3 = add int %1, %2"
+    class IRDumper {
+    public:
+        IRDumper(const IRModule* module);
+
+        std::string& GetDump();
+
+    private:
+        void DumpImpl();
+        void DumpFunction(const IRFunction* fn);
+        void DumpInstruction(const IRInstruction* inst);
+
+        std::string DumpConstant(const IRConstant& constant);
+
+    private:
+        const IRModule* m_Module = nullptr;
+
+        std::string m_Output;
+    };
+
+} // namespace Aria::Internal
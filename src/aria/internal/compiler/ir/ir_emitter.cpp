@@ -0,0 +1,700 @@
+#include "aria/internal/compiler/ir/ir_emitter.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
+
+#include <algorithm>
+
+namespace Aria::Internal {
+
+    static std::string GetLabel(const IRBlock* block) {
+        return fmt::format("bb{}", block->Id);
+    }
+
+    IREmitter::IREmitter(CompilationContext* ctx, IRModule* module) {
+        m_Context = ctx;
+        m_Module = module;
+
+        EmitImpl();
+    }
+
+    void IREmitter::EmitImpl() {
+        for (auto& fn : m_Module->GetFunctions()) {
+            m_FunctionMap[fn->GetName()] = fn.get();
+        }
+
+        for (auto& fn : m_Module->GetFunctions()) {
+            EmitFunction(fn.get());
+        }
+
+        m_Context->SetOpCodes(std::move(m_OpCodes));
+        m_OpCodes.clear();
+    }
+
+    void IREmitter::EmitFunction(IRFunction* fn) {
+        m_Function = fn;
+        m_IsStart = fn->GetName() == "_start$()";
+        m_Height = 0;
+        m_Slots.clear();
+        m_EdgeStubs.clear();
+
+        m_OpCodes.emplace_back(OpCodeType::Function, fn->GetName());
+        m_OpCodes.emplace_back(OpCodeType::Label, "_entry$");
+        m_OpCodes.emplace_back(OpCodeType::PushSF);
+
+        std::vector<IRBlock*> order = fn->GetReversePostOrder();
+        CollectImmediates(order);
+        CollectCompareJumps(order);
+        ComputeBlockHeights(order);
+
+        for (size_t i = 0; i < order.size(); i++) {
+            EmitBlock(order[i], (i + 1 < order.size()) ? order[i + 1] : nullptr);
+        }
+
+        for (const EdgeStub& stub : m_EdgeStubs) {
+            m_OpCodes.emplace_back(OpCodeType::Label, stub.Label);
+
+            m_Height = stub.Height;
+            EmitEdge(stub.From, stub.To);
+            EmitJump(stub.To, nullptr);
+        }
+    }
+
+    void IREmitter::EmitBlock(IRBlock* block, IRBlock* next) {
+        if (block != m_Function->GetEntryBlock()) {
+            m_OpCodes.emplace_back(OpCodeType::Label, GetLabel(block));
+        }
+
+        m_Height = m_BlockHeights.at(block);
+
+        // The phi values were pushed by every edge leading here
+        size_t phiCount = GetPhiCount(block);
+        for (size_t i = 0; i < phiCount; i++) {
+            m_Slots[block->Instructions[i]] = m_Height - phiCount + i;
+        }
+
+        for (size_t i = phiCount; i < block->Instructions.size(); i++) {
+            IRInstruction* inst = block->Instructions[i];
+
+            if (IsTailCall(inst)) {
+                EmitCall(inst, true);
+                break; // The ret following the call is never reached
+            } else if (inst->Op == IROpCode::Br) {
+                EmitBr(inst, next);
+            } else if (inst->Op == IROpCode::CondBr) {
+                EmitCondBr(inst, next);
+            } else {
+                EmitInstruction(inst);
+            }
+        }
+    }
+
+    void IREmitter::EmitInstruction(IRInstruction* inst) {
+        switch (inst->Op) {
+            case IROpCode::Param: {
+                size_t retSlot = (m_Function->GetReturnType()->Type == PrimitiveType::Void) ? 0 : 1;
+                i32 argSlot = -static_cast<i32>(m_Function->GetParamCount() + retSlot - inst->ParamIndex + m_Height); // The slot where the argument gets passed from
+
+                m_OpCodes.emplace_back(OpCodeType::Dup, MemRef(StackSlotRef(argSlot, inst->Type->GetSize())));
+                Push(inst);
+                break;
+            }
+
+            case IROpCode::Const: EmitConst(inst); break;
+
+            // A copy is just another name for the same slot
+            case IROpCode::Copy: m_Slots[inst] = m_Slots.at(inst->Operands[0]); break;
+
+            case IROpCode::Negate: {
+                m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::NegateI8, inst->Type), GetMemRef(inst->Operands[0]));
+                Push(inst);
+                break;
+            }
+
+            case IROpCode::Add:
+            case IROpCode::Sub:
+            case IROpCode::Mul:
+            case IROpCode::Div:
+            case IROpCode::Mod:
+            case IROpCode::Cmp:
+            case IROpCode::Ncmp:
+            case IROpCode::Lt:
+            case IROpCode::Lte:
+            case IROpCode::Gt:
+            case IROpCode::Gte: {
+                if (!IsCompareJump(inst)) { EmitBinary(inst); } // Otherwise the branch using it does the comparison
+                break;
+            }
+
+            case IROpCode::Cast: {
+                size_t index = GetVMTypeIndex(inst->Operands[0]->Type) * 10 + GetVMTypeIndex(inst->Type);
+                OpCodeType type = static_cast<OpCodeType>(static_cast<size_t>(OpCodeType::CastI8ToI8) + index);
+
+                m_OpCodes.emplace_back(type, OpCodeCast(GetMemRef(inst->Operands[0]), inst->Type));
+                Push(inst);
+                break;
+            }
+
+            case IROpCode::LoadGlobal: {
+                m_OpCodes.emplace_back(OpCodeType::Dup, MemRef(GlobalVarRef(inst->Name)));
+                Push(inst);
+                break;
+            }
+
+            case IROpCode::StoreGlobal: {
+                IRInstruction* value = inst->Operands[0];
+                ImmediateValue immediate;
+
+                if (IsImmediate(value) && GetImmediate(value, immediate)) {
+                    m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::StoreImmI8, value->Type), OpCodeImmediate(MemRef(GlobalVarRef(inst->Name)), immediate, value->Type));
+                } else {
+                    m_OpCodes.emplace_back(OpCodeType::Copy, OpCodeCopy(MemRef(GlobalVarRef(inst->Name)), GetMemRef(value)));
+                }
+
+                break;
+            }
+
+            case IROpCode::DeclareGlobal: {
+                // The global gets bound to the slot on top of the stack
+                if (inst->Operands.empty()) {
+                    m_OpCodes.emplace_back(OpCodeType::Alloca, OpCodeAlloca(inst->Type->GetSize(), inst->Type));
+                } else {
+                    m_OpCodes.emplace_back(OpCodeType::Dup, GetMemRef(inst->Operands[0]));
+                }
+
+                Push();
+                m_OpCodes.emplace_back(OpCodeType::SetGlobal, OpCodeSetGlobal(inst->Name));
+                break;
+            }
+
+            case IROpCode::Call: EmitCall(inst, false); break;
+
+            case IROpCode::ArrayNew: {
+                TypeInfo* elementType = std::get<ArrayDeclaration>(inst->Type->Data).Type;
+
+                m_OpCodes.emplace_back(OpCodeType::ArrayNew, OpCodeArray({}, {}, {}, elementType->GetSize(), inst->Type));
+                Push(inst);
+                break;
+            }
+
+            case IROpCode::ArrayLoad: {
+                m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::ArrayLoadI8, inst->Type), OpCodeArray(GetMemRef(inst->Operands[0]), GetMemRef(inst->Operands[1]), {}, inst->Type->GetSize(), inst->Type));
+                Push(inst);
+                break;
+            }
+
+            case IROpCode::ArrayStore:
+            case IROpCode::ArrayAppend: {
+                IRInstruction* value = inst->Operands.back();
+                MemRef index = (inst->Op == IROpCode::ArrayStore) ? GetMemRef(inst->Operands[1]) : MemRef{};
+                OpCodeType base = (inst->Op == IROpCode::ArrayStore) ? OpCodeType::ArrayStoreI8 : OpCodeType::ArrayAppendI8;
+
+                m_OpCodes.emplace_back(GetTypedOpCode(base, value->Type), OpCodeArray(GetMemRef(inst->Operands[0]), index, GetMemRef(value), value->Type->GetSize(), value->Type));
+                break;
+            }
+
+            case IROpCode::ArrayLength: {
+                TypeInfo* elementType = std::get<ArrayDeclaration>(inst->Operands[0]->Type->Data).Type;
+
+                m_OpCodes.emplace_back(OpCodeType::ArrayLength, OpCodeArray(GetMemRef(inst->Operands[0]), {}, {}, elementType->GetSize(), inst->Type));
+                Push(inst);
+                break;
+            }
+
+            case IROpCode::ArrayReserve: {
+                TypeInfo* elementType = std::get<ArrayDeclaration>(inst->Operands[0]->Type->Data).Type;
+
+                m_OpCodes.emplace_back(OpCodeType::ArrayReserve, OpCodeArray(GetMemRef(inst->Operands[0]), GetMemRef(inst->Operands[1]), {}, elementType->GetSize(), elementType));
+                break;
+            }
+
+            case IROpCode::ArrayShrinkToFit:
+            case IROpCode::ArrayClear: {
+                TypeInfo* elementType = std::get<ArrayDeclaration>(inst->Operands[0]->Type->Data).Type;
+                OpCodeType type = (inst->Op == IROpCode::ArrayShrinkToFit) ? OpCodeType::ArrayShrinkToFit : OpCodeType::ArrayClear;
+
+                m_OpCodes.emplace_back(type, OpCodeArray(GetMemRef(inst->Operands[0]), {}, {}, elementType->GetSize(), elementType));
+                break;
+            }
+
+            case IROpCode::StrConcat:
+            case IROpCode::StrCmp:
+            case IROpCode::StrNcmp:
+            case IROpCode::StrLt:
+            case IROpCode::StrLte:
+            case IROpCode::StrGt:
+            case IROpCode::StrGte:
+            case IROpCode::StrLength:
+            case IROpCode::StrHash: {
+                // Both enums list the string operations in the same order
+                OpCodeType type = static_cast<OpCodeType>(static_cast<size_t>(OpCodeType::StrConcat) + (static_cast<size_t>(inst->Op) - static_cast<size_t>(IROpCode::StrConcat)));
+                MemRef RHS = inst->Operands.size() > 1 ? GetMemRef(inst->Operands[1]) : MemRef{};
+
+                m_OpCodes.emplace_back(type, OpCodeMath(GetMemRef(inst->Operands[0]), RHS, inst->Type));
+                Push(inst);
+                break;
+            }
+
+            case IROpCode::Ret: EmitRet(inst); break;
+
+            default: ARIA_UNREACHABLE();
+        }
+    }
+
+    void IREmitter::EmitConst(IRInstruction* inst) {
+        if (IsImmediate(inst)) { return; } // Every user has it in its op code
+
+        std::visit([&](auto v) {
+            using T = decltype(v);
+            OpCodeType type = OpCodeType::LoadStr;
+
+            if constexpr (std::is_same_v<T, i8>) { type = OpCodeType::LoadI8; }
+            else if constexpr (std::is_same_v<T, i16>) { type = OpCodeType::LoadI16; }
+            else if constexpr (std::is_same_v<T, i32>) { type = OpCodeType::LoadI32; }
+            else if constexpr (std::is_same_v<T, i64>) { type = OpCodeType::LoadI64; }
+            else if constexpr (std::is_same_v<T, u8>) { type = OpCodeType::LoadU8; }
+            else if constexpr (std::is_same_v<T, u16>) { type = OpCodeType::LoadU16; }
+            else if constexpr (std::is_same_v<T, u32>) { type = OpCodeType::LoadU32; }
+            else if constexpr (std::is_same_v<T, u64>) { type = OpCodeType::LoadU64; }
+            else if constexpr (std::is_same_v<T, f32>) { type = OpCodeType::LoadF32; }
+            else if constexpr (std::is_same_v<T, f64>) { type = OpCodeType::LoadF64; }
+
+            m_OpCodes.emplace_back(type, OpCodeLoad(v, inst->Type));
+        }, inst->Constant);
+
+        Push(inst);
+    }
+
+    void IREmitter::EmitBinary(IRInstruction* inst) {
+        OpCodeType base = GetBaseOpCode(inst->Op);
+        IRInstruction* lhs = inst->Operands[0];
+        IRInstruction* rhs = inst->Operands[1];
+
+        // A constant on the left only ends up as an immediate for operations that don't care about the order, see CanUseImmediate()
+        if (IsImmediate(lhs)) {
+            GetSwappedOpCode(base, base);
+            std::swap(lhs, rhs);
+        }
+
+        OpCodeType immediate = OpCodeType::Nop;
+        if (IsImmediate(rhs) && GetImmediateOpCode(base, immediate)) {
+            ImmediateValue value;
+            GetImmediate(rhs, value);
+
+            m_OpCodes.emplace_back(GetTypedOpCode(immediate, lhs->Type), OpCodeImmediate(GetMemRef(lhs), value, inst->Type));
+            Push(inst);
+            return;
+        }
+
+        // Like the emitter, the operation is picked from the type of the left hand side
+        OpCodeType type = GetTypedOpCode(base, lhs->Type);
+        m_OpCodes.emplace_back(type, OpCodeMath(GetMemRef(lhs), GetMemRef(rhs), inst->Type));
+        Push(inst);
+    }
+
+    void IREmitter::EmitCall(IRInstruction* inst, bool tail) {
+        for (IRInstruction* arg : inst->Operands) {
+            m_OpCodes.emplace_back(OpCodeType::Dup, GetMemRef(arg));
+            Push();
+        }
+
+        size_t retCount = 0;
+        if (inst->HasValue()) {
+            retCount = 1;
+
+            // A tail call returns through the return slot of the active function instead
+            if (!tail) {
+                m_OpCodes.emplace_back(OpCodeType::Alloca, OpCodeAlloca(inst->Type->GetSize(), inst->Type));
+                Push(inst);
+            }
+        }
+
+        OpCodeType type = inst->Extern ? OpCodeType::CallExtern : OpCodeType::Call;
+        if (tail) { type = OpCodeType::TailCall; }
+
+        m_OpCodes.emplace_back(type, OpCodeCall(MemRef(FunctionRef(inst->Name)), inst->Operands.size(), retCount));
+    }
+
+    bool IREmitter::IsTailCall(IRInstruction* inst) {
+        if (inst->Op != IROpCode::Call || inst->Extern || m_IsStart) { return false; }
+
+        // Only a call whose value is returned right away, or a call of nothing followed by a plain return
+        const std::vector<IRInstruction*>& instructions = inst->Parent->Instructions;
+        auto it = std::find(instructions.begin(), instructions.end(), inst);
+        if (it + 1 == instructions.end()) { return false; }
+
+        IRInstruction* ret = *(it + 1);
+        if (ret->Op != IROpCode::Ret) { return false; }
+        if (inst->HasValue() ? (ret->Operands.size() != 1 || ret->Operands[0] != inst) : !ret->Operands.empty()) { return false; }
+
+        // The callee takes over the argument and return slots the caller of the active function set up, so they have to match exactly
+        auto callee = m_FunctionMap.find(inst->Name);
+        if (callee == m_FunctionMap.end()) { return false; }
+
+        const std::vector<TypeInfo*>& activeParams = m_Function->GetParamTypes();
+        const std::vector<TypeInfo*>& calleeParams = callee->second->GetParamTypes();
+
+        if (activeParams.size() != calleeParams.size()) { return false; }
+        if (m_Function->GetReturnType()->GetSize() != callee->second->GetReturnType()->GetSize()) { return false; }
+
+        for (size_t i = 0; i < activeParams.size(); i++) {
+            if (activeParams[i]->GetSize() != calleeParams[i]->GetSize()) { return false; }
+        }
+
+        return true;
+    }
+
+    void IREmitter::EmitRet(IRInstruction* inst) {
+        if (!inst->Operands.empty()) {
+            IRInstruction* value = inst->Operands[0];
+            MemRef retMem = { StackSlotRef(-static_cast<i32>(m_Height + 1), value->Type->GetSize()) };
+            ImmediateValue immediate;
+
+            if (IsImmediate(value) && GetImmediate(value, immediate)) {
+                m_OpCodes.emplace_back(GetTypedOpCode(OpCodeType::StoreImmI8, value->Type), OpCodeImmediate(retMem, immediate, value->Type));
+            } else {
+                m_OpCodes.emplace_back(OpCodeType::Copy, OpCodeCopy(retMem, GetMemRef(value)));
+            }
+        }
+
+        // The _start$() stack frame holds the globals, so it never gets popped
+        if (!m_IsStart) {
+            m_OpCodes.emplace_back(OpCodeType::PopSF);
+        }
+
+        m_OpCodes.emplace_back(OpCodeType::Ret);
+    }
+
+    void IREmitter::EmitBr(IRInstruction* inst, IRBlock* next) {
+        EmitEdge(inst->Parent, inst->Targets[0]);
+        EmitJump(inst->Targets[0], next);
+    }
+
+    void IREmitter::EmitCondBr(IRInstruction* inst, IRBlock* next) {
+        IRBlock* block = inst->Parent;
+        IRBlock* trueTarget = inst->Targets[0];
+        IRBlock* falseTarget = inst->Targets[1];
+
+        if (trueTarget == falseTarget) {
+            EmitBr(inst, next);
+            return;
+        }
+
+        // The edge to the block placed right after this one falls through, the other one is taken by the conditional jump
+        bool jumpIfTrue = falseTarget == next;
+        IRBlock* jumpTarget = jumpIfTrue ? trueTarget : falseTarget;
+        IRBlock* fallTarget = jumpIfTrue ? falseTarget : trueTarget;
+
+        // Jumped edges that need code go through a stub placed after the function
+        std::string label = GetLabel(jumpTarget);
+        if (NeedsEdgeCode(block, jumpTarget)) {
+            label = fmt::format("{}_{}", GetLabel(block), jumpTarget->Id);
+            m_EdgeStubs.push_back({ label, block, jumpTarget, m_Height });
+        }
+
+        if (IsCompareJump(inst->Operands[0])) {
+            EmitCompareJump(inst->Operands[0], jumpIfTrue, label);
+        } else {
+            MemRef condition = { StackSlotRef(static_cast<i32>(m_Slots.at(inst->Operands[0])), 1) };
+            m_OpCodes.emplace_back(jumpIfTrue ? OpCodeType::Jt : OpCodeType::Jf, OpCodeConditionalJump(condition, label));
+        }
+
+        EmitEdge(block, fallTarget);
+        EmitJump(fallTarget, next);
+    }
+
+    void IREmitter::EmitCompareJump(IRInstruction* inst, bool jumpIfTrue, const std::string& label) {
+        OpCodeType base = GetBaseOpCode(inst->Op);
+        IRInstruction* lhs = inst->Operands[0];
+        IRInstruction* rhs = inst->Operands[1];
+
+        // CollectCompareJumps() made sure the comparison can be negated if it has to be
+        if (!jumpIfTrue) { GetNegatedCompareOpCode(base, lhs->Type, base); }
+
+        if (IsImmediate(lhs)) {
+            GetSwappedOpCode(base, base);
+            std::swap(lhs, rhs);
+        }
+
+        OpCodeConditionalJump jump;
+        jump.Label = label;
+        jump.Mem = GetMemRef(lhs);
+
+        if (IsImmediate(rhs)) {
+            GetImmediate(rhs, jump.Value);
+            GetImmediateOpCode(base, base);
+        } else {
+            jump.RHSMem = GetMemRef(rhs);
+        }
+
+        GetCompareJumpOpCode(base, base);
+        m_OpCodes.emplace_back(GetTypedOpCode(base, lhs->Type), jump);
+    }
+
+    void IREmitter::EmitEdge(IRBlock* from, IRBlock* to) {
+        size_t phiCount = GetPhiCount(to);
+        size_t base = m_BlockHeights.at(to) - phiCount;
+
+        std::vector<IRInstruction*> values;
+        for (size_t i = 0; i < phiCount; i++) {
+            IRInstruction* phi = to->Instructions[i];
+
+            auto it = std::find(phi->IncomingBlocks.begin(), phi->IncomingBlocks.end(), from);
+            ARIA_ASSERT(it != phi->IncomingBlocks.end(), "Phi without a value for one of its predecessors");
+
+            values.push_back(phi->Operands[it - phi->IncomingBlocks.begin()]);
+        }
+
+        if (m_Height > base) {
+            EmitBackEdge(base, values);
+            return;
+        }
+
+        while (m_Height < base) {
+            TypeInfo* padType = TypeInfo::Create(m_Context, PrimitiveType::Char, true);
+            m_OpCodes.emplace_back(OpCodeType::Alloca, OpCodeAlloca(1, padType));
+            Push();
+        }
+
+        for (IRInstruction* value : values) {
+            m_OpCodes.emplace_back(OpCodeType::Dup, GetMemRef(value));
+            Push();
+        }
+    }
+
+    void IREmitter::EmitBackEdge(size_t base, const std::vector<IRInstruction*>& values) {
+        // The loop header sits below the current height, so its phi slots get overwritten in place and everything above them is popped
+        // Copying straight into the phi slots would clobber values that are still needed when one of the phis feeds another one
+        bool direct = true;
+        for (size_t i = 0; i < values.size(); i++) {
+            size_t slot = m_Slots.at(values[i]);
+            if (slot >= base && slot < base + values.size() && slot != base + i) { direct = false; }
+        }
+
+        std::vector<size_t> sources;
+        for (IRInstruction* value : values) {
+            if (direct) {
+                sources.push_back(m_Slots.at(value));
+            } else {
+                m_OpCodes.emplace_back(OpCodeType::Dup, GetMemRef(value));
+                sources.push_back(m_Height);
+                Push();
+            }
+        }
+
+        for (size_t i = 0; i < values.size(); i++) {
+            if (sources[i] == base + i) { continue; }
+
+            size_t size = values[i]->Type->GetSize();
+            m_OpCodes.emplace_back(OpCodeType::Copy, OpCodeCopy(MemRef(StackSlotRef(static_cast<i32>(base + i), size)), MemRef(StackSlotRef(static_cast<i32>(sources[i]), size))));
+        }
+
+        size_t height = base + values.size();
+        if (m_Height > height) {
+            m_OpCodes.emplace_back(OpCodeType::Pop, MemRef(StackSlotRef(static_cast<i32>(height), 0)));
+        }
+
+        m_Height = height;
+    }
+
+    bool IREmitter::NeedsEdgeCode(IRBlock* from, IRBlock* to) {
+        return GetPhiCount(to) > 0 || m_BlockEndHeights.at(from) != m_BlockHeights.at(to);
+    }
+
+    void IREmitter::EmitJump(IRBlock* to, IRBlock* next) {
+        if (to == next) { return; }
+
+        OpCodeConditionalJump jump;
+        jump.Label = GetLabel(to);
+        m_OpCodes.emplace_back(OpCodeType::Jmp, jump);
+    }
+
+    void IREmitter::ComputeBlockHeights(const std::vector<IRBlock*>& order) {
+        m_BlockHeights.clear();
+        m_BlockEndHeights.clear();
+
+        for (IRBlock* block : order) {
+            size_t height = 0;
+
+            if (block != m_Function->GetEntryBlock()) {
+                // Back edges come from blocks that aren't computed yet, they pop down to this height when they are taken
+                for (IRBlock* pred : block->Predecessors) {
+                    auto it = m_BlockEndHeights.find(pred);
+                    if (it != m_BlockEndHeights.end()) { height = std::max(height, it->second); }
+                }
+
+                height += GetPhiCount(block);
+            }
+
+            size_t end = height;
+            for (const IRInstruction* inst : block->Instructions) {
+                end += GetPushCount(inst);
+            }
+
+            m_BlockHeights[block] = height;
+            m_BlockEndHeights[block] = end;
+        }
+    }
+
+    void IREmitter::CollectImmediates(const std::vector<IRBlock*>& order) {
+        m_Immediates.clear();
+        std::unordered_set<const IRInstruction*> needsSlot;
+
+        for (IRBlock* block : order) {
+            for (IRInstruction* inst : block->Instructions) {
+                if (inst->Op == IROpCode::Const) { m_Immediates.insert(inst); }
+
+                for (size_t i = 0; i < inst->Operands.size(); i++) {
+                    if (inst->Operands[i]->Op == IROpCode::Const && !CanUseImmediate(inst, i)) { needsSlot.insert(inst->Operands[i]); }
+                }
+            }
+        }
+
+        for (const IRInstruction* inst : needsSlot) {
+            m_Immediates.erase(inst);
+        }
+    }
+
+    bool IREmitter::CanUseImmediate(const IRInstruction* inst, size_t index) {
+        const IRInstruction* operand = inst->Operands[index];
+
+        ImmediateValue value;
+        if (!GetImmediate(operand, value) || !IsImmediateOfType(value, operand->Type)) { return false; }
+
+        // Stored straight into the return slot or the global
+        if (inst->Op == IROpCode::Ret || inst->Op == IROpCode::StoreGlobal) { return true; }
+
+        OpCodeType base = GetBaseOpCode(inst->Op);
+        OpCodeType other = OpCodeType::Nop;
+        if (!GetImmediateOpCode(base, other)) { return false; }
+
+        // The operation is picked from the type of the other operand
+        const IRInstruction* lhs = inst->Operands[1 - index];
+        if (!IsImmediateOfType(value, lhs->Type)) { return false; }
+        if (index == 1) { return true; }
+
+        // A constant on the left swaps the operands, so only one of them can be the immediate
+        return lhs->Op != IROpCode::Const && GetSwappedOpCode(base, other);
+    }
+
+    void IREmitter::CollectCompareJumps(const std::vector<IRBlock*>& order) {
+        m_CompareJumps.clear();
+
+        std::unordered_map<const IRInstruction*, size_t> uses;
+        for (IRBlock* block : order) {
+            for (IRInstruction* inst : block->Instructions) {
+                for (IRInstruction* operand : inst->Operands) { uses[operand]++; }
+            }
+        }
+
+        for (size_t i = 0; i < order.size(); i++) {
+            IRInstruction* br = order[i]->GetTerminator();
+            if (!br || br->Op != IROpCode::CondBr || br->Targets[0] == br->Targets[1]) { continue; }
+
+            IRInstruction* condition = br->Operands[0];
+            OpCodeType base = GetBaseOpCode(condition->Op);
+            OpCodeType jump = OpCodeType::Nop;
+            if (condition->Parent != order[i] || uses.at(condition) != 1 || !GetCompareJumpOpCode(base, jump)) { continue; }
+
+            // Unless the false target comes right after the block, the jump is taken when the comparison fails, see EmitCondBr()
+            IRBlock* next = (i + 1 < order.size()) ? order[i + 1] : nullptr;
+            bool jumpIfTrue = br->Targets[1] == next;
+            if (!jumpIfTrue && !GetNegatedCompareOpCode(base, condition->Operands[0]->Type, base)) { continue; }
+
+            m_CompareJumps.insert(condition);
+        }
+    }
+
+    bool IREmitter::IsCompareJump(const IRInstruction* inst) const {
+        return m_CompareJumps.contains(inst);
+    }
+
+    OpCodeType IREmitter::GetBaseOpCode(IROpCode op) {
+        switch (op) {
+            case IROpCode::Add:  return OpCodeType::AddI8;
+            case IROpCode::Sub:  return OpCodeType::SubI8;
+            case IROpCode::Mul:  return OpCodeType::MulI8;
+            case IROpCode::Div:  return OpCodeType::DivI8;
+            case IROpCode::Mod:  return OpCodeType::ModI8;
+            case IROpCode::Cmp:  return OpCodeType::CmpI8;
+            case IROpCode::Ncmp: return OpCodeType::NcmpI8;
+            case IROpCode::Lt:   return OpCodeType::LtI8;
+            case IROpCode::Lte:  return OpCodeType::LteI8;
+            case IROpCode::Gt:   return OpCodeType::GtI8;
+            case IROpCode::Gte:  return OpCodeType::GteI8;
+            default: return OpCodeType::Nop;
+        }
+    }
+
+    bool IREmitter::IsImmediate(const IRInstruction* inst) const {
+        return m_Immediates.contains(inst);
+    }
+
+    bool IREmitter::GetImmediate(const IRInstruction* inst, ImmediateValue& value) {
+        if (inst->Op != IROpCode::Const) { return false; }
+
+        return std::visit([&value](auto v) {
+            if constexpr (std::is_same_v<decltype(v), StringView>) {
+                return false;
+            } else {
+                value = v;
+                return true;
+            }
+        }, inst->Constant);
+    }
+
+    MemRef IREmitter::GetMemRef(IRInstruction* inst) {
+        return { StackSlotRef(static_cast<i32>(m_Slots.at(inst)), inst->Type->GetSize()) };
+    }
+
+    void IREmitter::Push(IRInstruction* inst) {
+        if (inst) { m_Slots[inst] = m_Height; }
+        m_Height++;
+    }
+
+    size_t IREmitter::GetPushCount(const IRInstruction* inst) const {
+        switch (inst->Op) {
+            case IROpCode::Const: return IsImmediate(inst) ? 0 : 1;
+
+            case IROpCode::Cmp:
+            case IROpCode::Ncmp:
+            case IROpCode::Lt:
+            case IROpCode::Lte:
+            case IROpCode::Gt:
+            case IROpCode::Gte: return IsCompareJump(inst) ? 0 : 1;
+
+            case IROpCode::Param:
+            case IROpCode::Negate:
+            case IROpCode::Add:
+            case IROpCode::Sub:
+            case IROpCode::Mul:
+            case IROpCode::Div:
+            case IROpCode::Mod:
+            case IROpCode::Cast:
+            case IROpCode::LoadGlobal:
+            case IROpCode::DeclareGlobal:
+            case IROpCode::ArrayNew:
+            case IROpCode::ArrayLoad:
+            case IROpCode::ArrayLength:
+            case IROpCode::StrConcat:
+            case IROpCode::StrCmp:
+            case IROpCode::StrNcmp:
+            case IROpCode::StrLt:
+            case IROpCode::StrLte:
+            case IROpCode::StrGt:
+            case IROpCode::StrGte:
+            case IROpCode::StrLength:
+            case IROpCode::StrHash: return 1;
+
+            case IROpCode::Call: return inst->Operands.size() + (inst->HasValue() ? 1 : 0);
+
+            default: return 0; // Phis are pushed by the edges leading to their block
+        }
+    }
+
+    size_t IREmitter::GetPhiCount(const IRBlock* block) {
+        size_t count = 0;
+        while (count < block->Instructions.size() && block->Instructions[count]->Op == IROpCode::Phi) { count++; }
+
+        return count;
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/ir.hpp"
+#include "aria/internal/compiler/compilation_context.hpp"
+#include "aria/internal/vm/op_codes.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Lowers the IR back into byte code, the replacement of Emitter when the SSA pipeline is enabled
+    // Every value gets the stack slot it was pushed into, slots are only popped by loop back edges so a value
+    // stays valid everywhere its definition dominates (the loop recomputes whatever gets popped before it is used again)
+    // Blocks start at a fixed stack height, forward edges pad the stack up to it and then push the phi values in order,
+    // back edges copy the phi values into the slots of the loop header and pop everything above them
+    // Constants only used where an op code can take them as an immediate never get a slot at all,
+    // neither do comparisons only used by the conditional branch of their block which become a fused compare and branch
+    class IREmitter {
+    private:
+        // The code for a conditional edge that isn't taken by falling through
+        struct EdgeStub {
+            std::string Label;
+            IRBlock* From = nullptr;
+            IRBlock* To = nullptr;
+            size_t Height = 0; // The stack height at the jump
+        };
+
+    public:
+        IREmitter(CompilationContext* ctx, IRModule* module);
+
+    private:
+        void EmitImpl();
+        void EmitFunction(IRFunction* fn);
+        void EmitBlock(IRBlock* block, IRBlock* next);
+        void EmitInstruction(IRInstruction* inst);
+
+        void EmitConst(IRInstruction* inst);
+        void EmitBinary(IRInstruction* inst);
+        void EmitCall(IRInstruction* inst, bool tail);
+        // A call that can reuse the active stack frame, see VM::ReplaceStackFrame()
+        bool IsTailCall(IRInstruction* inst);
+        void EmitRet(IRInstruction* inst);
+        void EmitBr(IRInstruction* inst, IRBlock* next);
+        void EmitCondBr(IRInstruction* inst, IRBlock* next);
+        void EmitCompareJump(IRInstruction* inst, bool jumpIfTrue, const std::string& label);
+
+        // Pads the stack to the height the target expects and pushes its phi values
+        void EmitEdge(IRBlock* from, IRBlock* to);
+        void EmitBackEdge(size_t base, const std::vector<IRInstruction*>& values);
+        bool NeedsEdgeCode(IRBlock* from, IRBlock* to);
+        void EmitJump(IRBlock* to, IRBlock* next);
+
+        // Computes the stack height every block starts at, only forward edges are supported
+        void ComputeBlockHeights(const std::vector<IRBlock*>& order);
+
+        // Finds the constants of the active function that are only ever used as immediates
+        void CollectImmediates(const std::vector<IRBlock*>& order);
+        // Whether the operand at index can be passed to the op code of inst as an immediate
+        bool CanUseImmediate(const IRInstruction* inst, size_t index);
+        bool IsImmediate(const IRInstruction* inst) const;
+
+        // Finds the comparisons of the active function that get fused into the conditional branch using them
+        void CollectCompareJumps(const std::vector<IRBlock*>& order);
+        bool IsCompareJump(const IRInstruction* inst) const;
+        // Returns false for string constants
+        static bool GetImmediate(const IRInstruction* inst, ImmediateValue& value);
+        // The I8 variant of the op code an arithmetic or comparison instruction becomes, Nop for every other instruction
+        static OpCodeType GetBaseOpCode(IROpCode op);
+
+        MemRef GetMemRef(IRInstruction* inst);
+        // Every op code pushing a slot has to go through here, the slot is remembered for the instruction if there is one
+        void Push(IRInstruction* inst = nullptr);
+
+        size_t GetPushCount(const IRInstruction* inst) const;
+        static size_t GetPhiCount(const IRBlock* block);
+
+    private:
+        CompilationContext* m_Context = nullptr;
+        IRModule* m_Module = nullptr;
+        std::unordered_map<std::string, IRFunction*> m_FunctionMap; // By signature
+
+        std::vector<OpCode> m_OpCodes;
+
+        IRFunction* m_Function = nullptr;
+        bool m_IsStart = false;
+        size_t m_Height = 0;
+
+        std::unordered_map<IRInstruction*, size_t> m_Slots;
+        std::unordered_set<const IRInstruction*> m_Immediates;
+        std::unordered_set<const IRInstruction*> m_CompareJumps;
+        std::unordered_map<IRBlock*, size_t> m_BlockHeights; // Including the phis of the block
+        std::unordered_map<IRBlock*, size_t> m_BlockEndHeights;
+        std::vector<EdgeStub> m_EdgeStubs;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,62 @@
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+#include "aria/internal/compiler/ir/passes/copy_propagation.hpp"
+#include "aria/internal/compiler/ir/passes/sparse_conditional_constant_propagation.hpp"
+#include "aria/internal/compiler/ir/passes/common_subexpression_elimination.hpp"
+#include "aria/internal/compiler/ir/passes/loop_invariant_code_motion.hpp"
+#include "aria/internal/compiler/ir/passes/strength_reduction.hpp"
+#include "aria/internal/compiler/ir/passes/dead_code_elimination.hpp"
+#include "aria/internal/compiler/ir/passes/simplify_cfg.hpp"
+#include "aria/internal/compiler/ir/passes/inliner.hpp"
+
+namespace Aria::Internal {
+
+    IRPassManager IRPassManager::CreateDefault(size_t inlineBudget) {
+        IRPassManager pm;
+
+        pm.AddPass<CopyPropagationPass>();
+        pm.AddPass<SCCPPass>();
+        pm.AddPass<CopyPropagationPass>(); // SCCP turns phis whose only live operand is left into trivial ones
+        pm.AddPass<CSEPass>();
+        pm.AddPass<LICMPass>();
+        pm.AddPass<StrengthReductionPass>();
+        pm.AddPass<DCEPass>();
+        pm.AddPass<SimplifyCFGPass>();
+
+        if (inlineBudget > 0) {
+            pm.AddModulePass(std::make_unique<InlinerPass>(inlineBudget));
+        }
+
+        return pm;
+    }
+
+    void IRPassManager::AddPass(std::unique_ptr<IRPass> pass) {
+        m_Passes.push_back(std::move(pass));
+    }
+
+    void IRPassManager::AddModulePass(std::unique_ptr<IRModulePass> pass) {
+        m_ModulePasses.push_back(std::move(pass));
+    }
+
+    void IRPassManager::Run(IRModule& module) {
+        RunFunctionPasses(module);
+
+        for (auto& pass : m_ModulePasses) {
+            if (pass->Run(module)) { RunFunctionPasses(module); }
+        }
+    }
+
+    void IRPassManager::RunFunctionPasses(IRModule& module) {
+        for (auto& fn : module.GetFunctions()) {
+            for (size_t i = 0; i < MaxIterations; i++) {
+                bool changed = false;
+
+                for (auto& pass : m_Passes) {
+                    changed |= pass->Run(*fn);
+                }
+
+                if (!changed) { break; }
+            }
+        }
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/ir.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace Aria::Internal {
+
+    class IRPass {
+    public:
+        virtual ~IRPass() = default;
+
+        virtual const char* GetName() const = 0;
+        // Returns true if the function was changed
+        virtual bool Run(IRFunction& fn) = 0;
+    };
+
+    // A pass that needs to see more than one function at a time (eg. inlining)
+    class IRModulePass {
+    public:
+        virtual ~IRModulePass() = default;
+
+        virtual const char* GetName() const = 0;
+        // Returns true if any function was changed
+        virtual bool Run(IRModule& module) = 0;
+    };
+
+    // Runs its passes in order over every function of a module, repeating the whole pipeline while anything changes
+    // The module passes run afterwards on the optimized functions, every function gets optimized again if one of them changed anything
+    class IRPassManager {
+    public:
+        // The pipeline used by CompilationContext, an inline budget of 0 disables inlining
+        static IRPassManager CreateDefault(size_t inlineBudget = 0);
+
+        void AddPass(std::unique_ptr<IRPass> pass);
+        void AddModulePass(std::unique_ptr<IRModulePass> pass);
+
+        template <typename T>
+        void AddPass() { AddPass(std::make_unique<T>()); }
+
+        void Run(IRModule& module);
+
+    private:
+        void RunFunctionPasses(IRModule& module);
+
+    private:
+        static constexpr size_t MaxIterations = 8;
+
+        std::vector<std::unique_ptr<IRPass>> m_Passes;
+        std::vector<std::unique_ptr<IRModulePass>> m_ModulePasses;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,67 @@
+#include "aria/internal/compiler/ir/passes/common_subexpression_elimination.hpp"
+
+namespace Aria::Internal {
+
+    bool CSEPass::Run(IRFunction& fn) {
+        m_Available.clear();
+        m_Changed = false;
+
+        fn.ComputeDominators();
+        VisitBlock(fn, fn.GetEntryBlock());
+
+        return m_Changed;
+    }
+
+    void CSEPass::VisitBlock(IRFunction& fn, IRBlock* block) {
+        std::vector<IRInstruction*> added;
+
+        for (size_t i = 0; i < block->Instructions.size(); i++) {
+            IRInstruction* inst = block->Instructions[i];
+            if (!inst->IsPure()) { continue; }
+
+            if (IRInstruction* existing = FindEquivalent(inst)) {
+                fn.ReplaceAllUsesWith(inst, existing);
+                fn.RemoveInstruction(inst);
+                i--;
+
+                m_Changed = true;
+                continue;
+            }
+
+            m_Available[inst->Op].push_back(inst);
+            added.push_back(inst);
+        }
+
+        for (IRBlock* child : block->DominatedBlocks) {
+            VisitBlock(fn, child);
+        }
+
+        // Leaving the block, whatever it computed is no longer available to its siblings
+        for (IRInstruction* inst : added) {
+            m_Available[inst->Op].pop_back();
+        }
+    }
+
+    IRInstruction* CSEPass::FindEquivalent(IRInstruction* inst) {
+        auto it = m_Available.find(inst->Op);
+        if (it == m_Available.end()) { return nullptr; }
+
+        for (IRInstruction* candidate : it->second) {
+            if (IsEquivalent(candidate, inst)) { return candidate; }
+        }
+
+        return nullptr;
+    }
+
+    bool CSEPass::IsEquivalent(const IRInstruction* lhs, const IRInstruction* rhs) {
+        if (lhs->Op != rhs->Op || lhs->Operands != rhs->Operands) { return false; }
+        if (!TypeInfo::IsEqual(lhs->Type, rhs->Type)) { return false; }
+
+        if (lhs->Op == IROpCode::Const) {
+            return lhs->Constant == rhs->Constant;
+        }
+
+        return true;
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Dominator based value numbering
+    // A pure instruction computing the same thing as one in a dominating block (or earlier in its own block) gets replaced by it
+    class CSEPass : public IRPass {
+    public:
+        virtual const char* GetName() const override { return "cse"; }
+        virtual bool Run(IRFunction& fn) override;
+
+    private:
+        void VisitBlock(IRFunction& fn, IRBlock* block);
+
+        // Returns an available instruction computing the same value, nullptr if there is none
+        IRInstruction* FindEquivalent(IRInstruction* inst);
+        static bool IsEquivalent(const IRInstruction* lhs, const IRInstruction* rhs);
+
+    private:
+        std::unordered_map<IROpCode, std::vector<IRInstruction*>> m_Available; // Every pure instruction of the dominating blocks
+        bool m_Changed = false;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,53 @@
+#include "aria/internal/compiler/ir/passes/copy_propagation.hpp"
+
+namespace Aria::Internal {
+
+    bool CopyPropagationPass::Run(IRFunction& fn) {
+        bool changed = false;
+
+        // Removing a trivial phi can make the phis using it trivial, so keep going until nothing is left
+        bool removed = true;
+        while (removed) {
+            removed = false;
+
+            for (IRBlock* block : fn.GetBlocks()) {
+                for (size_t i = 0; i < block->Instructions.size(); i++) {
+                    IRInstruction* inst = block->Instructions[i];
+                    IRInstruction* value = nullptr;
+
+                    if (inst->Op == IROpCode::Copy) {
+                        value = inst->Operands[0];
+                    } else if (inst->Op == IROpCode::Phi) {
+                        value = GetTrivialPhiValue(inst);
+                    }
+
+                    if (!value) { continue; }
+
+                    fn.ReplaceAllUsesWith(inst, value);
+                    fn.RemoveInstruction(inst);
+                    i--;
+
+                    removed = true;
+                    changed = true;
+                }
+            }
+        }
+
+        return changed;
+    }
+
+    IRInstruction* CopyPropagationPass::GetTrivialPhiValue(IRInstruction* phi) {
+        IRInstruction* value = nullptr;
+
+        for (IRInstruction* op : phi->Operands) {
+            if (op == phi || op == value) { continue; }
+            if (value) { return nullptr; }
+
+            value = op;
+        }
+
+        // A phi only referring to itself is in unreachable code, which the builder already dropped
+        return value;
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+
+namespace Aria::Internal {
+
+    // Replaces every use of a copy with the value it copies
+    // Phis whose operands are all the same value (or the phi itself) are copies as well and get the same treatment
+    class CopyPropagationPass : public IRPass {
+    public:
+        virtual const char* GetName() const override { return "copy-propagation"; }
+        virtual bool Run(IRFunction& fn) override;
+
+    private:
+        // Returns the value a trivial phi stands for, nullptr if the phi really merges different values
+        static IRInstruction* GetTrivialPhiValue(IRInstruction* phi);
+    };
+
+} // namespace Aria::Internal
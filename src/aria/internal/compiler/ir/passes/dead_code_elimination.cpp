@@ -0,0 +1,42 @@
+#include "aria/internal/compiler/ir/passes/dead_code_elimination.hpp"
+
+#include <unordered_set>
+
+namespace Aria::Internal {
+
+    bool DCEPass::Run(IRFunction& fn) {
+        std::unordered_set<IRInstruction*> live;
+        std::vector<IRInstruction*> worklist;
+
+        for (IRBlock* block : fn.GetBlocks()) {
+            for (IRInstruction* inst : block->Instructions) {
+                if (inst->HasSideEffects() && live.insert(inst).second) { worklist.push_back(inst); }
+            }
+        }
+
+        while (!worklist.empty()) {
+            IRInstruction* inst = worklist.back();
+            worklist.pop_back();
+
+            for (IRInstruction* op : inst->Operands) {
+                if (live.insert(op).second) { worklist.push_back(op); }
+            }
+        }
+
+        bool changed = false;
+        for (IRBlock* block : fn.GetBlocks()) {
+            size_t count = block->Instructions.size();
+            std::erase_if(block->Instructions, [&](IRInstruction* inst) {
+                if (live.contains(inst)) { return false; }
+
+                inst->Parent = nullptr;
+                return true;
+            });
+
+            changed |= count != block->Instructions.size();
+        }
+
+        return changed;
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+
+namespace Aria::Internal {
+
+    // Removes every instruction without side effects whose value is never used, including unused phis
+    // Only instructions that are live (transitively used by something with side effects) are kept, so dead phi cycles go away as well
+    class DCEPass : public IRPass {
+    public:
+        virtual const char* GetName() const override { return "dce"; }
+        virtual bool Run(IRFunction& fn) override;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,236 @@
+#include "aria/internal/compiler/ir/passes/inliner.hpp"
+
+#include <algorithm>
+
+namespace Aria::Internal {
+
+    InlinerPass::InlinerPass(size_t budget) {
+        m_Budget = budget;
+    }
+
+    bool InlinerPass::Run(IRModule& module) {
+        m_Functions.clear();
+        m_Callees.clear();
+        m_Recursive.clear();
+
+        for (auto& fn : module.GetFunctions()) {
+            m_Functions[fn->GetName()] = fn.get();
+        }
+
+        CollectCallees(module);
+
+        for (auto& fn : module.GetFunctions()) {
+            if (CanReach(fn.get(), fn.get())) { m_Recursive.insert(fn.get()); }
+        }
+
+        // Callees first, so the size of a function already includes whatever got inlined into it
+        std::unordered_set<IRFunction*> visited;
+        std::vector<IRFunction*> order;
+        for (auto& fn : module.GetFunctions()) {
+            VisitFunction(fn.get(), visited, order);
+        }
+
+        bool changed = false;
+        for (IRFunction* fn : order) {
+            changed |= InlineCalls(*fn);
+        }
+
+        return changed;
+    }
+
+    size_t InlinerPass::GetInlineCost(const IRFunction& fn) {
+        size_t cost = 0;
+
+        for (const IRBlock* block : fn.GetBlocks()) {
+            for (const IRInstruction* inst : block->Instructions) {
+                switch (inst->Op) {
+                    case IROpCode::Param:
+                    case IROpCode::Copy:
+                    case IROpCode::Phi:
+                    case IROpCode::Br: break;
+
+                    default: cost++; break;
+                }
+            }
+        }
+
+        return cost;
+    }
+
+    void InlinerPass::CollectCallees(IRModule& module) {
+        for (auto& fn : module.GetFunctions()) {
+            std::vector<IRFunction*>& callees = m_Callees[fn.get()];
+
+            for (IRBlock* block : fn->GetBlocks()) {
+                for (IRInstruction* inst : block->Instructions) {
+                    if (inst->Op != IROpCode::Call || inst->Extern) { continue; }
+
+                    auto it = m_Functions.find(inst->Name);
+                    if (it != m_Functions.end() && std::find(callees.begin(), callees.end(), it->second) == callees.end()) {
+                        callees.push_back(it->second);
+                    }
+                }
+            }
+        }
+    }
+
+    bool InlinerPass::CanReach(IRFunction* from, IRFunction* to) {
+        std::unordered_set<IRFunction*> visited;
+        std::vector<IRFunction*> worklist = m_Callees[from];
+
+        while (!worklist.empty()) {
+            IRFunction* fn = worklist.back();
+            worklist.pop_back();
+
+            if (fn == to) { return true; }
+            if (!visited.insert(fn).second) { continue; }
+
+            for (IRFunction* callee : m_Callees[fn]) {
+                worklist.push_back(callee);
+            }
+        }
+
+        return false;
+    }
+
+    void InlinerPass::VisitFunction(IRFunction* fn, std::unordered_set<IRFunction*>& visited, std::vector<IRFunction*>& order) {
+        if (!visited.insert(fn).second) { return; }
+
+        for (IRFunction* callee : m_Callees[fn]) {
+            VisitFunction(callee, visited, order);
+        }
+
+        order.push_back(fn);
+    }
+
+    bool InlinerPass::InlineCalls(IRFunction& caller) {
+        bool changed = false;
+
+        // Inlining splits blocks, so start over after every call site
+        bool inlined = true;
+        while (inlined) {
+            inlined = false;
+
+            for (IRBlock* block : caller.GetBlocks()) {
+                for (IRInstruction* inst : block->Instructions) {
+                    if (inst->Op != IROpCode::Call || inst->Extern) { continue; }
+
+                    auto it = m_Functions.find(inst->Name);
+                    if (it == m_Functions.end()) { continue; }
+
+                    IRFunction* callee = it->second;
+                    if (callee == &caller || m_Recursive.contains(callee) || GetInlineCost(*callee) > m_Budget) { continue; }
+
+                    InlineCall(caller, inst, *callee);
+                    inlined = true;
+                    break;
+                }
+
+                if (inlined) { break; }
+            }
+
+            changed |= inlined;
+        }
+
+        return changed;
+    }
+
+    void InlinerPass::InlineCall(IRFunction& caller, IRInstruction* call, IRFunction& callee) {
+        IRBlock* block = call->Parent;
+
+        // Everything after the call moves into a new block, which the returns of the callee branch to
+        IRBlock* cont = caller.CreateBlock();
+        auto callIt = std::find(block->Instructions.begin(), block->Instructions.end(), call);
+
+        for (auto it = callIt + 1; it != block->Instructions.end(); ++it) {
+            cont->Append(*it);
+        }
+        block->Instructions.erase(callIt, block->Instructions.end());
+
+        // The successors now get reached from the new block
+        for (IRBlock* succ : cont->GetSuccessors()) {
+            for (IRInstruction* phi : succ->Instructions) {
+                if (phi->Op != IROpCode::Phi) { break; }
+                std::replace(phi->IncomingBlocks.begin(), phi->IncomingBlocks.end(), block, cont);
+            }
+        }
+
+        std::unordered_map<IRBlock*, IRBlock*> blocks;
+        std::unordered_map<IRInstruction*, IRInstruction*> values;
+
+        for (IRBlock* calleeBlock : callee.GetBlocks()) {
+            blocks[calleeBlock] = caller.CreateBlock();
+        }
+
+        for (IRBlock* calleeBlock : callee.GetBlocks()) {
+            for (IRInstruction* inst : calleeBlock->Instructions) {
+                if (inst->Op == IROpCode::Param) {
+                    values[inst] = call->Operands[inst->ParamIndex];
+                    continue;
+                }
+
+                IRInstruction* clone = caller.CreateInstruction(inst->Op, inst->Type);
+                clone->Constant = inst->Constant;
+                clone->Name = inst->Name;
+                clone->ParamIndex = inst->ParamIndex;
+                clone->Extern = inst->Extern;
+
+                values[inst] = clone;
+            }
+        }
+
+        // Operands can refer to instructions defined later on (eg. in phis), so they are only mapped once everything got cloned
+        std::vector<std::pair<IRInstruction*, IRBlock*>> returns;
+
+        for (IRBlock* calleeBlock : callee.GetBlocks()) {
+            IRBlock* clonedBlock = blocks.at(calleeBlock);
+
+            for (IRInstruction* inst : calleeBlock->Instructions) {
+                if (inst->Op == IROpCode::Param) { continue; }
+
+                IRInstruction* clone = values.at(inst);
+
+                for (IRInstruction* op : inst->Operands) { clone->Operands.push_back(values.at(op)); }
+                for (IRBlock* incoming : inst->IncomingBlocks) { clone->IncomingBlocks.push_back(blocks.at(incoming)); }
+                for (IRBlock* target : inst->Targets) { clone->Targets.push_back(blocks.at(target)); }
+
+                if (inst->Op == IROpCode::Ret) {
+                    if (!clone->Operands.empty()) { returns.push_back({ clone->Operands[0], clonedBlock }); }
+
+                    clone->Op = IROpCode::Br;
+                    clone->Operands.clear();
+                    clone->Targets = { cont };
+                }
+
+                clonedBlock->Append(clone);
+            }
+        }
+
+        IRInstruction* jump = caller.CreateInstruction(IROpCode::Br);
+        jump->Targets = { blocks.at(callee.GetEntryBlock()) };
+        block->Append(jump);
+
+        if (call->HasValue()) {
+            IRInstruction* result = nullptr;
+
+            if (returns.size() == 1) {
+                result = returns[0].first;
+            } else {
+                result = caller.CreateInstruction(IROpCode::Phi, call->Type);
+
+                for (auto& [value, from] : returns) {
+                    result->Operands.push_back(value);
+                    result->IncomingBlocks.push_back(from);
+                }
+
+                cont->InsertPhi(result);
+            }
+
+            caller.ReplaceAllUsesWith(call, result);
+        }
+
+        call->Parent = nullptr;
+        caller.RecomputePredecessors();
+    }
+
+} // namespace Aria::Internal
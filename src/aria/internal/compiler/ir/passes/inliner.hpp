@@ -0,0 +1,41 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Replaces calls to small script functions with a copy of their body
+    // Only non extern, non recursive functions whose size (see GetInlineCost()) is within the budget get inlined
+    // Callees are handled before their callers, so a function is measured with its own calls already inlined
+    // The callee itself is left alone, the host (or a function pointer) can still call it
+    class InlinerPass : public IRModulePass {
+    public:
+        InlinerPass(size_t budget);
+
+        virtual const char* GetName() const override { return "inliner"; }
+        virtual bool Run(IRModule& module) override;
+
+        // The number of instructions that turn into op codes, parameters, copies, phis and branches are (almost) free once inlined
+        static size_t GetInlineCost(const IRFunction& fn);
+
+    private:
+        void CollectCallees(IRModule& module);
+        bool CanReach(IRFunction* from, IRFunction* to);
+        void VisitFunction(IRFunction* fn, std::unordered_set<IRFunction*>& visited, std::vector<IRFunction*>& order);
+
+        bool InlineCalls(IRFunction& caller);
+        void InlineCall(IRFunction& caller, IRInstruction* call, IRFunction& callee);
+
+    private:
+        size_t m_Budget = 0;
+
+        std::unordered_map<std::string, IRFunction*> m_Functions;
+        std::unordered_map<IRFunction*, std::vector<IRFunction*>> m_Callees;
+        std::unordered_set<IRFunction*> m_Recursive;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,47 @@
+#include "aria/internal/compiler/ir/passes/loop_invariant_code_motion.hpp"
+
+namespace Aria::Internal {
+
+    bool LICMPass::Run(IRFunction& fn) {
+        bool changed = false;
+
+        for (const IRLoop& loop : fn.FindLoops()) {
+            if (!loop.Preheader) { continue; }
+
+            // Hoisting an instruction can make the ones using it invariant, so keep going until nothing moves
+            bool hoisted = true;
+            while (hoisted) {
+                hoisted = false;
+
+                for (IRBlock* block : fn.GetReversePostOrder()) {
+                    if (!loop.Blocks.contains(block)) { continue; }
+
+                    for (size_t i = 0; i < block->Instructions.size(); i++) {
+                        IRInstruction* inst = block->Instructions[i];
+                        if (!IsHoistable(inst, loop)) { continue; }
+
+                        fn.RemoveInstruction(inst);
+                        loop.Preheader->InsertBeforeTerminator(inst);
+                        i--;
+
+                        hoisted = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        return changed;
+    }
+
+    bool LICMPass::IsHoistable(const IRInstruction* inst, const IRLoop& loop) {
+        if (!inst->IsPure() || inst->Op == IROpCode::Div || inst->Op == IROpCode::Mod) { return false; }
+
+        for (const IRInstruction* op : inst->Operands) {
+            if (loop.Contains(op)) { return false; }
+        }
+
+        return true;
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+
+namespace Aria::Internal {
+
+    // Moves pure instructions whose operands are all defined outside of a loop into the loop's preheader, so they run once instead of every iteration
+    // Division and modulo stay where they are, hoisting them out of a loop that never runs would trap on a zero divisor the program never divides by
+    class LICMPass : public IRPass {
+    public:
+        virtual const char* GetName() const override { return "licm"; }
+        virtual bool Run(IRFunction& fn) override;
+
+    private:
+        static bool IsHoistable(const IRInstruction* inst, const IRLoop& loop);
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,53 @@
+#include "aria/internal/compiler/ir/passes/simplify_cfg.hpp"
+
+#include <algorithm>
+
+namespace Aria::Internal {
+
+    bool SimplifyCFGPass::Run(IRFunction& fn) {
+        fn.RecomputePredecessors();
+
+        bool changed = false;
+        for (size_t i = 1; i < fn.GetBlocks().size(); i++) {
+            if (MergeIntoPredecessor(fn, fn.GetBlocks()[i])) {
+                changed = true;
+                i--;
+            }
+        }
+
+        return changed;
+    }
+
+    bool SimplifyCFGPass::MergeIntoPredecessor(IRFunction& fn, IRBlock* block) {
+        if (block->Predecessors.size() != 1) { return false; }
+
+        IRBlock* pred = block->Predecessors[0];
+        IRInstruction* term = pred->GetTerminator();
+        if (pred == block || !term || term->Op != IROpCode::Br) { return false; }
+
+        // The phis of a block with a single predecessor just forward their only operand
+        while (!block->Instructions.empty() && block->Instructions.front()->Op == IROpCode::Phi) {
+            IRInstruction* phi = block->Instructions.front();
+            fn.ReplaceAllUsesWith(phi, phi->Operands[0]);
+            fn.RemoveInstruction(phi);
+        }
+
+        fn.RemoveInstruction(term);
+        for (IRInstruction* inst : block->Instructions) {
+            pred->Append(inst);
+        }
+        block->Instructions.clear();
+
+        for (IRBlock* succ : pred->GetSuccessors()) {
+            for (IRInstruction* phi : succ->Instructions) {
+                if (phi->Op != IROpCode::Phi) { break; }
+                std::replace(phi->IncomingBlocks.begin(), phi->IncomingBlocks.end(), block, pred);
+            }
+        }
+
+        std::erase(fn.GetBlocks(), block);
+        fn.RecomputePredecessors();
+        return true;
+    }
+
+} // namespace Aria::Internal
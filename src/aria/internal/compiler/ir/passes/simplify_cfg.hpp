@@ -0,0 +1,19 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+
+namespace Aria::Internal {
+
+    // Merges a block into its predecessor when that predecessor unconditionally branches to it and is its only one
+    // Inlining and folded branches leave lots of these behind, every merge saves a jump (or at least a label)
+    class SimplifyCFGPass : public IRPass {
+    public:
+        virtual const char* GetName() const override { return "simplify-cfg"; }
+        virtual bool Run(IRFunction& fn) override;
+
+    private:
+        // Returns false if the block has nothing to merge with
+        static bool MergeIntoPredecessor(IRFunction& fn, IRBlock* block);
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,333 @@
+#include "aria/internal/compiler/ir/passes/sparse_conditional_constant_propagation.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
+
+#include <algorithm>
+#include <optional>
+
+namespace Aria::Internal {
+
+    // Returns the VM representation of a constant of the given type, nullptr if the constant isn't stored as T
+    template <typename T>
+    static const T* GetConstant(const IRConstant& constant) {
+        return std::get_if<T>(&constant);
+    }
+
+    bool SCCPPass::Run(IRFunction& fn) {
+        m_Values.clear();
+        m_Users.clear();
+        m_ExecutableEdges.clear();
+        m_ExecutableBlocks.clear();
+        m_EdgeWorklist.clear();
+        m_ValueWorklist.clear();
+
+        Solve(fn);
+        return Rewrite(fn);
+    }
+
+    void SCCPPass::Solve(IRFunction& fn) {
+        for (IRBlock* block : fn.GetBlocks()) {
+            for (IRInstruction* inst : block->Instructions) {
+                for (IRInstruction* op : inst->Operands) {
+                    m_Users[op].push_back(inst);
+                }
+            }
+        }
+
+        MarkEdgeExecutable(nullptr, fn.GetEntryBlock());
+
+        while (!m_EdgeWorklist.empty() || !m_ValueWorklist.empty()) {
+            while (!m_EdgeWorklist.empty()) {
+                Edge edge = m_EdgeWorklist.back();
+                m_EdgeWorklist.pop_back();
+
+                VisitEdge(edge);
+            }
+
+            while (!m_ValueWorklist.empty()) {
+                IRInstruction* inst = m_ValueWorklist.back();
+                m_ValueWorklist.pop_back();
+
+                for (IRInstruction* user : m_Users[inst]) {
+                    if (!user->Parent || !m_ExecutableBlocks.contains(user->Parent)) { continue; }
+
+                    if (user->Op == IROpCode::Phi) {
+                        VisitPhi(user);
+                    } else {
+                        VisitInstruction(user);
+                    }
+                }
+            }
+        }
+    }
+
+    void SCCPPass::VisitEdge(const Edge& edge) {
+        IRBlock* block = edge.second;
+
+        for (IRInstruction* inst : block->Instructions) {
+            if (inst->Op == IROpCode::Phi) { VisitPhi(inst); }
+        }
+
+        // The rest of the block only has to be visited the first time it is reached, afterwards the value worklist takes care of it
+        if (!m_ExecutableBlocks.insert(block).second) { return; }
+
+        for (IRInstruction* inst : block->Instructions) {
+            if (inst->Op != IROpCode::Phi) { VisitInstruction(inst); }
+        }
+    }
+
+    void SCCPPass::VisitInstruction(IRInstruction* inst) {
+        if (inst->Op == IROpCode::Br) {
+            MarkEdgeExecutable(inst->Parent, inst->Targets[0]);
+            return;
+        }
+
+        if (inst->Op == IROpCode::CondBr) {
+            const LatticeValue& condition = m_Values[inst->Operands[0]];
+
+            if (condition.State == LatticeState::Overdefined) {
+                MarkEdgeExecutable(inst->Parent, inst->Targets[0]);
+                MarkEdgeExecutable(inst->Parent, inst->Targets[1]);
+            } else if (condition.State == LatticeState::Constant) {
+                const i8* value = GetConstant<i8>(condition.Value);
+                if (value) {
+                    MarkEdgeExecutable(inst->Parent, inst->Targets[(*value != 0) ? 0 : 1]);
+                } else {
+                    MarkEdgeExecutable(inst->Parent, inst->Targets[0]);
+                    MarkEdgeExecutable(inst->Parent, inst->Targets[1]);
+                }
+            }
+
+            return;
+        }
+
+        if (!inst->HasValue()) { return; }
+
+        SetValue(inst, Evaluate(inst));
+    }
+
+    void SCCPPass::VisitPhi(IRInstruction* phi) {
+        LatticeValue result;
+
+        for (size_t i = 0; i < phi->Operands.size(); i++) {
+            if (!m_ExecutableEdges.contains({ phi->IncomingBlocks[i], phi->Parent })) { continue; }
+
+            const LatticeValue& value = m_Values[phi->Operands[i]];
+
+            if (value.State == LatticeState::Undefined) { continue; }
+
+            if (value.State == LatticeState::Overdefined || (result.State == LatticeState::Constant && !(result.Value == value.Value))) {
+                result.State = LatticeState::Overdefined;
+                break;
+            }
+
+            result = value;
+        }
+
+        SetValue(phi, result);
+    }
+
+    void SCCPPass::MarkEdgeExecutable(IRBlock* from, IRBlock* to) {
+        if (m_ExecutableEdges.insert({ from, to }).second) {
+            m_EdgeWorklist.push_back({ from, to });
+        }
+    }
+
+    void SCCPPass::SetValue(IRInstruction* inst, const LatticeValue& value) {
+        LatticeValue& current = m_Values[inst];
+
+        if (current.State == LatticeState::Overdefined || value.State == LatticeState::Undefined) { return; }
+
+        if (current.State == LatticeState::Constant) {
+            if (value.State == LatticeState::Constant && current.Value == value.Value) { return; }
+
+            current.State = LatticeState::Overdefined;
+        } else {
+            current = value;
+        }
+
+        m_ValueWorklist.push_back(inst);
+    }
+
+    SCCPPass::LatticeValue SCCPPass::Evaluate(IRInstruction* inst) {
+        LatticeValue result;
+
+        if (inst->Op == IROpCode::Const) {
+            result.State = LatticeState::Constant;
+            result.Value = inst->Constant;
+            return result;
+        }
+
+        if (inst->Op == IROpCode::Copy) {
+            return m_Values[inst->Operands[0]];
+        }
+
+        // Parameters, globals and calls can hold anything
+        if (!inst->IsPure()) {
+            result.State = LatticeState::Overdefined;
+            return result;
+        }
+
+        std::vector<IRConstant> operands;
+        for (IRInstruction* op : inst->Operands) {
+            const LatticeValue& value = m_Values[op];
+
+            if (value.State != LatticeState::Constant) {
+                result.State = value.State;
+                if (result.State == LatticeState::Overdefined) { return result; }
+            } else {
+                operands.push_back(value.Value);
+            }
+        }
+
+        // Some operand was never computed yet
+        if (operands.size() != inst->Operands.size()) { return result; }
+
+        result.State = Compute(inst, operands, result.Value) ? LatticeState::Constant : LatticeState::Overdefined;
+        return result;
+    }
+
+    bool SCCPPass::Compute(const IRInstruction* inst, const std::vector<IRConstant>& operands, IRConstant& result) {
+        std::optional<IRConstant> value;
+
+        if (inst->Op == IROpCode::Cast) {
+            VisitVMType(inst->Operands[0]->Type, [&](auto srcTag) {
+                using Src = decltype(srcTag);
+                const Src* src = GetConstant<Src>(operands[0]);
+                if (!src) { return; }
+
+                VisitVMType(inst->Type, [&](auto dstTag) {
+                    using Dst = decltype(dstTag);
+
+                    if (IsConversionDefined<Dst>(*src)) {
+                        value = static_cast<Dst>(*src);
+                    }
+                });
+            });
+        } else if (inst->Op == IROpCode::Negate) {
+            VisitVMType(inst->Type, [&](auto tag) {
+                using T = decltype(tag);
+                const T* operand = GetConstant<T>(operands[0]);
+
+                if (operand) { value = Negate(*operand); }
+            });
+        } else {
+            // Like the VM, the operation is picked from the type of the left hand side
+            VisitVMType(inst->Operands[0]->Type, [&](auto tag) {
+                using T = decltype(tag);
+                const T* lhsPtr = GetConstant<T>(operands[0]);
+                const T* rhsPtr = GetConstant<T>(operands[1]);
+                if (!lhsPtr || !rhsPtr) { return; }
+
+                T lhs = *lhsPtr;
+                T rhs = *rhsPtr;
+
+                // The comparisons always produce a single byte
+                switch (inst->Op) {
+                    case IROpCode::Add: value = Add(lhs, rhs); break;
+                    case IROpCode::Sub: value = Sub(lhs, rhs); break;
+                    case IROpCode::Mul: value = Mul(lhs, rhs); break;
+                    case IROpCode::Div: if (IsDivisionDefined(lhs, rhs)) { value = Div(lhs, rhs); } break;
+                    case IROpCode::Mod: if (IsDivisionDefined(lhs, rhs)) { value = Mod(lhs, rhs); } break;
+
+                    case IROpCode::Cmp: value = static_cast<i8>(Cmp(lhs, rhs) != 0); break;
+                    case IROpCode::Ncmp: value = static_cast<i8>(Ncmp(lhs, rhs) != 0); break;
+                    case IROpCode::Lt: value = static_cast<i8>(Lt(lhs, rhs) != 0); break;
+                    case IROpCode::Lte: value = static_cast<i8>(Lte(lhs, rhs) != 0); break;
+                    case IROpCode::Gt: value = static_cast<i8>(Gt(lhs, rhs) != 0); break;
+                    case IROpCode::Gte: value = static_cast<i8>(Gte(lhs, rhs) != 0); break;
+
+                    default: break;
+                }
+            });
+        }
+
+        if (!value.has_value()) { return false; }
+
+        // The constant has to be stored the way the VM stores the type of the instruction, otherwise it would get loaded with the wrong width
+        bool matches = false;
+        VisitVMType(inst->Type, [&](auto tag) {
+            using T = decltype(tag);
+            matches = std::holds_alternative<T>(value.value());
+        });
+
+        if (!matches) { return false; }
+
+        result = value.value();
+        return true;
+    }
+
+    bool SCCPPass::Rewrite(IRFunction& fn) {
+        bool changed = false;
+
+        for (IRBlock* block : fn.GetBlocks()) {
+            if (!m_ExecutableBlocks.contains(block)) { continue; }
+
+            auto firstNonPhi = [&]() {
+                return std::find_if(block->Instructions.begin(), block->Instructions.end(), [](IRInstruction* inst) { return inst->Op != IROpCode::Phi; });
+            };
+
+            for (size_t i = 0; i < block->Instructions.size(); i++) {
+                IRInstruction* inst = block->Instructions[i];
+                if (inst->Op == IROpCode::Const || inst->Op == IROpCode::CondBr) { continue; }
+                if (inst->Op != IROpCode::Phi && !inst->IsPure()) { continue; }
+
+                auto it = m_Values.find(inst);
+                if (it == m_Values.end() || it->second.State != LatticeState::Constant) { continue; }
+
+                if (inst->Op == IROpCode::Phi) {
+                    // Phis have to stay at the start of the block, so the constant is a new instruction after them
+                    IRInstruction* constant = fn.CreateInstruction(IROpCode::Const, inst->Type);
+                    constant->Constant = it->second.Value;
+                    constant->Parent = block;
+                    block->Instructions.insert(firstNonPhi(), constant);
+
+                    fn.ReplaceAllUsesWith(inst, constant);
+                    fn.RemoveInstruction(inst);
+                    i--;
+                } else {
+                    inst->Op = IROpCode::Const;
+                    inst->Operands.clear();
+                    inst->Constant = it->second.Value;
+                }
+
+                changed = true;
+            }
+
+            IRInstruction* term = block->GetTerminator();
+            if (!term || term->Op != IROpCode::CondBr) { continue; }
+
+            bool taken[2] = { m_ExecutableEdges.contains({ block, term->Targets[0] }), m_ExecutableEdges.contains({ block, term->Targets[1] }) };
+            if (taken[0] == taken[1]) { continue; }
+
+            IRBlock* target = term->Targets[taken[0] ? 0 : 1];
+            IRBlock* dropped = term->Targets[taken[0] ? 1 : 0];
+
+            // The dropped target no longer gets a value from this block
+            if (dropped != target) {
+                for (IRInstruction* phi : dropped->Instructions) {
+                    if (phi->Op != IROpCode::Phi) { break; }
+
+                    auto pred = std::find(phi->IncomingBlocks.begin(), phi->IncomingBlocks.end(), block);
+                    if (pred == phi->IncomingBlocks.end()) { continue; }
+
+                    phi->Operands.erase(phi->Operands.begin() + (pred - phi->IncomingBlocks.begin()));
+                    phi->IncomingBlocks.erase(pred);
+                }
+            }
+
+            term->Op = IROpCode::Br;
+            term->Operands.clear();
+            term->Targets = { target };
+
+            changed = true;
+        }
+
+        if (changed) {
+            fn.RemoveUnreachableBlocks();
+            fn.RecomputePredecessors();
+        }
+
+        return changed;
+    }
+
+} // namespace Aria::Internal
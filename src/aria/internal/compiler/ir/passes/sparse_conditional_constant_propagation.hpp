@@ -0,0 +1,58 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Wegman and Zadeck, "Constant Propagation with Conditional Branches"
+    // Values are only evaluated in blocks that can actually be reached, so a phi only merges the values of the edges that can be taken
+    // Constant values get replaced by constants, conditional branches on a constant become plain branches and the blocks that can never
+    // run get dropped
+    // Values are computed with the same helpers the VM uses, anything that would trap at runtime is never folded
+    class SCCPPass : public IRPass {
+    private:
+        enum class LatticeState { Undefined, Constant, Overdefined };
+
+        struct LatticeValue {
+            LatticeState State = LatticeState::Undefined;
+            IRConstant Value{};
+        };
+
+        using Edge = std::pair<IRBlock*, IRBlock*>;
+
+    public:
+        virtual const char* GetName() const override { return "sccp"; }
+        virtual bool Run(IRFunction& fn) override;
+
+    private:
+        void Solve(IRFunction& fn);
+        void VisitEdge(const Edge& edge);
+        void VisitInstruction(IRInstruction* inst);
+        void VisitPhi(IRInstruction* phi);
+
+        void MarkEdgeExecutable(IRBlock* from, IRBlock* to);
+        // Lowers the value of the instruction, values only ever go from undefined to constant to overdefined
+        void SetValue(IRInstruction* inst, const LatticeValue& value);
+        LatticeValue Evaluate(IRInstruction* inst);
+        // Returns false if the result can't be computed at compile time
+        static bool Compute(const IRInstruction* inst, const std::vector<IRConstant>& operands, IRConstant& result);
+
+        bool Rewrite(IRFunction& fn);
+
+    private:
+        std::unordered_map<IRInstruction*, LatticeValue> m_Values;
+        std::unordered_map<IRInstruction*, std::vector<IRInstruction*>> m_Users;
+
+        std::set<Edge> m_ExecutableEdges;
+        std::unordered_set<IRBlock*> m_ExecutableBlocks;
+
+        std::vector<Edge> m_EdgeWorklist;
+        std::vector<IRInstruction*> m_ValueWorklist;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,101 @@
+#include "aria/internal/compiler/ir/passes/strength_reduction.hpp"
+
+#include <algorithm>
+
+namespace Aria::Internal {
+
+    bool StrengthReductionPass::Run(IRFunction& fn) {
+        bool changed = false;
+
+        for (const IRLoop& loop : fn.FindLoops()) {
+            if (!loop.Preheader || loop.Latches.size() != 1) { continue; }
+
+            // The header gains phis while reducing, only the ones that were there before are looked at
+            std::vector<IRInstruction*> phis;
+            for (IRInstruction* inst : loop.Header->Instructions) {
+                if (inst->Op != IROpCode::Phi) { break; }
+                phis.push_back(inst);
+            }
+
+            for (IRInstruction* phi : phis) {
+                IRInstruction* increment = GetIncrement(phi, loop);
+                if (!increment) { continue; }
+
+                for (IRBlock* block : fn.GetBlocks()) {
+                    if (!loop.Blocks.contains(block)) { continue; }
+
+                    for (size_t i = 0; i < block->Instructions.size(); i++) {
+                        if (ReduceMultiplication(fn, loop, phi, increment, block->Instructions[i])) {
+                            changed = true;
+                            i--;
+                        }
+                    }
+                }
+            }
+        }
+
+        return changed;
+    }
+
+    IRInstruction* StrengthReductionPass::GetIncrement(IRInstruction* phi, const IRLoop& loop) {
+        if (!phi->Type || !phi->Type->IsIntegral() || phi->Operands.size() != 2) { return nullptr; }
+
+        auto it = std::find(phi->IncomingBlocks.begin(), phi->IncomingBlocks.end(), loop.Latches[0]);
+        if (it == phi->IncomingBlocks.end()) { return nullptr; }
+
+        IRInstruction* next = phi->Operands[it - phi->IncomingBlocks.begin()];
+        if (next->Op != IROpCode::Add && next->Op != IROpCode::Sub) { return nullptr; }
+        if (!loop.Contains(next)) { return nullptr; }
+
+        if (next->Operands[0] == phi && next->Operands[1]->Op == IROpCode::Const) { return next; }
+        if (next->Op == IROpCode::Add && next->Operands[1] == phi && next->Operands[0]->Op == IROpCode::Const) { return next; }
+
+        return nullptr;
+    }
+
+    IRInstruction* StrengthReductionPass::GetFactor(IRInstruction* inst, IRInstruction* phi) {
+        if (inst->Op != IROpCode::Mul || !TypeInfo::IsEqual(inst->Type, phi->Type)) { return nullptr; }
+
+        if (inst->Operands[0] == phi && inst->Operands[1]->Op == IROpCode::Const) { return inst->Operands[1]; }
+        if (inst->Operands[1] == phi && inst->Operands[0]->Op == IROpCode::Const) { return inst->Operands[0]; }
+
+        return nullptr;
+    }
+
+    bool StrengthReductionPass::ReduceMultiplication(IRFunction& fn, const IRLoop& loop, IRInstruction* phi, IRInstruction* increment, IRInstruction* mul) {
+        IRInstruction* factor = GetFactor(mul, phi);
+        if (!factor) { return false; }
+
+        IRInstruction* step = (increment->Operands[0] == phi) ? increment->Operands[1] : increment->Operands[0];
+        size_t preheaderIndex = (phi->IncomingBlocks[0] == loop.Latches[0]) ? 1 : 0;
+
+        // Both of these are constant folded by SCCP whenever the start value is a constant
+        IRInstruction* start = fn.CreateInstruction(IROpCode::Mul, mul->Type);
+        start->Operands = { phi->Operands[preheaderIndex], factor };
+        loop.Preheader->InsertBeforeTerminator(start);
+
+        IRInstruction* scaledStep = fn.CreateInstruction(IROpCode::Mul, mul->Type);
+        scaledStep->Operands = { step, factor };
+        loop.Preheader->InsertBeforeTerminator(scaledStep);
+
+        IRInstruction* reduced = fn.CreateInstruction(IROpCode::Phi, mul->Type);
+        loop.Header->InsertPhi(reduced);
+
+        // Updated right after the original induction variable, which is where the latch operand of the phi becomes available
+        IRInstruction* next = fn.CreateInstruction(increment->Op, mul->Type);
+        next->Operands = { reduced, scaledStep };
+
+        IRBlock* incrementBlock = increment->Parent;
+        auto it = std::find(incrementBlock->Instructions.begin(), incrementBlock->Instructions.end(), increment);
+        incrementBlock->Instructions.insert(it + 1, next);
+        next->Parent = incrementBlock;
+
+        reduced->Operands = { start, next };
+        reduced->IncomingBlocks = { loop.Preheader, loop.Latches[0] };
+
+        fn.ReplaceAllUsesWith(mul, reduced);
+        fn.RemoveInstruction(mul);
+        return true;
+    }
+
+} // namespace Aria::Internal
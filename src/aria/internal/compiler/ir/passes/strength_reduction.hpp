@@ -0,0 +1,25 @@
+#pragma once
+
+#include "aria/internal/compiler/ir/pass_manager.hpp"
+
+namespace Aria::Internal {
+
+    // Replaces multiplying a basic induction variable by a constant with a second induction variable, an add per iteration instead of a mul
+    // A basic induction variable is a phi in the loop header that starts at some value and is incremented by a constant every iteration:
+    //     i = phi [init, preheader], [i + c, latch]      i * k      becomes      j = phi [init * k, preheader], [j + c * k, latch]
+    // Only integers are reduced, integer arithmetic wraps the same way whether it is multiplied or added up
+    class StrengthReductionPass : public IRPass {
+    public:
+        virtual const char* GetName() const override { return "strength-reduction"; }
+        virtual bool Run(IRFunction& fn) override;
+
+    private:
+        // Returns the increment (the add or sub of the phi and a constant) if the phi is a basic induction variable, nullptr otherwise
+        static IRInstruction* GetIncrement(IRInstruction* phi, const IRLoop& loop);
+        // Returns the constant the instruction multiplies the phi by, nullptr if it doesn't
+        static IRInstruction* GetFactor(IRInstruction* inst, IRInstruction* phi);
+
+        bool ReduceMultiplication(IRFunction& fn, const IRLoop& loop, IRInstruction* phi, IRInstruction* increment, IRInstruction* mul);
+    };
+
+} // namespace Aria::Internal
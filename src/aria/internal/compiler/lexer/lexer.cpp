@@ -314,18 +314,23 @@ namespace Aria::Internal {
 
                     case '"': {
                         size_t startIndex = m_Index - 1;
+                        bool terminated = false;
                        
                         while (Peek()) {
                             char nc = Consume();
                         
                             if (nc == '"' || nc == EOF) {
+                                terminated = nc == '"';
                                 break;
                             }
                         }
 
+                        // The value is what lies between the quotes
+                        size_t size = m_Index - startIndex - (terminated ? 2 : 1);
+
                         AddToken(TokenType::StrLit, 
                             SourceRange(m_CurrentLine, GetColumn(startIndex), m_CurrentLine, GetColumn(m_Index)), 
-                            StringView(m_Source.Data() + startIndex + 1, m_Index - startIndex));
+                            StringView(m_Source.Data() + startIndex + 1, size));
                         break;
                     }
                 }
@@ -363,6 +368,11 @@ namespace Aria::Internal {
         token.Type = type;
         token.Data = data;
         token.Loc = loc;
+
+        if (type == TokenType::Identifier) {
+            token.Symbol = m_Context->GetSymbolTable().Intern(data);
+        }
+
         m_Tokens.push_back(token);
     }
 
@@ -2,6 +2,7 @@
 
 #include "aria/internal/compiler/core/source_location.hpp"
 #include "aria/internal/compiler/core/string_view.hpp"
+#include "aria/internal/compiler/core/symbol_table.hpp"
 
 #include <vector>
 
@@ -187,6 +188,8 @@ namespace Aria::Internal {
         TokenType Type = TokenType::Semi;
         StringView Data;
         SourceRange Loc;
+
+        SymbolId Symbol = InvalidSymbol; // Only valid for identifiers
     };
 
     using Tokens = std::vector<Token>;
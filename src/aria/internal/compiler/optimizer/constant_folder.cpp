@@ -0,0 +1,401 @@
+#include "aria/internal/compiler/optimizer/constant_folder.hpp"
+#include "aria/internal/compiler/ast/ast.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
+
+#include <optional>
+
+namespace Aria::Internal {
+
+    static bool IsConstant(const Expr* expr) {
+        return GetNode<const IntegerConstantExpr>(expr) || GetNode<const FloatingConstantExpr>(expr) || GetNode<const CharacterConstantExpr>(expr);
+    }
+
+    template <typename T>
+    static T GetConstantValue(const Expr* expr) {
+        if (const IntegerConstantExpr* ic = GetNode<const IntegerConstantExpr>(expr)) {
+            return std::visit([](auto v) { return static_cast<T>(v); }, ic->GetValue());
+        } else if (const FloatingConstantExpr* fc = GetNode<const FloatingConstantExpr>(expr)) {
+            return std::visit([](auto v) { return static_cast<T>(v); }, fc->GetValue());
+        } else if (const CharacterConstantExpr* cc = GetNode<const CharacterConstantExpr>(expr)) {
+            return static_cast<T>(cc->GetValue());
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+    // Both operands of a binary operator must be stored the same way for the VM to operate on them
+    static bool HaveSameRepresentation(const TypeInfo* lhs, const TypeInfo* rhs) {
+        if (lhs == nullptr || rhs == nullptr) { return false; }
+        if (lhs->IsFloatingPoint() != rhs->IsFloatingPoint()) { return false; }
+
+        return lhs->GetSize() == rhs->GetSize();
+    }
+
+    ConstantFolder::ConstantFolder(CompilationContext* ctx) {
+        m_Context = ctx;
+
+        FoldImpl();
+    }
+
+    void ConstantFolder::FoldImpl() {
+        Stmt* root = m_Context->GetRootASTNode();
+        if (root == nullptr) { return; }
+
+        CollectAssignedDecls(root);
+        FoldStmt(root);
+    }
+
+    void ConstantFolder::CollectAssignedDecls(Stmt* stmt) {
+        if (stmt == nullptr) { return; }
+
+        if (TranslationUnitDecl* tu = GetNode<TranslationUnitDecl>(stmt)) {
+            for (Stmt* s : tu->GetStmts()) { CollectAssignedDecls(s); }
+        } else if (CompoundStmt* compound = GetNode<CompoundStmt>(stmt)) {
+            for (Stmt* s : compound->GetStmts()) { CollectAssignedDecls(s); }
+        } else if (WhileStmt* wh = GetNode<WhileStmt>(stmt)) {
+            CollectAssignedDecls(wh->GetCondition());
+            CollectAssignedDecls(wh->GetBody());
+        } else if (DoWhileStmt* doWh = GetNode<DoWhileStmt>(stmt)) {
+            CollectAssignedDecls(doWh->GetCondition());
+            CollectAssignedDecls(doWh->GetBody());
+        } else if (ForStmt* fs = GetNode<ForStmt>(stmt)) {
+            CollectAssignedDecls(fs->GetPrologue());
+            CollectAssignedDecls(fs->GetCondition());
+            CollectAssignedDecls(fs->GetEpilogue());
+            CollectAssignedDecls(fs->GetBody());
+        } else if (IfStmt* ifs = GetNode<IfStmt>(stmt)) {
+            CollectAssignedDecls(ifs->GetCondition());
+            CollectAssignedDecls(ifs->GetBody());
+            CollectAssignedDecls(ifs->GetElseBody());
+        } else if (ReturnStmt* ret = GetNode<ReturnStmt>(stmt)) {
+            CollectAssignedDecls(ret->GetValue());
+        } else if (VarDecl* varDecl = GetNode<VarDecl>(stmt)) {
+            CollectAssignedDecls(varDecl->GetDefaultValue());
+        } else if (FunctionDecl* fnDecl = GetNode<FunctionDecl>(stmt)) {
+            CollectAssignedDecls(fnDecl->GetBody());
+        } else if (ParenExpr* paren = GetNode<ParenExpr>(stmt)) {
+            CollectAssignedDecls(paren->GetChildExpr());
+        } else if (CastExpr* cast = GetNode<CastExpr>(stmt)) {
+            CollectAssignedDecls(cast->GetChildExpr());
+        } else if (ImplicitCastExpr* implicitCast = GetNode<ImplicitCastExpr>(stmt)) {
+            CollectAssignedDecls(implicitCast->GetChildExpr());
+        } else if (UnaryOperatorExpr* unary = GetNode<UnaryOperatorExpr>(stmt)) {
+            CollectAssignedDecls(unary->GetChildExpr());
+        } else if (CallExpr* call = GetNode<CallExpr>(stmt)) {
+            for (Expr* arg : call->GetArguments()) { CollectAssignedDecls(arg); }
+        } else if (MethodCallExpr* method = GetNode<MethodCallExpr>(stmt)) {
+            CollectAssignedDecls(method->GetBase());
+            for (Expr* arg : method->GetArguments()) { CollectAssignedDecls(arg); }
+        } else if (ArraySubscriptExpr* subscript = GetNode<ArraySubscriptExpr>(stmt)) {
+            CollectAssignedDecls(subscript->GetBase());
+            CollectAssignedDecls(subscript->GetIndex());
+        } else if (BinaryOperatorExpr* binop = GetNode<BinaryOperatorExpr>(stmt)) {
+            switch (binop->GetBinaryOperator()) {
+                case BinaryOperatorType::Eq:
+                case BinaryOperatorType::AddInPlace:
+                case BinaryOperatorType::SubInPlace:
+                case BinaryOperatorType::MulInPlace:
+                case BinaryOperatorType::DivInPlace:
+                case BinaryOperatorType::ModInPlace:
+                case BinaryOperatorType::AndInPlace:
+                case BinaryOperatorType::OrInPlace:
+                case BinaryOperatorType::XorInPlace: {
+                    Expr* target = binop->GetLHS();
+                    while (ParenExpr* paren = GetNode<ParenExpr>(target)) { target = paren->GetChildExpr(); }
+
+                    if (DeclRefExpr* ref = GetNode<DeclRefExpr>(target)) {
+                        m_AssignedDecls.insert(ref->GetReferencedDecl());
+                    }
+                    break;
+                }
+
+                default: break;
+            }
+
+            CollectAssignedDecls(binop->GetLHS());
+            CollectAssignedDecls(binop->GetRHS());
+        }
+    }
+
+    Expr* ConstantFolder::FoldParenExpr(Expr* expr) {
+        ParenExpr* paren = GetNode<ParenExpr>(expr);
+        paren->SetChildExpr(FoldExpr(paren->GetChildExpr()));
+
+        // Parentheses only matter for parsing, a constant doesn't need them
+        if (IsConstant(paren->GetChildExpr())) {
+            return paren->GetChildExpr();
+        }
+
+        return expr;
+    }
+
+    Expr* ConstantFolder::FoldCastExpr(Expr* expr) {
+        CastExpr* cast = GetNode<CastExpr>(expr);
+        cast->SetChildExpr(FoldExpr(cast->GetChildExpr()));
+
+        if (Expr* folded = FoldCast(cast->GetChildExpr(), cast->GetCastType(), cast->GetResolvedType())) {
+            return folded;
+        }
+
+        return expr;
+    }
+
+    Expr* ConstantFolder::FoldImplicitCastExpr(Expr* expr) {
+        ImplicitCastExpr* cast = GetNode<ImplicitCastExpr>(expr);
+
+        // Loading a local that always holds the same constant is the same as loading the constant
+        if (cast->GetCastType() == CastType::LValueToRValue) {
+            Expr* child = cast->GetChildExpr();
+            while (ParenExpr* paren = GetNode<ParenExpr>(child)) { child = paren->GetChildExpr(); }
+
+            if (DeclRefExpr* ref = GetNode<DeclRefExpr>(child)) {
+                auto it = m_ConstantLocals.find(ref->GetReferencedDecl());
+
+                if (it != m_ConstantLocals.end()) {
+                    return CloneConstant(it->second);
+                }
+            }
+
+            return expr;
+        }
+
+        cast->SetChildExpr(FoldExpr(cast->GetChildExpr()));
+
+        if (Expr* folded = FoldCast(cast->GetChildExpr(), cast->GetCastType(), cast->GetResolvedType())) {
+            return folded;
+        }
+
+        return expr;
+    }
+
+    Expr* ConstantFolder::FoldUnaryOperatorExpr(Expr* expr) {
+        UnaryOperatorExpr* unary = GetNode<UnaryOperatorExpr>(expr);
+        unary->SetChildExpr(FoldExpr(unary->GetChildExpr()));
+
+        Expr* child = unary->GetChildExpr();
+        if (unary->GetUnaryOperator() != UnaryOperatorType::Negate || !IsConstant(child) || unary->GetResolvedType() == nullptr) {
+            return expr;
+        }
+
+        Expr* result = expr;
+        VisitVMType(child->GetResolvedType(), [&](auto tag) {
+            using T = decltype(tag);
+            result = CreateConstant(Negate(GetConstantValue<T>(child)), unary->GetResolvedType());
+        });
+
+        return result;
+    }
+
+    Expr* ConstantFolder::FoldBinaryOperatorExpr(Expr* expr) {
+        BinaryOperatorExpr* binop = GetNode<BinaryOperatorExpr>(expr);
+
+        binop->SetLHS(FoldExpr(binop->GetLHS()));
+        binop->SetRHS(FoldExpr(binop->GetRHS()));
+
+        Expr* LHS = binop->GetLHS();
+        Expr* RHS = binop->GetRHS();
+
+        if (!IsConstant(LHS) || !IsConstant(RHS) || !HaveSameRepresentation(LHS->GetResolvedType(), RHS->GetResolvedType())) {
+            return expr;
+        }
+
+        Expr* result = expr;
+        VisitVMType(LHS->GetResolvedType(), [&](auto tag) {
+            using T = decltype(tag);
+
+            T lhs = GetConstantValue<T>(LHS);
+            T rhs = GetConstantValue<T>(RHS);
+            std::optional<T> value;
+            std::optional<bool> comparison;
+
+            switch (binop->GetBinaryOperator()) {
+                case BinaryOperatorType::Add: value = Add(lhs, rhs); break;
+                case BinaryOperatorType::Sub: value = Sub(lhs, rhs); break;
+                case BinaryOperatorType::Mul: value = Mul(lhs, rhs); break;
+                case BinaryOperatorType::Div: if (IsDivisionDefined(lhs, rhs)) { value = Div(lhs, rhs); } break;
+                case BinaryOperatorType::Mod: if (IsDivisionDefined(lhs, rhs)) { value = Mod(lhs, rhs); } break;
+
+                case BinaryOperatorType::Less: comparison = Lt(lhs, rhs) != 0; break;
+                case BinaryOperatorType::LessOrEq: comparison = Lte(lhs, rhs) != 0; break;
+                case BinaryOperatorType::Greater: comparison = Gt(lhs, rhs) != 0; break;
+                case BinaryOperatorType::GreaterOrEq: comparison = Gte(lhs, rhs) != 0; break;
+                case BinaryOperatorType::IsEq: comparison = Cmp(lhs, rhs) != 0; break;
+                case BinaryOperatorType::IsNotEq: comparison = Ncmp(lhs, rhs) != 0; break;
+
+                default: break;
+            }
+
+            if (value.has_value()) {
+                result = CreateConstant(value.value(), binop->GetResolvedType());
+            } else if (comparison.has_value()) {
+                result = m_Context->Allocate<BooleanConstantExpr>(m_Context, comparison.value());
+            }
+        });
+
+        return result;
+    }
+
+    Expr* ConstantFolder::FoldCallExpr(Expr* expr) {
+        CallExpr* call = GetNode<CallExpr>(expr);
+
+        for (size_t i = 0; i < call->GetArguments().Size; i++) {
+            call->SetArgument(i, FoldExpr(call->GetArguments().Items[i]));
+        }
+
+        return expr;
+    }
+
+    Expr* ConstantFolder::FoldMethodCallExpr(Expr* expr) {
+        MethodCallExpr* method = GetNode<MethodCallExpr>(expr);
+
+        for (size_t i = 0; i < method->GetArguments().Size; i++) {
+            method->SetArgument(i, FoldExpr(method->GetArguments().Items[i]));
+        }
+
+        return expr;
+    }
+
+    Expr* ConstantFolder::FoldArraySubscriptExpr(Expr* expr) {
+        ArraySubscriptExpr* subscript = GetNode<ArraySubscriptExpr>(expr);
+        subscript->SetIndex(FoldExpr(subscript->GetIndex()));
+
+        return expr;
+    }
+
+    Expr* ConstantFolder::FoldExpr(Expr* expr) {
+        if (GetNode<ParenExpr>(expr)) {
+            return FoldParenExpr(expr);
+        } else if (GetNode<CastExpr>(expr)) {
+            return FoldCastExpr(expr);
+        } else if (GetNode<ImplicitCastExpr>(expr)) {
+            return FoldImplicitCastExpr(expr);
+        } else if (GetNode<UnaryOperatorExpr>(expr)) {
+            return FoldUnaryOperatorExpr(expr);
+        } else if (GetNode<BinaryOperatorExpr>(expr)) {
+            return FoldBinaryOperatorExpr(expr);
+        } else if (GetNode<CallExpr>(expr)) {
+            return FoldCallExpr(expr);
+        } else if (GetNode<MethodCallExpr>(expr)) {
+            return FoldMethodCallExpr(expr);
+        } else if (GetNode<ArraySubscriptExpr>(expr)) {
+            return FoldArraySubscriptExpr(expr);
+        }
+
+        // Constants and references have nothing to fold
+        return expr;
+    }
+
+    void ConstantFolder::FoldVarDecl(Decl* decl) {
+        VarDecl* varDecl = GetNode<VarDecl>(decl);
+
+        if (!varDecl->GetDefaultValue()) { return; }
+
+        Expr* value = FoldExpr(varDecl->GetDefaultValue());
+        varDecl->SetDefaultValue(value);
+
+        // Globals can be changed from the host (and are kept across hot reloads), so only locals get propagated
+        if (m_InFunction && IsConstant(value) && !m_AssignedDecls.contains(decl) && TypeInfo::IsEqual(value->GetResolvedType(), varDecl->GetResolvedType())) {
+            m_ConstantLocals[decl] = value;
+        }
+    }
+
+    void ConstantFolder::FoldFunctionDecl(Decl* decl) {
+        FunctionDecl* fnDecl = GetNode<FunctionDecl>(decl);
+
+        if (fnDecl->GetBody()) {
+            m_InFunction = true;
+            FoldStmt(fnDecl->GetBody());
+            m_InFunction = false;
+        }
+    }
+
+    void ConstantFolder::FoldStmt(Stmt* stmt) {
+        if (stmt == nullptr) { return; }
+
+        if (TranslationUnitDecl* tu = GetNode<TranslationUnitDecl>(stmt)) {
+            for (Stmt* s : tu->GetStmts()) { FoldStmt(s); }
+        } else if (CompoundStmt* compound = GetNode<CompoundStmt>(stmt)) {
+            for (Stmt*& s : compound->GetStmts()) {
+                if (Expr* expr = GetNode<Expr>(s)) {
+                    s = FoldExpr(expr);
+                } else {
+                    FoldStmt(s);
+                }
+            }
+        } else if (WhileStmt* wh = GetNode<WhileStmt>(stmt)) {
+            wh->SetCondition(FoldExpr(wh->GetCondition()));
+            FoldStmt(wh->GetBody());
+        } else if (DoWhileStmt* doWh = GetNode<DoWhileStmt>(stmt)) {
+            FoldStmt(doWh->GetBody());
+            doWh->SetCondition(FoldExpr(doWh->GetCondition()));
+        } else if (ForStmt* fs = GetNode<ForStmt>(stmt)) {
+            FoldStmt(fs->GetPrologue());
+            if (fs->GetCondition()) { fs->SetCondition(FoldExpr(fs->GetCondition())); }
+            if (fs->GetEpilogue()) { fs->SetEpilogue(FoldExpr(fs->GetEpilogue())); }
+            FoldStmt(fs->GetBody());
+        } else if (IfStmt* ifs = GetNode<IfStmt>(stmt)) {
+            ifs->SetCondition(FoldExpr(ifs->GetCondition()));
+            FoldStmt(ifs->GetBody());
+            FoldStmt(ifs->GetElseBody());
+        } else if (ReturnStmt* ret = GetNode<ReturnStmt>(stmt)) {
+            if (ret->GetValue()) { ret->SetValue(FoldExpr(ret->GetValue())); }
+        } else if (GetNode<VarDecl>(stmt)) {
+            FoldVarDecl(GetNode<VarDecl>(stmt));
+        } else if (GetNode<FunctionDecl>(stmt)) {
+            FoldFunctionDecl(GetNode<FunctionDecl>(stmt));
+        } else if (Expr* expr = GetNode<Expr>(stmt)) {
+            FoldExpr(expr);
+        }
+    }
+
+    Expr* ConstantFolder::FoldCast(Expr* child, CastType castType, TypeInfo* dstType) {
+        if (!IsConstant(child) || dstType == nullptr) { return nullptr; }
+
+        switch (castType) {
+            case CastType::Integral:
+            case CastType::Floating:
+            case CastType::IntegralToFloating:
+            case CastType::FloatingToIntegral: break;
+
+            default: return nullptr;
+        }
+
+        Expr* result = nullptr;
+        VisitVMType(child->GetResolvedType(), [&](auto srcTag) {
+            using Src = decltype(srcTag);
+            Src value = GetConstantValue<Src>(child);
+
+            VisitVMType(dstType, [&](auto dstTag) {
+                using Dst = decltype(dstTag);
+
+                if (IsConversionDefined<Dst>(value)) {
+                    result = CreateConstant(static_cast<Dst>(value), dstType);
+                }
+            });
+        });
+
+        return result;
+    }
+
+    Expr* ConstantFolder::CloneConstant(Expr* constant) {
+        if (IntegerConstantExpr* ic = GetNode<IntegerConstantExpr>(constant)) {
+            return m_Context->Allocate<IntegerConstantExpr>(m_Context, ic->GetValue(), ic->GetResolvedType());
+        } else if (FloatingConstantExpr* fc = GetNode<FloatingConstantExpr>(constant)) {
+            return m_Context->Allocate<FloatingConstantExpr>(m_Context, fc->GetValue(), fc->GetResolvedType());
+        } else if (CharacterConstantExpr* cc = GetNode<CharacterConstantExpr>(constant)) {
+            return m_Context->Allocate<CharacterConstantExpr>(m_Context, cc->GetValue());
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+    template <typename T>
+    Expr* ConstantFolder::CreateConstant(T value, TypeInfo* type) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return m_Context->Allocate<FloatingConstantExpr>(m_Context, value, type);
+        } else {
+            return m_Context->Allocate<IntegerConstantExpr>(m_Context, value, type);
+        }
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "aria/internal/compiler/ast/expr.hpp"
+#include "aria/internal/compiler/ast/decl.hpp"
+#include "aria/internal/compiler/ast/stmt.hpp"
+#include "aria/internal/compiler/compilation_context.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Aria::Internal {
+
+    // Runs on the typed AST, between the semantic analyzer and the emitter
+    // Binary operators, negations and casts whose operands are constants get replaced by their result,
+    // computed with the same helpers the VM uses so the value is exactly what running the code would produce
+    // Reads of locals that are never assigned to after being initialized from a constant get replaced by that constant
+    // Anything that would trap or is undefined at runtime (eg. integer division by zero) is left alone
+    class ConstantFolder {
+    public:
+        ConstantFolder(CompilationContext* ctx);
+
+    private:
+        void FoldImpl();
+
+        // Finds every variable that is the left hand side of an assignment, those can't be propagated
+        void CollectAssignedDecls(Stmt* stmt);
+
+        Expr* FoldExpr(Expr* expr);
+        Expr* FoldParenExpr(Expr* expr);
+        Expr* FoldCastExpr(Expr* expr);
+        Expr* FoldImplicitCastExpr(Expr* expr);
+        Expr* FoldUnaryOperatorExpr(Expr* expr);
+        Expr* FoldBinaryOperatorExpr(Expr* expr);
+        Expr* FoldCallExpr(Expr* expr);
+        Expr* FoldMethodCallExpr(Expr* expr);
+        Expr* FoldArraySubscriptExpr(Expr* expr);
+
+        void FoldStmt(Stmt* stmt);
+        void FoldVarDecl(Decl* decl);
+        void FoldFunctionDecl(Decl* decl);
+
+        // Returns nullptr if the cast can't be done at compile time
+        Expr* FoldCast(Expr* child, CastType castType, TypeInfo* dstType);
+        // Returns a new constant node holding the same value as the given constant
+        Expr* CloneConstant(Expr* constant);
+
+        template <typename T>
+        Expr* CreateConstant(T value, TypeInfo* type);
+
+    private:
+        CompilationContext* m_Context = nullptr;
+
+        bool m_InFunction = false;
+
+        std::unordered_set<const Decl*> m_AssignedDecls;
+        std::unordered_map<const Decl*, Expr*> m_ConstantLocals;
+    };
+
+} // namespace Aria::Internal
@@ -12,17 +12,20 @@ namespace Aria::Internal {
     Parser::Parser(CompilationContext* ctx) {
         m_Context = ctx;
         m_Tokens = ctx->GetTokens();
+        m_DeclaredTypes.resize(ctx->GetSymbolTable().Size(), false);
 
         ParseImpl();
     }
 
     void Parser::ParseImpl() {
-        TinyVector<Stmt*> stmts;
+        size_t start = m_ScratchStmts.size();
         while (Peek()) {
             Stmt* stmt = ParseToken();
-            stmts.Append(m_Context, stmt);
+            m_ScratchStmts.push_back(stmt);
         }
 
+        TinyVector<Stmt*> stmts = PopScratchList(m_ScratchStmts, start);
+
         TranslationUnitDecl* root = m_Context->Allocate<TranslationUnitDecl>(m_Context, stmts);
         m_Context->SetRootASTNode(root);
     }
@@ -69,27 +72,33 @@ namespace Aria::Internal {
     StringBuilder Parser::ParseVariableType() {
         Token type = Consume();
 
-        StringBuilder strType;
+        StringView baseType;
 
         switch (type.Type) {
-            case TokenType::Void:       strType.Append(m_Context, "void"); break;
-            case TokenType::Bool:       strType.Append(m_Context, "bool"); break;
-            case TokenType::Char:       strType.Append(m_Context, "char"); break;
-            case TokenType::UChar:      strType.Append(m_Context, "uchar"); break;
-            case TokenType::Short:      strType.Append(m_Context, "short"); break;
-            case TokenType::UShort:     strType.Append(m_Context, "ushort"); break;
-            case TokenType::Int:        strType.Append(m_Context, "int"); break;
-            case TokenType::UInt:       strType.Append(m_Context, "uint"); break;
-            case TokenType::Long:       strType.Append(m_Context, "long"); break;
-            case TokenType::ULong:      strType.Append(m_Context, "ulong"); break;
-            case TokenType::Float:      strType.Append(m_Context, "float"); break;
-            case TokenType::Double:     strType.Append(m_Context, "double"); break;
-            case TokenType::String:     strType.Append(m_Context, "string"); break;
-            case TokenType::Identifier: strType.Append(m_Context, type.Data); break;
-            default:                    strType.Append(m_Context, ""); break;
+            case TokenType::Void:       baseType = "void"; break;
+            case TokenType::Bool:       baseType = "bool"; break;
+            case TokenType::Char:       baseType = "char"; break;
+            case TokenType::UChar:      baseType = "uchar"; break;
+            case TokenType::Short:      baseType = "short"; break;
+            case TokenType::UShort:     baseType = "ushort"; break;
+            case TokenType::Int:        baseType = "int"; break;
+            case TokenType::UInt:       baseType = "uint"; break;
+            case TokenType::Long:       baseType = "long"; break;
+            case TokenType::ULong:      baseType = "ulong"; break;
+            case TokenType::Float:      baseType = "float"; break;
+            case TokenType::Double:     baseType = "double"; break;
+            case TokenType::String:     baseType = "string"; break;
+            case TokenType::Identifier: baseType = type.Data; break;
+            default:                    baseType = ""; break;
         }
 
-        if (Match(TokenType::LeftBracket)) {
+        bool array = Match(TokenType::LeftBracket);
+
+        StringBuilder strType;
+        strType.Reserve(m_Context, baseType.Size() + (array ? 2 : 0));
+        strType.Append(m_Context, baseType);
+
+        if (array) {
             Consume();
             TryConsume(TokenType::RightBracket, "']'");
             strType.Append(m_Context, "[]");
@@ -99,27 +108,27 @@ namespace Aria::Internal {
     }
 
     TinyVector<ParamDecl*> Parser::ParseFunctionParameters() {
-        TinyVector<ParamDecl*> params;
+        size_t start = m_ScratchParams.size();
 
         while (!Match(TokenType::RightParen)) {
             StringBuilder type = ParseVariableType();
 
             Token& ident = Consume();
             
-            ParamDecl* param = m_Context->Allocate<ParamDecl>(m_Context, ident.Data, StringView(type.Data(), type.Size()));
+            ParamDecl* param = m_Context->Allocate<ParamDecl>(m_Context, ident.Symbol, StringView(type.Data(), type.Size()));
             
             if (Match(TokenType::Comma)) {
                 Consume();
             }
 
-            params.Append(m_Context, param);
+            m_ScratchParams.push_back(param);
         }
 
         if (!Match(TokenType::RightParen)) {
             ARIA_ASSERT(false, "todo: add error");
         }
 
-        return params;
+        return PopScratchList(m_ScratchParams, start);
     }
 
     bool Parser::IsPrimitiveType() {
@@ -151,7 +160,7 @@ namespace Aria::Internal {
         if (IsPrimitiveType()) { return true; }
 
         if (Peek()->Type == TokenType::Identifier) {
-            if (m_DeclaredTypes.contains(fmt::format("{}", Peek()->Data))) {
+            if (m_DeclaredTypes[Peek()->Symbol]) {
                 return true;
             }
 
@@ -337,13 +346,13 @@ namespace Aria::Internal {
             case TokenType::Identifier: {
                 Token i = Consume();
 
-                final = m_Context->Allocate<DeclRefExpr>(m_Context, i.Data);
+                final = m_Context->Allocate<DeclRefExpr>(m_Context, i.Symbol);
 
                 // Check if this is a function call
                 if (Match(TokenType::LeftParen)) {
                     Consume();
     
-                    TinyVector<Expr*> args;
+                    size_t start = m_ScratchArgs.size();
 
                     while (!Match(TokenType::RightParen)) {
                         Expr* val = ParseExpression();
@@ -352,10 +361,11 @@ namespace Aria::Internal {
                             Consume();
                         }
     
-                        args.Append(m_Context, val);
+                        m_ScratchArgs.push_back(val);
                     }
     
                     TryConsume(TokenType::RightParen, "')'");
+                    TinyVector<Expr*> args = PopScratchList(m_ScratchArgs, start);
     
                     final = m_Context->Allocate<CallExpr>(m_Context, GetNode<DeclRefExpr>(final), args);
                 }
@@ -364,52 +374,41 @@ namespace Aria::Internal {
             }
         }
 
-        // Handle member access (foo.bar) and array access (foo[5])
-        // NOTE: This is currently not avalible, AST refactoring in progress
-        // while (Match(TokenType::Dot) || Match(TokenType::LeftBracket)) {
-        //     Token op = Consume();
+        // Handle method calls (foo.bar()) and array access (foo[5])
+        // NOTE: Member access (foo.bar) is not avalible yet, it needs structs
+        while (final && (Match(TokenType::Dot) || Match(TokenType::LeftBracket))) {
+            Token op = Consume();
 
-        //     if (op.Type == TokenType::Dot) {
-        //         Token* member = TryConsume(TokenType::Identifier, "identifier");
-        //         if (!member) { return nullptr; }
+            if (op.Type == TokenType::Dot) {
+                Token* method = TryConsume(TokenType::Identifier, "identifier");
+                if (!method) { return final; }
 
-        //         if (Match(TokenType::LeftParen)) {
-        //             Consume();
-    
-        //             ExprMethodCall* methodExpr = Allocate<ExprMethodCall>();
-        //             methodExpr->Member = member->Data;
-        //             methodExpr->Parent = final;
-    
-        //             while (!Match(TokenType::RightParen)) {
-        //                 NodeExpr* val = ParseExpression();
-    
-        //                 if (Match(TokenType::Comma)) {
-        //                     Consume();
-        //                 }
-    
-        //                 methodExpr->Arguments.Append(m_Context, Allocate<Node>(val));
-        //             }
-    
-        //             TryConsume(TokenType::RightParen, "')'");
-    
-        //             final = Allocate<NodeExpr>(methodExpr, SourceRange(final->Range.Start, Peek(-1)->Loc.End), op.Loc.Start);
-        //         } else {
-        //             ExprMember* memExpr = Allocate<ExprMember>();
+                SymbolId symbol = method->Symbol;
+                if (!TryConsume(TokenType::LeftParen, "'('")) { return final; }
 
-        //             memExpr->Member = member->Data;
-        //             memExpr->Parent = final;
-        //             final = Allocate<NodeExpr>(memExpr, SourceRange(final->Range.Start, Peek(-1)->Loc.End), op.Loc.Start);
-        //         }
-        //     } else if (op.Type == TokenType::LeftBracket) {
-        //         ExprArrayAccess* arrExpr = Allocate<ExprArrayAccess>();
+                size_t start = m_ScratchArgs.size();
 
-        //         arrExpr->Index = ParseExpression();
-        //         arrExpr->Parent = final;
-        //         TryConsume(TokenType::RightBracket, "']'");
+                while (!Match(TokenType::RightParen)) {
+                    Expr* val = ParseExpression();
 
-        //         final = Allocate<NodeExpr>(arrExpr, SourceRange(final->Range.Start, Peek(-1)->Loc.End), op.Loc.Start);
-        //     }
-        // }
+                    if (Match(TokenType::Comma)) {
+                        Consume();
+                    }
+
+                    m_ScratchArgs.push_back(val);
+                }
+
+                TryConsume(TokenType::RightParen, "')'");
+                TinyVector<Expr*> args = PopScratchList(m_ScratchArgs, start);
+
+                final = m_Context->Allocate<MethodCallExpr>(m_Context, final, symbol, args);
+            } else {
+                Expr* index = ParseExpression();
+                TryConsume(TokenType::RightBracket, "']'");
+
+                final = m_Context->Allocate<ArraySubscriptExpr>(m_Context, final, index);
+            }
+        }
 
         return final;
     }
@@ -432,15 +431,16 @@ namespace Aria::Internal {
     }
 
     Stmt* Parser::ParseCompound() {
-        TinyVector<Stmt*> stmts;
+        size_t start = m_ScratchStmts.size();
         Token* l = TryConsume(TokenType::LeftCurly, "'{'");
 
         while (!Match(TokenType::RightCurly)) {
             Stmt* stmt = ParseToken();
-            stmts.Append(m_Context, stmt);
+            m_ScratchStmts.push_back(stmt);
         }
 
         TryConsume(TokenType::RightCurly, "'}'");
+        TinyVector<Stmt*> stmts = PopScratchList(m_ScratchStmts, start);
 
         return m_Context->Allocate<CompoundStmt>(m_Context, stmts);
     }
@@ -475,7 +475,7 @@ namespace Aria::Internal {
                 value = ParseExpression();
             }
 
-            return m_Context->Allocate<VarDecl>(m_Context, ident->Data, StringView(type.Data(), type.Size()), value);
+            return m_Context->Allocate<VarDecl>(m_Context, ident->Symbol, StringView(type.Data(), type.Size()), value);
         } else {
             return nullptr;
         }
@@ -499,7 +499,7 @@ namespace Aria::Internal {
                     m_NeedsSemi = false;
                 }
 
-                return m_Context->Allocate<FunctionDecl>(m_Context, ident->Data, StringView(returnType.Data(), returnType.Size()), params, external, GetNode<CompoundStmt>(body));
+                return m_Context->Allocate<FunctionDecl>(m_Context, ident->Symbol, StringView(returnType.Data(), returnType.Size()), params, external, GetNode<CompoundStmt>(body));
             } else {
                 ErrorExpected("'('");
             }
@@ -523,7 +523,7 @@ namespace Aria::Internal {
         // Token* ident = TryConsume(TokenType::Identifier, "indentifier");
 
         // if (!ident) { return nullptr; }
-        // m_DeclaredTypes[fmt::format("{}", ident->Data)] = true;
+        // m_DeclaredTypes[ident->Symbol] = true;
 
         // StmtStructDecl* node = Allocate<StmtStructDecl>();
         // node->Identifier = ident->Data;
@@ -584,67 +584,62 @@ namespace Aria::Internal {
     }
 
     Stmt* Parser::ParseDoWhile() {
-        ARIA_ASSERT(false, "todo: add do while parsing");
-        // Token d = Consume(); // Consume "do"
-
-        // StmtDoWhile* node = Allocate<StmtDoWhile>();
-        // node->Body = ParseCompoundInline();
+        Consume(); // Consume "do"
 
-        // TryConsume(TokenType::While, "while");
-        // TryConsume(TokenType::LeftParen, "'('");
-        // node->Condition = ParseExpression();
-        // TryConsume(TokenType::RightParen, "')'");
+        Stmt* body = ParseCompoundInline();
 
-        // m_NeedsSemi = false;
+        TryConsume(TokenType::While, "while");
+        TryConsume(TokenType::LeftParen, "'('");
+        Expr* condition = ParseExpression();
+        TryConsume(TokenType::RightParen, "')'");
 
-        // return Allocate<NodeStmt>(node, d.Loc);
+        return m_Context->Allocate<DoWhileStmt>(m_Context, condition, body);
     }
 
     Stmt* Parser::ParseFor() {
-        ARIA_ASSERT(false, "todo: add for parsing");
-        // Token f = Consume(); // Consume "for"
+        Consume(); // Consume "for"
 
-        // StmtFor* node = Allocate<StmtFor>();
-        // TryConsume(TokenType::LeftParen, "'('");
+        TryConsume(TokenType::LeftParen, "'('");
 
-        // node->Prologue = ParseStatement();
+        // Every part of the header is optional
+        Stmt* prologue = nullptr;
+        if (!Match(TokenType::Semi)) {
+            prologue = ParseStatement();
+            if (!prologue) { prologue = ParseExpression(); }
+        }
+        TryConsume(TokenType::Semi, "';'");
 
-        // node->Condition = ParseExpression();
-        // TryConsume(TokenType::Semi, "';'");
+        Expr* condition = Match(TokenType::Semi) ? nullptr : ParseExpression();
+        TryConsume(TokenType::Semi, "';'");
 
-        // node->Epilogue = ParseExpression();
-        // TryConsume(TokenType::RightParen, "')'");
+        Expr* epilogue = Match(TokenType::RightParen) ? nullptr : ParseExpression();
+        TryConsume(TokenType::RightParen, "')'");
 
-        // SourceLocation end = Peek(-1)->Loc.End;
-        // node->Body = ParseCompoundInline();
+        Stmt* body = ParseCompoundInline();
 
-        // m_NeedsSemi = false;
+        m_NeedsSemi = false;
 
-        // return Allocate<NodeStmt>(node, SourceRange(f.Loc.Start, end), f.Loc.Start);
+        return m_Context->Allocate<ForStmt>(m_Context, prologue, condition, epilogue, body);
     }
 
     Stmt* Parser::ParseIf() {
-        ARIA_ASSERT(false, "todo: add if parsing");
-        // Token i = Consume(); // Consume "if"
-
-        // StmtIf* node = Allocate<StmtIf>();
-        // TryConsume(TokenType::LeftParen, "'('");
+        Consume(); // Consume "if"
 
-        // node->Condition = ParseExpression();
-
-        // TryConsume(TokenType::RightParen, "')'");
-        // SourceLocation end = Peek(-1)->Loc.End;
-        // node->Body = ParseCompoundInline();
+        TryConsume(TokenType::LeftParen, "'('");
+        Expr* condition = ParseExpression();
+        TryConsume(TokenType::RightParen, "')'");
+        Stmt* body = ParseCompoundInline();
 
-        // if (Match(TokenType::Else)) {
-        //     Consume();
+        Stmt* elseBody = nullptr;
+        if (Match(TokenType::Else)) {
+            Consume();
 
-        //     node->ElseBody = ParseCompoundInline();
-        // }
+            elseBody = ParseCompoundInline();
+        }
 
-        // m_NeedsSemi = false;
+        m_NeedsSemi = false;
 
-        // return Allocate<NodeStmt>(node, SourceRange(i.Loc.Start, end), i.Loc.Start);
+        return m_Context->Allocate<IfStmt>(m_Context, condition, body, elseBody);
     }
 
     Stmt* Parser::ParseBreak() {
@@ -683,6 +678,7 @@ namespace Aria::Internal {
             node = ParseStructDecl();
         } else if (t == TokenType::LeftCurly) {
             node = ParseCompound();
+            m_NeedsSemi = false;
         } else if (t == TokenType::While) {
             node = ParseWhile();
         } else if (t == TokenType::Do) {
@@ -719,15 +715,17 @@ namespace Aria::Internal {
     }
 
     void Parser::ErrorExpected(const StringView msg) {
-        // if (Peek(-1)) {
-        //     m_Context->ReportCompilerError(Peek(-1)->Line, Peek(-1)->Column, fmt::format("Expected {} after token \"{}\"", msg, TokenTypeToString(Peek(-1)->Type)));
-        // } else {
-        //     m_Context->ReportCompilerError(Peek()->Line, Peek()->Column, fmt::format("Expected {} after token \"{}\"", msg, TokenTypeToString(Peek()->Type)));
-        // }
+        Token* t = Peek(-1) ? Peek(-1) : Peek();
+        if (!t) {
+            m_Context->ReportCompilerError({}, {}, fmt::format("Expected {}", msg));
+            return;
+        }
+
+        m_Context->ReportCompilerError(t->Loc.End, t->Loc, fmt::format("Expected {} after token \"{}\"", msg, TokenTypeToString(t->Type)));
     }
 
     void Parser::ErrorTooLarge(const StringView value) {
-        // m_Context->ReportCompilerError(Peek(-1)->Line, Peek(-1)->Column, fmt::format("Constant {} is too large", value));
+        m_Context->ReportCompilerError(Peek(-1)->Loc.Start, Peek(-1)->Loc, fmt::format("Constant {} is too large", value));
     }
 
 } // namespace Aria::Internal
@@ -7,7 +7,7 @@
 #include "aria/internal/compiler/ast/stmt.hpp"
 #include "aria/internal/compiler/ast/decl.hpp"
 
-#include <unordered_map>
+#include <vector>
 
 namespace Aria::Internal {
 
@@ -61,6 +61,20 @@ namespace Aria::Internal {
 
         Stmt* ParseToken();
 
+        // Copies everything pushed onto the scratch stack after "start" into an exactly sized arena list
+        template <typename T>
+        TinyVector<T> PopScratchList(std::vector<T>& scratch, size_t start) {
+            TinyVector<T> list;
+            list.Reserve(m_Context, scratch.size() - start);
+
+            for (size_t i = start; i < scratch.size(); i++) {
+                list.Append(m_Context, scratch[i]);
+            }
+
+            scratch.resize(start);
+            return list;
+        }
+
         void ErrorExpected(const StringView msg);
         void ErrorTooLarge(const StringView value);
 
@@ -70,7 +84,13 @@ namespace Aria::Internal {
 
         bool m_NeedsSemi = true; // A flag to see if the current statement needs to finish with a semicolon
 
-        std::unordered_map<std::string, bool> m_DeclaredTypes;
+        std::vector<bool> m_DeclaredTypes; // Indexed by SymbolId
+
+        // Lists are collected here first, since nested lists are popped before their parent this works as a stack
+        // Once a list is complete its final size is known and it gets copied into the arena exactly once
+        std::vector<Stmt*> m_ScratchStmts;
+        std::vector<ParamDecl*> m_ScratchParams;
+        std::vector<Expr*> m_ScratchArgs;
 
         CompilationContext* m_Context = nullptr;
     };
@@ -1,31 +1,329 @@
 #include "aria/internal/compiler/semantic_analyzer/semantic_analyzer.hpp"
 #include "aria/internal/compiler/ast/ast.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
 
 namespace Aria::Internal {
 
-    SemanticAnalyzer::SemanticAnalyzer(CompilationContext* ctx) : m_TypeChecker(ctx) {
+    SemanticAnalyzer::SemanticAnalyzer(CompilationContext* ctx) {
         m_Context = ctx;
         m_RootASTNode = ctx->GetRootASTNode();
 
-        m_TypeChecker.CheckImpl();
         AnalyzeImpl();
     }
 
     void SemanticAnalyzer::AnalyzeImpl() {
+        // Depth 0 of the map is the global space
+        m_Declarations.Reset(m_Context->GetSymbolTable().Size());
+
         HandleStmt(m_RootASTNode);
     }
 
-    TypeInfo* SemanticAnalyzer::HandleBooleanConstantExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleCharacterConstantExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleIntegerConstantExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleFloatingConstantExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleStringConstantExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleDeclRefExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleCallExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleParenExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleCastExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleUnaryOperatorExpr(Expr* expr) { return expr->GetResolvedType(); }
-    TypeInfo* SemanticAnalyzer::HandleBinaryOperatorExpr(Expr* expr) { return expr->GetResolvedType(); }
+    TypeInfo* SemanticAnalyzer::HandleBooleanConstantExpr(Expr* expr) {
+        return expr->GetResolvedType();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleCharacterConstantExpr(Expr* expr) {
+        return expr->GetResolvedType();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleIntegerConstantExpr(Expr* expr) {
+        return expr->GetResolvedType();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleFloatingConstantExpr(Expr* expr) {
+        return expr->GetResolvedType();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleStringConstantExpr(Expr* expr) {
+        return expr->GetResolvedType();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleDeclRefExpr(Expr* expr) {
+        DeclRefExpr* ref = GetNode<DeclRefExpr>(expr);
+
+        if (Declaration* d = m_Declarations.Find(ref->GetSymbol())) {
+            ref->SetResolvedType(d->ResolvedType);
+            ref->SetType(d->DeclType);
+            ref->SetReferencedDecl(d->SourceDeclaration);
+            return ref->GetResolvedType();
+        }
+
+        ARIA_ASSERT(false, "todo: add error for SemanticAnalyzer::HandleVarRefExpr()");
+        // m_Context->ReportCompilerError(expr->Loc.Line, expr->Loc.Column, 
+        //                                expr->Range.Start.Line, expr->Range.Start.Column,
+        //                                expr->Range.End.Line, expr->Range.End.Column,
+        //                                fmt::format("Undeclared identifier \"{}\"", ref->Identifier));
+        return nullptr;
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleCallExpr(Expr* expr) {
+        CallExpr* call = GetNode<CallExpr>(expr);
+
+        TypeInfo* calleeType = HandleExpr(call->GetCallee());
+        FunctionDeclaration& fnDecl = std::get<FunctionDeclaration>(calleeType->Data);
+
+        if (fnDecl.ParamTypes.Size != call->GetArguments().Size) {
+            ARIA_ASSERT(false, "todo: error msg");
+        }
+
+        for (size_t i = 0; i < fnDecl.ParamTypes.Size; i++) {
+            TypeInfo* paramType = fnDecl.ParamTypes.Items[i];
+            TypeInfo* argType = HandleExpr(call->GetArguments().Items[i]);
+
+            ConversionCost cost = GetConversionCost(paramType, argType, call->GetArguments().Items[i]->IsLValue());
+            if (cost.CastNeeded) {
+                if (cost.ImplicitCastPossible) {
+                    call->SetArgument(i, InsertImplicitCast(paramType, argType, call->GetArguments().Items[i], cost.CaType));
+                } else {
+                    ARIA_ASSERT(false, "todo: error msg");
+                }
+            }
+        }
+
+        call->SetExtern(fnDecl.External);
+        call->SetResolvedType(fnDecl.ReturnType);
+        return fnDecl.ReturnType;
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleMethodCallExpr(Expr* expr) {
+        MethodCallExpr* method = GetNode<MethodCallExpr>(expr);
+
+        TypeInfo* baseType = HandleExpr(method->GetBase());
+        TypeInfo* voidType = TypeInfo::Create(m_Context, PrimitiveType::Void);
+        method->SetResolvedType(voidType);
+
+        if (baseType->Type != PrimitiveType::Array && baseType->Type != PrimitiveType::String) {
+            m_Context->ReportCompilerError({}, {}, fmt::format("Type '{}' has no method '{}'", TypeInfoToString(baseType), method->GetMethodName()));
+            return voidType;
+        }
+
+        TypeInfo* intType = TypeInfo::Create(m_Context, PrimitiveType::Int, true);
+        StringView name = method->GetMethodName();
+
+        MethodType type = MethodType::Invalid;
+        TypeInfo* paramType = nullptr;
+
+        if (baseType->Type == PrimitiveType::String) {
+            if (name == "Length") { type = MethodType::StringLength; method->SetResolvedType(intType); }
+            else if (name == "Hash") { type = MethodType::StringHash; method->SetResolvedType(TypeInfo::Create(m_Context, PrimitiveType::Long, false)); }
+        } else {
+            TypeInfo* elementType = std::get<ArrayDeclaration>(baseType->Data).Type;
+
+            if (name == "Append") { type = MethodType::ArrayAppend; paramType = elementType; }
+            else if (name == "Length") { type = MethodType::ArrayLength; method->SetResolvedType(intType); }
+            else if (name == "Reserve") { type = MethodType::ArrayReserve; paramType = intType; }
+            else if (name == "ShrinkToFit") { type = MethodType::ArrayShrinkToFit; }
+            else if (name == "Clear") { type = MethodType::ArrayClear; }
+        }
+
+        if (type == MethodType::Invalid) {
+            m_Context->ReportCompilerError({}, {}, fmt::format("Type '{}' has no method '{}'", TypeInfoToString(baseType), name));
+            return voidType;
+        }
+
+        size_t paramCount = paramType ? 1 : 0;
+        if (method->GetArguments().Size != paramCount) {
+            m_Context->ReportCompilerError({}, {}, fmt::format("Method '{}' takes {} argument(s) but {} were given", name, paramCount, method->GetArguments().Size));
+            return method->GetResolvedType();
+        }
+
+        if (paramType) {
+            method->SetArgument(0, HandleConversion(paramType, method->GetArguments().Items[0]));
+        }
+
+        method->SetMethodType(type);
+        return method->GetResolvedType();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleArraySubscriptExpr(Expr* expr) {
+        ArraySubscriptExpr* subscript = GetNode<ArraySubscriptExpr>(expr);
+
+        TypeInfo* baseType = HandleExpr(subscript->GetBase());
+        subscript->SetIndex(HandleConversion(TypeInfo::Create(m_Context, PrimitiveType::Int, true), subscript->GetIndex()));
+
+        if (baseType->Type != PrimitiveType::Array) {
+            m_Context->ReportCompilerError({}, {}, fmt::format("Cannot index into a value of type '{}'", TypeInfoToString(baseType)));
+            subscript->SetResolvedType(TypeInfo::Create(m_Context, PrimitiveType::Void));
+            return subscript->GetResolvedType();
+        }
+
+        subscript->SetResolvedType(std::get<ArrayDeclaration>(baseType->Data).Type);
+        return subscript->GetResolvedType();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleParenExpr(Expr* expr) {
+        ParenExpr* paren = GetNode<ParenExpr>(expr);
+        HandleExpr(paren->GetChildExpr());
+        return paren->GetResolvedType();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleCastExpr(Expr* expr) { ARIA_ASSERT(false, "todo: SemanticAnalyzer::HandleCastExpr()"); }
+
+    TypeInfo* SemanticAnalyzer::HandleUnaryOperatorExpr(Expr* expr) {
+        UnaryOperatorExpr* unary = GetNode<UnaryOperatorExpr>(expr);
+
+        TypeInfo* type = HandleExpr(unary->GetChildExpr());
+        unary->SetResolvedType(type);
+
+        // Only negation has op codes so far, and only for numbers
+        bool numeric = (type->IsIntegral() && type->Type != PrimitiveType::Bool) || type->IsFloatingPoint();
+        if (unary->GetUnaryOperator() != UnaryOperatorType::Negate || !numeric) {
+            m_Context->ReportCompilerError({}, {}, fmt::format("Operator '{}' is not defined for type '{}'", UnaryOperatorTypeToString(unary->GetUnaryOperator()), TypeInfoToString(type)));
+            return type;
+        }
+
+        if (unary->GetChildExpr()->IsLValue()) {
+            unary->SetChildExpr(InsertImplicitCast(type, type, unary->GetChildExpr(), CastType::LValueToRValue));
+        }
+
+        return type;
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleBinaryOperatorExpr(Expr* expr) {
+        BinaryOperatorExpr* binop = GetNode<BinaryOperatorExpr>(expr);
+
+        Expr* LHS = binop->GetLHS();
+        Expr* RHS = binop->GetRHS();
+
+        TypeInfo* LHSType = HandleExpr(binop->GetLHS());
+        TypeInfo* RHSType = HandleExpr(binop->GetRHS());
+
+        if (LHSType->Type == PrimitiveType::String) {
+            return HandleStringBinaryOperator(binop, LHSType, RHSType);
+        }
+
+        switch (binop->GetBinaryOperator()) {
+            case BinaryOperatorType::Add:
+            case BinaryOperatorType::Sub:
+            case BinaryOperatorType::Mul:
+            case BinaryOperatorType::Div:
+            case BinaryOperatorType::Mod:
+            case BinaryOperatorType::Less:
+            case BinaryOperatorType::LessOrEq:
+            case BinaryOperatorType::Greater:
+            case BinaryOperatorType::GreaterOrEq:
+            case BinaryOperatorType::IsEq:
+            case BinaryOperatorType::IsNotEq: {
+                // The common type is the one the other operand gets promoted to, eg. int + float is a float addition
+                TypeInfo* type = LHSType;
+                if (!TypeInfo::IsEqual(LHSType, RHSType)) {
+                    if (GetConversionCost(LHSType, RHSType, false).CoType == ConversionType::Promotion) {
+                        type = LHSType;
+                    } else if (GetConversionCost(RHSType, LHSType, false).CoType == ConversionType::Promotion) {
+                        type = RHSType;
+                    } else {
+                        m_Context->ReportCompilerError({}, {}, fmt::format("Mismatched types '{}' and '{}', no viable implicit cast", TypeInfoToString(LHSType), TypeInfoToString(RHSType)));
+                        binop->SetResolvedType(LHSType);
+                        return LHSType;
+                    }
+                }
+
+                // Both operands end up as rvalues of the common type
+                binop->SetLHS(ConvertExpr(type, LHSType, LHS));
+                binop->SetRHS(ConvertExpr(type, RHSType, RHS));
+
+                // Comparing the operands always produces a bool
+                switch (binop->GetBinaryOperator()) {
+                    case BinaryOperatorType::Add:
+                    case BinaryOperatorType::Sub:
+                    case BinaryOperatorType::Mul:
+                    case BinaryOperatorType::Div:
+                    case BinaryOperatorType::Mod: binop->SetResolvedType(type); break;
+
+                    default: binop->SetResolvedType(TypeInfo::Create(m_Context, PrimitiveType::Bool, true)); break;
+                }
+
+                return binop->GetResolvedType();
+            }
+
+            case BinaryOperatorType::AddInPlace:
+            case BinaryOperatorType::SubInPlace:
+            case BinaryOperatorType::MulInPlace:
+            case BinaryOperatorType::DivInPlace:
+            case BinaryOperatorType::ModInPlace:
+            case BinaryOperatorType::Eq: {
+                if (!binop->GetLHS()->IsLValue()) {
+                    // m_Context->ReportCompilerError(binop->LHS->Loc.Line, binop->LHS->Loc.Column, 
+                    //                                binop->LHS->Range.Start.Line, binop->LHS->Range.Start.Column,
+                    //                                binop->LHS->Range.End.Line, binop->LHS->Range.End.Column,
+                    //                                "Expression must be a modifiable lvalue");
+                    ARIA_ASSERT(false, "todo: add error for SemanticAnalyzer::HandleBinaryOperatorExpr()");
+                }
+
+                ConversionCost cost = GetConversionCost(LHSType, RHSType, binop->GetRHS()->IsLValue());
+
+                if (cost.CastNeeded) {
+                    if (cost.ImplicitCastPossible) {
+                        binop->SetRHS(InsertImplicitCast(LHSType, RHSType, RHS, cost.CaType));
+                        RHSType = LHSType;
+                    } else {
+                        // m_Context->ReportCompilerError(binop->RHS->Loc.Line, binop->RHS->Loc.Column, 
+                        //                                binop->RHS->Range.Start.Line, binop->RHS->Range.Start.Column,
+                        //                                binop->RHS->Range.End.Line, binop->RHS->Range.End.Column,
+                        //                                fmt::format("Cannot implicitly cast from {} to {}", TypeInfoToString(RHSType), TypeInfoToString(LHSType)));
+                        ARIA_ASSERT(false, "todo: add error for SemanticAnalyzer::HandleBinaryOperatorExpr()");
+                    }
+                }
+
+                binop->SetResolvedType(LHSType);
+                return LHSType;
+            }
+        }
+
+        ARIA_UNREACHABLE();
+    }
+
+    TypeInfo* SemanticAnalyzer::HandleStringBinaryOperator(BinaryOperatorExpr* binop, TypeInfo* LHSType, TypeInfo* RHSType) {
+        BinaryOperatorType op = binop->GetBinaryOperator();
+        binop->SetResolvedType(LHSType);
+
+        if (RHSType->Type != PrimitiveType::String) {
+            m_Context->ReportCompilerError({}, {}, fmt::format("Mismatched types '{}' and '{}', no viable implicit cast", TypeInfoToString(LHSType), TypeInfoToString(RHSType)));
+            return LHSType;
+        }
+
+        switch (op) {
+            case BinaryOperatorType::Add:
+            case BinaryOperatorType::Less:
+            case BinaryOperatorType::LessOrEq:
+            case BinaryOperatorType::Greater:
+            case BinaryOperatorType::GreaterOrEq:
+            case BinaryOperatorType::IsEq:
+            case BinaryOperatorType::IsNotEq: {
+                if (binop->GetLHS()->IsLValue()) {
+                    binop->SetLHS(InsertImplicitCast(LHSType, LHSType, binop->GetLHS(), CastType::LValueToRValue));
+                }
+
+                if (binop->GetRHS()->IsLValue()) {
+                    binop->SetRHS(InsertImplicitCast(RHSType, RHSType, binop->GetRHS(), CastType::LValueToRValue));
+                }
+
+                if (op != BinaryOperatorType::Add) {
+                    binop->SetResolvedType(TypeInfo::Create(m_Context, PrimitiveType::Bool, true));
+                }
+
+                return binop->GetResolvedType();
+            }
+
+            case BinaryOperatorType::AddInPlace:
+            case BinaryOperatorType::Eq: {
+                if (!binop->GetLHS()->IsLValue()) {
+                    m_Context->ReportCompilerError({}, {}, "Expression must be a modifiable lvalue");
+                }
+
+                if (binop->GetRHS()->IsLValue()) {
+                    binop->SetRHS(InsertImplicitCast(RHSType, RHSType, binop->GetRHS(), CastType::LValueToRValue));
+                }
+
+                return LHSType;
+            }
+
+            default: {
+                m_Context->ReportCompilerError({}, {}, fmt::format("Operator '{}' is not defined for type '{}'", BinaryOperatorTypeToString(op), TypeInfoToString(LHSType)));
+                return LHSType;
+            }
+        }
+    }
 
     TypeInfo* SemanticAnalyzer::HandleExpr(Expr* expr) {
         if (GetNode<BooleanConstantExpr>(expr)) {
@@ -42,6 +340,12 @@ namespace Aria::Internal {
             return HandleDeclRefExpr(expr);
         } else if (GetNode<CallExpr>(expr)) {
             return HandleCallExpr(expr);
+        } else if (GetNode<MethodCallExpr>(expr)) {
+            return HandleMethodCallExpr(expr);
+        } else if (GetNode<ArraySubscriptExpr>(expr)) {
+            return HandleArraySubscriptExpr(expr);
+        } else if (GetNode<ParenExpr>(expr)) {
+            return HandleParenExpr(expr);
         } else if (GetNode<CastExpr>(expr)) {
             return HandleCastExpr(expr);
         } else if (GetNode<UnaryOperatorExpr>(expr)) {
@@ -54,7 +358,7 @@ namespace Aria::Internal {
     }
 
     void SemanticAnalyzer::HandleTranslationUnitDecl(Decl* decl) {
-        TranslationUnitDecl* tu = GetNode<TranslationUnitDecl>(decl);
+        TranslationUnitDecl* tu = GetNode<TranslationUnitDecl>(decl);       
 
         for (Stmt* stmt : tu->GetStmts()) {
             HandleStmt(stmt);
@@ -64,41 +368,77 @@ namespace Aria::Internal {
     void SemanticAnalyzer::HandleVarDecl(Decl* decl) {
         VarDecl* varDecl = GetNode<VarDecl>(decl);
 
-        auto& map = GetActiveDeclMap();
+        TypeInfo* resolvedType = GetTypeInfoFromString(varDecl->GetParsedType());
+        varDecl->SetResolvedType(resolvedType);
 
-        VariableDeclaration d;
-        d.Type = varDecl->GetResolvedType();
-        d.SourceDecl = varDecl;
+        if (varDecl->GetDefaultValue()) {
+            TypeInfo* valType = HandleExpr(varDecl->GetDefaultValue());
 
-        map[varDecl->GetIdentifier()] = d;
+            ConversionCost cost = GetConversionCost(resolvedType, valType, varDecl->GetDefaultValue()->IsLValue());
+            if (cost.CastNeeded) {
+                if (cost.ImplicitCastPossible) {
+                    varDecl->SetDefaultValue(InsertImplicitCast(resolvedType, valType, varDecl->GetDefaultValue(), cost.CaType));
+                } else {
+                    ARIA_ASSERT(false, "todo: SemanticAnalyzer::HandleVarDecl() error");
+                }
+            }
+        }
+
+        DeclRefType type = DeclRefType::LocalVar;
+        if (m_Declarations.GetDepth() == 0) {
+            type = DeclRefType::GlobalVar;
+        }
+        
+        m_Declarations.Declare(varDecl->GetSymbol(), { varDecl->GetResolvedType(), decl, type });
     }
 
     void SemanticAnalyzer::HandleParamDecl(Decl* decl) {
         ParamDecl* paramDecl = GetNode<ParamDecl>(decl);
 
-        auto& map = GetActiveDeclMap();
+        TypeInfo* resolvedType = GetTypeInfoFromString(paramDecl->GetParsedType());
+        paramDecl->SetResolvedType(resolvedType);
 
-        ParameterDeclaration d;
-        d.Type = paramDecl->GetResolvedType();
-        d.SourceDecl = paramDecl;
-
-        map[paramDecl->GetIdentifier()] = d;
+        m_Declarations.Declare(paramDecl->GetSymbol(), { paramDecl->GetResolvedType(), decl });
     }
 
     void SemanticAnalyzer::HandleFunctionDecl(Decl* decl) {
         FunctionDecl* fnDecl = GetNode<FunctionDecl>(decl);
 
-        if (fnDecl->GetBody()) {
-            PushScope();
+        TypeInfo* returnType = GetTypeInfoFromString(fnDecl->GetParsedType());
+        TinyVector<TypeInfo*> paramTypes;
+        paramTypes.Reserve(m_Context, fnDecl->GetParameters().Size);
 
-            for (ParamDecl* p : fnDecl->GetParameters()) {
-                HandleParamDecl(p);
-            }
+        for (ParamDecl* p : fnDecl->GetParameters()) {
+            TypeInfo* pType = GetTypeInfoFromString(p->GetParsedType());
+            p->SetResolvedType(pType);
+            paramTypes.Append(m_Context, pType);
+        }
 
-            HandleCompoundStmt(fnDecl->GetBody());
+        FunctionDeclaration fd;
+        fd.ParamTypes = paramTypes;
+        fd.ReturnType = returnType;
+        fd.External = fnDecl->IsExtern();
+        
+        TypeInfo* resolvedType = TypeInfo::Create(m_Context, PrimitiveType::Function, fd);
+        fnDecl->SetResolvedType(resolvedType);
+
+        // Functions can only be declared in the global space
+        // The function is declared before its body gets analyzed so that it can call itself
+        m_Declarations.Declare(fnDecl->GetSymbol(), { fnDecl->GetResolvedType(), decl, DeclRefType::Function });
 
-            PopScope();
+        m_ActiveReturnType = returnType;
+        m_Declarations.PushScope();
+
+        for (ParamDecl* p : fnDecl->GetParameters()) {
+            m_Declarations.Declare(p->GetSymbol(), { p->GetResolvedType(), p });
+        }
+
+        if (fnDecl->GetBody()) {
+            HandleCompoundStmt(fnDecl->GetBody());
         }
+
+        m_Declarations.PopScope();
+        m_ActiveReturnType = nullptr;
     }
 
     void SemanticAnalyzer::HandleDecl(Decl* decl) {
@@ -127,30 +467,84 @@ namespace Aria::Internal {
         }
     }
 
-
     void SemanticAnalyzer::HandleWhileStmt(Stmt* stmt) {
-        ARIA_ASSERT(false, "todo");
+        WhileStmt* wh = GetNode<WhileStmt>(stmt);
+
+        wh->SetCondition(HandleCondition(wh->GetCondition()));
+        HandleStmt(wh->GetBody());
     }
 
     void SemanticAnalyzer::HandleDoWhileStmt(Stmt* stmt) {
-        ARIA_ASSERT(false, "todo");
+        DoWhileStmt* doWh = GetNode<DoWhileStmt>(stmt);
+
+        HandleStmt(doWh->GetBody());
+        doWh->SetCondition(HandleCondition(doWh->GetCondition()));
     }
 
     void SemanticAnalyzer::HandleForStmt(Stmt* stmt) {
-        ARIA_ASSERT(false, "todo");
+        ForStmt* fs = GetNode<ForStmt>(stmt);
+
+        // Whatever the prologue declares is only visible inside of the loop
+        m_Declarations.PushScope();
+
+        if (fs->GetPrologue()) { HandleStmt(fs->GetPrologue()); }
+        if (fs->GetCondition()) { fs->SetCondition(HandleCondition(fs->GetCondition())); }
+        if (fs->GetEpilogue()) { HandleExpr(fs->GetEpilogue()); }
+        HandleStmt(fs->GetBody());
+
+        m_Declarations.PopScope();
     }
 
     void SemanticAnalyzer::HandleIfStmt(Stmt* stmt) {
-        ARIA_ASSERT(false, "todo");
+        IfStmt* ifs = GetNode<IfStmt>(stmt);
+
+        ifs->SetCondition(HandleCondition(ifs->GetCondition()));
+
+        HandleStmt(ifs->GetBody());
+        if (ifs->GetElseBody()) {
+            HandleStmt(ifs->GetElseBody());
+        }
     }
 
-    void SemanticAnalyzer::HandleReturnStmt(Stmt* stmt) {}
+    void SemanticAnalyzer::HandleReturnStmt(Stmt* stmt) {
+        ReturnStmt* ret = GetNode<ReturnStmt>(stmt);
+
+        if (m_ActiveReturnType == nullptr) {
+            ARIA_ASSERT(false, "todo: error msg");
+        }
+
+        Expr* value = ret->GetValue();
+        TypeInfo* valType = HandleExpr(value);
+
+        ConversionCost cost = GetConversionCost(m_ActiveReturnType, valType, value->IsLValue());
+        if (cost.CastNeeded) {
+            if (cost.ImplicitCastPossible) {
+                ret->SetValue(InsertImplicitCast(m_ActiveReturnType, valType, value, cost.CaType));
+            } else {
+                ARIA_ASSERT(false, "todo: error");
+            }
+        }
+    }
+
+    Expr* SemanticAnalyzer::HandleCondition(Expr* condition) {
+        TypeInfo* condType = HandleExpr(condition);
+
+        if (condType->Type != PrimitiveType::Bool && !condType->IsIntegral() && !condType->IsFloatingPoint()) {
+            ARIA_ASSERT(false, "todo: add error for SemanticAnalyzer::HandleCondition()");
+        }
+
+        if (condition->IsLValue()) {
+            return InsertImplicitCast(condType, condType, condition, CastType::LValueToRValue);
+        }
+
+        return condition;
+    }
 
     void SemanticAnalyzer::HandleStmt(Stmt* stmt) {
         if (GetNode<CompoundStmt>(stmt)) {
-            PushScope();
+            m_Declarations.PushScope();
             HandleCompoundStmt(stmt);
-            PopScope();
+            m_Declarations.PopScope();
             return;
         } else if (GetNode<WhileStmt>(stmt)) {
             HandleWhileStmt(stmt);
@@ -161,6 +555,9 @@ namespace Aria::Internal {
         } else if (GetNode<ForStmt>(stmt)) {
             HandleForStmt(stmt);
             return;
+        } else if (GetNode<IfStmt>(stmt)) {
+            HandleIfStmt(stmt);
+            return;
         } else if (GetNode<ReturnStmt>(stmt)) {
             HandleReturnStmt(stmt);
             return;
@@ -175,21 +572,148 @@ namespace Aria::Internal {
         ARIA_UNREACHABLE();
     }
 
-    void SemanticAnalyzer::PushScope() {
-        m_Scopes.emplace_back();
+    TypeInfo* SemanticAnalyzer::GetTypeInfoFromString(StringView str) {
+        size_t bracket = str.Find('[');
+
+        std::string isolatedType;
+        bool array = false;
+
+        if (bracket != StringView::npos) {
+            isolatedType = fmt::format("{}", str.SubStr(0, bracket));
+            array = true;
+        } else {
+            isolatedType = fmt::format("{}", str);
+        }
+
+        TypeInfo* type = nullptr;
+
+        if (isolatedType == "void") { type = TypeInfo::Create(m_Context, PrimitiveType::Void); }
+        if (isolatedType == "bool") { type = TypeInfo::Create(m_Context, PrimitiveType::Bool, true); }
+        if (isolatedType == "char") { type = TypeInfo::Create(m_Context, PrimitiveType::Char, true); }
+        if (isolatedType == "uchar") { type = TypeInfo::Create(m_Context, PrimitiveType::Char, false); }
+        if (isolatedType == "short") { type = TypeInfo::Create(m_Context, PrimitiveType::Short, true); }
+        if (isolatedType == "ushort") { type = TypeInfo::Create(m_Context, PrimitiveType::Short, false); }
+        if (isolatedType == "int") { type = TypeInfo::Create(m_Context, PrimitiveType::Int, true); }
+        if (isolatedType == "uint") { type = TypeInfo::Create(m_Context, PrimitiveType::Int, false); }
+        if (isolatedType == "long") { type = TypeInfo::Create(m_Context, PrimitiveType::Long, true); }
+        if (isolatedType == "ulong") { type = TypeInfo::Create(m_Context, PrimitiveType::Long, false); }
+        if (isolatedType == "float") { type = TypeInfo::Create(m_Context, PrimitiveType::Float); }
+        if (isolatedType == "double") { type = TypeInfo::Create(m_Context, PrimitiveType::Double); }
+        if (isolatedType == "string") { type = TypeInfo::Create(m_Context, PrimitiveType::String); }
+
+        #undef TYPE
+
+        // Handle user defined type
+        if (type->Type == PrimitiveType::Invalid) {
+            ARIA_ASSERT(false, "todo");
+            // if (m_DeclaredStructs.contains(isolatedType)) {
+            //     type->Type = PrimitiveType::Structure;
+            //     type->Data = m_DeclaredStructs.at(isolatedType);
+            // } else {
+            //     ErrorUndeclaredIdentifier(StringView(isolatedType.c_str(), isolatedType.size()), 0, 0);
+            // }
+        }
+
+        if (array) {
+            // The array op codes are typed, so only elements the VM has arithmetic for are supported so far
+            if (!VisitVMType(type, [](auto) {})) {
+                m_Context->ReportCompilerError({}, {}, fmt::format("Arrays of '{}' are not supported yet", TypeInfoToString(type)));
+            }
+
+            ArrayDeclaration decl;
+            decl.Type = type;
+
+            type = TypeInfo::Create(m_Context, PrimitiveType::Array, decl);
+        }
+
+        return type;
+    }
+
+    ConversionCost SemanticAnalyzer::GetConversionCost(TypeInfo* dst, TypeInfo* src, bool srcLValue) {
+        ConversionCost cost{};
+        cost.CastNeeded = true;
+        cost.ExplicitCastPossible = true;
+        cost.ImplicitCastPossible = true;
+
+        if (TypeInfo::IsEqual(src, dst)) {
+            if (srcLValue) {
+                cost.CastNeeded = true;
+                cost.CaType = CastType::LValueToRValue;
+                cost.CoType = ConversionType::LValueToRValue;
+            } else {
+                cost.CastNeeded = false;
+            }
+
+            return cost;
+        }
+
+        if (src->IsIntegral()) {
+            if (dst->IsIntegral()) { // Int to int
+                if (src->GetSize() > dst->GetSize()) {
+                    cost.CoType = ConversionType::Narrowing;
+                    cost.CaType = CastType::Integral;
+                } else if (src->GetSize() < dst->GetSize()) {
+                    cost.CoType = ConversionType::Promotion;
+                    cost.CaType = CastType::Integral;
+                } else {
+                    if (src->IsSigned() == dst->IsSigned()) {
+                        cost.CoType = ConversionType::None;
+                        cost.CastNeeded = false;
+                    } else {
+                        cost.CoType = ConversionType::SignChange;
+                        cost.CastNeeded = true;
+                    }
+                }
+            } else if (dst->IsFloatingPoint()) { // Int to float
+                cost.CoType = ConversionType::Promotion;
+                cost.CaType = CastType::IntegralToFloating;
+            } else {
+                cost.ExplicitCastPossible = false;
+            }
+        }
+
+        if (src->IsFloatingPoint()) {
+            if (dst->IsFloatingPoint()) { // Float to float
+                if (src->GetSize() > dst->GetSize()) {
+                    cost.CoType = ConversionType::Narrowing;
+                    cost.CaType = CastType::Floating;
+                } else if (src->GetSize() < dst->GetSize()) {
+                    cost.CoType = ConversionType::Promotion;
+                    cost.CaType = CastType::Floating;
+                } else {
+                    cost.CoType = ConversionType::None;
+                    cost.CastNeeded = false;
+                }
+            } else if (dst->IsIntegral()) { // Float to int
+                cost.ImplicitCastPossible = false;
+                cost.CoType = ConversionType::Narrowing;
+                cost.CaType = CastType::FloatingToIntegral;
+            } else {
+                cost.ExplicitCastPossible = false;
+            }
+        }
+
+        return cost;
+    }
+
+    Expr* SemanticAnalyzer::InsertImplicitCast(TypeInfo* dstType, TypeInfo* srcType, Expr* srcExpr, CastType castType) {
+        return m_Context->Allocate<ImplicitCastExpr>(m_Context, srcExpr, castType, dstType);
     }
 
-    void SemanticAnalyzer::PopScope() {
-        ARIA_ASSERT(m_Scopes.size() > 0, "SemanticAnalyzer::PopScope() called with no active scopes");
-        m_Scopes.pop_back();
+    Expr* SemanticAnalyzer::HandleConversion(TypeInfo* dstType, Expr* expr) {
+        return ConvertExpr(dstType, HandleExpr(expr), expr);
     }
 
-    std::unordered_map<std::string, SemanticAnalyzer::Declaration>& SemanticAnalyzer::GetActiveDeclMap() {
-        if (m_Scopes.size() == 0) {
-            return m_GlobalDeclaredSymbols;
+    Expr* SemanticAnalyzer::ConvertExpr(TypeInfo* dstType, TypeInfo* srcType, Expr* expr) {
+        ConversionCost cost = GetConversionCost(dstType, srcType, expr->IsLValue());
+        if (!cost.CastNeeded) { return expr; }
+
+        if (!cost.ImplicitCastPossible) {
+            m_Context->ReportCompilerError({}, {}, fmt::format("Cannot implicitly cast from '{}' to '{}'", TypeInfoToString(srcType), TypeInfoToString(dstType)));
+            return expr;
         }
 
-        return m_Scopes.back().DeclaredSymbols;
+        return InsertImplicitCast(dstType, srcType, expr, cost.CaType);
     }
 
 } // namespace Aria::Internal
@@ -1,36 +1,42 @@
 #pragma once
 
+#include "aria/internal/compiler/types/type_info.hpp"
+#include "aria/internal/compiler/core/string_builder.hpp"
+#include "aria/internal/compiler/core/symbol_table.hpp"
 #include "aria/internal/compiler/ast/expr.hpp"
 #include "aria/internal/compiler/ast/decl.hpp"
 #include "aria/internal/compiler/ast/stmt.hpp"
-#include "aria/internal/compiler/semantic_analyzer/type_checker.hpp"
 #include "aria/internal/compiler/compilation_context.hpp"
 
-#include <unordered_map>
-
 namespace Aria::Internal {
+    
+    enum class ConversionType {
+        None,
+        Promotion,
+        Narrowing,
+        SignChange,
+        LValueToRValue
+    };
 
-    class SemanticAnalyzer {
-    private:
-        struct VariableDeclaration {
-            TypeInfo* Type = nullptr;
-            VarDecl* SourceDecl = nullptr;
-        };
-
-        struct ParameterDeclaration {
-            TypeInfo* Type = nullptr;
-            ParamDecl* SourceDecl = nullptr;
-        };
-
-        struct FunctionDeclaration {
-            TypeInfo* ReturnType = nullptr;
-            FunctionDecl* SourceDecl = nullptr;
-        };
+    struct ConversionCost {
+        ConversionType CoType = ConversionType::None;
+        CastType CaType = CastType::Invalid;
 
-        using Declaration = std::variant<VariableDeclaration, ParameterDeclaration, FunctionDeclaration>;
+        bool CastNeeded = false;
+        bool SignedMismatch = false;
+        bool LValueMismatch = false;
+        bool ImplicitCastPossible = false;
+        bool ExplicitCastPossible = false;
+    };
 
-        struct Scope {
-            std::unordered_map<std::string, Declaration> DeclaredSymbols;
+    // Resolves names, types and implicit casts in a single walk over the AST
+    // Every subtree is visited exactly once, with one scope stack shared by all of the checks
+    class SemanticAnalyzer {
+    private:
+        struct Declaration {
+            TypeInfo* ResolvedType = nullptr;
+            Decl* SourceDeclaration = nullptr;
+            DeclRefType DeclType = DeclRefType::LocalVar;
         };
 
     public:
@@ -46,10 +52,14 @@ namespace Aria::Internal {
         TypeInfo* HandleStringConstantExpr(Expr* expr);
         TypeInfo* HandleDeclRefExpr(Expr* expr);
         TypeInfo* HandleCallExpr(Expr* expr);
+        TypeInfo* HandleMethodCallExpr(Expr* expr);
+        TypeInfo* HandleArraySubscriptExpr(Expr* expr);
         TypeInfo* HandleParenExpr(Expr* expr);
         TypeInfo* HandleCastExpr(Expr* expr);
         TypeInfo* HandleUnaryOperatorExpr(Expr* expr);
         TypeInfo* HandleBinaryOperatorExpr(Expr* expr);
+        // Strings only concatenate and compare, both sides have to be strings
+        TypeInfo* HandleStringBinaryOperator(BinaryOperatorExpr* binop, TypeInfo* LHSType, TypeInfo* RHSType);
 
         TypeInfo* HandleExpr(Expr* expr);
 
@@ -67,22 +77,27 @@ namespace Aria::Internal {
         void HandleIfStmt(Stmt* stmt);
         void HandleReturnStmt(Stmt* stmt);
 
+        // Conditions of ifs and loops, returns the condition as an rvalue
+        Expr* HandleCondition(Expr* condition);
+
         void HandleStmt(Stmt* stmt);
 
-        void PushScope();
-        void PopScope();
+        TypeInfo* GetTypeInfoFromString(StringView str);
 
-        std::unordered_map<std::string, Declaration>& GetActiveDeclMap();
+        // type1 is the destination type and type2 is the source type
+        ConversionCost GetConversionCost(TypeInfo* dst, TypeInfo* src, bool srcLValue);
+        Expr* InsertImplicitCast(TypeInfo* dstType, TypeInfo* srcType, Expr* srcExpr, CastType castType); // Returns the new ImplicitCastExpr
+        // Analyzes expr and converts it to dstType, reports an error if there is no implicit conversion
+        Expr* HandleConversion(TypeInfo* dstType, Expr* expr);
+        // Same as HandleConversion() for an expression that has already been analyzed, srcType being its type
+        Expr* ConvertExpr(TypeInfo* dstType, TypeInfo* srcType, Expr* expr);
 
     private:
         Stmt* m_RootASTNode = nullptr;
 
-        std::unordered_map<std::string, Declaration> m_GlobalDeclaredSymbols;
-        std::vector<Scope> m_Scopes;
-
-        bool m_IsFunctionScope = false;
+        ScopedSymbolMap<Declaration> m_Declarations; // Depth 0 holds the global declarations
+        TypeInfo* m_ActiveReturnType = nullptr;
 
-        TypeChecker m_TypeChecker;
         CompilationContext* m_Context = nullptr;
     };
 
@@ -68,6 +68,10 @@ namespace Aria::Internal {
         static bool IsEqual(TypeInfo* lhs, TypeInfo* rhs) {
             if (lhs->Type != rhs->Type) { return false; }
 
+            if (lhs->Type == PrimitiveType::Array) {
+                return IsEqual(std::get<ArrayDeclaration>(lhs->Data).Type, std::get<ArrayDeclaration>(rhs->Data).Type);
+            }
+
             return true;
         }
 
@@ -0,0 +1,73 @@
+#include "aria/internal/mapped_file.hpp"
+
+#include <fstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+    #define ARIA_HAS_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Aria::Internal {
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    bool MappedFile::Open(const std::string& path) {
+        Close();
+
+        #ifdef ARIA_HAS_MMAP
+            int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) { return false; }
+
+            struct stat st{};
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                return false;
+            }
+
+            if (st.st_size > 0) {
+                void* mem = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+                if (mem != MAP_FAILED) {
+                    close(fd); // The mapping keeps its own reference to the file
+
+                    m_Data = reinterpret_cast<const u8*>(mem);
+                    m_Size = static_cast<size_t>(st.st_size);
+                    m_Mapped = true;
+                    return true;
+                }
+            }
+
+            close(fd);
+        #endif
+
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) { return false; }
+
+        m_Buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(m_Buffer.data()), static_cast<std::streamsize>(m_Buffer.size()));
+
+        m_Data = m_Buffer.data();
+        m_Size = m_Buffer.size();
+        return true;
+    }
+
+    void MappedFile::Close() {
+        #ifdef ARIA_HAS_MMAP
+            if (m_Mapped) {
+                munmap(const_cast<u8*>(m_Data), m_Size);
+            }
+        #endif
+
+        m_Buffer.clear();
+        m_Data = nullptr;
+        m_Size = 0;
+        m_Mapped = false;
+    }
+
+} // namespace Aria::Internal
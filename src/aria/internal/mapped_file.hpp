@@ -0,0 +1,38 @@
+#pragma once
+
+#include "aria/internal/types.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // A read-only view of a whole file
+    // On POSIX systems the file gets mapped into memory so nothing is copied until a page is touched,
+    // elsewhere the file is simply read into a buffer
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile(MappedFile&& other) = delete;
+        void operator=(const MappedFile& other) = delete;
+        void operator=(MappedFile&& other) = delete;
+
+        // Returns false if the file could not be opened
+        bool Open(const std::string& path);
+        void Close();
+
+        inline const u8* Data() const { return m_Data; }
+        inline size_t Size() const { return m_Size; }
+
+    private:
+        const u8* m_Data = nullptr;
+        size_t m_Size = 0;
+
+        bool m_Mapped = false;
+        std::vector<u8> m_Buffer; // Only used when the file couldn't be mapped
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Returns the amount of workers to use when the caller didn't ask for a specific amount
+    inline size_t GetDefaultWorkerCount() {
+        size_t count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 1;
+    }
+
+    // Calls fn(i) for every i in [0, count) on a pool of workers
+    // Work items are handed out one at a time so a few big items don't leave the other workers idle
+    // The calling thread is used as one of the workers and the function returns once every item is done
+    template <typename Fn>
+    void ParallelFor(size_t count, size_t workerCount, Fn&& fn) {
+        if (workerCount == 0) { workerCount = GetDefaultWorkerCount(); }
+        if (workerCount > count) { workerCount = count; }
+
+        std::atomic<size_t> next = 0;
+        auto work = [&]() {
+            for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                fn(i);
+            }
+        };
+
+        if (workerCount <= 1) {
+            work();
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(workerCount - 1);
+
+        for (size_t i = 0; i < workerCount - 1; i++) {
+            workers.emplace_back(work);
+        }
+
+        work();
+
+        for (std::thread& t : workers) {
+            t.join();
+        }
+    }
+
+} // namespace Aria::Internal
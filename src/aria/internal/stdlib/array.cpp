@@ -1,79 +1,205 @@
 #include "aria/internal/stdlib/array.hpp"
 #include "aria/core.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <new>
+
 namespace Aria::Internal {
 
-    struct Array {
-        uint8_t* Data = nullptr;
-        int32_t MemberSize = 0;
+    ArrayHeap::ArrayHeap(ScriptHeap* heap)
+        : m_Heap(heap) {}
 
-        int32_t Size = 0;
-        int32_t Capacity = 0;
-    };
+    ArrayHeap::ArrayHeap(ArrayHeap&& other) noexcept
+        : m_Arrays(std::move(other.m_Arrays)), m_Heap(other.m_Heap), m_Allocator(other.m_Allocator), m_Stats(other.m_Stats),
+          m_ArenaMark(other.m_ArenaMark), m_ArenaBytes(other.m_ArenaBytes) {
+        other.m_Arrays.clear();
+        other.m_Stats = {};
+        other.m_ArenaMark = SIZE_MAX;
+        other.m_ArenaBytes = 0;
+    }
 
-    void bl__array__init__(Context* ctx) {
-        Array* arr = new Array();
-        int32_t size = ctx->GetInt(-2);
-        
-        arr->Size = 0;
-        arr->Capacity = 1;
-        arr->MemberSize = size;
-        arr->Data = new uint8_t[size];
-        
-        ctx->StorePointer(-1, arr);
+    ArrayHeap::~ArrayHeap() {
+        FreeAll();
+    }
+
+    ArrayHeap& ArrayHeap::operator=(ArrayHeap&& other) noexcept {
+        if (this != &other) {
+            FreeAll();
+
+            m_Arrays = std::move(other.m_Arrays);
+            m_Heap = other.m_Heap;
+            m_Allocator = other.m_Allocator;
+            m_Stats = other.m_Stats;
+            m_ArenaMark = other.m_ArenaMark;
+            m_ArenaBytes = other.m_ArenaBytes;
+
+            other.m_Arrays.clear();
+            other.m_Stats = {};
+            other.m_ArenaMark = SIZE_MAX;
+            other.m_ArenaBytes = 0;
+        }
+
+        return *this;
+    }
+
+    bool ArrayHeap::SetAllocator(const ArrayAllocator& allocator) {
+        // Every block has to go back to the allocator it came from
+        if (!m_Arrays.empty()) { return false; }
+
+        m_Allocator = allocator;
+        return true;
+    }
+
+    Array* ArrayHeap::Create(int32_t memberSize) {
+        Array* arr = new (Allocate(sizeof(Array))) Array();
+        arr->MemberSize = memberSize;
+        arr->Data = arr->Inline;
+        arr->Capacity = arr->GetInlineCapacity();
+
+        m_Arrays.push_back(arr);
+        return arr;
     }
 
-    void bl__array__copy__(Context* ctx) {
-        // Array* dst = reinterpret_cast<Array*>(ctx->GetVM().GetPointer(-2));
-        // Array* src = reinterpret_cast<Array*>(ctx->GetVM().GetPointer(-1));
-        // 
-        // dst->Size = src->Size;
-        // dst->MemberSize = src->MemberSize;
-        // dst->Data = new uint8_t[dst->Size * dst->MemberSize];
-        // memcpy(dst->Data, src->Data, dst->Size * dst->MemberSize);
+    void ArrayHeap::Reserve(Array* arr, int32_t capacity) {
+        if (capacity <= arr->Capacity) { return; }
+
+        Relocate(arr, capacity);
+        m_Stats.Grows++;
+    }
+
+    uint8_t* ArrayHeap::Append(Array* arr) {
+        if (arr->Size == arr->Capacity) {
+            ARIA_ASSERT(arr->Capacity < INT32_MAX, "Array too long!");
+
+            // Grown in 64 bits, the capacity of a large array times the growth factor doesn't fit into an int32_t anymore
+            int64_t capacity = std::clamp<int64_t>(static_cast<int64_t>(arr->Capacity) * ArrayGrowthFactor, 1, INT32_MAX);
+            Relocate(arr, static_cast<int32_t>(capacity));
+            m_Stats.Grows++;
+        }
 
-        ARIA_ASSERT(false, "TODO");
+        return arr->Data + static_cast<size_t>(arr->Size++) * arr->MemberSize;
     }
 
-    void bl__array__destruct__(Context* ctx) {
-        Array* arr = reinterpret_cast<Array*>(ctx->GetPointer(-1));
-        
-        delete[] arr->Data;
+    void ArrayHeap::ShrinkToFit(Array* arr) {
+        if (arr->IsInline() || arr->Size == arr->Capacity) { return; }
+
+        Relocate(arr, arr->Size);
+        m_Stats.Shrinks++;
+    }
+
+    void ArrayHeap::Clear(Array* arr) {
         arr->Size = 0;
-        arr->Capacity = 0;
-        
-        delete arr;
-        ctx->StorePointer(-1, nullptr);
     }
 
-    void bl__array__append__(Context* ctx) {
-        Array* arr = reinterpret_cast<Array*>(ctx->GetPointer(-2));
-        StackSlot slot = ctx->GetStackSlot(-1);
+    void ArrayHeap::FreeAll() {
+        // The script heap gets released as a whole, only a custom allocator needs every block back
+        if (!m_Allocator.Allocate) {
+            m_Arrays.clear();
+            return;
+        }
+
+        for (Array* arr : m_Arrays) {
+            if (!arr->IsInline()) {
+                Free(arr->Data, static_cast<size_t>(arr->Capacity) * arr->MemberSize);
+            }
+
+            arr->~Array();
+            Free(arr, sizeof(Array));
+        }
+
+        m_Arrays.clear();
+    }
+
+    void ArrayHeap::BeginArena() {
+        // Blocks of a custom allocator have to go back to it, so those arrays never live in the arena
+        if (m_Allocator.Allocate) { return; }
+
+        m_ArenaMark = m_Arrays.size();
+    }
+
+    void ArrayHeap::EndArena() {
+        if (m_ArenaMark == SIZE_MAX) { return; }
+
+        // Every array created since the mark came from the arena, the ones from before stay in the heap even if they grew in between
+        m_Arrays.resize(m_ArenaMark);
+        m_ArenaMark = SIZE_MAX;
+
+        m_Stats.BytesAllocated -= m_ArenaBytes;
+        m_ArenaBytes = 0;
+    }
+
+    Array* ArrayHeap::Persist(const Array* arr) {
+        Array* copy = Create(arr->MemberSize);
+        Relocate(copy, std::max(arr->Size, copy->Capacity));
+
+        memcpy(copy->Data, arr->Data, static_cast<size_t>(arr->Size) * arr->MemberSize);
+        copy->Size = arr->Size;
+
+        return copy;
+    }
+
+    ArrayStats ArrayHeap::GetStats() const {
+        ArrayStats stats = m_Stats;
+        stats.GrowthFactor = ArrayGrowthFactor;
+        stats.InlineBytes = ArrayInlineBytes;
 
-        ARIA_ASSERT(slot.Size == arr->MemberSize, "Invalid Array::Append argument");
+        stats.Arrays = m_Arrays.size();
+        stats.InlineArrays = static_cast<size_t>(std::count_if(m_Arrays.begin(), m_Arrays.end(), [](const Array* arr) { return arr->IsInline(); }));
+
+        return stats;
+    }
 
-        if (arr->Size + 1 >= arr->Capacity) {
-            arr->Capacity *= 2;
-            uint8_t* newData = new uint8_t[arr->Capacity * arr->MemberSize];
-            memcpy(newData, arr->Data, arr->Size * arr->MemberSize);
-            delete[] arr->Data;
-            arr->Data = newData;
+    void* ArrayHeap::Allocate(size_t bytes, bool persistent) {
+        void* memory = nullptr;
+
+        if (m_Allocator.Allocate) {
+            memory = m_Allocator.Allocate(bytes, m_Allocator.UserData);
+        } else if (persistent || !m_Heap->IsArenaActive()) {
+            memory = m_Heap->AllocatePersistent(bytes);
+        } else {
+            memory = m_Heap->Allocate(bytes);
+            m_ArenaBytes += bytes;
         }
 
-        memcpy(arr->Data + arr->Size * arr->MemberSize, slot.Memory, arr->MemberSize);
-        arr->Size++;
+        m_Stats.Allocations++;
+        m_Stats.BytesAllocated += bytes;
+        m_Stats.PeakBytesAllocated = std::max(m_Stats.PeakBytesAllocated, m_Stats.BytesAllocated);
+
+        return memory;
     }
 
-    void bl__array__index__(Context* ctx) {
-        Array* arr = reinterpret_cast<Array*>(ctx->GetPointer(-3));
-        int32_t index = ctx->GetInt(-2);
-        
-        if (index >= arr->Size) {
-            ARIA_ASSERT(false, "TODO: runtime error");
+    void ArrayHeap::Free(void* memory, size_t bytes, bool arena) {
+        if (arena) {
+            m_ArenaBytes -= bytes;
+        } else if (!m_Allocator.Allocate) {
+            m_Heap->Free(memory, bytes);
+        } else if (m_Allocator.Free) {
+            m_Allocator.Free(memory, bytes, m_Allocator.UserData);
+        }
+
+        m_Stats.Frees++;
+        m_Stats.BytesAllocated -= bytes;
+    }
+
+    void ArrayHeap::Relocate(Array* arr, int32_t capacity) {
+        bool inlined = capacity <= arr->GetInlineCapacity();
+        if (inlined && arr->IsInline()) { return; }
+
+        // The elements of an array always live where its header does, so an array from before the arena began keeps growing in the heap
+        // Only looked up while an arena is active, outside of one nothing can be arena memory
+        bool arena = m_Heap->IsArenaActive() && m_Heap->IsArenaMemory(arr);
+        bool persistent = m_Heap->IsArenaActive() && !arena;
+
+        uint8_t* block = inlined ? arr->Inline : reinterpret_cast<uint8_t*>(Allocate(static_cast<size_t>(capacity) * arr->MemberSize, persistent));
+        memcpy(block, arr->Data, static_cast<size_t>(arr->Size) * arr->MemberSize);
+
+        if (!arr->IsInline()) {
+            Free(arr->Data, static_cast<size_t>(arr->Capacity) * arr->MemberSize, arena);
         }
 
-        StackSlot retSlot = ctx->GetStackSlot(-1);
-        memcpy(retSlot.Memory, &arr->Data[index * arr->MemberSize], arr->MemberSize);
+        arr->Data = block;
+        arr->Capacity = inlined ? arr->GetInlineCapacity() : capacity;
     }
 
 } // namespace Aria::Internal
@@ -1,14 +1,90 @@
 #pragma once
 
 #include "aria/context.hpp"
+#include "aria/internal/types.hpp"
+#include "aria/internal/vm/heap.hpp"
+
+#include <vector>
 
 namespace Aria::Internal {
 
-    void bl__array__init__(Context* ctx);
-    void bl__array__copy__(Context* ctx);
-    void bl__array__destruct__(Context* ctx);
+    // The elements of a small array live right behind its header, both come from a single allocation
+    inline constexpr size_t ArrayInlineBytes = 40;
+    // How much the capacity gets multiplied by once an append runs out of room
+    inline constexpr int32_t ArrayGrowthFactor = 2;
+
+    // The runtime representation of T[], scripts only ever hold a pointer to it
+    struct Array {
+        uint8_t* Data = nullptr; // Either Inline or a block from the script heap (or the ArrayAllocator)
+        int32_t MemberSize = 0;
+
+        int32_t Size = 0;
+        int32_t Capacity = 0;
+
+        alignas(8) uint8_t Inline[ArrayInlineBytes];
+
+        inline bool IsInline() const { return Data == Inline; }
+        inline int32_t GetInlineCapacity() const { return static_cast<int32_t>(ArrayInlineBytes) / MemberSize; }
+    };
+
+    static_assert(sizeof(Array) == 64, "An array header and its inline elements should fill a single cache line");
+
+    // Owns the arrays created by the array op codes, they all live until the heap is destroyed (together with its VM)
+    // There are no destructors in the language yet so nothing frees an array any earlier
+    // All the memory comes from the script heap of the VM, or from an ArrayAllocator which can only be set while the heap is still empty
+    class ArrayHeap {
+    public:
+        explicit ArrayHeap(ScriptHeap* heap);
+        ArrayHeap(const ArrayHeap&) = delete;
+        ArrayHeap(ArrayHeap&& other) noexcept;
+        ~ArrayHeap();
+
+        ArrayHeap& operator=(const ArrayHeap&) = delete;
+        ArrayHeap& operator=(ArrayHeap&& other) noexcept;
+
+        // Returns false (and keeps the current allocator) if the heap already holds arrays
+        bool SetAllocator(const ArrayAllocator& allocator);
+
+        Array* Create(int32_t memberSize);
+
+        // Makes room for at least capacity elements, never shrinks
+        void Reserve(Array* arr, int32_t capacity);
+        // Grows the array by one element and returns its (uninitialized) memory
+        uint8_t* Append(Array* arr);
+        // Releases the capacity the elements don't use, moving them back into the inline storage if they fit
+        void ShrinkToFit(Array* arr);
+        // Drops every element but keeps the capacity
+        void Clear(Array* arr);
+
+        // Frees every array, arrays from the script heap are left to the script heap which releases them all at once
+        void FreeAll();
+
+        // Arrays created in between come from the invocation arena of the script heap, unless there is an ArrayAllocator
+        void BeginArena();
+        // Forgets every array of the arena, has to happen before the script heap resets it
+        void EndArena();
+        // Copies an array of the arena (header and elements) into memory that outlives the arena
+        Array* Persist(const Array* arr);
+
+        inline size_t GetCount() const { return m_Arrays.size(); }
+        ArrayStats GetStats() const;
+
+    private:
+        // persistent keeps the memory out of the arena
+        void* Allocate(size_t bytes, bool persistent = false);
+        // Arena memory never goes back on its own, it only stops counting towards BytesAllocated
+        void Free(void* memory, size_t bytes, bool arena = false);
+        // Moves the elements into a block of exactly capacity elements, or into the inline storage if they fit it
+        void Relocate(Array* arr, int32_t capacity);
+
+    private:
+        std::vector<Array*> m_Arrays;
+        ScriptHeap* m_Heap = nullptr;
+        ArrayAllocator m_Allocator;
+        ArrayStats m_Stats;
 
-    void bl__array__append__(Context* ctx);
-    void bl__array__index__(Context* ctx);
+        size_t m_ArenaMark = SIZE_MAX; // How many arrays existed when the arena began, SIZE_MAX while there is none
+        size_t m_ArenaBytes = 0; // Part of BytesAllocated that goes away with the arena
+    };
 
 } // namespace Aria::Internal
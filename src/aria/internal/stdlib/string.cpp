@@ -1,78 +1,280 @@
 #include "aria/internal/stdlib/string.hpp"
 #include "aria/core.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <new>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define ARIA_STRING_SIMD
+#endif
+
 namespace Aria::Internal {
 
-    struct String {
-        int8_t* DynamicBuffer = nullptr;
-        
-        int32_t Size = 0;
-        int32_t Capacity = 0;
-    };
-
-    void bl__string__construct__(Context* ctx) {
-        // String* str = new String();
-        // 
-        // str->Size = 0;
-        // str->Capacity = 1;
-        // str->DynamicBuffer = new int8_t[1];
-        // 
-        // ctx->StorePointer(-1, str);
-        ARIA_ASSERT(false, "TODO");
+    static constexpr u64 HashSeed = 0x9e3779b97f4a7c15;
+    static constexpr u64 HashPrime = 0x100000001b3;
+    static constexpr u64 HashKeys[2] = { 0xbe4ba423396cfeb8, 0x1cad21f72c81017c };
+    static constexpr u64 HashKeySteps[2] = { 0xdb979083e96dd4de, 0x1f67b3b7a4a44072 };
+
+    static u64 Avalanche(u64 h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccd;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53;
+        h ^= h >> 33;
+        return h;
+    }
+
+    u64 HashString(std::string_view str) {
+        const char* data = str.data();
+        size_t size = str.size();
+        size_t i = 0;
+
+        // Two 64 bit lanes, each one adds the product of the halves of its keyed lane to the other lane of the block
+        // The keys change with every block, so swapping two blocks changes the hash
+        u64 lanes[2] = { HashSeed, HashSeed ^ size };
+
+        if (size >= StringSimdThreshold) {
+            #ifdef ARIA_STRING_SIMD
+                __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+                __m128i key = _mm_set_epi64x(static_cast<i64>(HashKeys[1]), static_cast<i64>(HashKeys[0]));
+                __m128i step = _mm_set_epi64x(static_cast<i64>(HashKeySteps[1]), static_cast<i64>(HashKeySteps[0]));
+
+                for (; i + 16 <= size; i += 16) {
+                    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                    __m128i keyed = _mm_xor_si128(block, key);
+                    __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+
+                    acc = _mm_add_epi64(acc, _mm_add_epi64(product, _mm_shuffle_epi32(block, _MM_SHUFFLE(1, 0, 3, 2))));
+                    key = _mm_add_epi64(key, step);
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+            #else
+                u64 keys[2] = { HashKeys[0], HashKeys[1] };
+
+                for (; i + 16 <= size; i += 16) {
+                    u64 block[2];
+                    memcpy(block, data + i, sizeof(block));
+
+                    for (size_t lane = 0; lane < 2; lane++) {
+                        u64 keyed = block[lane] ^ keys[lane];
+                        lanes[lane] += (keyed & 0xffffffff) * (keyed >> 32) + block[1 - lane];
+                        keys[lane] += HashKeySteps[lane];
+                    }
+                }
+            #endif
+        }
+
+        u64 h = Avalanche(lanes[0]) ^ Avalanche(lanes[1] + HashPrime);
+
+        for (; i + 8 <= size; i += 8) {
+            u64 word;
+            memcpy(&word, data + i, sizeof(word));
+            h = (h ^ Avalanche(word)) * HashPrime;
+        }
+
+        for (; i < size; i++) {
+            h = (h ^ static_cast<u8>(data[i])) * HashPrime;
+        }
+
+        return Avalanche(h);
+    }
+
+    // The index of the first byte that differs, size if there is none
+    static size_t FindMismatch(const char* lhs, const char* rhs, size_t size) {
+        size_t i = 0;
+
+        #ifdef ARIA_STRING_SIMD
+            if (size >= StringSimdThreshold) {
+                for (; i + 16 <= size; i += 16) {
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+
+                    u32 differing = static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) ^ 0xffff;
+                    if (differing) { return i + static_cast<size_t>(std::countr_zero(differing)); }
+                }
+            }
+        #endif
+
+        for (; i < size; i++) {
+            if (lhs[i] != rhs[i]) { return i; }
+        }
+
+        return size;
+    }
+
+    int CompareStrings(std::string_view lhs, std::string_view rhs) {
+        size_t size = std::min(lhs.size(), rhs.size());
+        size_t mismatch = FindMismatch(lhs.data(), rhs.data(), size);
+
+        if (mismatch < size) {
+            return static_cast<u8>(lhs[mismatch]) < static_cast<u8>(rhs[mismatch]) ? -1 : 1;
+        }
+
+        if (lhs.size() == rhs.size()) { return 0; }
+        return lhs.size() < rhs.size() ? -1 : 1;
+    }
+
+    bool StringsEqual(std::string_view lhs, std::string_view rhs) {
+        if (lhs.size() != rhs.size()) { return false; }
+        if (lhs.data() == rhs.data()) { return true; }
+
+        return FindMismatch(lhs.data(), rhs.data(), lhs.size()) == lhs.size();
+    }
+
+    StringHeap::StringHeap(ScriptHeap* heap)
+        : m_Heap(heap) {}
+
+    StringHeap::StringHeap(StringHeap&& other) noexcept
+        : m_Heap(other.m_Heap), m_Literals(std::move(other.m_Literals)), m_Stats(other.m_Stats) {
+        other.m_Literals.clear();
+        other.m_Stats = {};
+    }
+
+    StringHeap::~StringHeap() {
+        FreeAll();
     }
 
-    void bl__string__construct_from_literal__(Context* ctx) {
-        // StackSlot s = ctx->GetVM().GetStackSlot(-2);
-        // 
-        // String* str = new String();
-        // str->Capacity = s.Size;
-        // str->DynamicBuffer = new int8_t[str->Capacity];
-        // 
-        // memcpy(str->DynamicBuffer, s.Memory, s.Size);
-        // 
-        // ctx->GetVM().StorePointer(-1, str);
-        ARIA_ASSERT(false, "TODO");
+    StringHeap& StringHeap::operator=(StringHeap&& other) noexcept {
+        if (this != &other) {
+            FreeAll();
+
+            m_Heap = other.m_Heap;
+            m_Literals = std::move(other.m_Literals);
+            m_Stats = other.m_Stats;
+
+            other.m_Literals.clear();
+            other.m_Stats = {};
+        }
+
+        return *this;
     }
 
-    void bl__string__copy__(Context* ctx) {
-        // String* str = reinterpret_cast<String*>(ctx->GetVM().GetPointer(-2));
-        // 
-        // String* newStr = new String();
-        // newStr->Capacity = str->Capacity;
-        // newStr->Size = str->Size;
-        // newStr->DynamicBuffer = new int8_t[newStr->Capacity];
-        // 
-        // memcpy(newStr->DynamicBuffer, str->DynamicBuffer, str->Size);
-        // 
-        // ctx->GetVM().StorePointer(-1, newStr);
-        ARIA_ASSERT(false, "TODO");
+    String* StringHeap::Intern(std::string_view literal) {
+        if (literal.empty()) { return nullptr; }
+
+        auto it = m_Literals.find(literal);
+        if (it != m_Literals.end()) { return it->second; }
+
+        // Literals stay interned across invocations, so they never come from the arena
+        String* str = AllocateString(true);
+        str->Size = static_cast<int32_t>(literal.size());
+
+        if (literal.size() <= StringInlineBytes) {
+            str->Data = str->Inline;
+        } else {
+            // Nothing ever appends to a literal, so its buffer has no room to spare and the string doesn't point to it
+            StringBuffer* buffer = AllocateBuffer(str->Size, true);
+            buffer->Used = str->Size;
+            str->Data = buffer->GetData();
+        }
+
+        memcpy(const_cast<char*>(str->Data), literal.data(), literal.size());
+
+        m_Literals[GetStringView(str)] = str;
+        m_Stats.Literals++;
+        return str;
     }
 
-    void bl__string__assign__(Context* ctx) {
-        // String* str = reinterpret_cast<String*>(ctx->GetVM().GetPointer(-3));
-        // String* other = reinterpret_cast<String*>(ctx->GetVM().GetPointer(-2));
-        // delete[] str->DynamicBuffer;
-        // 
-        // str->Capacity = other->Capacity;
-        // str->Size = other->Size;
-        // str->DynamicBuffer = new int8_t[str->Capacity];
-        // 
-        // memcpy(str->DynamicBuffer, other->DynamicBuffer, other->Size);
-        // 
-        // ctx->GetVM().StorePointer(-1, str);
-        ARIA_ASSERT(false, "TODO");
+    String* StringHeap::Create(std::string_view str) {
+        if (str.empty()) { return nullptr; }
+
+        String* result = AllocateString();
+        result->Size = static_cast<int32_t>(str.size());
+        m_Stats.Strings++;
+
+        if (str.size() <= StringInlineBytes) {
+            result->Data = result->Inline;
+            m_Stats.InlineStrings++;
+        } else {
+            result->Buffer = AllocateBuffer(result->Size);
+            result->Buffer->Used = result->Size;
+            result->Data = result->Buffer->GetData();
+        }
+
+        memcpy(const_cast<char*>(result->Data), str.data(), str.size());
+        return result;
     }
 
-    void bl__string__destruct__(Context* ctx) {
-        // String* str = reinterpret_cast<String*>(ctx->GetVM().GetPointer(-1));
-        // delete[] str->DynamicBuffer;
-        // 
-        // str->Size = 0;
-        // str->Capacity = 0;
-        // 
-        // delete str;
-        // ctx->GetVM().StorePointer(-1, nullptr);
-        ARIA_ASSERT(false, "TODO");
+    String* StringHeap::Concat(String* lhs, String* rhs) {
+        // Strings never change, so concatenating the empty string can hand out the other side as is
+        if (!rhs) { return lhs; }
+        if (!lhs) { return rhs; }
+
+        size_t size = static_cast<size_t>(lhs->Size) + static_cast<size_t>(rhs->Size);
+        ARIA_ASSERT(size <= INT32_MAX, "String too long!");
+
+        String* result = AllocateString();
+        result->Size = static_cast<int32_t>(size);
+        m_Stats.Strings++;
+
+        if (size <= StringInlineBytes) {
+            memcpy(result->Inline, lhs->Data, static_cast<size_t>(lhs->Size));
+            memcpy(result->Inline + lhs->Size, rhs->Data, static_cast<size_t>(rhs->Size));
+            result->Data = result->Inline;
+            m_Stats.InlineStrings++;
+
+            return result;
+        }
+
+        // Every string sharing the buffer ends at or before Used, so if lhs ends right there the bytes after it belong to nobody yet
+        // This is what makes building a string piece by piece grow its buffer geometrically instead of copying it every time
+        StringBuffer* buffer = lhs->Buffer;
+        if (buffer && lhs->Data + lhs->Size == buffer->GetData() + buffer->Used && buffer->Capacity - buffer->Used >= rhs->Size) {
+            memcpy(buffer->GetData() + buffer->Used, rhs->Data, static_cast<size_t>(rhs->Size));
+            buffer->Used += rhs->Size;
+
+            result->Data = lhs->Data;
+            result->Buffer = buffer;
+            m_Stats.InPlaceConcats++;
+
+            return result;
+        }
+
+        buffer = AllocateBuffer(static_cast<int32_t>(std::min<size_t>(size * StringGrowthFactor, INT32_MAX)));
+        memcpy(buffer->GetData(), lhs->Data, static_cast<size_t>(lhs->Size));
+        memcpy(buffer->GetData() + lhs->Size, rhs->Data, static_cast<size_t>(rhs->Size));
+        buffer->Used = result->Size;
+
+        result->Data = buffer->GetData();
+        result->Buffer = buffer;
+        return result;
+    }
+
+    void StringHeap::FreeAll() {
+        // The strings themselves are left to the script heap, which releases them all at once
+        m_Literals.clear();
+    }
+
+    StringStats StringHeap::GetStats() const {
+        StringStats stats = m_Stats;
+        stats.InlineBytes = StringInlineBytes;
+        stats.GrowthFactor = StringGrowthFactor;
+
+        return stats;
+    }
+
+    String* StringHeap::AllocateString(bool persistent) {
+        void* memory = persistent ? m_Heap->AllocatePersistent(sizeof(String)) : m_Heap->Allocate(sizeof(String));
+        String* str = new (memory) String();
+
+        m_Stats.BytesAllocated += sizeof(String);
+        return str;
+    }
+
+    StringBuffer* StringHeap::AllocateBuffer(int32_t capacity, bool persistent) {
+        size_t bytes = sizeof(StringBuffer) + static_cast<size_t>(capacity);
+
+        void* memory = persistent ? m_Heap->AllocatePersistent(bytes) : m_Heap->Allocate(bytes);
+        StringBuffer* buffer = new (memory) StringBuffer();
+        buffer->Capacity = capacity;
+
+        m_Stats.Buffers++;
+        m_Stats.BytesAllocated += bytes;
+        return buffer;
     }
 
 } // namespace Aria::Internal
@@ -1,17 +1,89 @@
 #pragma once
 
 #include "aria/context.hpp"
+#include "aria/internal/types.hpp"
+#include "aria/internal/vm/heap.hpp"
+
+#include <string_view>
+#include <unordered_map>
 
 namespace Aria::Internal {
 
-    void bl__string__construct__(Context* ctx);
-    void bl__string__construct_from_literal__(Context* ctx);
+    // The characters of a short string live right behind its header, both come from a single allocation
+    inline constexpr size_t StringInlineBytes = 44;
+    // How much room a concatenation that has to copy leaves for the ones following it
+    inline constexpr int32_t StringGrowthFactor = 2;
+    // From this size on hashing and comparing work on 16 byte SIMD blocks
+    inline constexpr size_t StringSimdThreshold = 32;
+
+    // Characters shared by strings that got concatenated onto each other, the bytes below Used never change
+    struct StringBuffer {
+        int32_t Used = 0;
+        int32_t Capacity = 0;
+
+        inline char* GetData() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    // The runtime representation of string, scripts only ever hold a pointer to it and a null pointer is the empty string
+    // Strings never change once they are created, so two variables sharing one behave exactly like two copies
+    struct String {
+        const char* Data = nullptr; // Either Inline, a literal in the constant pool or somewhere inside Buffer
+        StringBuffer* Buffer = nullptr; // The buffer Data points into, nullptr for inline strings and literals
+
+        int32_t Size = 0;
+        char Inline[StringInlineBytes];
+
+        inline bool IsInline() const { return Data == Inline; }
+    };
+
+    static_assert(sizeof(String) == 64, "A string header and its inline characters should fill a single cache line");
+
+    inline std::string_view GetStringView(const String* str) {
+        return str ? std::string_view(str->Data, static_cast<size_t>(str->Size)) : std::string_view();
+    }
+
+    // Both go through SSE2 for strings of at least StringSimdThreshold bytes
+    // The scalar fallback hashes the same way, so a hash never depends on the build
+    u64 HashString(std::string_view str);
+    // Less than 0 if lhs orders before rhs, 0 if both are equal and greater than 0 otherwise, bytes compare as unsigned
+    int CompareStrings(std::string_view lhs, std::string_view rhs);
+    bool StringsEqual(std::string_view lhs, std::string_view rhs);
+
+    // Creates the strings of the string op codes in the script heap of the VM, they all live until the script heap is released
+    // Literals are interned once, every execution of their load shares the same string
+    class StringHeap {
+    public:
+        explicit StringHeap(ScriptHeap* heap);
+        StringHeap(const StringHeap&) = delete;
+        StringHeap(StringHeap&& other) noexcept;
+        ~StringHeap();
+
+        StringHeap& operator=(const StringHeap&) = delete;
+        StringHeap& operator=(StringHeap&& other) noexcept;
+
+        // Returns the string for a literal of the program, the characters are copied into the constant pool the first time
+        // The empty literal is the null string
+        String* Intern(std::string_view literal);
+        // Copies the characters into a new string, from the arena if it is active
+        String* Create(std::string_view str);
+        // Appends onto the buffer of lhs if lhs is where it ends and there is room, otherwise copies both into a new one
+        String* Concat(String* lhs, String* rhs);
+
+        // Forgets every literal, the memory of the strings goes back with the script heap
+        void FreeAll();
+
+        StringStats GetStats() const;
 
-    void bl__string__copy__(Context* ctx);
-    void bl__string__assign__(Context* ctx);
-    void bl__string__assign_literal__(Context* ctx);
+    private:
+        // persistent keeps the memory out of the arena
+        String* AllocateString(bool persistent = false);
+        StringBuffer* AllocateBuffer(int32_t capacity, bool persistent = false);
 
-    void bl__string__destruct__(Context* ctx);
+    private:
+        ScriptHeap* m_Heap = nullptr;
+        std::unordered_map<std::string_view, String*> m_Literals; // The keys point into the strings themselves
 
+        StringStats m_Stats;
+    };
 
 } // namespace Aria::Internal
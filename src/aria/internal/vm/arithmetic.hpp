@@ -0,0 +1,224 @@
+#pragma once
+
+#include "aria/internal/compiler/types/type_info.hpp"
+#include "aria/internal/vm/op_codes.hpp"
+
+#include <cmath>
+#include <concepts>
+#include <limits>
+
+namespace Aria::Internal {
+
+    // The operations the VM performs on its operands
+    // The optimizers use these as well, so a folded expression always has the value running it would produce
+
+    template <typename T>
+    T Negate(T value) { return -value; }
+
+    template <typename T>
+    T Add(T lhs, T rhs) { return lhs + rhs; }
+    template <typename T>
+    T Sub(T lhs, T rhs) { return lhs - rhs; }
+    template <typename T>
+    T Mul(T lhs, T rhs) { return lhs * rhs; }
+    template <typename T>
+    T Div(T lhs, T rhs) { return lhs / rhs; }
+    template <std::integral T>
+    T Mod(T lhs, T rhs) { return lhs % rhs; }
+    template <std::floating_point T>
+    T Mod(T lhs, T rhs) {
+        T r = std::fmod(lhs, rhs);
+        if (r < 0) { r += std::abs(rhs); }
+        return r;
+    }
+
+    template <typename T>
+    T And(T lhs, T rhs) { return lhs & rhs; }
+    template <typename T>
+    T Or(T lhs, T rhs) { return lhs | rhs; }
+    template <typename T>
+    T Xor(T lhs, T rhs) { return lhs ^ rhs; }
+
+    template <typename T>
+    T Cmp(T lhs, T rhs) { return lhs == rhs; }
+    template <typename T>
+    T Ncmp(T lhs, T rhs) { return lhs != rhs; }
+    template <typename T>
+    T Lt(T lhs, T rhs) { return lhs < rhs; }
+    template <typename T>
+    T Lte(T lhs, T rhs) { return lhs <= rhs; }
+    template <typename T>
+    T Gt(T lhs, T rhs) { return lhs > rhs; }
+    template <typename T>
+    T Gte(T lhs, T rhs) { return lhs >= rhs; }
+
+    // Calls fn with a value of the type the VM operates on for the given type, the same mapping the emitter uses to pick its op codes
+    template <typename F>
+    inline bool VisitVMType(const TypeInfo* type, F&& fn) {
+        if (type == nullptr) { return false; }
+
+        if (type->IsIntegral()) {
+            bool isSigned = type->IsSigned();
+
+            switch (type->GetSize()) {
+                case 1: if (isSigned) { fn(i8{}); } else { fn(u8{}); } return true;
+                case 2: if (isSigned) { fn(i16{}); } else { fn(u16{}); } return true;
+                case 4: if (isSigned) { fn(i32{}); } else { fn(u32{}); } return true;
+                case 8: if (isSigned) { fn(i64{}); } else { fn(u64{}); } return true;
+                default: return false;
+            }
+        }
+
+        if (type->Type == PrimitiveType::Bool) { fn(i8{}); return true; } // Booleans are loaded and stored as i8
+        if (type->Type == PrimitiveType::Float) { fn(f32{}); return true; }
+        if (type->Type == PrimitiveType::Double) { fn(f64{}); return true; }
+
+        return false;
+    }
+
+    // The typed op codes are laid out in the order of this index
+    static_assert(static_cast<size_t>(OpCodeType::AddF64) - static_cast<size_t>(OpCodeType::AddI8) == 9);
+    static_assert(static_cast<size_t>(OpCodeType::CastF64ToF64) - static_cast<size_t>(OpCodeType::CastI8ToI8) == 99);
+    static_assert(static_cast<size_t>(OpCodeType::LoadF64) - static_cast<size_t>(OpCodeType::LoadI8) == 9);
+    static_assert(static_cast<size_t>(OpCodeType::StoreImmF64) - static_cast<size_t>(OpCodeType::AddImmI8) == 119);
+    static_assert(static_cast<size_t>(OpCodeType::JgteImmF64) - static_cast<size_t>(OpCodeType::JcmpI8) == 119);
+    static_assert(static_cast<size_t>(OpCodeType::ArrayAppendF64) - static_cast<size_t>(OpCodeType::ArrayLoadI8) == 29);
+
+    inline size_t GetVMTypeIndex(const TypeInfo* type) {
+        size_t index = 0;
+
+        bool visited = VisitVMType(type, [&](auto tag) {
+            using T = decltype(tag);
+
+            if constexpr (std::is_same_v<T, i8>) { index = 0; }
+            else if constexpr (std::is_same_v<T, i16>) { index = 1; }
+            else if constexpr (std::is_same_v<T, i32>) { index = 2; }
+            else if constexpr (std::is_same_v<T, i64>) { index = 3; }
+            else if constexpr (std::is_same_v<T, u8>) { index = 4; }
+            else if constexpr (std::is_same_v<T, u16>) { index = 5; }
+            else if constexpr (std::is_same_v<T, u32>) { index = 6; }
+            else if constexpr (std::is_same_v<T, u64>) { index = 7; }
+            else if constexpr (std::is_same_v<T, f32>) { index = 8; }
+            else if constexpr (std::is_same_v<T, f64>) { index = 9; }
+        });
+
+        ARIA_ASSERT(visited, "todo: Typed op codes for non primitive types");
+        return index;
+    }
+
+    // Picks the variant of a typed op code for the given type, base is always the I8 variant (AddI8, LoadI8, ...)
+    inline OpCodeType GetTypedOpCode(OpCodeType base, const TypeInfo* type) {
+        return static_cast<OpCodeType>(static_cast<size_t>(base) + GetVMTypeIndex(type));
+    }
+
+    // The immediate form of a typed op code, both are the I8 variants (AddI8 -> AddImmI8)
+    // Returns false for the operations that don't have one
+    inline bool GetImmediateOpCode(OpCodeType base, OpCodeType& out) {
+        switch (base) {
+            case OpCodeType::AddI8:  out = OpCodeType::AddImmI8;  return true;
+            case OpCodeType::SubI8:  out = OpCodeType::SubImmI8;  return true;
+            case OpCodeType::MulI8:  out = OpCodeType::MulImmI8;  return true;
+            case OpCodeType::DivI8:  out = OpCodeType::DivImmI8;  return true;
+            case OpCodeType::ModI8:  out = OpCodeType::ModImmI8;  return true;
+            case OpCodeType::CmpI8:  out = OpCodeType::CmpImmI8;  return true;
+            case OpCodeType::NcmpI8: out = OpCodeType::NcmpImmI8; return true;
+            case OpCodeType::LtI8:   out = OpCodeType::LtImmI8;   return true;
+            case OpCodeType::LteI8:  out = OpCodeType::LteImmI8;  return true;
+            case OpCodeType::GtI8:   out = OpCodeType::GtImmI8;   return true;
+            case OpCodeType::GteI8:  out = OpCodeType::GteImmI8;  return true;
+            default: return false;
+        }
+    }
+
+    // The operation giving the same result with its operands swapped (I8 variants), which lets a constant on the left become an immediate
+    // Returns false for the operations where the order matters
+    inline bool GetSwappedOpCode(OpCodeType base, OpCodeType& out) {
+        switch (base) {
+            case OpCodeType::AddI8:
+            case OpCodeType::MulI8:
+            case OpCodeType::CmpI8:
+            case OpCodeType::NcmpI8: out = base; return true;
+            case OpCodeType::LtI8:   out = OpCodeType::GtI8;  return true;
+            case OpCodeType::LteI8:  out = OpCodeType::GteI8; return true;
+            case OpCodeType::GtI8:   out = OpCodeType::LtI8;  return true;
+            case OpCodeType::GteI8:  out = OpCodeType::LteI8; return true;
+            default: return false;
+        }
+    }
+
+    // The fused compare and branch form of a comparison, both are the I8 variants (LtI8 -> JltI8, LtImmI8 -> JltImmI8)
+    // Returns false for everything that isn't a comparison
+    inline bool GetCompareJumpOpCode(OpCodeType base, OpCodeType& out) {
+        switch (base) {
+            case OpCodeType::CmpI8:     out = OpCodeType::JcmpI8;     return true;
+            case OpCodeType::NcmpI8:    out = OpCodeType::JncmpI8;    return true;
+            case OpCodeType::LtI8:      out = OpCodeType::JltI8;      return true;
+            case OpCodeType::LteI8:     out = OpCodeType::JlteI8;     return true;
+            case OpCodeType::GtI8:      out = OpCodeType::JgtI8;      return true;
+            case OpCodeType::GteI8:     out = OpCodeType::JgteI8;     return true;
+            case OpCodeType::CmpImmI8:  out = OpCodeType::JcmpImmI8;  return true;
+            case OpCodeType::NcmpImmI8: out = OpCodeType::JncmpImmI8; return true;
+            case OpCodeType::LtImmI8:   out = OpCodeType::JltImmI8;   return true;
+            case OpCodeType::LteImmI8:  out = OpCodeType::JlteImmI8;  return true;
+            case OpCodeType::GtImmI8:   out = OpCodeType::JgtImmI8;   return true;
+            case OpCodeType::GteImmI8:  out = OpCodeType::JgteImmI8;  return true;
+            default: return false;
+        }
+    }
+
+    // The comparison that holds exactly when base (an I8 variant) doesn't, which lets a jf become a fused jump
+    // Returns false for the ordered comparisons of floating point types, with a NaN operand neither a < b nor a >= b holds
+    inline bool GetNegatedCompareOpCode(OpCodeType base, const TypeInfo* type, OpCodeType& out) {
+        bool ordered = base != OpCodeType::CmpI8 && base != OpCodeType::NcmpI8;
+        if (ordered && type->IsFloatingPoint()) { return false; }
+
+        switch (base) {
+            case OpCodeType::CmpI8:  out = OpCodeType::NcmpI8; return true;
+            case OpCodeType::NcmpI8: out = OpCodeType::CmpI8;  return true;
+            case OpCodeType::LtI8:   out = OpCodeType::GteI8;  return true;
+            case OpCodeType::LteI8:  out = OpCodeType::GtI8;   return true;
+            case OpCodeType::GtI8:   out = OpCodeType::LteI8;  return true;
+            case OpCodeType::GteI8:  out = OpCodeType::LtI8;   return true;
+            default: return false;
+        }
+    }
+
+    // True if the constant has exactly the type the VM operates on for type, the immediate op codes rely on that
+    inline bool IsImmediateOfType(const ImmediateValue& value, const TypeInfo* type) {
+        bool matches = false;
+
+        VisitVMType(type, [&](auto tag) {
+            matches = std::holds_alternative<decltype(tag)>(value);
+        });
+
+        return matches;
+    }
+
+    // Integer division by zero (and the one overflowing signed division) traps or is undefined, so it is left for the runtime
+    template <typename T>
+    inline bool IsDivisionDefined(T lhs, T rhs) {
+        if constexpr (std::is_integral_v<T>) {
+            if (rhs == 0) { return false; }
+
+            if constexpr (std::is_signed_v<T>) {
+                if (lhs == std::numeric_limits<T>::min() && rhs == static_cast<T>(-1)) { return false; }
+            }
+        }
+
+        return true;
+    }
+
+    // Converting a floating point value that doesn't fit into an integer is undefined
+    template <typename Dst, typename Src>
+    inline bool IsConversionDefined(Src value) {
+        if constexpr (std::is_floating_point_v<Src> && std::is_integral_v<Dst>) {
+            long double truncated = std::trunc(static_cast<long double>(value));
+            long double limit = std::ldexp(1.0L, std::numeric_limits<Dst>::digits);
+
+            return std::isfinite(truncated) && truncated < limit && truncated >= (std::is_signed_v<Dst> ? -limit : 0.0L);
+        }
+
+        return true;
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,687 @@
+#include "aria/internal/vm/bytecode_image.hpp"
+#include "aria/internal/compiler/types/type_info.hpp"
+
+#include <cstring>
+
+namespace Aria::Internal {
+
+    enum class ImageDataKind : u32 {
+        MemRef,
+        String,
+        Alloca,
+        Copy,
+        Load,
+        SetGlobal,
+        ConditionalJump,
+        Call,
+        Math,
+        Cast,
+        Immediate,
+        Array,
+
+        Count
+    };
+
+    static_assert(std::variant_size_v<decltype(OpCode::Data)> == static_cast<size_t>(ImageDataKind::Count), "Update the bytecode image format (and its version) when changing OpCode::Data!");
+    static_assert(std::variant_size_v<decltype(OpCodeLoad::Data)> == 11, "Update the bytecode image format (and its version) when changing OpCodeLoad::Data!");
+    static_assert(std::variant_size_v<ImmediateValue> == 10, "Update the bytecode image format (and its version) when changing ImmediateValue!");
+
+    static constexpr u32 LoadStringIndex = 10; // The index of StringView in OpCodeLoad::Data
+    static constexpr u32 ImageTypeExternal = 1 << 0;
+
+    inline static size_t AlignImageOffset(size_t offset) {
+        return (offset + 7) & ~static_cast<size_t>(7);
+    }
+
+    // Numeric constants are stored as their raw bits, the alternative index says which type they are
+    // OpCodeLoad::Data and ImmediateValue share the order of their numeric alternatives
+    template <typename V>
+    inline static u64 EncodeConstant(const V& value) {
+        u64 bits = 0;
+        std::visit([&bits](auto v) {
+            if constexpr (!std::is_same_v<decltype(v), StringView>) {
+                memcpy(&bits, &v, sizeof(v));
+            }
+        }, value);
+
+        return bits;
+    }
+
+    inline static bool IsOpCodeInRange(OpCodeType type, OpCodeType first, OpCodeType last) {
+        return type >= first && type <= last;
+    }
+
+    // The payload the VM reads for every op code, a reader must never hand it anything else
+    inline static ImageDataKind GetImageDataKind(OpCodeType type) {
+        switch (type) {
+            case OpCodeType::Alloca: return ImageDataKind::Alloca;
+            case OpCodeType::Copy: return ImageDataKind::Copy;
+            case OpCodeType::SetGlobal: return ImageDataKind::SetGlobal;
+
+            case OpCodeType::Function:
+            case OpCodeType::Label: return ImageDataKind::String;
+
+            case OpCodeType::Jmp:
+            case OpCodeType::Jt:
+            case OpCodeType::Jf: return ImageDataKind::ConditionalJump;
+
+            case OpCodeType::Call:
+            case OpCodeType::CallExtern:
+            case OpCodeType::TailCall: return ImageDataKind::Call;
+
+            default: break;
+        }
+
+        if (IsOpCodeInRange(type, OpCodeType::LoadI8, OpCodeType::LoadStr)) { return ImageDataKind::Load; }
+        if (IsOpCodeInRange(type, OpCodeType::AddI8, OpCodeType::GteF64)) { return ImageDataKind::Math; }
+        if (IsOpCodeInRange(type, OpCodeType::CastI8ToI8, OpCodeType::CastF64ToF64)) { return ImageDataKind::Cast; }
+        if (IsOpCodeInRange(type, OpCodeType::AddImmI8, OpCodeType::StoreImmF64)) { return ImageDataKind::Immediate; }
+        if (IsOpCodeInRange(type, OpCodeType::JcmpI8, OpCodeType::JgteImmF64)) { return ImageDataKind::ConditionalJump; }
+        if (IsOpCodeInRange(type, OpCodeType::ArrayNew, OpCodeType::ArrayClear)) { return ImageDataKind::Array; }
+        if (IsOpCodeInRange(type, OpCodeType::StrConcat, OpCodeType::StrHash)) { return ImageDataKind::Math; }
+
+        // Dup, Pop, the negations and everything without a payload (which defaults to a MemRef)
+        return ImageDataKind::MemRef;
+    }
+
+    // The alternative of OpCodeLoad::Data (or ImmediateValue) the VM reads for an op code, ImageInvalidIndex if it reads none
+    // Typed op codes go I8, I16, I32, I64, U8, ... while the constants go i8, u8, i16, u16, ...
+    inline static u32 GetImageConstantKind(OpCodeType type) {
+        static constexpr u32 s_Kinds[] = { 0, 2, 4, 6, 1, 3, 5, 7, 8, 9 };
+
+        if (type == OpCodeType::LoadStr) { return LoadStringIndex; }
+        if (IsOpCodeInRange(type, OpCodeType::LoadI8, OpCodeType::LoadF64)) { return s_Kinds[static_cast<u32>(type) - static_cast<u32>(OpCodeType::LoadI8)]; }
+        if (IsOpCodeInRange(type, OpCodeType::AddImmI8, OpCodeType::StoreImmF64)) { return s_Kinds[(static_cast<u32>(type) - static_cast<u32>(OpCodeType::AddImmI8)) % 10]; }
+        if (IsOpCodeInRange(type, OpCodeType::JcmpImmI8, OpCodeType::JgteImmF64)) { return s_Kinds[(static_cast<u32>(type) - static_cast<u32>(OpCodeType::JcmpImmI8)) % 10]; }
+
+        return ImageInvalidIndex;
+    }
+
+    template <typename V>
+    inline static bool DecodeConstant(u32 index, u64 bits, V& out) {
+        switch (index) {
+            case 0: { i8 v;  memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 1: { u8 v;  memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 2: { i16 v; memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 3: { u16 v; memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 4: { i32 v; memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 5: { u32 v; memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 6: { i64 v; memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 7: { u64 v; memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 8: { f32 v; memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            case 9: { f64 v; memcpy(&v, &bits, sizeof(v)); out = v; return true; }
+            default: return false;
+        }
+    }
+
+    BytecodeImageWriter::BytecodeImageWriter(const std::vector<OpCode>* opcodes) {
+        m_OpCodes = opcodes;
+
+        WriteImpl();
+    }
+
+    void BytecodeImageWriter::WriteImpl() {
+        m_Code.reserve(m_OpCodes->size());
+
+        for (const OpCode& op : *m_OpCodes) {
+            ImageInstruction inst;
+            inst.Type = static_cast<u32>(op.Type);
+            inst.DataKind = static_cast<u32>(op.Data.index());
+            ARIA_ASSERT(inst.DataKind == static_cast<u32>(GetImageDataKind(op.Type)), "Op code carries a payload its reader would reject!");
+
+            if (!op.DebugData.empty()) {
+                inst.DebugString = AddString(op.DebugData);
+            }
+
+            switch (static_cast<ImageDataKind>(inst.DataKind)) {
+                case ImageDataKind::MemRef: {
+                    inst.Mem[0] = ConvertMemRef(std::get<MemRef>(op.Data));
+                    break;
+                }
+
+                case ImageDataKind::String: {
+                    const std::string& str = std::get<std::string>(op.Data);
+                    inst.Operand0 = AddString(str);
+
+                    if (op.Type == OpCodeType::Function) {
+                        m_Functions.push_back({ inst.Operand0, static_cast<u32>(m_Code.size()) });
+                    }
+
+                    break;
+                }
+
+                case ImageDataKind::Alloca: {
+                    const OpCodeAlloca& alloca = std::get<OpCodeAlloca>(op.Data);
+                    inst.Operand0 = static_cast<u32>(alloca.Size);
+                    inst.TypeIndex = AddType(alloca.ResolvedType);
+                    break;
+                }
+
+                case ImageDataKind::Copy: {
+                    const OpCodeCopy& copy = std::get<OpCodeCopy>(op.Data);
+                    inst.Mem[0] = ConvertMemRef(copy.DstMem);
+                    inst.Mem[1] = ConvertMemRef(copy.SrcMem);
+                    break;
+                }
+
+                case ImageDataKind::Load: {
+                    const OpCodeLoad& load = std::get<OpCodeLoad>(op.Data);
+                    inst.Operand1 = static_cast<u32>(load.Data.index());
+                    inst.TypeIndex = AddType(load.ResolvedType);
+
+                    if (inst.Operand1 == LoadStringIndex) {
+                        StringView str = std::get<StringView>(load.Data);
+                        inst.Operand0 = AddString(std::string(str.Data(), str.Size()));
+                    } else {
+                        inst.Operand0 = static_cast<u32>(m_Constants.size());
+                        m_Constants.push_back(EncodeConstant(load.Data));
+                    }
+
+                    break;
+                }
+
+                case ImageDataKind::SetGlobal: {
+                    const OpCodeSetGlobal& g = std::get<OpCodeSetGlobal>(op.Data);
+                    inst.Operand0 = AddString(g.Name);
+                    inst.Mem[0] = ConvertMemRef(g.Mem);
+                    break;
+                }
+
+                case ImageDataKind::ConditionalJump: {
+                    const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
+                    inst.Operand0 = AddString(jump.Label);
+                    inst.Operand1 = (jump.Target == SIZE_MAX) ? ImageInvalidIndex : static_cast<u32>(jump.Target);
+                    inst.Mem[0] = ConvertMemRef(jump.Mem);
+                    inst.Mem[1] = ConvertMemRef(jump.RHSMem);
+
+                    if (op.Type >= OpCodeType::JcmpImmI8 && op.Type <= OpCodeType::JgteImmF64) {
+                        inst.Constant = static_cast<u32>(m_Constants.size());
+                        inst.ConstantKind = static_cast<u32>(jump.Value.index());
+                        m_Constants.push_back(EncodeConstant(jump.Value));
+                    }
+
+                    break;
+                }
+
+                case ImageDataKind::Call: {
+                    const OpCodeCall& call = std::get<OpCodeCall>(op.Data);
+                    inst.Operand0 = static_cast<u32>(call.ArgCount);
+                    inst.Operand1 = static_cast<u32>(call.RetCount);
+                    inst.Mem[0] = ConvertMemRef(call.Function);
+                    break;
+                }
+
+                case ImageDataKind::Math: {
+                    const OpCodeMath& math = std::get<OpCodeMath>(op.Data);
+                    inst.Mem[0] = ConvertMemRef(math.LHSMem);
+                    inst.Mem[1] = ConvertMemRef(math.RHSMem);
+                    inst.TypeIndex = AddType(math.ResolvedType);
+                    break;
+                }
+
+                case ImageDataKind::Cast: {
+                    const OpCodeCast& cast = std::get<OpCodeCast>(op.Data);
+                    inst.Mem[0] = ConvertMemRef(cast.Mem);
+                    inst.TypeIndex = AddType(cast.ResolvedType);
+                    break;
+                }
+
+                case ImageDataKind::Immediate: {
+                    const OpCodeImmediate& imm = std::get<OpCodeImmediate>(op.Data);
+                    inst.Mem[0] = ConvertMemRef(imm.Mem);
+                    inst.Operand0 = static_cast<u32>(m_Constants.size());
+                    inst.Operand1 = static_cast<u32>(imm.Value.index());
+                    inst.TypeIndex = AddType(imm.ResolvedType);
+
+                    m_Constants.push_back(EncodeConstant(imm.Value));
+                    break;
+                }
+
+                case ImageDataKind::Array: {
+                    const OpCodeArray& arr = std::get<OpCodeArray>(op.Data);
+                    inst.Mem[0] = ConvertMemRef(arr.Mem);
+                    inst.Mem[1] = ConvertMemRef(arr.IndexMem);
+                    inst.Mem[2] = ConvertMemRef(arr.ValueMem);
+                    inst.Operand0 = static_cast<u32>(arr.ElementSize);
+                    inst.TypeIndex = AddType(arr.ResolvedType);
+                    break;
+                }
+
+                default: ARIA_UNREACHABLE();
+            }
+
+            m_Code.push_back(inst);
+        }
+
+        ImageHeader header;
+        memcpy(header.Magic, BytecodeImageMagic, sizeof(header.Magic));
+        header.Version = BytecodeImageVersion;
+
+        m_Image.resize(AlignImageOffset(sizeof(ImageHeader)));
+
+        header.Code = AppendSection(m_Code);
+        header.Functions = AppendSection(m_Functions);
+        header.Constants = AppendSection(m_Constants);
+        header.Strings = AppendSection(m_Strings);
+        header.StringData = AppendSection(m_StringData);
+        header.Types = AppendSection(m_Types);
+        header.TypeLists = AppendSection(m_TypeLists);
+        header.FileSize = m_Image.size();
+
+        memcpy(m_Image.data(), &header, sizeof(header));
+    }
+
+    u32 BytecodeImageWriter::AddString(const std::string& str) {
+        auto it = m_StringIndices.find(str);
+        if (it != m_StringIndices.end()) { return it->second; }
+
+        u32 index = static_cast<u32>(m_Strings.size());
+        m_Strings.push_back({ static_cast<u32>(m_StringData.size()), static_cast<u32>(str.size()) });
+        m_StringData.insert(m_StringData.end(), str.begin(), str.end());
+
+        m_StringIndices[str] = index;
+        return index;
+    }
+
+    u32 BytecodeImageWriter::AddType(TypeInfo* type) {
+        if (!type) { return ImageInvalidIndex; }
+
+        auto it = m_TypeIndices.find(type);
+        if (it != m_TypeIndices.end()) { return it->second; }
+
+        // Children are added first so the reader can always resolve them in a single pass
+        ImageType t;
+        t.Type = static_cast<u32>(type->Type);
+
+        switch (type->Type) {
+            case PrimitiveType::StringLiteral: {
+                t.Payload = std::get<size_t>(type->Data);
+                break;
+            }
+
+            case PrimitiveType::Array: {
+                t.Payload = AddType(std::get<ArrayDeclaration>(type->Data).Type);
+                break;
+            }
+
+            case PrimitiveType::Function: {
+                const FunctionDeclaration& fn = std::get<FunctionDeclaration>(type->Data);
+                t.Payload = AddType(fn.ReturnType);
+                t.Flags = fn.External ? ImageTypeExternal : 0;
+
+                std::vector<u32> params;
+                for (TypeInfo* param : fn.ParamTypes) {
+                    params.push_back(AddType(param));
+                }
+
+                t.ListStart = static_cast<u32>(m_TypeLists.size());
+                t.ListCount = static_cast<u32>(params.size());
+                m_TypeLists.insert(m_TypeLists.end(), params.begin(), params.end());
+                break;
+            }
+
+            case PrimitiveType::Structure: ARIA_ASSERT(false, "todo: BytecodeImageWriter::AddType() structures"); break;
+
+            default: break;
+        }
+
+        u32 index = static_cast<u32>(m_Types.size());
+        m_Types.push_back(t);
+        m_TypeIndices[type] = index;
+        return index;
+    }
+
+    ImageMemRef BytecodeImageWriter::ConvertMemRef(const MemRef& mem) {
+        ImageMemRef ref;
+
+        if (mem.ContainsStackSlot()) {
+            const StackSlotRef& s = mem.GetStackSlot();
+            ref.Kind = ImageMemRefKind::StackSlot;
+            ref.Slot = s.Slot;
+            ref.Size = static_cast<u32>(s.Size);
+            ref.Offset = static_cast<u32>(s.Offset);
+        } else if (mem.ContainsGlobalVar()) {
+            ref.Kind = ImageMemRefKind::GlobalVar;
+            ref.Slot = static_cast<i32>(AddString(mem.GetGlobalVar().Name));
+        } else if (mem.ContainsFunction()) {
+            ref.Kind = ImageMemRefKind::Function;
+            ref.Slot = static_cast<i32>(AddString(mem.GetFunction().Signature));
+        }
+
+        return ref;
+    }
+
+    template <typename T>
+    ImageSection BytecodeImageWriter::AppendSection(const std::vector<T>& items) {
+        ImageSection section;
+        section.Offset = m_Image.size();
+        section.Count = items.size();
+
+        size_t bytes = sizeof(T) * items.size();
+        m_Image.resize(AlignImageOffset(section.Offset + bytes));
+
+        if (bytes > 0) {
+            memcpy(m_Image.data() + section.Offset, items.data(), bytes);
+        }
+
+        return section;
+    }
+
+    BytecodeImageReader::BytecodeImageReader(CompilationContext* ctx, const u8* data, size_t size) {
+        m_Context = ctx;
+        m_Data = data;
+        m_Size = size;
+
+        ReadImpl();
+    }
+
+    void BytecodeImageReader::ReadImpl() {
+        if (m_Size < sizeof(ImageHeader)) { Fail("File is too small to be a bytecode image"); return; }
+
+        m_Header = reinterpret_cast<const ImageHeader*>(m_Data);
+
+        if (memcmp(m_Header->Magic, BytecodeImageMagic, sizeof(BytecodeImageMagic)) != 0) { Fail("File is not a bytecode image"); return; }
+        if (m_Header->Version != BytecodeImageVersion) {
+            Fail(fmt::format("Bytecode image version {} is not supported (expected version {})", m_Header->Version, BytecodeImageVersion));
+            return;
+        }
+        if (m_Header->FileSize != m_Size) { Fail("Bytecode image is truncated"); return; }
+
+        if (!ValidateSection(m_Header->Code, m_Code) ||
+            !ValidateSection(m_Header->Functions, m_Functions) ||
+            !ValidateSection(m_Header->Constants, m_Constants) ||
+            !ValidateSection(m_Header->Strings, m_Strings) ||
+            !ValidateSection(m_Header->StringData, m_StringData) ||
+            !ValidateSection(m_Header->Types, m_Types) ||
+            !ValidateSection(m_Header->TypeLists, m_TypeLists)) {
+            return;
+        }
+
+        for (size_t i = 0; i < m_Header->Strings.Count; i++) {
+            if (static_cast<u64>(m_Strings[i].Offset) + m_Strings[i].Size > m_Header->StringData.Count) { Fail("Corrupt string table"); return; }
+        }
+
+        for (size_t i = 0; i < m_Header->Functions.Count; i++) {
+            if (m_Functions[i].CodeIndex >= m_Header->Code.Count || m_Code[m_Functions[i].CodeIndex].Type != static_cast<u32>(OpCodeType::Function)) {
+                Fail("Corrupt function table");
+                return;
+            }
+        }
+
+        // Types only reference types with a lower index, so they can be decoded in order
+        // ReadType() only knows about the types decoded so far which rejects any forward (or cyclic) reference
+        m_DecodedTypes.reserve(m_Header->Types.Count);
+
+        for (size_t i = 0; i < m_Header->Types.Count; i++) {
+            const ImageType& t = m_Types[i];
+            if (t.Type > static_cast<u32>(PrimitiveType::Structure)) { Fail("Corrupt type table"); return; }
+
+            PrimitiveType type = static_cast<PrimitiveType>(t.Type);
+            TypeInfo* info = nullptr;
+
+            switch (type) {
+                case PrimitiveType::StringLiteral: {
+                    info = TypeInfo::Create(m_Context, type, static_cast<size_t>(t.Payload));
+                    break;
+                }
+
+                case PrimitiveType::Array: {
+                    ArrayDeclaration decl;
+                    if (!ReadType(static_cast<u32>(t.Payload), decl.Type)) { Fail("Corrupt type table"); return; }
+
+                    info = TypeInfo::Create(m_Context, type, decl);
+                    break;
+                }
+
+                case PrimitiveType::Function: {
+                    FunctionDeclaration decl;
+                    decl.External = (t.Flags & ImageTypeExternal) != 0;
+                    if (!ReadType(static_cast<u32>(t.Payload), decl.ReturnType)) { Fail("Corrupt type table"); return; }
+                    if (static_cast<u64>(t.ListStart) + t.ListCount > m_Header->TypeLists.Count) { Fail("Corrupt type table"); return; }
+
+                    decl.ParamTypes.Reserve(m_Context, t.ListCount);
+                    for (u32 p = 0; p < t.ListCount; p++) {
+                        TypeInfo* param = nullptr;
+                        if (!ReadType(m_TypeLists[t.ListStart + p], param)) { Fail("Corrupt type table"); return; }
+
+                        decl.ParamTypes.Append(m_Context, param);
+                    }
+
+                    info = TypeInfo::Create(m_Context, type, decl);
+                    break;
+                }
+
+                case PrimitiveType::Structure: Fail("Structures are not supported in bytecode images yet"); return;
+
+                default: {
+                    info = TypeInfo::Create(m_Context, type);
+                    break;
+                }
+            }
+
+            m_DecodedTypes.push_back(info);
+        }
+
+        std::vector<OpCode>& opcodes = m_Context->GetOpCodes();
+        opcodes.clear();
+        opcodes.reserve(m_Header->Code.Count);
+
+        for (size_t i = 0; i < m_Header->Code.Count; i++) {
+            const ImageInstruction& inst = m_Code[i];
+
+            if (inst.Type > static_cast<u32>(OpCodeType::StrHash)) { Fail(fmt::format("Unknown op code at instruction {}", i)); return; }
+
+            OpCode op;
+            op.Type = static_cast<OpCodeType>(inst.Type);
+
+            if (inst.DebugString != ImageInvalidIndex) {
+                StringView debug;
+                if (!ReadString(inst.DebugString, debug)) { return; }
+
+                op.DebugData = std::string(debug.Data(), debug.Size());
+            }
+
+            if (inst.DataKind != static_cast<u32>(GetImageDataKind(op.Type))) { Fail(fmt::format("Corrupt instruction {}", i)); return; }
+
+            u32 constantKind = GetImageConstantKind(op.Type);
+            bool valid = true;
+
+            switch (static_cast<ImageDataKind>(inst.DataKind)) {
+                case ImageDataKind::MemRef: {
+                    MemRef mem;
+                    valid = ReadMemRef(inst.Mem[0], mem);
+                    op.Data = mem;
+                    break;
+                }
+
+                case ImageDataKind::String: {
+                    StringView str;
+                    valid = ReadString(inst.Operand0, str);
+                    op.Data = std::string(str.Data(), str.Size());
+                    break;
+                }
+
+                case ImageDataKind::Alloca: {
+                    OpCodeAlloca alloca;
+                    alloca.Size = inst.Operand0;
+                    valid = ReadType(inst.TypeIndex, alloca.ResolvedType);
+                    op.Data = alloca;
+                    break;
+                }
+
+                case ImageDataKind::Copy: {
+                    OpCodeCopy copy;
+                    valid = ReadMemRef(inst.Mem[0], copy.DstMem) && ReadMemRef(inst.Mem[1], copy.SrcMem);
+                    op.Data = copy;
+                    break;
+                }
+
+                case ImageDataKind::Load: {
+                    OpCodeLoad load;
+                    valid = ReadType(inst.TypeIndex, load.ResolvedType);
+
+                    if (inst.Operand1 != constantKind) {
+                        valid = Fail(fmt::format("Corrupt constant at instruction {}", i));
+                    } else if (inst.Operand1 == LoadStringIndex) {
+                        StringView str;
+                        valid = valid && ReadString(inst.Operand0, str);
+                        load.Data = str;
+                    } else if (inst.Operand0 >= m_Header->Constants.Count || !DecodeConstant(inst.Operand1, m_Constants[inst.Operand0], load.Data)) {
+                        valid = Fail(fmt::format("Corrupt constant at instruction {}", i));
+                    }
+
+                    op.Data = load;
+                    break;
+                }
+
+                case ImageDataKind::SetGlobal: {
+                    OpCodeSetGlobal g;
+                    StringView name;
+                    valid = ReadString(inst.Operand0, name) && ReadMemRef(inst.Mem[0], g.Mem);
+                    g.Name = std::string(name.Data(), name.Size());
+                    op.Data = g;
+                    break;
+                }
+
+                case ImageDataKind::ConditionalJump: {
+                    OpCodeConditionalJump jump;
+                    StringView label;
+                    valid = ReadString(inst.Operand0, label) && ReadMemRef(inst.Mem[0], jump.Mem) && ReadMemRef(inst.Mem[1], jump.RHSMem);
+                    jump.Label = std::string(label.Data(), label.Size());
+
+                    if (inst.Constant != ImageInvalidIndex || constantKind != ImageInvalidIndex) {
+                        if (inst.ConstantKind != constantKind || inst.Constant >= m_Header->Constants.Count || !DecodeConstant(inst.ConstantKind, m_Constants[inst.Constant], jump.Value)) {
+                            valid = Fail(fmt::format("Corrupt constant at instruction {}", i));
+                        }
+                    }
+
+                    if (inst.Operand1 != ImageInvalidIndex) {
+                        if (inst.Operand1 >= m_Header->Code.Count) { valid = Fail(fmt::format("Jump target out of bounds in instruction {}", i)); }
+                        jump.Target = inst.Operand1;
+                    }
+
+                    op.Data = jump;
+                    break;
+                }
+
+                case ImageDataKind::Call: {
+                    OpCodeCall call;
+                    call.ArgCount = inst.Operand0;
+                    call.RetCount = inst.Operand1;
+                    valid = ReadMemRef(inst.Mem[0], call.Function);
+                    op.Data = call;
+                    break;
+                }
+
+                case ImageDataKind::Math: {
+                    OpCodeMath math;
+                    valid = ReadMemRef(inst.Mem[0], math.LHSMem) && ReadMemRef(inst.Mem[1], math.RHSMem) && ReadType(inst.TypeIndex, math.ResolvedType);
+                    op.Data = math;
+                    break;
+                }
+
+                case ImageDataKind::Cast: {
+                    OpCodeCast cast;
+                    valid = ReadMemRef(inst.Mem[0], cast.Mem) && ReadType(inst.TypeIndex, cast.ResolvedType);
+                    op.Data = cast;
+                    break;
+                }
+
+                case ImageDataKind::Immediate: {
+                    OpCodeImmediate imm;
+                    valid = ReadMemRef(inst.Mem[0], imm.Mem) && ReadType(inst.TypeIndex, imm.ResolvedType);
+
+                    if (inst.Operand1 != constantKind || inst.Operand0 >= m_Header->Constants.Count || !DecodeConstant(inst.Operand1, m_Constants[inst.Operand0], imm.Value)) {
+                        valid = Fail(fmt::format("Corrupt constant at instruction {}", i));
+                    }
+
+                    op.Data = imm;
+                    break;
+                }
+
+                case ImageDataKind::Array: {
+                    OpCodeArray arr;
+                    arr.ElementSize = inst.Operand0;
+                    valid = ReadMemRef(inst.Mem[0], arr.Mem) && ReadMemRef(inst.Mem[1], arr.IndexMem) && ReadMemRef(inst.Mem[2], arr.ValueMem) && ReadType(inst.TypeIndex, arr.ResolvedType);
+                    op.Data = arr;
+                    break;
+                }
+
+                default: {
+                    valid = Fail(fmt::format("Corrupt instruction {}", i));
+                    break;
+                }
+            }
+
+            if (!valid) {
+                opcodes.clear();
+                return;
+            }
+
+            opcodes.push_back(std::move(op));
+        }
+    }
+
+    template <typename T>
+    bool BytecodeImageReader::ValidateSection(const ImageSection& section, const T*& out) {
+        if (section.Offset % alignof(T) != 0 || section.Offset > m_Size || section.Count > (m_Size - section.Offset) / sizeof(T)) {
+            return Fail("Bytecode image contains an out of bounds section");
+        }
+
+        out = reinterpret_cast<const T*>(m_Data + section.Offset);
+        return true;
+    }
+
+    bool BytecodeImageReader::ReadString(u32 index, StringView& out) {
+        if (index >= m_Header->Strings.Count) { return Fail("Out of bounds string index"); }
+
+        out = StringView(m_StringData + m_Strings[index].Offset, m_Strings[index].Size);
+        return true;
+    }
+
+    bool BytecodeImageReader::ReadMemRef(const ImageMemRef& mem, MemRef& out) {
+        switch (mem.Kind) {
+            case ImageMemRefKind::None: out = MemRef(); return true;
+            case ImageMemRefKind::StackSlot: out = MemRef(StackSlotRef(mem.Slot, mem.Size, mem.Offset)); return true;
+
+            case ImageMemRefKind::GlobalVar: {
+                StringView name;
+                if (!ReadString(static_cast<u32>(mem.Slot), name)) { return false; }
+
+                out = MemRef(GlobalVarRef(std::string(name.Data(), name.Size())));
+                return true;
+            }
+
+            case ImageMemRefKind::Function: {
+                StringView signature;
+                if (!ReadString(static_cast<u32>(mem.Slot), signature)) { return false; }
+
+                out = MemRef(FunctionRef(std::string(signature.Data(), signature.Size())));
+                return true;
+            }
+        }
+
+        return Fail("Corrupt memory reference");
+    }
+
+    bool BytecodeImageReader::ReadType(u32 index, TypeInfo*& out) {
+        if (index == ImageInvalidIndex) {
+            out = nullptr;
+            return true;
+        }
+
+        if (index >= m_DecodedTypes.size()) { return Fail("Out of bounds type index"); }
+
+        out = m_DecodedTypes[index];
+        return true;
+    }
+
+    bool BytecodeImageReader::Fail(const std::string& error) {
+        if (m_Error.empty()) {
+            m_Error = error;
+        }
+
+        return false;
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "aria/internal/vm/op_codes.hpp"
+#include "aria/internal/compiler/compilation_context.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Layout of a .ariac file, every section is 8 byte aligned and all values are stored in the host's byte order
+    //
+    // header
+    // code         - ImageInstruction[], one per op code
+    // functions    - ImageFunction[], where every function starts in the code section
+    // constants    - u64[], the raw bits of every numeric constant
+    // strings      - ImageString[], offsets into the string data
+    // string data  - char[], NOT null terminated
+    // types        - ImageType[], a type only ever references types with a lower index
+    // type lists   - u32[], parameter types of function types
+    //
+    // Bump the version whenever the layout or the meaning of an op code changes
+    inline constexpr u32 BytecodeImageVersion = 9;
+    inline constexpr char BytecodeImageMagic[4] = { 'A', 'R', 'I', 'C' };
+    inline constexpr u32 ImageInvalidIndex = UINT32_MAX;
+
+    struct ImageSection {
+        u64 Offset = 0;
+        u64 Count = 0;
+    };
+
+    struct ImageHeader {
+        char Magic[4] = {};
+        u32 Version = 0;
+        u64 FileSize = 0;
+
+        ImageSection Code;
+        ImageSection Functions;
+        ImageSection Constants;
+        ImageSection Strings;
+        ImageSection StringData;
+        ImageSection Types;
+        ImageSection TypeLists;
+    };
+
+    enum class ImageMemRefKind : u32 {
+        None,
+        StackSlot,
+        GlobalVar, // Slot is an index into the string table
+        Function // Slot is an index into the string table
+    };
+
+    struct ImageMemRef {
+        ImageMemRefKind Kind = ImageMemRefKind::None;
+        i32 Slot = 0;
+        u32 Size = 0;
+        u32 Offset = 0;
+    };
+
+    // The meaning of the operands depends on DataKind (the index of the alternative in OpCode::Data)
+    struct ImageInstruction {
+        u32 Type = 0;
+        u32 DataKind = 0;
+        u32 Operand0 = 0;
+        u32 Operand1 = 0;
+        u32 TypeIndex = ImageInvalidIndex;
+        u32 DebugString = ImageInvalidIndex;
+        ImageMemRef Mem[3];
+
+        // The constant of a fused compare and branch with an immediate, an index into the constants section and its ImmediateValue alternative
+        u32 Constant = ImageInvalidIndex;
+        u32 ConstantKind = 0;
+    };
+
+    struct ImageFunction {
+        u32 Name = 0;
+        u32 CodeIndex = 0;
+    };
+
+    struct ImageString {
+        u32 Offset = 0;
+        u32 Size = 0;
+    };
+
+    struct ImageType {
+        u32 Type = 0; // PrimitiveType
+        u32 Flags = 0;
+        u64 Payload = 0; // Size of string literals, element type of arrays, return type of functions
+        u32 ListStart = 0;
+        u32 ListCount = 0;
+    };
+
+    // Serializes op codes into a .ariac image
+    class BytecodeImageWriter {
+    public:
+        BytecodeImageWriter(const std::vector<OpCode>* opcodes);
+
+        inline const std::vector<u8>& GetImage() const { return m_Image; }
+
+    private:
+        void WriteImpl();
+
+        u32 AddString(const std::string& str);
+        u32 AddType(TypeInfo* type);
+        ImageMemRef ConvertMemRef(const MemRef& mem);
+
+        template <typename T>
+        ImageSection AppendSection(const std::vector<T>& items);
+
+    private:
+        const std::vector<OpCode>* m_OpCodes = nullptr;
+
+        std::vector<ImageInstruction> m_Code;
+        std::vector<ImageFunction> m_Functions;
+        std::vector<u64> m_Constants;
+        std::vector<ImageString> m_Strings;
+        std::vector<char> m_StringData;
+        std::vector<ImageType> m_Types;
+        std::vector<u32> m_TypeLists;
+
+        std::unordered_map<std::string, u32> m_StringIndices;
+        std::unordered_map<TypeInfo*, u32> m_TypeIndices;
+
+        std::vector<u8> m_Image;
+    };
+
+    // Decodes a .ariac image into the op codes of a compilation context
+    // No copy of the image is made, string constants point straight into it so it must stay alive (mapped) as long as the op codes are used
+    class BytecodeImageReader {
+    public:
+        BytecodeImageReader(CompilationContext* ctx, const u8* data, size_t size);
+
+        inline bool IsValid() const { return m_Error.empty(); }
+        inline const std::string& GetError() const { return m_Error; }
+
+    private:
+        void ReadImpl();
+
+        template <typename T>
+        bool ValidateSection(const ImageSection& section, const T*& out);
+
+        bool ReadString(u32 index, StringView& out);
+        bool ReadMemRef(const ImageMemRef& mem, MemRef& out);
+        bool ReadType(u32 index, TypeInfo*& out);
+
+        bool Fail(const std::string& error);
+
+    private:
+        CompilationContext* m_Context = nullptr;
+        const u8* m_Data = nullptr;
+        size_t m_Size = 0;
+
+        const ImageHeader* m_Header = nullptr;
+        const ImageInstruction* m_Code = nullptr;
+        const ImageFunction* m_Functions = nullptr;
+        const u64* m_Constants = nullptr;
+        const ImageString* m_Strings = nullptr;
+        const char* m_StringData = nullptr;
+        const ImageType* m_Types = nullptr;
+        const u32* m_TypeLists = nullptr;
+
+        std::vector<TypeInfo*> m_DecodedTypes;
+
+        std::string m_Error;
+    };
+
+} // namespace Aria::Internal
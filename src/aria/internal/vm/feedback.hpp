@@ -0,0 +1,40 @@
+#pragma once
+
+#include "aria/internal/types.hpp"
+
+#include <vector>
+
+// Building with ARIA_DISABLE_FEEDBACK defined (premake5 --disable-feedback) leaves out every counter below,
+// the VM then records nothing about what it executes
+#if !defined(ARIA_DISABLE_FEEDBACK)
+    #define ARIA_FEEDBACK
+#endif
+
+namespace Aria::Internal {
+
+    // What the VM observed while running a program, meant to guide decisions such as what to compile or inline
+    // Every counter lives in an array indexed by the op code it belongs to, entries of unrelated op codes stay 0
+    // The interpreter and the JIT both record into it, native modules (see Context::LoadNative()) don't
+    struct ExecutionFeedback {
+        std::vector<u32> Invocations; // At the entry of a function, how often it has been called
+        std::vector<u32> Taken;       // At a conditional jump, how often it jumped
+        std::vector<u32> NotTaken;    // At a conditional jump, how often it fell through
+        std::vector<u32> CallTargets; // At a call, tail call or extern call, how often it called its target
+
+        // Grows every array to cover newly emitted op codes, existing counts are kept
+        void Resize(size_t programSize) {
+            Invocations.resize(programSize);
+            Taken.resize(programSize);
+            NotTaken.resize(programSize);
+            CallTargets.resize(programSize);
+        }
+
+        void Clear() {
+            Invocations.clear();
+            Taken.clear();
+            NotTaken.clear();
+            CallTargets.clear();
+        }
+    };
+
+} // namespace Aria::Internal
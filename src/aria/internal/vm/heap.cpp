@@ -0,0 +1,279 @@
+#include "aria/internal/vm/heap.hpp"
+#include "aria/core.hpp"
+
+#include <algorithm>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #define ARIA_HEAP_MMAP
+#endif
+
+namespace Aria::Internal {
+
+    static constexpr size_t PageSize = 4096;
+
+    // Maps every size up to the threshold (in steps of the alignment) to the smallest size class holding it
+    static constexpr auto SizeClassLookup = [] {
+        std::array<u8, HeapLargeObjectThreshold / HeapAlignment> lookup{};
+        size_t sizeClass = 0;
+
+        for (size_t i = 0; i < lookup.size(); i++) {
+            if ((i + 1) * HeapAlignment > HeapSizeClasses[sizeClass]) { sizeClass++; }
+            lookup[i] = static_cast<u8>(sizeClass);
+        }
+
+        return lookup;
+    }();
+
+    static void* MapPages(size_t bytes) {
+        #ifdef ARIA_HEAP_MMAP
+            void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            ARIA_ASSERT(memory != MAP_FAILED, "Out of memory!");
+            return memory;
+        #else
+            return ::operator new(bytes, std::align_val_t(PageSize));
+        #endif
+    }
+
+    static void UnmapPages(void* memory, size_t bytes) {
+        #ifdef ARIA_HEAP_MMAP
+            munmap(memory, bytes);
+        #else
+            ::operator delete(memory, bytes, std::align_val_t(PageSize));
+        #endif
+    }
+
+    ScriptHeap::ScriptHeap(ScriptHeap&& other) noexcept
+        : m_FreeLists(other.m_FreeLists), m_ActiveChunk(other.m_ActiveChunk), m_LargeObjects(other.m_LargeObjects),
+          m_ArenaActive(other.m_ArenaActive), m_ArenaChunks(other.m_ArenaChunks), m_ArenaCurrent(other.m_ArenaCurrent), m_Stats(other.m_Stats) {
+        other.m_FreeLists = {};
+        other.m_ActiveChunk = nullptr;
+        other.m_LargeObjects = nullptr;
+        other.m_ArenaActive = false;
+        other.m_ArenaChunks = nullptr;
+        other.m_ArenaCurrent = nullptr;
+        other.m_Stats = {};
+    }
+
+    ScriptHeap::~ScriptHeap() {
+        FreeAll();
+    }
+
+    ScriptHeap& ScriptHeap::operator=(ScriptHeap&& other) noexcept {
+        if (this != &other) {
+            FreeAll();
+
+            m_FreeLists = other.m_FreeLists;
+            m_ActiveChunk = other.m_ActiveChunk;
+            m_LargeObjects = other.m_LargeObjects;
+            m_ArenaActive = other.m_ArenaActive;
+            m_ArenaChunks = other.m_ArenaChunks;
+            m_ArenaCurrent = other.m_ArenaCurrent;
+            m_Stats = other.m_Stats;
+
+            other.m_FreeLists = {};
+            other.m_ActiveChunk = nullptr;
+            other.m_LargeObjects = nullptr;
+            other.m_ArenaActive = false;
+            other.m_ArenaChunks = nullptr;
+            other.m_ArenaCurrent = nullptr;
+            other.m_Stats = {};
+        }
+
+        return *this;
+    }
+
+    void* ScriptHeap::Allocate(size_t bytes) {
+        if (m_ArenaActive) {
+            return AllocateArena(bytes);
+        }
+
+        return AllocatePersistent(bytes);
+    }
+
+    void* ScriptHeap::AllocatePersistent(size_t bytes) {
+        m_Stats.Allocations++;
+        m_Stats.Objects++;
+
+        if (bytes > HeapLargeObjectThreshold) {
+            return AllocateLarge(bytes);
+        }
+
+        size_t sizeClass = GetSizeClass(bytes);
+        m_Stats.BytesInUse += HeapSizeClasses[sizeClass];
+        m_Stats.PeakBytesInUse = std::max(m_Stats.PeakBytesInUse, m_Stats.BytesInUse);
+
+        return AllocateSmall(sizeClass);
+    }
+
+    void ScriptHeap::Free(void* memory, size_t bytes) {
+        if (!memory) { return; }
+
+        m_Stats.Frees++;
+        m_Stats.Objects--;
+
+        if (bytes > HeapLargeObjectThreshold) {
+            FreeLarge(memory, bytes);
+            return;
+        }
+
+        size_t sizeClass = GetSizeClass(bytes);
+        m_Stats.BytesInUse -= HeapSizeClasses[sizeClass];
+
+        FreeBlock* block = new (memory) FreeBlock();
+        block->Next = m_FreeLists[sizeClass];
+        m_FreeLists[sizeClass] = block;
+    }
+
+    bool ScriptHeap::IsArenaMemory(const void* memory) const {
+        if (!m_ArenaCurrent) { return false; }
+
+        const u8* address = reinterpret_cast<const u8*>(memory);
+
+        for (ArenaChunk* chunk = m_ArenaChunks; chunk; chunk = chunk->Next) {
+            if (address >= chunk->GetData() && address < chunk->GetData() + chunk->Capacity) { return true; }
+            if (chunk == m_ArenaCurrent) { break; }
+        }
+
+        return false;
+    }
+
+    void ScriptHeap::ResetArena() {
+        // Every chunk after the current one gets its offset cleared once the arena reaches it again
+        m_ArenaCurrent = nullptr;
+        m_ArenaActive = false;
+
+        m_Stats.ArenaBytesInUse = 0;
+        m_Stats.ArenaResets++;
+    }
+
+    void ScriptHeap::FreeAll() {
+        while (m_ActiveChunk) {
+            Chunk* previous = m_ActiveChunk->Previous;
+            UnmapPages(m_ActiveChunk, HeapChunkSize);
+            m_ActiveChunk = previous;
+        }
+
+        while (m_LargeObjects) {
+            LargeObject* next = m_LargeObjects->Next;
+            UnmapPages(m_LargeObjects, m_LargeObjects->MappingSize);
+            m_LargeObjects = next;
+        }
+
+        while (m_ArenaChunks) {
+            ArenaChunk* next = m_ArenaChunks->Next;
+            UnmapPages(m_ArenaChunks, sizeof(ArenaChunk) + m_ArenaChunks->Capacity);
+            m_ArenaChunks = next;
+        }
+
+        m_FreeLists = {};
+        m_ArenaCurrent = nullptr;
+        m_Stats = {};
+    }
+
+    HeapStats ScriptHeap::GetStats() const {
+        HeapStats stats = m_Stats;
+        stats.SizeClasses = HeapSizeClassCount;
+        stats.LargeObjectThreshold = HeapLargeObjectThreshold;
+        stats.ChunkSize = HeapChunkSize;
+
+        return stats;
+    }
+
+    size_t ScriptHeap::GetSizeClass(size_t bytes) {
+        return bytes ? SizeClassLookup[(bytes - 1) / HeapAlignment] : 0;
+    }
+
+    void* ScriptHeap::AllocateSmall(size_t sizeClass) {
+        if (FreeBlock* block = m_FreeLists[sizeClass]) {
+            m_FreeLists[sizeClass] = block->Next;
+            m_Stats.FreeListHits++;
+            return block;
+        }
+
+        size_t size = HeapSizeClasses[sizeClass];
+
+        // Whatever is left at the end of a full chunk stays unused, it is less than the largest size class
+        if (!m_ActiveChunk || m_ActiveChunk->Offset + size > HeapChunkSize - sizeof(Chunk)) {
+            Chunk* chunk = new (MapPages(HeapChunkSize)) Chunk();
+            chunk->Previous = m_ActiveChunk;
+            m_ActiveChunk = chunk;
+
+            m_Stats.Chunks++;
+            m_Stats.BytesReserved += HeapChunkSize;
+        }
+
+        void* memory = m_ActiveChunk->GetData() + m_ActiveChunk->Offset;
+        m_ActiveChunk->Offset += size;
+        return memory;
+    }
+
+    void* ScriptHeap::AllocateLarge(size_t bytes) {
+        size_t mappingSize = (sizeof(LargeObject) + bytes + PageSize - 1) / PageSize * PageSize;
+
+        LargeObject* object = new (MapPages(mappingSize)) LargeObject();
+        object->MappingSize = mappingSize;
+        object->Next = m_LargeObjects;
+        if (m_LargeObjects) { m_LargeObjects->Previous = object; }
+        m_LargeObjects = object;
+
+        m_Stats.LargeObjects++;
+        m_Stats.BytesInUse += bytes;
+        m_Stats.BytesReserved += mappingSize;
+        m_Stats.PeakBytesInUse = std::max(m_Stats.PeakBytesInUse, m_Stats.BytesInUse);
+
+        return object->GetData();
+    }
+
+    void ScriptHeap::FreeLarge(void* memory, size_t bytes) {
+        LargeObject* object = reinterpret_cast<LargeObject*>(memory) - 1;
+
+        if (object->Previous) { object->Previous->Next = object->Next; }
+        else { m_LargeObjects = object->Next; }
+        if (object->Next) { object->Next->Previous = object->Previous; }
+
+        m_Stats.LargeObjects--;
+        m_Stats.BytesInUse -= bytes;
+        m_Stats.BytesReserved -= object->MappingSize;
+
+        UnmapPages(object, object->MappingSize);
+    }
+
+    void* ScriptHeap::AllocateArena(size_t bytes) {
+        size_t size = (std::max<size_t>(bytes, 1) + HeapAlignment - 1) / HeapAlignment * HeapAlignment;
+
+        if (!m_ArenaCurrent || m_ArenaCurrent->Offset + size > m_ArenaCurrent->Capacity) {
+            ArenaChunk* next = m_ArenaCurrent ? m_ArenaCurrent->Next : m_ArenaChunks;
+
+            if (!next || next->Capacity < size) {
+                size_t mappingSize = std::max(HeapChunkSize, (sizeof(ArenaChunk) + size + PageSize - 1) / PageSize * PageSize);
+
+                ArenaChunk* chunk = new (MapPages(mappingSize)) ArenaChunk();
+                chunk->Capacity = mappingSize - sizeof(ArenaChunk);
+                chunk->Next = next;
+
+                if (m_ArenaCurrent) { m_ArenaCurrent->Next = chunk; }
+                else { m_ArenaChunks = chunk; }
+
+                next = chunk;
+
+                m_Stats.ArenaChunks++;
+                m_Stats.ArenaBytesReserved += mappingSize;
+            }
+
+            next->Offset = 0;
+            m_ArenaCurrent = next;
+        }
+
+        void* memory = m_ArenaCurrent->GetData() + m_ArenaCurrent->Offset;
+        m_ArenaCurrent->Offset += size;
+
+        m_Stats.ArenaAllocations++;
+        m_Stats.ArenaBytesInUse += size;
+        m_Stats.PeakArenaBytesInUse = std::max(m_Stats.PeakArenaBytesInUse, m_Stats.ArenaBytesInUse);
+
+        return memory;
+    }
+
+} // namespace Aria::Internal
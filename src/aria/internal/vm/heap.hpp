@@ -0,0 +1,112 @@
+#pragma once
+
+#include "aria/context.hpp"
+#include "aria/internal/types.hpp"
+
+#include <array>
+#include <cstddef>
+
+namespace Aria::Internal {
+
+    // Small objects get rounded up to one of these sizes and carved out of chunks, every size has a free list of its own
+    inline constexpr size_t HeapSizeClasses[] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048 };
+    inline constexpr size_t HeapSizeClassCount = sizeof(HeapSizeClasses) / sizeof(HeapSizeClasses[0]);
+    // Anything bigger than the largest size class gets a mapping of its own
+    inline constexpr size_t HeapLargeObjectThreshold = HeapSizeClasses[HeapSizeClassCount - 1];
+    inline constexpr size_t HeapChunkSize = 64 * 1024;
+    inline constexpr size_t HeapAlignment = 16;
+
+    // The memory of everything a module creates at runtime (array headers and elements, strings and their buffers)
+    // A heap belongs to the VM of a single module, and only the thread running that module ever touches it,
+    // so the free lists are thread local by construction and nothing has to lock or go through the global allocator
+    // Memory is never returned to the system before FreeAll() (or the destructor), which releases every chunk and mapping at once
+    //
+    // While the invocation arena is active Allocate() bump allocates from the arena instead, see Context::SetInvocationArena()
+    // Arena memory is never freed on its own, ResetArena() hands all of it back at once
+    class ScriptHeap {
+    public:
+        ScriptHeap() = default;
+        ScriptHeap(const ScriptHeap&) = delete;
+        ScriptHeap(ScriptHeap&& other) noexcept;
+        ~ScriptHeap();
+
+        ScriptHeap& operator=(const ScriptHeap&) = delete;
+        ScriptHeap& operator=(ScriptHeap&& other) noexcept;
+
+        // Returns memory aligned to HeapAlignment, from the arena if it is active
+        void* Allocate(size_t bytes);
+        // Same as Allocate() but never from the arena, for whatever has to outlive the invocation
+        void* AllocatePersistent(size_t bytes);
+        // bytes has to be the size memory was allocated with, memory from the arena must never be freed
+        // Free() doesn't look at the arena at all, so the owner has to know where the memory came from
+        void Free(void* memory, size_t bytes);
+
+        inline void SetArenaActive(bool active) { m_ArenaActive = active; }
+        inline bool IsArenaActive() const { return m_ArenaActive; }
+        // Whether memory lies in the part of the arena used since the last reset, walks the arena chunks
+        bool IsArenaMemory(const void* memory) const;
+        // Makes every arena chunk available again, without touching the chunks themselves
+        void ResetArena();
+        inline void RecordPersistedObject() { m_Stats.PersistedObjects++; }
+
+        // Releases every chunk and large mapping, no matter how many objects still live in them
+        // Costs one unmap per chunk and large object, nothing walks the objects themselves
+        void FreeAll();
+
+        HeapStats GetStats() const;
+
+    private:
+        struct Chunk {
+            Chunk* Previous = nullptr;
+            size_t Offset = 0;
+
+            inline u8* GetData() { return reinterpret_cast<u8*>(this + 1); }
+        };
+
+        struct FreeBlock {
+            FreeBlock* Next = nullptr;
+        };
+
+        // Sits right in front of the object, linked so both freeing one and freeing all of them need no lookup
+        struct LargeObject {
+            LargeObject* Previous = nullptr;
+            LargeObject* Next = nullptr;
+            size_t MappingSize = 0;
+            size_t Padding = 0;
+
+            inline u8* GetData() { return reinterpret_cast<u8*>(this + 1); }
+        };
+
+        // The arena keeps its chunks across resets, a chunk too small for an allocation gets a bigger one inserted after it
+        struct ArenaChunk {
+            ArenaChunk* Next = nullptr;
+            size_t Capacity = 0;
+            size_t Offset = 0;
+            size_t Padding = 0;
+
+            inline u8* GetData() { return reinterpret_cast<u8*>(this + 1); }
+        };
+
+        static_assert(sizeof(Chunk) % HeapAlignment == 0 && sizeof(LargeObject) % HeapAlignment == 0 && sizeof(ArenaChunk) % HeapAlignment == 0,
+                      "Heap headers must keep objects aligned");
+
+        static size_t GetSizeClass(size_t bytes);
+
+        void* AllocateSmall(size_t sizeClass);
+        void* AllocateLarge(size_t bytes);
+        void FreeLarge(void* memory, size_t bytes);
+        void* AllocateArena(size_t bytes);
+
+    private:
+        std::array<FreeBlock*, HeapSizeClassCount> m_FreeLists{};
+        Chunk* m_ActiveChunk = nullptr;
+        LargeObject* m_LargeObjects = nullptr;
+
+        bool m_ArenaActive = false;
+        ArenaChunk* m_ArenaChunks = nullptr;
+        ArenaChunk* m_ArenaCurrent = nullptr; // The last chunk in use, nullptr right after a reset
+
+        HeapStats m_Stats;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,672 @@
+#include "aria/internal/vm/jit.hpp"
+#include "aria/internal/vm/vm.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
+
+#ifdef ARIA_JIT
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace Aria::Internal {
+
+    #ifdef ARIA_JIT
+
+    // What the generated code calls, rdi holds the VM and rsi the index of the op code
+    // The op code is looked up again on every call since lazy code generation may reallocate the program
+    struct JitRuntime {
+        using Helper = void(*)(VM* vm, size_t index);
+        using BranchHelper = bool(*)(VM* vm, size_t index); // Returns whether to jump
+
+        template <typename T>
+        static const T& GetData(VM* vm, size_t index) {
+            return *std::get_if<T>(&vm->m_Program[index].Data);
+        }
+
+        // The slot the last Alloca() created
+        static void* GetTop(VM* vm) {
+            return &vm->m_Stack[vm->m_StackSlots[vm->m_StackSlotPointer - 1].Index];
+        }
+
+        static void Alloca(VM* vm, size_t index) {
+            const OpCodeAlloca& alloca = GetData<OpCodeAlloca>(vm, index);
+            vm->Alloca(alloca.Size, alloca.ResolvedType);
+        }
+
+        static void Copy(VM* vm, size_t index) {
+            const OpCodeCopy& copy = GetData<OpCodeCopy>(vm, index);
+            vm->Copy(copy.DstMem, copy.SrcMem);
+        }
+
+        static void Dup(VM* vm, size_t index) {
+            vm->Dup(GetData<MemRef>(vm, index));
+        }
+
+        static void PushSF(VM* vm, size_t) {
+            vm->PushStackFrame();
+        }
+
+        static void PopSF(VM* vm, size_t) {
+            vm->PopStackFrame();
+        }
+
+        static void Pop(VM* vm, size_t index) {
+            vm->Pop(GetData<MemRef>(vm, index).GetStackSlot().Slot);
+        }
+
+        template <typename T>
+        static void Load(VM* vm, size_t index) {
+            const OpCodeLoad& l = GetData<OpCodeLoad>(vm, index);
+            vm->Alloca(sizeof(T), l.ResolvedType);
+            memcpy(GetTop(vm), std::get_if<T>(&l.Data), sizeof(T));
+        }
+
+        static void LoadStr(VM* vm, size_t index) {
+            vm->LoadStr(index, GetData<OpCodeLoad>(vm, index).ResolvedType);
+        }
+
+        static void SetGlobal(VM* vm, size_t index) {
+            vm->SetGlobal(GetData<OpCodeSetGlobal>(vm, index).Name);
+        }
+
+        static bool Condition(VM* vm, size_t index) {
+            bool condition = vm->GetBool(GetData<OpCodeConditionalJump>(vm, index).Mem);
+            vm->RecordBranch(index, condition == (vm->m_Program[index].Type == OpCodeType::Jt));
+
+            return condition;
+        }
+
+        // fn is the callee if it was already known when the caller got compiled, otherwise it gets resolved now
+        static void Call(VM* vm, size_t index, VMFunction* fn) {
+            vm->RecordCall(index);
+            vm->RunFunction(fn ? *fn : *vm->GetCallTarget(index));
+        }
+
+        // Returns the native code to jump to, or nullptr if the function already ran in the interpreter
+        static NativeFn TailCall(VM* vm, size_t index, VMFunction* fn) {
+            const OpCodeCall& call = GetData<OpCodeCall>(vm, index);
+            vm->RecordCall(index);
+
+            vm->ReplaceStackFrame(call.ArgCount, call.RetCount);
+            if (!fn) { fn = vm->GetCallTarget(index); }
+
+            if (NativeFn native = vm->GetNativeCode(*fn)) { return native; }
+
+            vm->RunInterpreted(*fn);
+            return nullptr;
+        }
+
+        static void CallExtern(VM* vm, size_t index) {
+            const OpCodeCall& call = GetData<OpCodeCall>(vm, index);
+            vm->RecordCall(index);
+            vm->CallExtern(call.Function.GetFunction().Signature, call.ArgCount, call.RetCount);
+        }
+
+        template <typename T>
+        static void Negate(VM* vm, size_t index) {
+            VMSlice s = vm->GetVMSlice(GetData<MemRef>(vm, index));
+            T value{};
+            memcpy(&value, s.Memory, sizeof(T));
+            T result = Internal::Negate(value);
+            vm->Alloca(sizeof(T), s.ResolvedType);
+            memcpy(GetTop(vm), &result, sizeof(T));
+        }
+
+        template <typename T, T(*Fn)(T, T)>
+        static void Binary(VM* vm, size_t index) {
+            const OpCodeMath& m = GetData<OpCodeMath>(vm, index);
+            T lhs{};
+            T rhs{};
+            memcpy(&lhs, vm->GetVMSlice(m.LHSMem).Memory, sizeof(T));
+            memcpy(&rhs, vm->GetVMSlice(m.RHSMem).Memory, sizeof(T));
+            T result = Fn(lhs, rhs);
+            vm->Alloca(sizeof(T), m.ResolvedType);
+            memcpy(GetTop(vm), &result, sizeof(T));
+        }
+
+        template <typename T, T(*Fn)(T, T)>
+        static void Compare(VM* vm, size_t index) {
+            const OpCodeMath& m = GetData<OpCodeMath>(vm, index);
+            T lhs{};
+            T rhs{};
+            memcpy(&lhs, vm->GetVMSlice(m.LHSMem).Memory, sizeof(T));
+            memcpy(&rhs, vm->GetVMSlice(m.RHSMem).Memory, sizeof(T));
+            bool result = Fn(lhs, rhs);
+            vm->Alloca(1, m.ResolvedType);
+            memcpy(GetTop(vm), &result, 1);
+        }
+
+        template <typename T, T(*Fn)(T, T)>
+        static void BinaryImm(VM* vm, size_t index) {
+            const OpCodeImmediate& m = GetData<OpCodeImmediate>(vm, index);
+            T lhs{};
+            memcpy(&lhs, vm->GetVMSlice(m.Mem).Memory, sizeof(T));
+            T result = Fn(lhs, *std::get_if<T>(&m.Value));
+            vm->Alloca(sizeof(T), m.ResolvedType);
+            memcpy(GetTop(vm), &result, sizeof(T));
+        }
+
+        template <typename T, T(*Fn)(T, T)>
+        static void CompareImm(VM* vm, size_t index) {
+            const OpCodeImmediate& m = GetData<OpCodeImmediate>(vm, index);
+            T lhs{};
+            memcpy(&lhs, vm->GetVMSlice(m.Mem).Memory, sizeof(T));
+            bool result = Fn(lhs, *std::get_if<T>(&m.Value));
+            vm->Alloca(1, m.ResolvedType);
+            memcpy(GetTop(vm), &result, 1);
+        }
+
+        template <typename T>
+        static void StoreImm(VM* vm, size_t index) {
+            const OpCodeImmediate& m = GetData<OpCodeImmediate>(vm, index);
+            memcpy(vm->GetVMSlice(m.Mem).Memory, std::get_if<T>(&m.Value), sizeof(T));
+        }
+
+        template <typename T, T(*Fn)(T, T)>
+        static bool CompareJump(VM* vm, size_t index) {
+            const OpCodeConditionalJump& jump = GetData<OpCodeConditionalJump>(vm, index);
+            T lhs{};
+            T rhs{};
+            memcpy(&lhs, vm->GetVMSlice(jump.Mem).Memory, sizeof(T));
+            memcpy(&rhs, vm->GetVMSlice(jump.RHSMem).Memory, sizeof(T));
+            bool taken = Fn(lhs, rhs);
+            vm->RecordBranch(index, taken);
+
+            return taken;
+        }
+
+        template <typename T, T(*Fn)(T, T)>
+        static bool CompareJumpImm(VM* vm, size_t index) {
+            const OpCodeConditionalJump& jump = GetData<OpCodeConditionalJump>(vm, index);
+            T lhs{};
+            memcpy(&lhs, vm->GetVMSlice(jump.Mem).Memory, sizeof(T));
+            bool taken = Fn(lhs, *std::get_if<T>(&jump.Value));
+            vm->RecordBranch(index, taken);
+
+            return taken;
+        }
+
+        static void ArrayNew(VM* vm, size_t index) {
+            vm->ArrayNew(GetData<OpCodeArray>(vm, index));
+        }
+
+        static void ArrayLength(VM* vm, size_t index) {
+            const OpCodeArray& arr = GetData<OpCodeArray>(vm, index);
+            i32 length = vm->GetArray(arr.Mem)->Size;
+            vm->Alloca(sizeof(i32), arr.ResolvedType);
+            memcpy(GetTop(vm), &length, sizeof(i32));
+        }
+
+        static void ArrayReserve(VM* vm, size_t index) {
+            const OpCodeArray& arr = GetData<OpCodeArray>(vm, index);
+            vm->m_Arrays.Reserve(vm->GetArray(arr.Mem), vm->GetInt(arr.IndexMem));
+        }
+
+        static void ArrayShrinkToFit(VM* vm, size_t index) {
+            vm->m_Arrays.ShrinkToFit(vm->GetArray(GetData<OpCodeArray>(vm, index).Mem));
+        }
+
+        static void ArrayClear(VM* vm, size_t index) {
+            vm->m_Arrays.Clear(vm->GetArray(GetData<OpCodeArray>(vm, index).Mem));
+        }
+
+        template <typename T>
+        static void ArrayLoad(VM* vm, size_t index) {
+            const OpCodeArray& arr = GetData<OpCodeArray>(vm, index);
+            T value{};
+            if (u8* element = vm->GetArrayElement(arr)) { memcpy(&value, element, sizeof(T)); }
+            vm->Alloca(sizeof(T), arr.ResolvedType);
+            memcpy(GetTop(vm), &value, sizeof(T));
+        }
+
+        template <typename T>
+        static void ArrayStore(VM* vm, size_t index) {
+            const OpCodeArray& arr = GetData<OpCodeArray>(vm, index);
+            if (u8* element = vm->GetArrayElement(arr)) { memcpy(element, vm->GetVMSlice(arr.ValueMem).Memory, sizeof(T)); }
+        }
+
+        template <typename T>
+        static void ArrayAppend(VM* vm, size_t index) {
+            const OpCodeArray& arr = GetData<OpCodeArray>(vm, index);
+            memcpy(vm->m_Arrays.Append(vm->GetArray(arr.Mem)), vm->GetVMSlice(arr.ValueMem).Memory, sizeof(T));
+        }
+
+        static void StringBinary(VM* vm, size_t index) {
+            vm->StringBinary(vm->m_Program[index].Type, GetData<OpCodeMath>(vm, index));
+        }
+
+        static void StringLength(VM* vm, size_t index) {
+            vm->StringLength(GetData<OpCodeMath>(vm, index));
+        }
+
+        static void StringHash(VM* vm, size_t index) {
+            vm->StringHash(GetData<OpCodeMath>(vm, index));
+        }
+
+        template <typename Src, typename Dst>
+        static void Cast(VM* vm, size_t index) {
+            const OpCodeCast& cast = GetData<OpCodeCast>(vm, index);
+            Src s{};
+            memcpy(&s, vm->GetVMSlice(cast.Mem).Memory, sizeof(Src));
+            Dst d = static_cast<Dst>(s);
+            vm->Alloca(sizeof(Dst), cast.ResolvedType);
+            memcpy(GetTop(vm), &d, sizeof(Dst));
+        }
+
+        // The helper for every op code that isn't control flow, nullptr if there is none
+        static Helper GetHelper(OpCodeType type) {
+            #define JIT_TYPED_CASES(_enum, helper) \
+                case OpCodeType::_enum##I8:  return &helper<i8>; \
+                case OpCodeType::_enum##I16: return &helper<i16>; \
+                case OpCodeType::_enum##I32: return &helper<i32>; \
+                case OpCodeType::_enum##I64: return &helper<i64>; \
+                case OpCodeType::_enum##U8:  return &helper<u8>; \
+                case OpCodeType::_enum##U16: return &helper<u16>; \
+                case OpCodeType::_enum##U32: return &helper<u32>; \
+                case OpCodeType::_enum##U64: return &helper<u64>; \
+                case OpCodeType::_enum##F32: return &helper<f32>; \
+                case OpCodeType::_enum##F64: return &helper<f64>;
+
+            #define JIT_INTEGRAL_OP_CASES(_enum, helper, op) \
+                case OpCodeType::_enum##I8:  return &helper<i8,  op<i8>>; \
+                case OpCodeType::_enum##I16: return &helper<i16, op<i16>>; \
+                case OpCodeType::_enum##I32: return &helper<i32, op<i32>>; \
+                case OpCodeType::_enum##I64: return &helper<i64, op<i64>>; \
+                case OpCodeType::_enum##U8:  return &helper<u8,  op<u8>>; \
+                case OpCodeType::_enum##U16: return &helper<u16, op<u16>>; \
+                case OpCodeType::_enum##U32: return &helper<u32, op<u32>>; \
+                case OpCodeType::_enum##U64: return &helper<u64, op<u64>>;
+
+            #define JIT_OP_CASES(_enum, helper, op) \
+                JIT_INTEGRAL_OP_CASES(_enum, helper, op) \
+                case OpCodeType::_enum##F32: return &helper<f32, op<f32>>; \
+                case OpCodeType::_enum##F64: return &helper<f64, op<f64>>;
+
+            #define JIT_CAST_CASES(_cast, sourceType) \
+                case OpCodeType::Cast##_cast##ToI8:  return &Cast<sourceType, i8>; \
+                case OpCodeType::Cast##_cast##ToI16: return &Cast<sourceType, i16>; \
+                case OpCodeType::Cast##_cast##ToI32: return &Cast<sourceType, i32>; \
+                case OpCodeType::Cast##_cast##ToI64: return &Cast<sourceType, i64>; \
+                case OpCodeType::Cast##_cast##ToU8:  return &Cast<sourceType, u8>; \
+                case OpCodeType::Cast##_cast##ToU16: return &Cast<sourceType, u16>; \
+                case OpCodeType::Cast##_cast##ToU32: return &Cast<sourceType, u32>; \
+                case OpCodeType::Cast##_cast##ToU64: return &Cast<sourceType, u64>; \
+                case OpCodeType::Cast##_cast##ToF32: return &Cast<sourceType, f32>; \
+                case OpCodeType::Cast##_cast##ToF64: return &Cast<sourceType, f64>;
+
+            switch (type) {
+                case OpCodeType::Alloca:     return &Alloca;
+                case OpCodeType::Copy:       return &Copy;
+                case OpCodeType::Dup:        return &Dup;
+                case OpCodeType::PushSF:     return &PushSF;
+                case OpCodeType::PopSF:      return &PopSF;
+                case OpCodeType::Pop:        return &Pop;
+                case OpCodeType::LoadStr:    return &LoadStr;
+                case OpCodeType::SetGlobal:  return &SetGlobal;
+                case OpCodeType::CallExtern: return &CallExtern;
+
+                JIT_TYPED_CASES(Load, Load)
+                JIT_TYPED_CASES(Negate, Negate)
+
+                JIT_OP_CASES(Add, Binary, Internal::Add)
+                JIT_OP_CASES(Sub, Binary, Internal::Sub)
+                JIT_OP_CASES(Mul, Binary, Internal::Mul)
+                JIT_OP_CASES(Div, Binary, Internal::Div)
+                JIT_OP_CASES(Mod, Binary, Internal::Mod)
+
+                JIT_INTEGRAL_OP_CASES(And, Binary, Internal::And)
+                JIT_INTEGRAL_OP_CASES(Or, Binary, Internal::Or)
+                JIT_INTEGRAL_OP_CASES(Xor, Binary, Internal::Xor)
+
+                JIT_OP_CASES(Cmp, Compare, Internal::Cmp)
+                JIT_OP_CASES(Ncmp, Compare, Internal::Ncmp)
+                JIT_OP_CASES(Lt, Compare, Internal::Lt)
+                JIT_OP_CASES(Lte, Compare, Internal::Lte)
+                JIT_OP_CASES(Gt, Compare, Internal::Gt)
+                JIT_OP_CASES(Gte, Compare, Internal::Gte)
+
+                JIT_CAST_CASES(I8,  i8)
+                JIT_CAST_CASES(I16, i16)
+                JIT_CAST_CASES(I32, i32)
+                JIT_CAST_CASES(I64, i64)
+                JIT_CAST_CASES(U8,  u8)
+                JIT_CAST_CASES(U16, u16)
+                JIT_CAST_CASES(U32, u32)
+                JIT_CAST_CASES(U64, u64)
+                JIT_CAST_CASES(F32, f32)
+                JIT_CAST_CASES(F64, f64)
+
+                JIT_OP_CASES(AddImm, BinaryImm, Internal::Add)
+                JIT_OP_CASES(SubImm, BinaryImm, Internal::Sub)
+                JIT_OP_CASES(MulImm, BinaryImm, Internal::Mul)
+                JIT_OP_CASES(DivImm, BinaryImm, Internal::Div)
+                JIT_OP_CASES(ModImm, BinaryImm, Internal::Mod)
+
+                JIT_OP_CASES(CmpImm, CompareImm, Internal::Cmp)
+                JIT_OP_CASES(NcmpImm, CompareImm, Internal::Ncmp)
+                JIT_OP_CASES(LtImm, CompareImm, Internal::Lt)
+                JIT_OP_CASES(LteImm, CompareImm, Internal::Lte)
+                JIT_OP_CASES(GtImm, CompareImm, Internal::Gt)
+                JIT_OP_CASES(GteImm, CompareImm, Internal::Gte)
+
+                JIT_TYPED_CASES(StoreImm, StoreImm)
+
+                case OpCodeType::ArrayNew:         return &ArrayNew;
+                case OpCodeType::ArrayLength:      return &ArrayLength;
+                case OpCodeType::ArrayReserve:     return &ArrayReserve;
+                case OpCodeType::ArrayShrinkToFit: return &ArrayShrinkToFit;
+                case OpCodeType::ArrayClear:       return &ArrayClear;
+
+                JIT_TYPED_CASES(ArrayLoad, ArrayLoad)
+                JIT_TYPED_CASES(ArrayStore, ArrayStore)
+                JIT_TYPED_CASES(ArrayAppend, ArrayAppend)
+
+                case OpCodeType::StrConcat:
+                case OpCodeType::StrCmp:
+                case OpCodeType::StrNcmp:
+                case OpCodeType::StrLt:
+                case OpCodeType::StrLte:
+                case OpCodeType::StrGt:
+                case OpCodeType::StrGte:    return &StringBinary;
+                case OpCodeType::StrLength: return &StringLength;
+                case OpCodeType::StrHash:   return &StringHash;
+
+                default: return nullptr;
+            }
+
+            #undef JIT_TYPED_CASES
+            #undef JIT_INTEGRAL_OP_CASES
+            #undef JIT_OP_CASES
+            #undef JIT_CAST_CASES
+        }
+
+        // The helper deciding a fused compare and branch, nullptr for every other op code
+        static BranchHelper GetBranchHelper(OpCodeType type) {
+            #define JIT_BRANCH_CASES(_enum, helper, op) \
+                case OpCodeType::_enum##I8:  return &helper<i8,  op<i8>>; \
+                case OpCodeType::_enum##I16: return &helper<i16, op<i16>>; \
+                case OpCodeType::_enum##I32: return &helper<i32, op<i32>>; \
+                case OpCodeType::_enum##I64: return &helper<i64, op<i64>>; \
+                case OpCodeType::_enum##U8:  return &helper<u8,  op<u8>>; \
+                case OpCodeType::_enum##U16: return &helper<u16, op<u16>>; \
+                case OpCodeType::_enum##U32: return &helper<u32, op<u32>>; \
+                case OpCodeType::_enum##U64: return &helper<u64, op<u64>>; \
+                case OpCodeType::_enum##F32: return &helper<f32, op<f32>>; \
+                case OpCodeType::_enum##F64: return &helper<f64, op<f64>>;
+
+            switch (type) {
+                JIT_BRANCH_CASES(Jcmp, CompareJump, Internal::Cmp)
+                JIT_BRANCH_CASES(Jncmp, CompareJump, Internal::Ncmp)
+                JIT_BRANCH_CASES(Jlt, CompareJump, Internal::Lt)
+                JIT_BRANCH_CASES(Jlte, CompareJump, Internal::Lte)
+                JIT_BRANCH_CASES(Jgt, CompareJump, Internal::Gt)
+                JIT_BRANCH_CASES(Jgte, CompareJump, Internal::Gte)
+
+                JIT_BRANCH_CASES(JcmpImm, CompareJumpImm, Internal::Cmp)
+                JIT_BRANCH_CASES(JncmpImm, CompareJumpImm, Internal::Ncmp)
+                JIT_BRANCH_CASES(JltImm, CompareJumpImm, Internal::Lt)
+                JIT_BRANCH_CASES(JlteImm, CompareJumpImm, Internal::Lte)
+                JIT_BRANCH_CASES(JgtImm, CompareJumpImm, Internal::Gt)
+                JIT_BRANCH_CASES(JgteImm, CompareJumpImm, Internal::Gte)
+
+                default: return nullptr;
+            }
+
+            #undef JIT_BRANCH_CASES
+        }
+    };
+
+    // Appends x86-64 instructions, the VM pointer lives in rbx for the whole function
+    class JitCodeBuffer {
+    public:
+        void Prologue() {
+            Emit({ 0x53 });             // push rbx (also aligns the stack for the calls)
+            Emit({ 0x48, 0x89, 0xFB }); // mov rbx, rdi
+        }
+
+        void Epilogue() {
+            Emit({ 0x5B }); // pop rbx
+            Emit({ 0xC3 }); // ret
+        }
+
+        // helper(vm, index, arg)
+        void CallHelper(const void* helper, size_t index, const void* arg) {
+            Emit({ 0x48, 0xBA }); // mov rdx, imm64
+            EmitImm(reinterpret_cast<u64>(arg));
+            CallHelper(helper, index);
+        }
+
+        // helper(vm, index)
+        void CallHelper(const void* helper, size_t index) {
+            Emit({ 0x48, 0x89, 0xDF }); // mov rdi, rbx
+
+            if (index <= UINT32_MAX) {
+                Emit({ 0xBE }); // mov esi, imm32
+                EmitImm(static_cast<u32>(index));
+            } else {
+                Emit({ 0x48, 0xBE }); // mov rsi, imm64
+                EmitImm(static_cast<u64>(index));
+            }
+
+            Emit({ 0x48, 0xB8 }); // mov rax, imm64
+            EmitImm(reinterpret_cast<u64>(helper));
+            Emit({ 0xFF, 0xD0 }); // call rax
+        }
+
+        // Jumps to the native code returned by the last helper, unless it returned nullptr
+        void TailJumpOrReturn() {
+            Emit({ 0x48, 0x85, 0xC0 }); // test rax, rax
+            Emit({ 0x74, 0x06 });       // jz +6
+            Emit({ 0x48, 0x89, 0xDF }); // mov rdi, rbx
+            Emit({ 0x5B });             // pop rbx
+            Emit({ 0xFF, 0xE0 });       // jmp rax
+            Epilogue();
+        }
+
+        void Jmp(size_t target) {
+            Emit({ 0xE9 });
+            EmitFixup(target);
+        }
+
+        // Jumps if the bool the last helper returned is (not) set
+        void JumpIf(bool value, size_t target) {
+            Emit({ 0x84, 0xC0 }); // test al, al
+            Emit({ 0x0F, static_cast<u8>(value ? 0x85 : 0x84) }); // jnz / jz rel32
+            EmitFixup(target);
+        }
+
+        // Resolves the jumps, offsets holds the native offset of every op code index the jumps refer to
+        void PatchJumps(const std::vector<size_t>& offsets) {
+            for (const Fixup& fixup : m_Fixups) {
+                i32 rel = static_cast<i32>(static_cast<i64>(offsets[fixup.Target]) - static_cast<i64>(fixup.Position + 4));
+                memcpy(&m_Code[fixup.Position], &rel, sizeof(rel));
+            }
+        }
+
+        size_t Size() const { return m_Code.size(); }
+        const u8* Data() const { return m_Code.data(); }
+
+    private:
+        void Emit(std::initializer_list<u8> bytes) {
+            m_Code.insert(m_Code.end(), bytes);
+        }
+
+        template <typename T>
+        void EmitImm(T value) {
+            size_t pos = m_Code.size();
+            m_Code.resize(pos + sizeof(T));
+            memcpy(&m_Code[pos], &value, sizeof(T));
+        }
+
+        void EmitFixup(size_t target) {
+            m_Fixups.push_back({ m_Code.size(), target });
+            EmitImm<i32>(0);
+        }
+
+    private:
+        struct Fixup {
+            size_t Position = 0;
+            size_t Target = 0;
+        };
+
+        std::vector<u8> m_Code;
+        std::vector<Fixup> m_Fixups;
+    };
+
+    NativeFn JitCompiler::Compile(const OpCode* program, size_t programSize, VMFunction* const* callTargets, const VMFunction& fn, size_t& codeSize) {
+        // Execution starts right after the entry, just like when interpreting
+        size_t begin = fn.Entry + 1;
+        size_t end = begin;
+        while (end < programSize && program[end].Type != OpCodeType::Function) { end++; }
+
+        // Jumps go to the op code after their target
+        auto getJumpIndex = [&](const OpCodeConditionalJump& jump, size_t& index) {
+            size_t target = jump.Target;
+
+            if (target == SIZE_MAX) {
+                auto it = fn.Labels.find(jump.Label);
+                if (it == fn.Labels.end()) { return false; }
+                target = it->second;
+            }
+
+            if (target + 1 < begin || target + 1 > end) { return false; }
+            index = target + 1 - begin;
+            return true;
+        };
+
+        JitCodeBuffer code;
+        std::vector<size_t> offsets(end - begin + 1);
+
+        code.Prologue();
+
+        for (size_t pc = begin; pc < end; pc++) {
+            const OpCode& op = program[pc];
+            offsets[pc - begin] = code.Size();
+
+            switch (op.Type) {
+                case OpCodeType::Nop:
+                case OpCodeType::Label: break;
+
+                case OpCodeType::Jmp:
+                case OpCodeType::Jt:
+                case OpCodeType::Jf: {
+                    size_t index = 0;
+                    if (!getJumpIndex(std::get<OpCodeConditionalJump>(op.Data), index)) { return nullptr; }
+
+                    if (op.Type == OpCodeType::Jmp) {
+                        code.Jmp(index);
+                    } else {
+                        code.CallHelper(reinterpret_cast<const void*>(&JitRuntime::Condition), pc);
+                        code.JumpIf(op.Type == OpCodeType::Jt, index);
+                    }
+
+                    break;
+                }
+
+                // The callee is baked into the code when the prepass already resolved it
+                case OpCodeType::Call: {
+                    if (!std::get<OpCodeCall>(op.Data).Function.ContainsFunction()) { return nullptr; }
+
+                    code.CallHelper(reinterpret_cast<const void*>(&JitRuntime::Call), pc, callTargets[pc]);
+                    break;
+                }
+
+                case OpCodeType::TailCall: {
+                    if (!std::get<OpCodeCall>(op.Data).Function.ContainsFunction()) { return nullptr; }
+
+                    code.CallHelper(reinterpret_cast<const void*>(&JitRuntime::TailCall), pc, callTargets[pc]);
+                    code.TailJumpOrReturn();
+                    break;
+                }
+
+                case OpCodeType::Ret: {
+                    code.Epilogue();
+                    break;
+                }
+
+                default: {
+                    if (JitRuntime::BranchHelper branch = JitRuntime::GetBranchHelper(op.Type)) {
+                        size_t index = 0;
+                        if (!getJumpIndex(std::get<OpCodeConditionalJump>(op.Data), index)) { return nullptr; }
+
+                        code.CallHelper(reinterpret_cast<const void*>(branch), pc);
+                        code.JumpIf(true, index);
+                        break;
+                    }
+
+                    if (op.Type == OpCodeType::CallExtern && !std::get<OpCodeCall>(op.Data).Function.ContainsFunction()) {
+                        return nullptr;
+                    }
+
+                    JitRuntime::Helper helper = JitRuntime::GetHelper(op.Type);
+                    if (!helper) { return nullptr; }
+
+                    code.CallHelper(reinterpret_cast<const void*>(helper), pc);
+                    break;
+                }
+            }
+        }
+
+        offsets[end - begin] = code.Size();
+        code.Epilogue(); // Never reached by valid byte code, which always ends a function with a ret or a tail call
+
+        code.PatchJumps(offsets);
+
+        // The code gets written while the memory is only writable, and only then made executable
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t mappingSize = ((code.Size() + pageSize - 1) / pageSize) * pageSize;
+
+        void* memory = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) { return nullptr; }
+
+        memcpy(memory, code.Data(), code.Size());
+        if (mprotect(memory, mappingSize, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, mappingSize);
+            return nullptr;
+        }
+
+        m_Mappings.push_back({ memory, mappingSize });
+        codeSize = code.Size();
+        return reinterpret_cast<NativeFn>(memory);
+    }
+
+    void JitCompiler::Reset() {
+        for (const CodeMapping& mapping : m_Mappings) {
+            munmap(mapping.Memory, mapping.Size);
+        }
+
+        m_Mappings.clear();
+    }
+
+    bool JitCompiler::IsAvailable() {
+        return true;
+    }
+
+    #else
+
+    NativeFn JitCompiler::Compile(const OpCode*, size_t, VMFunction* const*, const VMFunction&, size_t&) {
+        return nullptr;
+    }
+
+    void JitCompiler::Reset() {}
+
+    bool JitCompiler::IsAvailable() {
+        return false;
+    }
+
+    #endif
+
+    JitCompiler::~JitCompiler() {
+        Reset();
+    }
+
+    JitCompiler& JitCompiler::operator=(JitCompiler&& other) {
+        if (this != &other) {
+            Reset();
+            m_Mappings = std::move(other.m_Mappings);
+            other.m_Mappings.clear();
+        }
+
+        return *this;
+    }
+
+} // namespace Aria::Internal
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "aria/internal/vm/op_codes.hpp"
+
+#include <vector>
+
+// The JIT writes x86-64 machine code into mmap'd memory, so it only exists on x86-64 Linux
+// Building with ARIA_DISABLE_JIT defined (premake5 --disable-jit) leaves it out, every function then runs in the interpreter
+#if defined(__x86_64__) && defined(__linux__) && !defined(ARIA_DISABLE_JIT)
+    #define ARIA_JIT
+#endif
+
+namespace Aria::Internal {
+
+    class VM;
+    struct VMFunction;
+
+    // Native code of a script function, runs the function to completion (up to and including its ret) and then returns
+    using NativeFn = void(*)(VM* vm);
+
+    // Baseline JIT which translates the byte code of a single function into x86-64 machine code
+    // Every op code becomes a direct call into a helper specialized for it, which works on the regular VM stack
+    // So the stack and its frames look exactly like they do while interpreting, which is what lets native and interpreted
+    // functions call each other freely
+    // What does go away is the dispatch: jumps and returns are compiled to native branches
+    // Calls still go through a helper (which does the tiering), but with the callee resolved up front, and a tail call
+    // into native code jumps straight to it
+    class JitCompiler {
+    public:
+        JitCompiler() = default;
+        ~JitCompiler();
+
+        JitCompiler(const JitCompiler& other) = delete;
+        JitCompiler(JitCompiler&& other) = default;
+        JitCompiler& operator=(const JitCompiler& other) = delete;
+        JitCompiler& operator=(JitCompiler&& other);
+
+        // Returns nullptr if the function can't be compiled (or the JIT is disabled), it then stays in the interpreter
+        // callTargets runs parallel to the program and holds the callee of every call the VM already resolved
+        NativeFn Compile(const OpCode* program, size_t programSize, VMFunction* const* callTargets, const VMFunction& fn, size_t& codeSize);
+
+        // Frees all generated code, none of it may be running anymore
+        void Reset();
+
+        static bool IsAvailable();
+
+    private:
+        struct CodeMapping {
+            void* Memory = nullptr;
+            size_t Size = 0;
+        };
+
+        std::vector<CodeMapping> m_Mappings;
+    };
+
+} // namespace Aria::Internal
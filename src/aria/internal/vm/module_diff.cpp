@@ -0,0 +1,139 @@
+#include "aria/internal/vm/module_diff.hpp"
+#include "aria/internal/compiler/codegen/disassembler.hpp"
+#include "aria/internal/compiler/ast/decl.hpp"
+#include "aria/internal/compiler/ast/ast.hpp"
+
+#include <unordered_map>
+
+namespace Aria::Internal {
+
+    static constexpr const char* StartFunction = "_start$()";
+
+    ModuleDiff::ModuleDiff(CompilationContext* oldCtx, CompilationContext* newCtx) {
+        m_OldContext = oldCtx;
+        m_NewContext = newCtx;
+
+        DiffImpl();
+    }
+
+    void ModuleDiff::DiffImpl() {
+        std::vector<NamedEntry> oldFunctions = CollectFunctions(&m_OldContext->GetOpCodes());
+        std::vector<NamedEntry> newFunctions = CollectFunctions(&m_NewContext->GetOpCodes());
+
+        std::unordered_map<std::string, const NamedEntry*> oldFunctionMap;
+        for (const NamedEntry& fn : oldFunctions) {
+            oldFunctionMap[fn.Name] = &fn;
+        }
+
+        for (const NamedEntry& fn : newFunctions) {
+            auto it = oldFunctionMap.find(fn.Name);
+            bool added = it == oldFunctionMap.end();
+
+            if (!added && it->second->Contents == fn.Contents) {
+                oldFunctionMap.erase(it);
+                continue;
+            }
+
+            m_HasChanges = true;
+            if (fn.Name == StartFunction) {
+                oldFunctionMap.erase(fn.Name);
+                continue;
+            }
+
+            if (added) {
+                m_AddedFunctions.push_back(fn.Name);
+            } else {
+                m_ChangedFunctions.push_back(fn.Name);
+                oldFunctionMap.erase(it);
+            }
+        }
+
+        // Whatever is left in the map doesn't exist anymore
+        for (const NamedEntry& fn : oldFunctions) {
+            if (oldFunctionMap.contains(fn.Name)) {
+                m_RemovedFunctions.push_back(fn.Name);
+                m_HasChanges = true;
+            }
+        }
+
+        std::vector<NamedEntry> oldGlobals;
+        std::vector<NamedEntry> newGlobals;
+        bool oldGlobalsKnown = CollectGlobals(m_OldContext, oldGlobals);
+        CollectGlobals(m_NewContext, newGlobals);
+
+        std::unordered_map<std::string, const NamedEntry*> oldGlobalMap;
+        for (const NamedEntry& g : oldGlobals) {
+            oldGlobalMap[g.Name] = &g;
+        }
+
+        for (const NamedEntry& g : newGlobals) {
+            auto it = oldGlobalMap.find(g.Name);
+
+            if (!oldGlobalsKnown) {
+                // Without the old types there is no way of telling if the current value is still valid
+                m_ResetGlobals.push_back(g.Name);
+            } else if (it == oldGlobalMap.end()) {
+                m_AddedGlobals.push_back(g.Name);
+            } else if (it->second->Contents == g.Contents) {
+                m_KeptGlobals.push_back(g.Name);
+                oldGlobalMap.erase(it);
+            } else {
+                m_ResetGlobals.push_back(g.Name);
+                oldGlobalMap.erase(it);
+            }
+        }
+
+        for (const NamedEntry& g : oldGlobals) {
+            if (oldGlobalMap.contains(g.Name)) {
+                m_RemovedGlobals.push_back(g.Name);
+            }
+        }
+
+        m_HasChanges = m_HasChanges || !m_ResetGlobals.empty() || !m_AddedGlobals.empty() || !m_RemovedGlobals.empty();
+    }
+
+    std::vector<ModuleDiff::NamedEntry> ModuleDiff::CollectFunctions(const std::vector<OpCode>* opcodes) {
+        Disassembler d(opcodes);
+        const std::string& disassembly = d.GetDisassembly();
+
+        const std::string functionPrefix = ".function ";
+        std::vector<NamedEntry> functions;
+
+        size_t pos = 0;
+        while (pos < disassembly.size()) {
+            size_t end = disassembly.find('\n', pos);
+            if (end == std::string::npos) { end = disassembly.size(); }
+
+            std::string_view line(disassembly.data() + pos, end - pos);
+
+            if (line.starts_with(functionPrefix)) {
+                std::string_view name = line.substr(functionPrefix.size());
+                if (name.ends_with(':')) { name.remove_suffix(1); }
+
+                functions.push_back({ std::string(name), {} });
+            } else if (!functions.empty()) {
+                functions.back().Contents.append(line);
+                functions.back().Contents += '\n';
+            }
+
+            pos = end + 1;
+        }
+
+        return functions;
+    }
+
+    bool ModuleDiff::CollectGlobals(CompilationContext* ctx, std::vector<NamedEntry>& globals) {
+        TranslationUnitDecl* tu = GetNode<TranslationUnitDecl>(ctx->GetRootASTNode());
+        if (!tu) { return false; }
+
+        for (Stmt* stmt : tu->GetStmts()) {
+            if (VarDecl* varDecl = GetNode<VarDecl>(stmt)) {
+                StringView ident = varDecl->GetIdentifier();
+                globals.push_back({ std::string(ident.Data(), ident.Size()), TypeInfoToString(varDecl->GetResolvedType()) });
+            }
+        }
+
+        return true;
+    }
+
+} // namespace Aria::Internal
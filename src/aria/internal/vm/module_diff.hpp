@@ -0,0 +1,58 @@
+#pragma once
+
+#include "aria/internal/compiler/compilation_context.hpp"
+
+#include <string>
+#include <vector>
+
+namespace Aria::Internal {
+
+    // Compares two compilations of the same module, this is what hot reloading uses to figure out what changed
+    // Functions are compared by their byte code, globals by their name and type
+    class ModuleDiff {
+    public:
+        ModuleDiff(CompilationContext* oldCtx, CompilationContext* newCtx);
+
+        // True if the byte code of any function (including _start$()) is different
+        inline bool HasChanges() const { return m_HasChanges; }
+
+        // None of the function lists contain _start$()
+        inline const std::vector<std::string>& GetChangedFunctions() const { return m_ChangedFunctions; }
+        inline const std::vector<std::string>& GetAddedFunctions() const { return m_AddedFunctions; }
+        inline const std::vector<std::string>& GetRemovedFunctions() const { return m_RemovedFunctions; }
+
+        inline const std::vector<std::string>& GetKeptGlobals() const { return m_KeptGlobals; }
+        inline const std::vector<std::string>& GetResetGlobals() const { return m_ResetGlobals; }
+        inline const std::vector<std::string>& GetAddedGlobals() const { return m_AddedGlobals; }
+        inline const std::vector<std::string>& GetRemovedGlobals() const { return m_RemovedGlobals; }
+
+    private:
+        struct NamedEntry {
+            std::string Name;
+            std::string Contents; // The disassembly of a function or the type of a global
+        };
+
+        void DiffImpl();
+
+        // Splits the disassembly at every function, in the order the functions appear in
+        static std::vector<NamedEntry> CollectFunctions(const std::vector<OpCode>* opcodes);
+        // Returns false if the module has no AST (loaded from a bytecode image) so its globals are unknown
+        static bool CollectGlobals(CompilationContext* ctx, std::vector<NamedEntry>& globals);
+
+    private:
+        CompilationContext* m_OldContext = nullptr;
+        CompilationContext* m_NewContext = nullptr;
+
+        bool m_HasChanges = false;
+
+        std::vector<std::string> m_ChangedFunctions;
+        std::vector<std::string> m_AddedFunctions;
+        std::vector<std::string> m_RemovedFunctions;
+
+        std::vector<std::string> m_KeptGlobals;
+        std::vector<std::string> m_ResetGlobals;
+        std::vector<std::string> m_AddedGlobals;
+        std::vector<std::string> m_RemovedGlobals;
+    };
+
+} // namespace Aria::Internal
@@ -0,0 +1,112 @@
+#include "aria/internal/vm/native_module.hpp"
+#include "aria/internal/vm/vm.hpp"
+
+#if defined(__linux__) || defined(__APPLE__)
+    #define ARIA_HAS_DLOPEN
+    #include <dlfcn.h>
+#endif
+
+namespace Aria::Internal {
+
+    static MemRef ToMemRef(const NativeMemRef* ref) {
+        if (ref->Global) { return { GlobalVarRef(ref->Global) }; }
+
+        return { StackSlotRef(ref->Slot, ref->Size, ref->Offset) };
+    }
+
+    static VM* ToVM(void* vm) {
+        return static_cast<VM*>(vm);
+    }
+
+    static const NativeApi s_NativeApi = {
+        .Alloca = [](void* vm, size_t size) {
+            ToVM(vm)->Alloca(size, nullptr);
+        },
+        .Push = [](void* vm, const void* data, size_t size) {
+            ToVM(vm)->Alloca(size, nullptr);
+            memcpy(ToVM(vm)->GetVMSlice({ StackSlotRef(-1, size) }).Memory, data, size);
+        },
+        .Address = [](void* vm, const NativeMemRef* ref) {
+            return ToVM(vm)->GetVMSlice(ToMemRef(ref)).Memory;
+        },
+        .Copy = [](void* vm, const NativeMemRef* dst, const NativeMemRef* src) {
+            ToVM(vm)->Copy(ToMemRef(dst), ToMemRef(src));
+        },
+        .Dup = [](void* vm, const NativeMemRef* ref) {
+            ToVM(vm)->Dup(ToMemRef(ref));
+        },
+        .PushStackFrame = [](void* vm) {
+            ToVM(vm)->PushStackFrame();
+        },
+        .PopStackFrame = [](void* vm) {
+            ToVM(vm)->PopStackFrame();
+        },
+        .Pop = [](void* vm, i32 slot) {
+            ToVM(vm)->Pop(slot);
+        },
+        .ReplaceStackFrame = [](void* vm, size_t argCount, size_t retCount) {
+            ToVM(vm)->ReplaceStackFrame(argCount, retCount);
+        },
+        .SetGlobal = [](void* vm, const char* name) {
+            ToVM(vm)->SetGlobal(name);
+        },
+        .CallExtern = [](void* vm, const char* signature, size_t argCount, size_t retCount) {
+            ToVM(vm)->CallExtern(signature, argCount, retCount);
+        },
+    };
+
+    const NativeApi* GetNativeApi() {
+        return &s_NativeApi;
+    }
+
+    NativeLibrary::~NativeLibrary() {
+        #ifdef ARIA_HAS_DLOPEN
+            if (m_Handle) { dlclose(m_Handle); }
+        #endif
+    }
+
+    bool NativeLibrary::Open(const std::string& path, std::string& error) {
+        #ifdef ARIA_HAS_DLOPEN
+            // dlopen() only searches the library paths for names without a slash
+            std::string file = (path.find('/') == std::string::npos) ? "./" + path : path;
+
+            m_Handle = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+            if (!m_Handle) {
+                const char* dlError = dlerror();
+                error = dlError ? dlError : "Failed to open library";
+                return false;
+            }
+
+            const u32* version = reinterpret_cast<const u32*>(dlsym(m_Handle, "aria_native_api_version"));
+            const NativeApi** api = reinterpret_cast<const NativeApi**>(dlsym(m_Handle, "aria_native_api"));
+            const NativeFunction* functions = reinterpret_cast<const NativeFunction*>(dlsym(m_Handle, "aria_native_functions"));
+
+            if (!version || !api || !functions) {
+                error = "Not a native Aria module";
+                return false;
+            }
+
+            if (*version != NativeApiVersion) {
+                error = "Built against an incompatible version";
+                return false;
+            }
+
+            *api = GetNativeApi();
+
+            for (const NativeFunction* fn = functions; fn->Signature; fn++) {
+                m_Functions[fn->Signature] = fn->Function;
+            }
+
+            return true;
+        #else
+            error = "Native modules are not supported on this platform";
+            return false;
+        #endif
+    }
+
+    NativeModuleFn NativeLibrary::GetFunction(const std::string& signature) const {
+        auto it = m_Functions.find(signature);
+        return (it != m_Functions.end()) ? it->second : nullptr;
+    }
+
+} // namespace Aria::Internal
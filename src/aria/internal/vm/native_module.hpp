@@ -0,0 +1,75 @@
+#pragma once
+
+#include "aria/internal/types.hpp"
+
+#include <string>
+#include <unordered_map>
+
+namespace Aria::Internal {
+
+    // The interface between the VM and a module translated to C by CEmitter and built into a shared object
+    // The generated C declares the same structs (as AriaMemRef, AriaNativeApi and AriaNativeFunction), so any change here
+    // has to be made to the prelude in c_emitter.cpp as well, together with bumping the version
+    //
+    // The library exports:
+    // aria_native_api_version - u32, has to match NativeApiVersion
+    // aria_native_api         - const NativeApi*, set by the VM before anything runs
+    // aria_native_functions   - NativeFunction[], terminated by an entry without a signature
+    inline constexpr u32 NativeApiVersion = 1;
+
+    // Native code of a whole script function, the VM gets passed as vm
+    using NativeModuleFn = void(*)(void* vm);
+
+    // A MemRef, Global is nullptr for stack slots
+    struct NativeMemRef {
+        i32 Slot = 0;
+        size_t Size = 0;
+        size_t Offset = 0;
+        const char* Global = nullptr;
+    };
+
+    // Everything the generated code needs from the VM, all of it works on the regular VM stack
+    struct NativeApi {
+        void  (*Alloca)(void* vm, size_t size);
+        void  (*Push)(void* vm, const void* data, size_t size);
+        void* (*Address)(void* vm, const NativeMemRef* ref);
+        void  (*Copy)(void* vm, const NativeMemRef* dst, const NativeMemRef* src);
+        void  (*Dup)(void* vm, const NativeMemRef* ref);
+        void  (*PushStackFrame)(void* vm);
+        void  (*PopStackFrame)(void* vm);
+        void  (*Pop)(void* vm, i32 slot);
+        void  (*ReplaceStackFrame)(void* vm, size_t argCount, size_t retCount);
+        void  (*SetGlobal)(void* vm, const char* name);
+        void  (*CallExtern)(void* vm, const char* signature, size_t argCount, size_t retCount);
+    };
+
+    struct NativeFunction {
+        const char* Signature = nullptr;
+        NativeModuleFn Function = nullptr;
+    };
+
+    const NativeApi* GetNativeApi();
+
+    // A loaded shared object built from the output of CEmitter, see Context::LoadNative()
+    class NativeLibrary {
+    public:
+        NativeLibrary() = default;
+        ~NativeLibrary();
+
+        NativeLibrary(const NativeLibrary& other) = delete;
+        NativeLibrary(NativeLibrary&& other) = delete;
+        void operator=(const NativeLibrary& other) = delete;
+        void operator=(NativeLibrary&& other) = delete;
+
+        // Returns false and sets error if the library can't be loaded or was built against another version of the interface
+        bool Open(const std::string& path, std::string& error);
+
+        // nullptr if the library doesn't contain the function
+        NativeModuleFn GetFunction(const std::string& signature) const;
+
+    private:
+        void* m_Handle = nullptr;
+        std::unordered_map<std::string, NativeModuleFn> m_Functions;
+    };
+
+} // namespace Aria::Internal
@@ -91,6 +91,7 @@ namespace Aria::Internal {
 
         PushSF,
         PopSF,
+        Pop, // Pops the given stack slot of the active stack frame and everything above it
 
         LoadI8,
         LoadI16,
@@ -102,7 +103,7 @@ namespace Aria::Internal {
         LoadU64,
         LoadF32,
         LoadF64,
-        LoadStr,
+        LoadStr, // Pushes the handle of an interned literal, the characters never get copied
 
         SetGlobal,
         Function,
@@ -113,6 +114,7 @@ namespace Aria::Internal {
 
         Call,
         CallExtern,
+        TailCall, // Calls a function in place of the active one, which must take the same argument and return slots
         Ret,
 
         TYPED_OP(Negate)
@@ -244,6 +246,60 @@ namespace Aria::Internal {
         CastF64ToU64,
         CastF64ToF32,
         CastF64ToF64,
+
+        // Immediate forms, the right hand side is a constant stored in the op code instead of a stack slot
+        TYPED_OP(AddImm)
+        TYPED_OP(SubImm)
+        TYPED_OP(MulImm)
+        TYPED_OP(DivImm)
+        TYPED_OP(ModImm)
+
+        TYPED_OP(CmpImm)
+        TYPED_OP(NcmpImm)
+        TYPED_OP(LtImm)
+        TYPED_OP(LteImm)
+        TYPED_OP(GtImm)
+        TYPED_OP(GteImm)
+
+        TYPED_OP(StoreImm) // Writes the constant into the given memory without pushing anything
+
+        // Fused compare and branch, jumps if the comparison holds without pushing its result
+        TYPED_OP(Jcmp)
+        TYPED_OP(Jncmp)
+        TYPED_OP(Jlt)
+        TYPED_OP(Jlte)
+        TYPED_OP(Jgt)
+        TYPED_OP(Jgte)
+
+        TYPED_OP(JcmpImm)
+        TYPED_OP(JncmpImm)
+        TYPED_OP(JltImm)
+        TYPED_OP(JlteImm)
+        TYPED_OP(JgtImm)
+        TYPED_OP(JgteImm)
+
+        // Arrays, the element type is part of the op code so none of them go through an extern call
+        ArrayNew, // Pushes a new empty array
+        ArrayLength, // Pushes the element count as an int
+        ArrayReserve, // Makes room for IndexMem elements without changing the length
+
+        TYPED_OP(ArrayLoad) // Pushes the element at IndexMem
+        TYPED_OP(ArrayStore) // Writes ValueMem into the element at IndexMem
+        TYPED_OP(ArrayAppend) // Adds ValueMem to the end of the array
+
+        ArrayShrinkToFit, // Gives back the capacity the elements don't use
+        ArrayClear, // Drops every element, the capacity stays
+
+        // Strings are handles to immutable strings owned by the VM (see String), they all take an OpCodeMath
+        StrConcat, // Pushes a new string holding LHSMem followed by RHSMem
+        StrCmp, // The comparisons push a bool, strings are ordered by their bytes
+        StrNcmp,
+        StrLt,
+        StrLte,
+        StrGt,
+        StrGte,
+        StrLength, // Pushes the byte count of LHSMem as an int
+        StrHash, // Pushes the hash of LHSMem as a ulong
     };
 
     #undef TYPED_OP
@@ -265,12 +321,24 @@ namespace Aria::Internal {
 
     struct OpCodeSetGlobal {
         std::string Name;
-        MemRef Mem;
+        MemRef Mem{};
     };
 
+    // A constant of one of the primitive types, in the same order as OpCodeLoad::Data
+    using ImmediateValue = std::variant<i8, u8, i16, u16, i32, u32, i64, u64, f32, f64>;
+
+    // Used by jt, jf, jmp (which ignores Mem) and the fused compare and branch op codes
+    // Those compare Mem against RHSMem, their immediate forms against Value
     struct OpCodeConditionalJump {
         MemRef Mem{};
         std::string Label;
+
+        // Once resolved, the index the program counter gets set to (the op code right before the target, where the label would be)
+        // Jumps that have a target don't need their label to be in the byte code anymore
+        size_t Target = SIZE_MAX;
+
+        MemRef RHSMem{};
+        ImmediateValue Value{};
     };
 
     struct OpCodeCall {
@@ -291,9 +359,34 @@ namespace Aria::Internal {
         TypeInfo* ResolvedType = nullptr;
     };
 
+    // Used by the immediate op codes, Mem is the left hand side (or the destination of storeimm)
+    struct OpCodeImmediate {
+        MemRef Mem{};
+        ImmediateValue Value;
+        TypeInfo* ResolvedType = nullptr;
+    };
+
+    // Used by the array op codes, Mem is the array itself
+    // IndexMem holds the (int) index, or the capacity for arrayreserve, and ValueMem the element to store or append
+    struct OpCodeArray {
+        MemRef Mem{};
+        MemRef IndexMem{};
+        MemRef ValueMem{};
+
+        size_t ElementSize = 0;
+        TypeInfo* ResolvedType = nullptr; // The type of the element (or of the array for arraynew)
+    };
+
+    // Every op code that can change the program counter within its function, they all carry an OpCodeConditionalJump
+    inline bool IsJumpOpCode(OpCodeType type) {
+        if (type == OpCodeType::Jmp || type == OpCodeType::Jt || type == OpCodeType::Jf) { return true; }
+
+        return type >= OpCodeType::JcmpI8 && type <= OpCodeType::JgteImmF64;
+    }
+
     struct OpCode {
         OpCodeType Type = OpCodeType::Nop;
-        std::variant<MemRef, std::string, OpCodeAlloca, OpCodeCopy, OpCodeLoad, OpCodeSetGlobal, OpCodeConditionalJump, OpCodeCall, OpCodeMath, OpCodeCast> Data;
+        std::variant<MemRef, std::string, OpCodeAlloca, OpCodeCopy, OpCodeLoad, OpCodeSetGlobal, OpCodeConditionalJump, OpCodeCall, OpCodeMath, OpCodeCast, OpCodeImmediate, OpCodeArray> Data;
         std::string DebugData; // Optional debug data the compiler can provide
     };
 
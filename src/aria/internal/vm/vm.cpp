@@ -1,46 +1,11 @@
 #include "aria/internal/vm/vm.hpp"
+#include "aria/internal/vm/arithmetic.hpp"
 #include "aria/context.hpp"
 
 namespace Aria::Internal {
 
-    template <typename T>
-    T Add(T lhs, T rhs) { return lhs + rhs; }
-    template <typename T>
-    T Sub(T lhs, T rhs) { return lhs - rhs; }
-    template <typename T>
-    T Mul(T lhs, T rhs) { return lhs * rhs; }
-    template <typename T>
-    T Div(T lhs, T rhs) { return lhs / rhs; }
-    template <std::integral T>
-    T Mod(T lhs, T rhs) { return lhs % rhs; }
-    template <std::floating_point T>
-    T Mod(T lhs, T rhs) {
-        T r = std::fmod(lhs, rhs);
-        if (r < 0) { r += std::abs(rhs); }
-        return r;
-    }
-
-    template <typename T>
-    T And(T lhs, T rhs) { return lhs & rhs; }
-    template <typename T>
-    T Or(T lhs, T rhs) { return lhs | rhs; }
-    template <typename T>
-    T Xor(T lhs, T rhs) { return lhs ^ rhs; }
-
-    template <typename T>
-    T Cmp(T lhs, T rhs) { return lhs == rhs; }
-    template <typename T>
-    T Ncmp(T lhs, T rhs) { return lhs != rhs; }
-    template <typename T>
-    T Lt(T lhs, T rhs) { return lhs < rhs; }
-    template <typename T>
-    T Lte(T lhs, T rhs) { return lhs <= rhs; }
-    template <typename T>
-    T Gt(T lhs, T rhs) { return lhs > rhs; }
-    template <typename T>
-    T Gte(T lhs, T rhs) { return lhs >= rhs; }
-
-    VM::VM(Context* ctx) {
+    VM::VM(Context* ctx)
+        : m_Heap(std::make_unique<ScriptHeap>()), m_Arrays(m_Heap.get()), m_Strings(m_Heap.get()) {
         m_Stack.resize(4 * 1024 * 1024); // 4MB stack by default
         m_StackSlots.resize(1024); // 1024 slots by default
 
@@ -51,7 +16,7 @@ namespace Aria::Internal {
         size_t alignedSize = ((size + 8 - 1) / 8) * 8; // We need to handle 8 byte alignment since some CPU's will require it
         
         ARIA_ASSERT(alignedSize % 8 == 0, "Memory not aligned to 8 bytes correctly!");
-        ARIA_ASSERT(m_StackPointer + alignedSize < m_Stack.max_size(), "Stack overflow, allocating an insane amount of memory!");
+        ARIA_ASSERT(m_StackPointer + alignedSize <= m_Stack.size(), "Stack overflow, allocating an insane amount of memory!");
 
         m_StackPointer += alignedSize;
 
@@ -99,10 +64,99 @@ namespace Aria::Internal {
         m_StackFrames.pop_back();
     }
 
+    void VM::Pop(i32 slot) {
+        int32_t index = static_cast<int32_t>(m_StackFrames.back().SlotOffset) + slot;
+        if (index >= m_StackSlotPointer) { return; }
+
+        m_StackPointer = m_StackSlots[index].Index;
+        m_StackSlotPointer = index;
+    }
+
+    void VM::ReplaceStackFrame(size_t argCount, size_t retCount) {
+        size_t firstArg = m_StackFrames.back().SlotOffset - retCount - argCount;
+        size_t firstNewArg = m_StackSlotPointer - argCount;
+
+        for (size_t i = 0; i < argCount; i++) {
+            const StackSlot& dst = m_StackSlots[firstArg + i];
+            const StackSlot& src = m_StackSlots[firstNewArg + i];
+
+            ARIA_ASSERT(dst.Size == src.Size, "Tail call with different argument slots!");
+            memcpy(&m_Stack[dst.Index], &m_Stack[src.Index], dst.Size);
+        }
+
+        PopStackFrame();
+    }
+
     void VM::AddExtern(const std::string& signature, ExternFn fn) {
         m_ExternalFunctions[signature] = fn;
     }
 
+    void VM::PreserveGlobals(const std::vector<std::string>& globals) {
+        m_PreservedGlobals.insert(globals.begin(), globals.end());
+    }
+
+    void VM::SetGlobal(const std::string& name) {
+        auto it = m_GlobalMap.find(name);
+        if (it != m_GlobalMap.end() && m_PreservedGlobals.contains(name)) { return; }
+
+        const StackSlot& top = m_StackSlots[m_StackSlotPointer - 1];
+
+        // Running the module again reuses the memory of the global, only a global that changed its size (hot reloading) gets a new home
+        if (it == m_GlobalMap.end() || it->second.Size != top.Size) {
+            size_t alignedSize = ((top.Size + 8 - 1) / 8) * 8;
+            StackSlot slot = { m_GlobalMemory.size(), top.Size };
+            m_GlobalMemory.resize(m_GlobalMemory.size() + alignedSize);
+
+            it = m_GlobalMap.insert_or_assign(name, slot).first;
+        }
+
+        memcpy(&m_GlobalMemory[it->second.Index], &m_Stack[top.Index], top.Size);
+    }
+
+    void VM::RemoveGlobal(const std::string& name) {
+        m_GlobalMap.erase(name);
+    }
+
+    void VM::BeginInvocationArena() {
+        m_Arrays.BeginArena();
+        m_Heap->SetArenaActive(true);
+    }
+
+    void VM::EndInvocationArena() {
+        m_Heap->SetArenaActive(false);
+        m_Arrays.EndArena();
+
+        // The arena is still intact at this point, only new allocations go to the heap again
+        for (const auto& [name, type] : m_PersistentGlobals) {
+            auto it = m_GlobalMap.find(name);
+            if (it == m_GlobalMap.end()) { continue; }
+
+            void** handle = reinterpret_cast<void**>(m_GlobalMemory.data() + it->second.Index);
+            if (!*handle || !m_Heap->IsArenaMemory(*handle)) { continue; }
+
+            switch (type) {
+                case PersistentType::Array:  *handle = m_Arrays.Persist(reinterpret_cast<Array*>(*handle)); break;
+                case PersistentType::String: *handle = m_Strings.Create(GetStringView(reinterpret_cast<String*>(*handle))); break;
+            }
+
+            m_Heap->RecordPersistedObject();
+        }
+
+        m_Heap->ResetArena();
+    }
+
+    void VM::PersistGlobal(const std::string& name, PersistentType type) {
+        m_PersistentGlobals[name] = type;
+    }
+
+    void VM::SetLazyCompilationContext(CompilationContext* ctx) {
+        m_LazyCompilationContext = ctx;
+    }
+
+    void VM::SetJitThreshold(size_t threshold) {
+        m_JitThreshold = threshold;
+    }
+
     void VM::Call(int32_t label) {
         ARIA_ASSERT(false, "todo: VM::Call()");
         // // Perform a jump
@@ -287,20 +341,64 @@ namespace Aria::Internal {
     }
 
     void VM::RunByteCode(const OpCode* data, size_t count) {
-        m_Program = data;
-        m_ProgramSize = count;
+        // Running the same program again keeps its functions, along with their native code, call counts and feedback
+        // A reload hands over different byte code, and lazy code generation only ever moves m_Program itself
+        if (data != m_Program || count != m_ProgramSize) {
+            m_Program = data;
+            m_ProgramSize = count;
 
-        RunPrepass();
+            RunPrepass();
+        }
+
+        ResetStack();
 
         const std::string& signature = "_start$()";
 
         ARIA_ASSERT(m_Functions.contains(signature), "Byte code does not contain _start$() function");
         VMFunction& func = m_Functions.at(signature);
+        RecordInvocation(func);
+
+        // The top level code only ever runs once so it is always interpreted
+        if (m_JitThreshold == 0) {
+            for (auto& [sig, fn] : m_Functions) {
+                if (&fn != &func) { CompileNative(fn); }
+            }
+        }
 
-        // Perform a jump to the function
-        ARIA_ASSERT(func.Labels.contains("_entry$"), "_start$() function doesn't contain a \"_entry$\" label");
-        m_ProgramCounter = func.Labels.at("_entry$");
+        // Perform a jump to the function, the entry itself is either a label or the function op code so it gets skipped
+        m_ProgramCounter = func.Entry + 1;
+        m_ActiveFunction = &func;
         Run();
+
+        m_PreservedGlobals.clear();
+    }
+
+    void VM::RunNative(NativeModuleFn start) {
+        // The functions of a native module call each other directly, so the VM doesn't track any of them
+        m_Program = nullptr;
+        m_ProgramSize = 0;
+        m_ProgramCounter = 0;
+        m_Functions.clear();
+        m_CallTargets.clear();
+        m_Jit.Reset();
+
+        #ifdef ARIA_FEEDBACK
+            m_Feedback.Clear();
+        #endif
+
+        ResetStack();
+
+        m_ReturnAddress = SIZE_MAX;
+        m_ActiveFunction = nullptr;
+        start(this);
+
+        m_PreservedGlobals.clear();
+    }
+
+    void VM::ResetStack() {
+        m_StackPointer = 0;
+        m_StackSlotPointer = 0;
+        m_StackFrames.clear();
     }
 
     void VM::Run() {
@@ -395,6 +493,151 @@ namespace Aria::Internal {
             CASE_BINEXPR_BOOL(mathop##F32, float,    op) \
             CASE_BINEXPR_BOOL(mathop##F64, double,   op)
 
+        #define CASE_IMMEXPR(_enum, builtinType, builtinOp) case OpCodeType::_enum: { \
+            const OpCodeImmediate& m = std::get<OpCodeImmediate>(op.Data); \
+            builtinType lhs{}; \
+            memcpy(&lhs, GetVMSlice(m.Mem).Memory, sizeof(builtinType)); \
+            builtinType result = builtinOp(lhs, std::get<builtinType>(m.Value)); \
+            Alloca(sizeof(builtinType), m.ResolvedType); \
+            VMSlice s = GetVMSlice({ StackSlotRef(-1, sizeof(builtinType)) }); \
+            memcpy(s.Memory, &result, sizeof(builtinType)); \
+            break; \
+        }
+
+        #define CASE_IMMEXPR_BOOL(_enum, builtinType, builtinOp) case OpCodeType::_enum: { \
+            const OpCodeImmediate& m = std::get<OpCodeImmediate>(op.Data); \
+            builtinType lhs{}; \
+            memcpy(&lhs, GetVMSlice(m.Mem).Memory, sizeof(builtinType)); \
+            bool result = builtinOp(lhs, std::get<builtinType>(m.Value)); \
+            Alloca(1, m.ResolvedType); \
+            VMSlice s = GetVMSlice({ StackSlotRef(-1, 1) }); \
+            memcpy(s.Memory, &result, 1); \
+            break; \
+        }
+
+        #define CASE_STOREIMM(_enum, builtinType) case OpCodeType::_enum: { \
+            const OpCodeImmediate& m = std::get<OpCodeImmediate>(op.Data); \
+            memcpy(GetVMSlice(m.Mem).Memory, &std::get<builtinType>(m.Value), sizeof(builtinType)); \
+            break; \
+        }
+
+        #define CASE_IMMEXPR_GROUP(mathop, op) \
+            CASE_IMMEXPR(mathop##I8,  int8_t,   op) \
+            CASE_IMMEXPR(mathop##I16, int16_t,  op) \
+            CASE_IMMEXPR(mathop##I32, int32_t,  op) \
+            CASE_IMMEXPR(mathop##I64, int64_t,  op) \
+            CASE_IMMEXPR(mathop##U8,  uint8_t,  op) \
+            CASE_IMMEXPR(mathop##U16, uint16_t, op) \
+            CASE_IMMEXPR(mathop##U32, uint32_t, op) \
+            CASE_IMMEXPR(mathop##U64, uint64_t, op) \
+            CASE_IMMEXPR(mathop##F32, float,    op) \
+            CASE_IMMEXPR(mathop##F64, double,   op)
+
+        #define CASE_IMMEXPR_BOOL_GROUP(mathop, op) \
+            CASE_IMMEXPR_BOOL(mathop##I8,  int8_t,   op) \
+            CASE_IMMEXPR_BOOL(mathop##I16, int16_t,  op) \
+            CASE_IMMEXPR_BOOL(mathop##I32, int32_t,  op) \
+            CASE_IMMEXPR_BOOL(mathop##I64, int64_t,  op) \
+            CASE_IMMEXPR_BOOL(mathop##U8,  uint8_t,  op) \
+            CASE_IMMEXPR_BOOL(mathop##U16, uint16_t, op) \
+            CASE_IMMEXPR_BOOL(mathop##U32, uint32_t, op) \
+            CASE_IMMEXPR_BOOL(mathop##U64, uint64_t, op) \
+            CASE_IMMEXPR_BOOL(mathop##F32, float,    op) \
+            CASE_IMMEXPR_BOOL(mathop##F64, double,   op)
+
+        #define CASE_STOREIMM_GROUP() \
+            CASE_STOREIMM(StoreImmI8,  int8_t) \
+            CASE_STOREIMM(StoreImmI16, int16_t) \
+            CASE_STOREIMM(StoreImmI32, int32_t) \
+            CASE_STOREIMM(StoreImmI64, int64_t) \
+            CASE_STOREIMM(StoreImmU8,  uint8_t) \
+            CASE_STOREIMM(StoreImmU16, uint16_t) \
+            CASE_STOREIMM(StoreImmU32, uint32_t) \
+            CASE_STOREIMM(StoreImmU64, uint64_t) \
+            CASE_STOREIMM(StoreImmF32, float) \
+            CASE_STOREIMM(StoreImmF64, double)
+
+        // The comparison result never gets pushed, it only decides whether to jump
+        #define CASE_CMPJUMP(_enum, builtinType, builtinOp) case OpCodeType::_enum: { \
+            const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data); \
+            builtinType lhs{}; \
+            builtinType rhs{}; \
+            memcpy(&lhs, GetVMSlice(jump.Mem).Memory, sizeof(builtinType)); \
+            memcpy(&rhs, GetVMSlice(jump.RHSMem).Memory, sizeof(builtinType)); \
+            bool taken = builtinOp(lhs, rhs); \
+            RecordBranch(m_ProgramCounter, taken); \
+            if (taken) { m_ProgramCounter = GetJumpTarget(jump); } \
+            break; \
+        }
+
+        #define CASE_CMPJUMP_IMM(_enum, builtinType, builtinOp) case OpCodeType::_enum: { \
+            const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data); \
+            builtinType lhs{}; \
+            memcpy(&lhs, GetVMSlice(jump.Mem).Memory, sizeof(builtinType)); \
+            bool taken = builtinOp(lhs, std::get<builtinType>(jump.Value)); \
+            RecordBranch(m_ProgramCounter, taken); \
+            if (taken) { m_ProgramCounter = GetJumpTarget(jump); } \
+            break; \
+        }
+
+        #define CASE_CMPJUMP_GROUP(jumpop, op) \
+            CASE_CMPJUMP(jumpop##I8,  int8_t,   op) \
+            CASE_CMPJUMP(jumpop##I16, int16_t,  op) \
+            CASE_CMPJUMP(jumpop##I32, int32_t,  op) \
+            CASE_CMPJUMP(jumpop##I64, int64_t,  op) \
+            CASE_CMPJUMP(jumpop##U8,  uint8_t,  op) \
+            CASE_CMPJUMP(jumpop##U16, uint16_t, op) \
+            CASE_CMPJUMP(jumpop##U32, uint32_t, op) \
+            CASE_CMPJUMP(jumpop##U64, uint64_t, op) \
+            CASE_CMPJUMP(jumpop##F32, float,    op) \
+            CASE_CMPJUMP(jumpop##F64, double,   op)
+
+        #define CASE_CMPJUMP_IMM_GROUP(jumpop, op) \
+            CASE_CMPJUMP_IMM(jumpop##I8,  int8_t,   op) \
+            CASE_CMPJUMP_IMM(jumpop##I16, int16_t,  op) \
+            CASE_CMPJUMP_IMM(jumpop##I32, int32_t,  op) \
+            CASE_CMPJUMP_IMM(jumpop##I64, int64_t,  op) \
+            CASE_CMPJUMP_IMM(jumpop##U8,  uint8_t,  op) \
+            CASE_CMPJUMP_IMM(jumpop##U16, uint16_t, op) \
+            CASE_CMPJUMP_IMM(jumpop##U32, uint32_t, op) \
+            CASE_CMPJUMP_IMM(jumpop##U64, uint64_t, op) \
+            CASE_CMPJUMP_IMM(jumpop##F32, float,    op) \
+            CASE_CMPJUMP_IMM(jumpop##F64, double,   op)
+
+        // Out of bounds loads push a zeroed element after reporting the error, out of bounds stores do nothing
+        #define CASE_ARRAYLOAD(_enum, builtinType) case OpCodeType::_enum: { \
+            const OpCodeArray& arr = std::get<OpCodeArray>(op.Data); \
+            builtinType value{}; \
+            if (u8* element = GetArrayElement(arr)) { memcpy(&value, element, sizeof(builtinType)); } \
+            Alloca(sizeof(builtinType), arr.ResolvedType); \
+            memcpy(GetVMSlice({ StackSlotRef(-1, sizeof(builtinType)) }).Memory, &value, sizeof(builtinType)); \
+            break; \
+        }
+
+        #define CASE_ARRAYSTORE(_enum, builtinType) case OpCodeType::_enum: { \
+            const OpCodeArray& arr = std::get<OpCodeArray>(op.Data); \
+            if (u8* element = GetArrayElement(arr)) { memcpy(element, GetVMSlice(arr.ValueMem).Memory, sizeof(builtinType)); } \
+            break; \
+        }
+
+        #define CASE_ARRAYAPPEND(_enum, builtinType) case OpCodeType::_enum: { \
+            const OpCodeArray& arr = std::get<OpCodeArray>(op.Data); \
+            memcpy(m_Arrays.Append(GetArray(arr.Mem)), GetVMSlice(arr.ValueMem).Memory, sizeof(builtinType)); \
+            break; \
+        }
+
+        #define CASE_ARRAY_GROUP(arrayop, _case) \
+            _case(arrayop##I8,  int8_t) \
+            _case(arrayop##I16, int16_t) \
+            _case(arrayop##I32, int32_t) \
+            _case(arrayop##I64, int64_t) \
+            _case(arrayop##U8,  uint8_t) \
+            _case(arrayop##U16, uint16_t) \
+            _case(arrayop##U32, uint32_t) \
+            _case(arrayop##U64, uint64_t) \
+            _case(arrayop##F32, float) \
+            _case(arrayop##F64, double)
+
         #define CASE_CAST(_enum, sourceType, destType) case OpCodeType::_enum: { \
             OpCodeCast cast = std::get<OpCodeCast>(op.Data); \
             VMSlice s = GetVMSlice(cast.Mem); \
@@ -454,6 +697,12 @@ namespace Aria::Internal {
                     break;
                 }
 
+                case OpCodeType::Pop: {
+                    MemRef mem = std::get<MemRef>(op.Data);
+                    Pop(mem.GetStackSlot().Slot);
+                    break;
+                }
+
                 CASE_LOAD(LoadI8,  i8)
                 CASE_LOAD(LoadI16, i16)
                 CASE_LOAD(LoadI32, i32)
@@ -467,16 +716,12 @@ namespace Aria::Internal {
                 CASE_LOAD(LoadF32, f32)
                 CASE_LOAD(LoadF64, f64)
                 case OpCodeType::LoadStr: {
-                    OpCodeLoad l = std::get<OpCodeLoad>(op.Data);
-                    StringView str = std::get<StringView>(l.Data);
-                    Alloca(str.Size(), l.ResolvedType);
-                    memcpy(GetVMSlice({ StackSlotRef(-1, str.Size()) }).Memory, str.Data(), str.Size());
+                    LoadStr(m_ProgramCounter, std::get<OpCodeLoad>(op.Data).ResolvedType);
                     break;
                 }
 
                 case OpCodeType::SetGlobal: {
-                    const OpCodeSetGlobal& g = std::get<OpCodeSetGlobal>(op.Data);
-                    m_GlobalMap[g.Name] = { m_StackSlots[m_StackSlotPointer - 1].Index, m_StackSlots[m_StackSlotPointer - 1].Size };
+                    SetGlobal(std::get<OpCodeSetGlobal>(op.Data).Name);
                     break;
                 };
 
@@ -484,31 +729,33 @@ namespace Aria::Internal {
                 case OpCodeType::Label: break; // We just keep going
 
                 case OpCodeType::Jmp: {
-                    const std::string& labelIdentifier = std::get<std::string>(op.Data);
-
-                    ARIA_ASSERT(m_ActiveFunction->Labels.contains(labelIdentifier), "Trying to jump to an unknown label!");
-                    m_ProgramCounter = m_ActiveFunction->Labels.at(labelIdentifier);
+                    const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
+                    m_ProgramCounter = GetJumpTarget(jump);
 
                     break;
                 }
 
                 case OpCodeType::Jt: {
-                    OpCodeConditionalJump jump = std::get<OpCodeConditionalJump>(op.Data);
+                    const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
+
+                    bool taken = GetBool(jump.Mem) == true;
+                    RecordBranch(m_ProgramCounter, taken);
 
-                    if (GetBool(jump.Mem) == true) {
-                        ARIA_ASSERT(m_ActiveFunction->Labels.contains(jump.Label), "Trying to jump to an unknown label!");
-                        m_ProgramCounter = m_ActiveFunction->Labels.at(jump.Label);
+                    if (taken) {
+                        m_ProgramCounter = GetJumpTarget(jump);
                     }
 
                     break;
                 }
 
                 case OpCodeType::Jf: {
-                    OpCodeConditionalJump jump = std::get<OpCodeConditionalJump>(op.Data);
+                    const OpCodeConditionalJump& jump = std::get<OpCodeConditionalJump>(op.Data);
 
-                    if (GetBool(jump.Mem) == false) {
-                        ARIA_ASSERT(m_ActiveFunction->Labels.contains(jump.Label), "Trying to jump to an unknown label!");
-                        m_ProgramCounter = m_ActiveFunction->Labels.at(jump.Label);
+                    bool taken = GetBool(jump.Mem) == false;
+                    RecordBranch(m_ProgramCounter, taken);
+
+                    if (taken) {
+                        m_ProgramCounter = GetJumpTarget(jump);
                     }
 
                     break;
@@ -518,21 +765,51 @@ namespace Aria::Internal {
                     const OpCodeCall& call = std::get<OpCodeCall>(op.Data);
 
                     ARIA_ASSERT(call.Function.ContainsFunction(), "todo");
-                    const std::string& sig = call.Function.GetFunction().Signature;
+                    RecordCall(m_ProgramCounter);
+
+                    // NOTE: Emitting a function can reallocate the program, so nothing from op may be used after this
+                    VMFunction& func = *GetCallTarget(m_ProgramCounter);
+
+                    // Native code returns once the function is done, so the loop simply continues after the call
+                    if (NativeFn native = GetNativeCode(func)) {
+                        native(this);
+                        break;
+                    }
 
                     // Save the state in the current stack frame
                     m_StackFrames.back().PreviousReturnAddress = m_ReturnAddress;
                     m_StackFrames.back().PreviousFunction = m_ActiveFunction;
 
-                    m_ReturnAddress = m_ProgramCounter + 1;
-
-                    ARIA_ASSERT(m_Functions.contains(sig), "Calling unknown function");
-                    VMFunction& func = m_Functions.at(sig);
+                    m_ReturnAddress = m_ProgramCounter; // The loop increments the program counter past the call after returning
 
                     // Perform a jump to the function
-                    ARIA_ASSERT(func.Labels.contains("_entry$"), "All functions must contain a \"_entry$\" label");
-                    m_ProgramCounter = func.Labels.at("_entry$");
+                    m_ProgramCounter = func.Entry;
+                    m_ActiveFunction = &func;
+
+                    break;
+                }
+
+                case OpCodeType::TailCall: {
+                    const OpCodeCall& call = std::get<OpCodeCall>(op.Data);
+
+                    ARIA_ASSERT(call.Function.ContainsFunction(), "todo");
+                    RecordCall(m_ProgramCounter);
+
+                    // The return address and the previous function stay the ones of the function being replaced
+                    ReplaceStackFrame(call.ArgCount, call.RetCount);
+
+                    // NOTE: Emitting a function can reallocate the program, so nothing from op may be used after this
+                    VMFunction* fn = GetCallTarget(m_ProgramCounter);
+
+                    // The native code finishes the function, so what is left is returning out of the replaced one
+                    if (NativeFn native = GetNativeCode(*fn)) {
+                        native(this);
+                        Return();
+                        break;
+                    }
 
+                    m_ProgramCounter = fn->Entry;
+                    m_ActiveFunction = fn;
                     break;
                 }
 
@@ -541,26 +818,18 @@ namespace Aria::Internal {
 
                     ARIA_ASSERT(call.Function.ContainsFunction(), "todo");
                     const std::string& sig = call.Function.GetFunction().Signature;
+                    RecordCall(m_ProgramCounter);
 
                     CallExtern(sig, call.ArgCount, call.RetCount);
                     break;
                 }
 
                 case OpCodeType::Ret: {
-                    ARIA_ASSERT(m_StackFrames.size() > 0, "Trying to return out of no stack frame!");
-
-                    if (m_ReturnAddress == SIZE_MAX) {
-                        StopExecution();
-                    } else {
-                        m_ProgramCounter = m_ReturnAddress;
-                    }
-
-                    m_ReturnAddress = m_StackFrames.back().PreviousReturnAddress;
-                    m_ActiveFunction = m_StackFrames.back().PreviousFunction;
+                    Return();
                     break;
                 }
 
-                CASE_UNARYEXPR_GROUP(Negate, -);
+                CASE_UNARYEXPR_GROUP(Negate, Negate);
 
                 CASE_BINEXPR_GROUP(Add, Add)
                 CASE_BINEXPR_GROUP(Sub, Sub)
@@ -589,6 +858,90 @@ namespace Aria::Internal {
                 CASE_CAST_GROUP(U64, uint64_t)
                 CASE_CAST_GROUP(F32, float)
                 CASE_CAST_GROUP(F64, double)
+
+                CASE_IMMEXPR_GROUP(AddImm, Add)
+                CASE_IMMEXPR_GROUP(SubImm, Sub)
+                CASE_IMMEXPR_GROUP(MulImm, Mul)
+                CASE_IMMEXPR_GROUP(DivImm, Div)
+                CASE_IMMEXPR_GROUP(ModImm, Mod)
+
+                CASE_IMMEXPR_BOOL_GROUP(CmpImm, Cmp)
+                CASE_IMMEXPR_BOOL_GROUP(NcmpImm, Ncmp)
+                CASE_IMMEXPR_BOOL_GROUP(LtImm, Lt)
+                CASE_IMMEXPR_BOOL_GROUP(LteImm, Lte)
+                CASE_IMMEXPR_BOOL_GROUP(GtImm, Gt)
+                CASE_IMMEXPR_BOOL_GROUP(GteImm, Gte)
+
+                CASE_STOREIMM_GROUP()
+
+                CASE_CMPJUMP_GROUP(Jcmp, Cmp)
+                CASE_CMPJUMP_GROUP(Jncmp, Ncmp)
+                CASE_CMPJUMP_GROUP(Jlt, Lt)
+                CASE_CMPJUMP_GROUP(Jlte, Lte)
+                CASE_CMPJUMP_GROUP(Jgt, Gt)
+                CASE_CMPJUMP_GROUP(Jgte, Gte)
+
+                CASE_CMPJUMP_IMM_GROUP(JcmpImm, Cmp)
+                CASE_CMPJUMP_IMM_GROUP(JncmpImm, Ncmp)
+                CASE_CMPJUMP_IMM_GROUP(JltImm, Lt)
+                CASE_CMPJUMP_IMM_GROUP(JlteImm, Lte)
+                CASE_CMPJUMP_IMM_GROUP(JgtImm, Gt)
+                CASE_CMPJUMP_IMM_GROUP(JgteImm, Gte)
+
+                case OpCodeType::ArrayNew: {
+                    ArrayNew(std::get<OpCodeArray>(op.Data));
+                    break;
+                }
+
+                case OpCodeType::ArrayLength: {
+                    const OpCodeArray& arr = std::get<OpCodeArray>(op.Data);
+                    i32 length = GetArray(arr.Mem)->Size;
+
+                    Alloca(sizeof(i32), arr.ResolvedType);
+                    memcpy(GetVMSlice({ StackSlotRef(-1, sizeof(i32)) }).Memory, &length, sizeof(i32));
+                    break;
+                }
+
+                case OpCodeType::ArrayReserve: {
+                    const OpCodeArray& arr = std::get<OpCodeArray>(op.Data);
+                    m_Arrays.Reserve(GetArray(arr.Mem), GetInt(arr.IndexMem));
+                    break;
+                }
+
+                case OpCodeType::ArrayShrinkToFit: {
+                    m_Arrays.ShrinkToFit(GetArray(std::get<OpCodeArray>(op.Data).Mem));
+                    break;
+                }
+
+                case OpCodeType::ArrayClear: {
+                    m_Arrays.Clear(GetArray(std::get<OpCodeArray>(op.Data).Mem));
+                    break;
+                }
+
+                CASE_ARRAY_GROUP(ArrayLoad, CASE_ARRAYLOAD)
+                CASE_ARRAY_GROUP(ArrayStore, CASE_ARRAYSTORE)
+                CASE_ARRAY_GROUP(ArrayAppend, CASE_ARRAYAPPEND)
+
+                case OpCodeType::StrConcat:
+                case OpCodeType::StrCmp:
+                case OpCodeType::StrNcmp:
+                case OpCodeType::StrLt:
+                case OpCodeType::StrLte:
+                case OpCodeType::StrGt:
+                case OpCodeType::StrGte: {
+                    StringBinary(op.Type, std::get<OpCodeMath>(op.Data));
+                    break;
+                }
+
+                case OpCodeType::StrLength: {
+                    StringLength(std::get<OpCodeMath>(op.Data));
+                    break;
+                }
+
+                case OpCodeType::StrHash: {
+                    StringHash(std::get<OpCodeMath>(op.Data));
+                    break;
+                }
             }
         }
 
@@ -596,6 +949,20 @@ namespace Aria::Internal {
         #undef CASE_UNARYEXPR_GROUP
         #undef CASE_BINEXPR
         #undef CASE_BINEXPR_GROUP
+        #undef CASE_IMMEXPR
+        #undef CASE_IMMEXPR_BOOL
+        #undef CASE_STOREIMM
+        #undef CASE_IMMEXPR_GROUP
+        #undef CASE_IMMEXPR_BOOL_GROUP
+        #undef CASE_STOREIMM_GROUP
+        #undef CASE_CMPJUMP
+        #undef CASE_CMPJUMP_IMM
+        #undef CASE_CMPJUMP_GROUP
+        #undef CASE_CMPJUMP_IMM_GROUP
+        #undef CASE_ARRAYLOAD
+        #undef CASE_ARRAYSTORE
+        #undef CASE_ARRAYAPPEND
+        #undef CASE_ARRAY_GROUP
         #undef CASE_CAST
         #undef CASE_CAST_GROUP
     }
@@ -619,25 +986,231 @@ namespace Aria::Internal {
             const GlobalVarRef& ref = mem.GetGlobalVar();
             ARIA_ASSERT(m_GlobalMap.contains(ref.Name), "Unknown global identifier!");
             StackSlot slot = m_GlobalMap.at(ref.Name);
-            return VMSlice(&m_Stack[slot.Index], slot.Size);
+            return VMSlice(&m_GlobalMemory[slot.Index], slot.Size);
         }
 
         ARIA_UNREACHABLE();
     }
 
+    size_t VM::GetJumpTarget(const OpCodeConditionalJump& jump) {
+        if (jump.Target != SIZE_MAX) { return jump.Target; }
+
+        ARIA_ASSERT(m_ActiveFunction->Labels.contains(jump.Label), "Trying to jump to an unknown label!");
+        return m_ActiveFunction->Labels.at(jump.Label);
+    }
+
+    void VM::Return() {
+        ARIA_ASSERT(m_StackFrames.size() > 0, "Trying to return out of no stack frame!");
+
+        if (m_ReturnAddress == SIZE_MAX) {
+            StopExecution();
+        } else {
+            m_ProgramCounter = m_ReturnAddress;
+        }
+
+        m_ReturnAddress = m_StackFrames.back().PreviousReturnAddress;
+        m_ActiveFunction = m_StackFrames.back().PreviousFunction;
+    }
+
+    VMFunction* VM::GetFunction(const std::string& signature) {
+        auto it = m_Functions.find(signature);
+        return (it != m_Functions.end()) ? &it->second : ResolveLazyFunction(signature);
+    }
+
+    VMFunction* VM::GetCallTarget(size_t pc) {
+        if (VMFunction* fn = m_CallTargets[pc]) { return fn; }
+
+        // A callee that is emitted lazily only shows up in m_Functions once it gets called
+        VMFunction* fn = GetFunction(std::get<OpCodeCall>(m_Program[pc].Data).Function.GetFunction().Signature);
+        ARIA_ASSERT(fn, "Calling unknown function");
+
+        m_CallTargets[pc] = fn;
+        return fn;
+    }
+
+    NativeFn VM::GetNativeCode(VMFunction& fn) {
+        RecordInvocation(fn);
+
+        if (m_JitThreshold == SIZE_MAX) { return nullptr; } // Native code kept from an earlier run must not be used either
+        if (fn.NativeCode || fn.NativeFailed) { return fn.NativeCode; }
+        if (++fn.CallCount < m_JitThreshold) { return nullptr; }
+
+        CompileNative(fn);
+        return fn.NativeCode;
+    }
+
+    void VM::CompileNative(VMFunction& fn) {
+        if (fn.NativeCode || fn.NativeFailed) { return; }
+
+        fn.NativeCode = m_Jit.Compile(m_Program, m_ProgramSize, m_CallTargets.data(), fn, fn.NativeCodeSize);
+        fn.NativeFailed = fn.NativeCode == nullptr;
+    }
+
+    void VM::RunFunction(VMFunction& fn) {
+        if (NativeFn native = GetNativeCode(fn)) {
+            native(this);
+            return;
+        }
+
+        RunInterpreted(fn);
+    }
+
+    void VM::RunInterpreted(VMFunction& fn) {
+        size_t pc = m_ProgramCounter;
+
+        // Without a return address the ret of the function ends the loop
+        m_StackFrames.back().PreviousReturnAddress = m_ReturnAddress;
+        m_StackFrames.back().PreviousFunction = m_ActiveFunction;
+        m_ReturnAddress = SIZE_MAX;
+
+        m_ProgramCounter = fn.Entry + 1;
+        m_ActiveFunction = &fn;
+        Run();
+
+        m_ProgramCounter = pc;
+    }
+
+    void VM::ArrayNew(const OpCodeArray& arr) {
+        Array* array = m_Arrays.Create(static_cast<int32_t>(arr.ElementSize));
+
+        Alloca(sizeof(Array*), arr.ResolvedType);
+        memcpy(GetVMSlice({ StackSlotRef(-1, sizeof(Array*)) }).Memory, &array, sizeof(Array*));
+    }
+
+    u8* VM::GetArrayElement(const OpCodeArray& arr) {
+        Array* array = GetArray(arr.Mem);
+        i32 index = GetInt(arr.IndexMem);
+
+        if (static_cast<u32>(index) >= static_cast<u32>(array->Size)) {
+            m_Context->ReportRuntimeError(fmt::format("Array index {} is out of bounds (length {})", index, array->Size));
+            return nullptr;
+        }
+
+        return array->Data + static_cast<size_t>(index) * arr.ElementSize;
+    }
+
+    Array* VM::GetArray(MemRef mem) {
+        Array* array = nullptr;
+        memcpy(&array, GetVMSlice(mem).Memory, sizeof(Array*));
+
+        return array;
+    }
+
+    void VM::LoadStr(size_t pc, TypeInfo* type) {
+        String* str = m_Literals[pc];
+
+        Alloca(sizeof(String*), type);
+        memcpy(GetVMSlice({ StackSlotRef(-1, sizeof(String*)) }).Memory, &str, sizeof(String*));
+    }
+
+    void VM::StringBinary(OpCodeType type, const OpCodeMath& math) {
+        String* lhs = GetString(math.LHSMem);
+        String* rhs = GetString(math.RHSMem);
+
+        if (type == OpCodeType::StrConcat) {
+            String* str = m_Strings.Concat(lhs, rhs);
+
+            Alloca(sizeof(String*), math.ResolvedType);
+            memcpy(GetVMSlice({ StackSlotRef(-1, sizeof(String*)) }).Memory, &str, sizeof(String*));
+            return;
+        }
+
+        std::string_view l = GetStringView(lhs);
+        std::string_view r = GetStringView(rhs);
+        bool result = false;
+
+        switch (type) {
+            case OpCodeType::StrCmp:  result = StringsEqual(l, r); break;
+            case OpCodeType::StrNcmp: result = !StringsEqual(l, r); break;
+            case OpCodeType::StrLt:   result = CompareStrings(l, r) < 0; break;
+            case OpCodeType::StrLte:  result = CompareStrings(l, r) <= 0; break;
+            case OpCodeType::StrGt:   result = CompareStrings(l, r) > 0; break;
+            case OpCodeType::StrGte:  result = CompareStrings(l, r) >= 0; break;
+            default: ARIA_UNREACHABLE();
+        }
+
+        Alloca(1, math.ResolvedType);
+        memcpy(GetVMSlice({ StackSlotRef(-1, 1) }).Memory, &result, 1);
+    }
+
+    void VM::StringLength(const OpCodeMath& math) {
+        i32 length = static_cast<i32>(GetStringView(GetString(math.LHSMem)).size());
+
+        Alloca(sizeof(i32), math.ResolvedType);
+        memcpy(GetVMSlice({ StackSlotRef(-1, sizeof(i32)) }).Memory, &length, sizeof(i32));
+    }
+
+    void VM::StringHash(const OpCodeMath& math) {
+        u64 hash = HashString(GetStringView(GetString(math.LHSMem)));
+
+        Alloca(sizeof(u64), math.ResolvedType);
+        memcpy(GetVMSlice({ StackSlotRef(-1, sizeof(u64)) }).Memory, &hash, sizeof(u64));
+    }
+
+    String* VM::GetString(MemRef mem) {
+        String* str = nullptr;
+        memcpy(&str, GetVMSlice(mem).Memory, sizeof(String*));
+
+        return str;
+    }
+
     void VM::StopExecution() {
         m_ProgramCounter = m_ProgramSize;
     }
 
-    void VM::RunPrepass() {
+    VMFunction* VM::ResolveLazyFunction(std::string signature) {
+        if (!m_LazyCompilationContext) { return nullptr; }
+
+        size_t start = m_ProgramSize;
+        if (!m_LazyCompilationContext->EmitFunction(signature)) { return nullptr; }
+
+        const std::vector<OpCode>& opcodes = m_LazyCompilationContext->GetOpCodes();
+        m_Program = opcodes.data();
+        m_ProgramSize = opcodes.size();
+
+        size_t pc = m_ProgramCounter;
+        RunPrepass(start);
+        m_ProgramCounter = pc;
+
+        auto it = m_Functions.find(signature);
+        return (it != m_Functions.end()) ? &it->second : nullptr;
+    }
+
+    void VM::RunPrepass(size_t start) {
+        if (start == 0) {
+            m_Functions.clear();
+            m_CallTargets.clear();
+            m_Jit.Reset(); // Nothing is running at this point, the native code of the old functions can go
+
+            #ifdef ARIA_FEEDBACK
+                m_Feedback.Clear();
+            #endif
+        }
+
+        #ifdef ARIA_FEEDBACK
+            m_Feedback.Resize(m_ProgramSize);
+        #endif
+
+        m_Literals.resize(m_ProgramSize);
+        m_CallTargets.resize(m_ProgramSize, nullptr);
+
+        m_ProgramCounter = start;
+
         for (; m_ProgramCounter < m_ProgramSize; m_ProgramCounter++) {
             const OpCode& op = m_Program[m_ProgramCounter];
 
+            // Every literal gets interned once, executing the load only pushes the handle
+            if (op.Type == OpCodeType::LoadStr) {
+                StringView literal = std::get<StringView>(std::get<OpCodeLoad>(op.Data).Data);
+                m_Literals[m_ProgramCounter] = m_Strings.Intern(std::string_view(literal.Data(), literal.Size()));
+            }
+
             if (op.Type == OpCodeType::Function) {
                 size_t startPc = m_ProgramCounter;
 
                 const std::string& ident = std::get<std::string>(op.Data);
                 VMFunction func;
+                func.Entry = startPc;
                 
                 for (; m_ProgramCounter < m_ProgramSize; m_ProgramCounter++) {
                     const OpCode& op = m_Program[m_ProgramCounter];
@@ -645,8 +1218,10 @@ namespace Aria::Internal {
                     if (op.Type == OpCodeType::Label) {
                         std::string label = std::get<std::string>(op.Data);
                         func.Labels[label] = m_ProgramCounter;
-                    } else if (op.Type == OpCodeType::Ret) {
-                        break;
+
+                        if (label == "_entry$") { func.Entry = m_ProgramCounter; }
+                    } else if (op.Type == OpCodeType::Function && m_ProgramCounter != startPc) {
+                        break; // Labels can follow an early return, so only the next function ends this one
                     }
                 }
 
@@ -655,6 +1230,18 @@ namespace Aria::Internal {
             }
         }
 
+        // Callees can come after their callers, so the calls only get resolved once every function is known
+        for (size_t pc = start; pc < m_ProgramSize; pc++) {
+            const OpCode& op = m_Program[pc];
+            if (op.Type != OpCodeType::Call && op.Type != OpCodeType::TailCall) { continue; }
+
+            const OpCodeCall& call = std::get<OpCodeCall>(op.Data);
+            if (!call.Function.ContainsFunction()) { continue; }
+
+            auto it = m_Functions.find(call.Function.GetFunction().Signature);
+            if (it != m_Functions.end()) { m_CallTargets[pc] = &it->second; }
+        }
+
         m_ProgramCounter = 0; // Reset the program counter so the normal execution happens from the start
     }
 
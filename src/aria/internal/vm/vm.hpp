@@ -1,10 +1,18 @@
 #pragma once
 
 #include "aria/internal/vm/op_codes.hpp"
+#include "aria/internal/vm/jit.hpp"
+#include "aria/internal/vm/native_module.hpp"
+#include "aria/internal/vm/feedback.hpp"
+#include "aria/internal/stdlib/array.hpp"
+#include "aria/internal/stdlib/string.hpp"
+#include "aria/internal/vm/heap.hpp"
 #include "aria/internal/compiler/types/type_info.hpp"
 
+#include <memory>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace Aria {
     struct Context;
@@ -32,6 +40,13 @@ namespace Aria::Internal {
     // A function that is not external, AKA implemented in the language itself
     struct VMFunction {
         std::unordered_map<std::string, size_t> Labels;
+        size_t Entry = 0; // The "_entry$" label, or the function op code itself if labels have been stripped
+
+        // Tiering, see VM::SetJitThreshold()
+        size_t CallCount = 0;
+        NativeFn NativeCode = nullptr;
+        size_t NativeCodeSize = 0;
+        bool NativeFailed = false; // The JIT can't compile the function, so it stays in the interpreter
     };
 
     class VM {
@@ -46,9 +61,48 @@ namespace Aria::Internal {
         void PushStackFrame();
         // Removes the current stack frame and goes back to the previous one (if there is one)
         void PopStackFrame();
+        // Frees the given slot of the current stack frame together with every slot above it
+        void Pop(i32 slot);
+        // Moves the arguments on top of the stack into the argument slots of the current stack frame and removes the frame
+        // The function jumped to afterwards returns straight to the caller of the current one
+        void ReplaceStackFrame(size_t argCount, size_t retCount);
 
         void AddExtern(const std::string& signature, ExternFn fn);
 
+        // Makes the next RunByteCode() call skip setting these globals, so they keep the value they had before it
+        // This is what lets a hot reloaded module hold on to its state
+        void PreserveGlobals(const std::vector<std::string>& globals);
+        // Copies the slot on top of the stack into the memory of the global, unless it is preserved
+        void SetGlobal(const std::string& name);
+        void RemoveGlobal(const std::string& name);
+
+        // Calls to functions missing from the byte code get them emitted by the given compilation context, nullptr turns that off
+        // The op codes passed to RunByteCode() must be the ones of this context
+        void SetLazyCompilationContext(CompilationContext* ctx);
+
+        // Script functions get compiled to native code once they have been called threshold times
+        // 0 compiles every function before it first runs, SIZE_MAX keeps everything in the interpreter
+        void SetJitThreshold(size_t threshold);
+        const std::unordered_map<std::string, VMFunction>& GetFunctions() const { return m_Functions; }
+
+        // nullptr if the VM was built without ARIA_FEEDBACK
+        const ExecutionFeedback* GetFeedback() const;
+
+        // Only takes effect while the VM hasn't created any arrays yet, see ArrayHeap::SetAllocator()
+        inline void SetArrayAllocator(const ArrayAllocator& allocator) { m_Arrays.SetAllocator(allocator); }
+        inline ArrayStats GetArrayStats() const { return m_Arrays.GetStats(); }
+
+        inline StringStats GetStringStats() const { return m_Strings.GetStats(); }
+        inline HeapStats GetHeapStats() const { return m_Heap->GetStats(); }
+        // How the host hands a string to the module, the characters get copied
+        inline String* CreateString(std::string_view str) { return m_Strings.Create(str); }
+
+        // Every array and string created until EndInvocationArena() comes from the arena of the script heap
+        void BeginInvocationArena();
+        // Copies what the persistent globals hold out of the arena, then resets it
+        void EndInvocationArena();
+        void PersistGlobal(const std::string& name, PersistentType type);
+
         void Call(int32_t label);
         void CallExtern(const std::string& signature, size_t argCount, size_t retCount);
         
@@ -73,6 +127,8 @@ namespace Aria::Internal {
         // Run an array of op codes in the VM, executing each operations one at a time
         void RunByteCode(const OpCode* data, size_t count);
         void Run();
+        // Runs a module loaded with Context::LoadNative(), which has no byte code at all, start is its "_start$()" function
+        void RunNative(NativeModuleFn start);
 
         VMSlice GetVMSlice(MemRef mem);
 
@@ -89,7 +145,56 @@ namespace Aria::Internal {
         //
         // loop.end:
         //     ...
-        void RunPrepass();
+        void RunPrepass(size_t start = 0);
+
+        // Every top level run starts out with an empty stack, whatever the previous one (or the host) left on it is gone
+        // The globals don't live on the stack, so they stay around
+        void ResetStack();
+
+        // Looks up a function that isn't part of m_Functions yet, emitting it if code generation is lazy
+        // Afterwards the function is in m_Functions so later calls don't come back here
+        VMFunction* ResolveLazyFunction(std::string signature);
+
+        // Uses the resolved target if there is one, otherwise looks the label up in the active function
+        size_t GetJumpTarget(const OpCodeConditionalJump& jump);
+
+        // What the ret op code does, goes back to the return address or stops if there is none
+        void Return();
+
+        // Finds a function, emitting it first if code generation is lazy
+        VMFunction* GetFunction(const std::string& signature);
+        // The callee of the call or tailcall at pc, only looked up by its signature the first time
+        VMFunction* GetCallTarget(size_t pc);
+        // Counts the call and compiles the function once it is hot, returns nullptr for as long as it has to be interpreted
+        NativeFn GetNativeCode(VMFunction& fn);
+        void CompileNative(VMFunction& fn);
+
+        // Runs a function to completion on behalf of native code, natively if possible and otherwise in a nested interpreter loop
+        void RunFunction(VMFunction& fn);
+        void RunInterpreted(VMFunction& fn);
+
+        // What the array op codes share between the interpreter and the JIT
+        void ArrayNew(const OpCodeArray& arr);
+        // Returns the element IndexMem refers to, or reports a runtime error and returns nullptr if the index is out of bounds
+        // A single unsigned compare covers both negative indices and ones past the end
+        u8* GetArrayElement(const OpCodeArray& arr);
+        Array* GetArray(MemRef mem);
+
+        // What the string op codes share between the interpreter and the JIT
+        // Pushes the literal the prepass interned for the loadstr at pc
+        void LoadStr(size_t pc, TypeInfo* type);
+        // strconcat and the string comparisons
+        void StringBinary(OpCodeType type, const OpCodeMath& math);
+        void StringLength(const OpCodeMath& math);
+        void StringHash(const OpCodeMath& math);
+        String* GetString(MemRef mem);
+
+        // Without ARIA_FEEDBACK these do nothing, pc is the index of the op code being executed
+        void RecordInvocation(const VMFunction& fn);
+        void RecordBranch(size_t pc, bool taken);
+        void RecordCall(size_t pc);
+
+        friend struct JitRuntime;
         
     private:
         // For local variables and temporaries
@@ -98,11 +203,18 @@ namespace Aria::Internal {
         std::vector<StackSlot> m_StackSlots;
         int32_t m_StackSlotPointer = 0;
 
-        // NOTE: Global variables point to stack memory!
-        // However specifically memory in the "_start$" function, which does not pop any stack frames
-        // Only when the "_exit$" function gets called does the stack frame get popped
-        // Note that _exit$ gets called when the VM gets destroyed
+        // Global variables have memory of their own, which outlives the stack of the run that declared them
+        // SetGlobal() copies the value "_start$" computed into it, StackSlot::Index is an offset into m_GlobalMemory
+        std::vector<u8> m_GlobalMemory;
         std::unordered_map<std::string, StackSlot> m_GlobalMap;
+        std::unordered_set<std::string> m_PreservedGlobals;
+        std::unordered_map<std::string, PersistentType> m_PersistentGlobals;
+
+        // The memory of every array and string, behind a pointer so the array and string heaps keep pointing at it when the VM gets moved
+        std::unique_ptr<ScriptHeap> m_Heap;
+        ArrayHeap m_Arrays; // Every array created by arraynew, moving the VM (hot reloading) keeps them alive
+        StringHeap m_Strings; // Every string, including the constant pool of literals
+        std::vector<String*> m_Literals; // Indexed by program counter, the interned literal of every loadstr
 
         struct StackFrame {
             size_t Offset = 0;
@@ -120,7 +232,16 @@ namespace Aria::Internal {
         size_t m_ProgramCounter = 0;
 
         std::unordered_map<std::string, VMFunction> m_Functions;
+        std::vector<VMFunction*> m_CallTargets; // Indexed by program counter, the callee of every call and tailcall once it is known
         std::unordered_map<std::string, ExternFn> m_ExternalFunctions;
+        CompilationContext* m_LazyCompilationContext = nullptr;
+
+        JitCompiler m_Jit;
+        size_t m_JitThreshold = 1000;
+
+        #ifdef ARIA_FEEDBACK
+            ExecutionFeedback m_Feedback;
+        #endif
 
         size_t m_ReturnAddress = SIZE_MAX;
         VMFunction* m_ActiveFunction = nullptr;
@@ -128,4 +249,30 @@ namespace Aria::Internal {
         Context* m_Context = nullptr;
     };
 
+    inline const ExecutionFeedback* VM::GetFeedback() const {
+        #ifdef ARIA_FEEDBACK
+            return &m_Feedback;
+        #else
+            return nullptr;
+        #endif
+    }
+
+    inline void VM::RecordInvocation([[maybe_unused]] const VMFunction& fn) {
+        #ifdef ARIA_FEEDBACK
+            m_Feedback.Invocations[fn.Entry]++;
+        #endif
+    }
+
+    inline void VM::RecordBranch([[maybe_unused]] size_t pc, [[maybe_unused]] bool taken) {
+        #ifdef ARIA_FEEDBACK
+            (taken ? m_Feedback.Taken : m_Feedback.NotTaken)[pc]++;
+        #endif
+    }
+
+    inline void VM::RecordCall([[maybe_unused]] size_t pc) {
+        #ifdef ARIA_FEEDBACK
+            m_Feedback.CallTargets[pc]++;
+        #endif
+    }
+
 } // namespace Aria::Internal
@@ -1,7 +1,44 @@
 #include "aria/context.hpp"
+#include "aria/internal/allocator.hpp"
 
 #include "catch2.hpp"
 
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+using RuntimeSetup = std::function<void(Aria::Context& ctx)>;
+using RuntimeCheck = std::function<void(Aria::Context& ctx, Aria::JitMode mode)>;
+
+// Compiles and runs source once for every JIT mode, with and without SSA optimization (inlining stays off so the functions stay around)
+// setup runs in between compiling and running, check once the run is done
+static void RunInEveryConfiguration(const char* module, const char* source, const RuntimeSetup& setup, const RuntimeCheck& check, std::initializer_list<Aria::JitMode> modes = { Aria::JitMode::Disabled, Aria::JitMode::Eager }) {
+    for (Aria::JitMode mode : modes) {
+        for (bool ssa : { false, true }) {
+            Aria::Context ctx = Aria::Context::Create();
+            ctx.SetSSAOptimization(ssa);
+            ctx.SetInlineBudget(0);
+            ctx.SetJitMode(mode);
+            ctx.CompileString(source, module);
+
+            if (setup) { setup(ctx); }
+
+            ctx.Run(module);
+            check(ctx, mode);
+        }
+    }
+}
+
+static void RunInEveryConfiguration(const char* module, const char* source, const RuntimeCheck& check) {
+    RunInEveryConfiguration(module, source, {}, check);
+}
+
 TEST_CASE("Runtime Variable Declaration") {
     Aria::Context ctx = Aria::Context::Create();
     ctx.CompileFile("tests/runtime/variable_declaration.bl", "Runtime Variable Declaration");
@@ -131,13 +168,986 @@ TEST_CASE("Runtime Structs") {
     // REQUIRE((ctx.GetFloat(-1) > 3.9999f && ctx.GetFloat(-1) < 4.0001f));
 }
 
+TEST_CASE("Runtime Scopes") {
+    // Every declaration of x shadows the one outside of it until its scope ends, r collects which x each statement saw
+    const char* source = "int x = 1; int Param(int x) { return x * 2; } int Shadow() { int r = x; int x = 2; r = r * 10 + x; { int x = 3; r = r * 10 + x; { int x = 4; r = r * 10 + x; } r = r * 10 + x; } r = r * 10 + x; for (int x = 5; x < 6; x += 1) { r = r * 10 + x; } { int x = 6; r = r * 10 + x; } return r * 10 + x; } int r1 = Shadow(); int r2 = Param(7); int r3 = x;";
+
+    RunInEveryConfiguration("Runtime Scopes", source, [](Aria::Context& ctx, Aria::JitMode) {
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 123432562);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetInt(-1) == 14);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetInt(-1) == 1); // None of the locals touched the global
+    });
+}
+
 TEST_CASE("Runtime Arrays") {
-    // Aria::Context ctx = Aria::Context::Create();
-    // ctx.CompileFile("tests/runtime/arrays.bl", "Runtime Arrays");
-    // fmt::print("{}\n", ctx.Disassemble("Runtime Arrays"));
-    // ctx.Run("Runtime Arrays");
-    // ctx.Call("main", "Runtime Arrays");
-    // 
-    // ctx.PushGlobal("result");
-    // REQUIRE(ctx.GetInt(-1) == 140);
+    const char* source = "int Main() { int[] arr; arr.Append(5); arr.Append(7); arr.Append(15); int[] other = arr; other[1] += 2; return arr[0] + arr[1] * arr[2]; } int Fill(int n) { int[] arr; arr.Reserve(n); for (int i = 0; i < n; i += 1) { arr.Append(i * 2); } arr[1] = 7; int s = 0; for (int i = 0; i < arr.Length(); i += 1) { s += arr[i]; } return s; } int result = Main(); int sum = Fill(10);";
+
+    RunInEveryConfiguration("Runtime Arrays", source, [&](Aria::Context& ctx, Aria::JitMode) {
+        // Every array operation is an op code of its own, none of them goes through an extern call
+        std::string disassembly = ctx.Disassemble("Runtime Arrays");
+        REQUIRE(disassembly.find("arrayappendi32") != std::string::npos);
+        REQUIRE(disassembly.find("arrayloadi32") != std::string::npos);
+        REQUIRE(disassembly.find("arraystorei32") != std::string::npos);
+        REQUIRE(disassembly.find("callextern") == std::string::npos);
+
+        ctx.PushGlobal("result");
+        REQUIRE(ctx.GetInt(-1) == 140); // Both variables refer to the same array
+        ctx.PushGlobal("sum");
+        REQUIRE(ctx.GetInt(-1) == 95);
+    });
+
+    static bool outOfBounds = false;
+
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.SetRuntimeErrorHandler([](const std::string& error) { outOfBounds = error.find("out of bounds") != std::string::npos; });
+    ctx.CompileString("int Get(int i) { int[] arr; arr.Append(1); return arr[i]; } int r = Get(3);", "Runtime Arrays Bounds");
+    ctx.Run("Runtime Arrays Bounds");
+    REQUIRE(outOfBounds);
+}
+
+TEST_CASE("Runtime Array Allocator") {
+    const char* source = "int Build(int n) { int[] arr; arr.Reserve(n); for (int i = 0; i < n; i += 1) { arr.Append(i); } return arr.Length(); } int Grow(int n) { int[] arr; for (int i = 0; i < n; i += 1) { arr.Append(i); } arr.Clear(); arr.Append(3); arr.ShrinkToFit(); return arr[0] + arr.Length(); } int Small() { int[] arr; arr.Append(1); arr.Append(2); return arr[1]; } int r1 = Build(1000); int r2 = Grow(1000); int r3 = Small();";
+
+    struct Counters {
+        size_t Allocations = 0;
+        size_t LiveBytes = 0;
+    };
+
+    Counters counters;
+
+    RunInEveryConfiguration("Runtime Array Allocator", source, [&](Aria::Context& ctx) {
+        counters = {};
+
+        Aria::ArrayAllocator allocator;
+        allocator.Allocate = [](size_t bytes, void* userData) -> void* {
+            Counters* c = reinterpret_cast<Counters*>(userData);
+            c->Allocations++;
+            c->LiveBytes += bytes;
+            return ::operator new(bytes);
+        };
+        allocator.Free = [](void* memory, size_t bytes, void* userData) {
+            reinterpret_cast<Counters*>(userData)->LiveBytes -= bytes;
+            ::operator delete(memory);
+        };
+        allocator.UserData = &counters;
+
+        ctx.SetArrayAllocator(allocator);
+    }, [&](Aria::Context& ctx, Aria::JitMode) {
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 1000);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetInt(-1) == 4);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetInt(-1) == 2);
+
+        // Reserving up front grows once, appending grows from the 10 inline ints up to 1280, shrinking moves the last element back inline
+        Aria::ArrayStats stats = ctx.GetArrayStats("Runtime Array Allocator");
+        REQUIRE(stats.GrowthFactor == 2);
+        REQUIRE(stats.InlineBytes == 40);
+        REQUIRE(stats.Arrays == 3);
+        REQUIRE(stats.InlineArrays == 2);
+        REQUIRE(stats.Allocations == 11);
+        REQUIRE(stats.Grows == 8);
+        REQUIRE(stats.Shrinks == 1);
+        REQUIRE(stats.Frees == 7);
+        REQUIRE(stats.BytesAllocated == 3 * 64 + 1000 * sizeof(int32_t));
+
+        REQUIRE(counters.Allocations == stats.Allocations);
+        REQUIRE(counters.LiveBytes == stats.BytesAllocated);
+        REQUIRE(ctx.GetHeapStats("Runtime Array Allocator").Objects == 0);
+
+        ctx.FreeModule("Runtime Array Allocator");
+        REQUIRE(counters.LiveBytes == 0);
+    });
+}
+
+TEST_CASE("Runtime Strings") {
+    const char* source = "string Build(int n) { string s; for (int i = 0; i < n; i += 1) { s += \"abcdefghij\"; } return s; } int Count(int n) { int c = 0; for (int i = 0; i < n; i += 1) { string lit = \"literal\"; c += lit.Length(); } return c; } string built = Build(100); string twice = Build(100); int length = built.Length(); string joined = \"Hello, \" + \"World\"; string other = \"Hello, \" + \"World\"; bool equal = joined == \"Hello, World\"; bool notEqual = joined != \"Hello, world\"; bool less = \"apple\" < \"banana\"; bool greater = built > joined; bool longEqual = built == twice; ulong hash = joined.Hash(); ulong otherHash = other.Hash(); ulong builtHash = built.Hash(); int count = Count(50);";
+
+    RunInEveryConfiguration("Runtime Strings", source, [&](Aria::Context& ctx, Aria::JitMode) {
+        std::string disassembly = ctx.Disassemble("Runtime Strings");
+        REQUIRE(disassembly.find("strconcat") != std::string::npos);
+        REQUIRE(disassembly.find("callextern") == std::string::npos);
+
+        ctx.PushGlobal("length");
+        REQUIRE(ctx.GetInt(-1) == 1000);
+        ctx.PushGlobal("joined");
+        REQUIRE(ctx.GetString(-1) == "Hello, World");
+        ctx.PushGlobal("equal");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("notEqual");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("less");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("greater");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("longEqual");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("hash");
+        ctx.PushGlobal("otherHash");
+        ctx.PushGlobal("builtHash");
+        REQUIRE(ctx.GetLong(-3) == ctx.GetLong(-2));
+        REQUIRE(ctx.GetLong(-3) != ctx.GetLong(-1));
+        ctx.PushGlobal("count");
+        REQUIRE(ctx.GetInt(-1) == 350);
+
+        ctx.PushString("pushed", "Runtime Strings");
+        REQUIRE(ctx.GetString(-1, "Runtime Strings") == "pushed");
+
+        // Loading a literal never creates a string, building one piece by piece appends in place between the geometric grows
+        Aria::StringStats stats = ctx.GetStringStats("Runtime Strings");
+        REQUIRE(stats.InlineBytes == 44);
+        REQUIRE(stats.GrowthFactor == 2);
+        REQUIRE(stats.Literals == 8);
+        REQUIRE(stats.Strings == 2 * 99 + 2 + 1);
+        REQUIRE(stats.InlineStrings == 2 * 3 + 2 + 1);
+        REQUIRE(stats.Buffers == 2 * 5);
+        REQUIRE(stats.InPlaceConcats == 2 * 91);
+    });
+}
+
+TEST_CASE("Runtime Script Heap") {
+    const char* source = "int Grow(int n) { int[] arr; for (int i = 0; i < n; i += 1) { arr.Append(i); } return arr.Length(); } int a = Grow(1000); int b = Grow(1000);";
+
+    RunInEveryConfiguration("Runtime Script Heap", source, [&](Aria::Context& ctx, Aria::JitMode) {
+        ctx.PushGlobal("b");
+        REQUIRE(ctx.GetInt(-1) == 1000);
+
+        // Each array grows from 80 up to 5120 bytes of elements, the last two blocks are too big for a size class
+        // The second array reuses every small block the first one left behind
+        Aria::HeapStats stats = ctx.GetHeapStats("Runtime Script Heap");
+        REQUIRE(stats.LargeObjectThreshold == 2048);
+        REQUIRE(stats.Chunks == 1);
+        REQUIRE(stats.Allocations == 2 * 8);
+        REQUIRE(stats.Frees == 2 * 6);
+        REQUIRE(stats.FreeListHits == 5);
+        REQUIRE(stats.Objects == 4);
+        REQUIRE(stats.LargeObjects == 2);
+        REQUIRE(stats.BytesInUse == 2 * 64 + 2 * 5120);
+        REQUIRE(stats.BytesReserved == stats.ChunkSize + 2 * 8192);
+
+        ctx.FreeModule("Runtime Script Heap");
+    });
+}
+
+TEST_CASE("Runtime Invocation Arena") {
+    const char* source = "string Build(int n) { string s; for (int i = 0; i < n; i += 1) { s += \"abcdefghij\"; } return s; } int[] Fill(int n) { int[] arr; for (int i = 0; i < n; i += 1) { arr.Append(i); } return arr; } string kept = Build(100); string scratch = Build(100); int[] values = Fill(1000); int[] temp = Fill(1000); int length = values.Length();";
+
+    std::string expected;
+    for (int i = 0; i < 100; i++) { expected += "abcdefghij"; }
+
+    RunInEveryConfiguration("Runtime Invocation Arena", source, [&](Aria::Context& ctx) {
+        ctx.SetInvocationArena(true);
+        ctx.PersistGlobal("kept", Aria::PersistentType::String, "Runtime Invocation Arena");
+        ctx.PersistGlobal("values", Aria::PersistentType::Array, "Runtime Invocation Arena");
+    }, [&](Aria::Context& ctx, Aria::JitMode) {
+        ctx.PushGlobal("length");
+        REQUIRE(ctx.GetInt(-1) == 1000);
+        ctx.PushGlobal("kept");
+        REQUIRE(ctx.GetString(-1) == expected);
+
+        // Only the copies of the persistent globals outlive the run, the small heap objects are the literal and the two copies
+        Aria::HeapStats stats = ctx.GetHeapStats("Runtime Invocation Arena");
+        REQUIRE(stats.ArenaResets == 1);
+        REQUIRE(stats.ArenaBytesInUse == 0);
+        REQUIRE(stats.PeakArenaBytesInUse > 2 * 4000);
+        REQUIRE(stats.PersistedObjects == 2);
+        REQUIRE(stats.LargeObjects == 1);
+        REQUIRE(stats.Objects == 5);
+
+        Aria::ArrayStats arrays = ctx.GetArrayStats("Runtime Invocation Arena");
+        REQUIRE(arrays.Arrays == 1);
+        REQUIRE(arrays.BytesAllocated == 64 + 4000);
+
+        // The second run reuses the arena chunks of the first one
+        size_t reserved = stats.ArenaBytesReserved;
+        ctx.Run("Runtime Invocation Arena");
+
+        stats = ctx.GetHeapStats("Runtime Invocation Arena");
+        REQUIRE(stats.ArenaResets == 2);
+        REQUIRE(stats.ArenaBytesReserved == reserved);
+        REQUIRE(stats.PersistedObjects == 4);
+        REQUIRE(ctx.GetArrayStats("Runtime Invocation Arena").Arrays == 2);
+
+        ctx.FreeModule("Runtime Invocation Arena");
+    });
+}
+
+TEST_CASE("Runtime Repeated Runs") {
+    // Every run declares the globals again, so each one has to start from an empty stack instead of piling up on top of the last
+    const char* source = "string Build(int n) { string s; for (int i = 0; i < n; i += 1) { s += \"ab\"; } return s; } int runs = 0; long total = 40; float scale = 1.5; string name = Build(4); int Next() { runs = runs + 1; return runs; } int last = Next();";
+
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.SetInvocationArena(true);
+    ctx.CompileString(source, "Runtime Repeated Runs");
+    ctx.PersistGlobal("name", Aria::PersistentType::String, "Runtime Repeated Runs");
+
+    for (int i = 0; i < 300000; i++) {
+        ctx.Run("Runtime Repeated Runs");
+    }
+
+    ctx.PushGlobal("last");
+    REQUIRE(ctx.GetInt(-1) == 1);
+    ctx.PushGlobal("total");
+    REQUIRE(ctx.GetLong(-1) == 40);
+    ctx.PushGlobal("name");
+    REQUIRE(ctx.GetString(-1) == "abababab");
+    REQUIRE(ctx.GetHeapStats("Runtime Repeated Runs").ArenaResets == 300000);
+
+    Aria::ModuleReloadReport report = ctx.ReloadModule("Runtime Repeated Runs", "int runs = 0; long total = 40; float scale = 1.5; int Next() { runs = runs + 2; return runs; } int last = Next();");
+    REQUIRE(report.Success);
+    REQUIRE(report.KeptGlobals == std::vector<std::string>{ "runs", "total", "scale", "last" });
+
+    // Kept globals skip their initializer on the first run of the reloaded module, then it is back to declaring them every run
+    ctx.Run("Runtime Repeated Runs");
+    ctx.PushGlobal("runs");
+    REQUIRE(ctx.GetInt(-1) == 3);
+    ctx.PushGlobal("last");
+    REQUIRE(ctx.GetInt(-1) == 1);
+
+    for (int i = 0; i < 300000; i++) {
+        ctx.Run("Runtime Repeated Runs");
+    }
+
+    ctx.PushGlobal("runs");
+    REQUIRE(ctx.GetInt(-1) == 2);
+    ctx.PushGlobal("scale");
+    REQUIRE(ctx.GetFloat(-1) == 1.5f);
+}
+
+TEST_CASE("Runtime Compile Modules") {
+    Aria::Context ctx = Aria::Context::Create();
+
+    std::vector<Aria::ModuleSource> modules = {
+        { "a", {}, "int a = 1;" },
+        { "b", {}, "int add(int lhs, int rhs) { return lhs + rhs; }" },
+        { "c", {}, "int c = 3;" },
+    };
+
+    std::vector<Aria::ModuleCompileResult> results = ctx.CompileModules(modules, 4);
+    REQUIRE(results.size() == 3);
+    for (const Aria::ModuleCompileResult& r : results) {
+        REQUIRE(r.Success);
+        REQUIRE(r.Errors.empty());
+    }
+
+    // A single broken module means none of the batch gets registered
+    std::vector<Aria::ModuleSource> broken = {
+        { "d", {}, "int d = 4;" },
+        { "e", {}, "int e = 5" },
+    };
+
+    results = ctx.CompileModules(broken, 4);
+    REQUIRE(results[0].Success);
+    REQUIRE(!results[1].Success);
+    REQUIRE(results[1].Errors.size() == 1);
+
+    REQUIRE(ctx.CompileModules({ { "d", {}, "int d = 4;" } }).at(0).Success);
+}
+
+TEST_CASE("Runtime Bytecode Image") {
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.CompileString("int g = 3; float f = 2.5; int add(int lhs, int rhs) { g = rhs; return lhs + rhs; } int r = add(4, 5); int count(int n) { int c = 0; while (c < n) { c += 1; } if (c == 3) { c += 1; } return c; } int k = count(3);", "Runtime Bytecode Image");
+
+    std::string path = (std::filesystem::temp_directory_path() / "runtime_bytecode_image.ariac").string();
+    REQUIRE(ctx.SaveImage("Runtime Bytecode Image", path));
+    REQUIRE(ctx.LoadImage(path, "Runtime Bytecode Image Loaded"));
+
+    REQUIRE(ctx.Disassemble("Runtime Bytecode Image") == ctx.Disassemble("Runtime Bytecode Image Loaded"));
+
+    for (const char* module : { "Runtime Bytecode Image", "Runtime Bytecode Image Loaded" }) {
+        ctx.Run(module);
+
+        ctx.PushGlobal("g", module);
+        REQUIRE(ctx.GetInt(-1, module) == 5);
+        ctx.PushGlobal("f", module);
+        REQUIRE(ctx.GetFloat(-1, module) == 2.5f);
+        ctx.PushGlobal("r", module);
+        REQUIRE(ctx.GetInt(-1, module) == 9);
+        ctx.PushGlobal("k", module);
+        REQUIRE(ctx.GetInt(-1, module) == 4);
+    }
+
+    ctx.FreeModule("Runtime Bytecode Image Loaded");
+
+    std::string image;
+    {
+        std::ifstream file(path, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Every corrupted image must be rejected instead of reaching the VM
+    std::string corruptPath = (std::filesystem::temp_directory_path() / "runtime_bytecode_image_corrupt.ariac").string();
+    auto loadCorrupted = [&](auto corrupt) {
+        std::string bytes = image;
+        corrupt(bytes);
+        std::ofstream(corruptPath, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+        return ctx.LoadImage(corruptPath, "Runtime Bytecode Image Corrupt");
+    };
+
+    auto writeU32 = [](std::string& bytes, size_t offset, uint32_t value) { memcpy(bytes.data() + offset, &value, sizeof(value)); };
+    auto readU32 = [](const std::string& bytes, size_t offset) { uint32_t value = 0; memcpy(&value, bytes.data() + offset, sizeof(value)); return value; };
+
+    // The header starts with the magic and the version, the code section offset follows the file size
+    uint64_t code = 0;
+    memcpy(&code, image.data() + 16, sizeof(code));
+    constexpr size_t instructionSize = 80;
+    REQUIRE(code + instructionSize <= image.size());
+
+    REQUIRE(!loadCorrupted([](std::string& bytes) { bytes.resize(bytes.size() / 2); }));
+    REQUIRE(!loadCorrupted([](std::string& bytes) { bytes.resize(8); }));
+    REQUIRE(!loadCorrupted([](std::string& bytes) { bytes[0] = 'X'; }));
+    REQUIRE(!loadCorrupted([&](std::string& bytes) { writeU32(bytes, 4, readU32(bytes, 4) + 1); }));
+
+    // Instructions start with their type, payload kind and two operands, followed by the type and debug string indices
+    REQUIRE(!loadCorrupted([&](std::string& bytes) { writeU32(bytes, code, 0xFFFF); }));
+    REQUIRE(!loadCorrupted([&](std::string& bytes) { writeU32(bytes, code + 4, 0xFFFF); }));
+    REQUIRE(!loadCorrupted([&](std::string& bytes) { writeU32(bytes, code + 4, (readU32(bytes, code + 4) + 1) % 12); }));
+    REQUIRE(!loadCorrupted([&](std::string& bytes) { writeU32(bytes, code + 20, 0xFFFF); }));
+
+    // The untouched image still loads
+    REQUIRE(loadCorrupted([](std::string&) {}));
+    ctx.FreeModule("Runtime Bytecode Image Corrupt");
+
+    std::filesystem::remove(corruptPath);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Runtime Compile Cache") {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "runtime_compile_cache";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    std::string scriptA = (dir / "a.aria").string();
+    std::string scriptB = (dir / "b.aria").string();
+    std::ofstream(scriptA) << "int a = 1; int add(int lhs, int rhs) { return lhs + rhs; }";
+    std::ofstream(scriptB) << "int b = 2;";
+
+    {
+        Aria::Context ctx = Aria::Context::Create();
+        ctx.EnableCompileCache((dir / "cache").string());
+        ctx.CompileFile(scriptA, "a");
+
+        Aria::CompileCacheStats stats = ctx.GetCompileCacheStats();
+        REQUIRE(stats.Misses == 1);
+        REQUIRE(stats.Hits == 0);
+        REQUIRE(stats.Writes == 1);
+    }
+
+    {
+        Aria::Context ctx = Aria::Context::Create();
+        ctx.EnableCompileCache((dir / "cache").string());
+        ctx.CompileFile(scriptA, "a");
+        ctx.Run("a");
+
+        Aria::CompileCacheStats stats = ctx.GetCompileCacheStats();
+        REQUIRE(stats.Misses == 0);
+        REQUIRE(stats.Hits == 1);
+    }
+
+    {
+        // A limit of a single byte means only the most recent image survives
+        Aria::Context ctx = Aria::Context::Create();
+        ctx.EnableCompileCache((dir / "cache").string(), 1);
+        ctx.CompileFile(scriptB, "b");
+
+        Aria::CompileCacheStats stats = ctx.GetCompileCacheStats();
+        REQUIRE(stats.Misses == 1);
+        REQUIRE(stats.Evictions == 1);
+        REQUIRE(std::distance(std::filesystem::directory_iterator(dir / "cache"), std::filesystem::directory_iterator()) == 1);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Runtime Compiler Memory") {
+    // Big enough that the compiler needs more than the 10MB a single fixed arena used to have
+    std::string source;
+    for (int i = 0; i < 8000; i++) {
+        source += "int F" + std::to_string(i) + "(int a) { int b = a * 2 + " + std::to_string(i) + "; if (b > 10) { b = b - 1; } return b; } ";
+    }
+    source += "int r = F7999(3);";
+
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.CompileString(source, "Runtime Compiler Memory");
+    ctx.Run("Runtime Compiler Memory");
+    ctx.PushGlobal("r");
+    REQUIRE(ctx.GetInt(-1) == 8004);
+
+    std::string stats = ctx.DumpCompilerMemoryStats("Runtime Compiler Memory");
+    for (const char* phase : { "Lex ", "Parse ", "Analyze ", "Emit ", "Total " }) {
+        REQUIRE(stats.find(phase) != std::string::npos);
+    }
+
+    size_t used = 0, wasted = 0, reserved = 0, chunks = 0;
+    int read = std::sscanf(stats.c_str() + stats.find("Total "), "Total used: %zu bytes, wasted: %zu bytes, reserved: %zu bytes, chunks: %zu", &used, &wasted, &reserved, &chunks);
+    REQUIRE(read == 4);
+    REQUIRE(used > 10 * 1024 * 1024);
+    REQUIRE(used + wasted <= reserved);
+    REQUIRE(chunks > 1);
+
+    // Rewinding to a marker hands the memory allocated since then back, leaving the allocator as it was
+    Aria::Allocator allocator;
+    REQUIRE(allocator.Allocate(100) != nullptr);
+    Aria::Allocator::Marker marker = allocator.GetMarker();
+    Aria::AllocatorStats before = allocator.GetStats();
+
+    void* afterMarker = allocator.Allocate(64);
+    {
+        Aria::AllocatorScope scope(&allocator);
+        void* block = nullptr;
+        for (int i = 0; i < 100; i++) { block = allocator.Allocate(64 * 1024); }
+
+        REQUIRE(block != nullptr);
+        REQUIRE(allocator.GetStats().ChunkCount > before.ChunkCount);
+    }
+    REQUIRE(allocator.GetStats().ChunkCount == before.ChunkCount);
+    REQUIRE(allocator.GetStats().BytesUsed == before.BytesUsed + 64);
+    REQUIRE(allocator.Allocate(8) == static_cast<uint8_t*>(afterMarker) + 64);
+
+    allocator.Rewind(marker);
+    Aria::AllocatorStats after = allocator.GetStats();
+    REQUIRE(after.BytesUsed == before.BytesUsed);
+    REQUIRE(after.BytesWasted == before.BytesWasted);
+    REQUIRE(after.BytesReserved == before.BytesReserved);
+    REQUIRE(after.ChunkCount == before.ChunkCount);
+    REQUIRE(after.AllocationCount == before.AllocationCount);
+    REQUIRE(allocator.Allocate(64) == afterMarker);
+}
+
+TEST_CASE("Runtime Hot Reload") {
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.CompileString("int counter = 5; int limit = 10; int removed = 1; int Bump() { counter = counter + 1; return counter; } int x = Bump();", "Runtime Hot Reload");
+    ctx.Run("Runtime Hot Reload");
+
+    ctx.PushGlobal("counter");
+    REQUIRE(ctx.GetInt(-1) == 6);
+
+    Aria::ModuleReloadReport broken = ctx.ReloadModule("Runtime Hot Reload", "int counter = 5");
+    REQUIRE(!broken.Success);
+    REQUIRE(!broken.Errors.empty());
+
+    Aria::ModuleReloadReport report = ctx.ReloadModule("Runtime Hot Reload",
+        "int counter = 100; float limit = 2.5; int added = 7; int Bump() { counter = counter + 2; return counter; } int x = Bump();");
+    REQUIRE(report.Success);
+    REQUIRE(report.ChangedFunctions == std::vector<std::string>{ "Bump()" });
+    REQUIRE(report.KeptGlobals == std::vector<std::string>{ "counter", "x" });
+    REQUIRE(report.ResetGlobals == std::vector<std::string>{ "limit" });
+    REQUIRE(report.AddedGlobals == std::vector<std::string>{ "added" });
+    REQUIRE(report.RemovedGlobals == std::vector<std::string>{ "removed" });
+
+    // The old byte code stays active until the next run
+    ctx.PushGlobal("counter");
+    REQUIRE(ctx.GetInt(-1) == 6);
+
+    ctx.Run("Runtime Hot Reload");
+
+    ctx.PushGlobal("counter");
+    REQUIRE(ctx.GetInt(-1) == 8);
+    ctx.PushGlobal("x");
+    REQUIRE(ctx.GetInt(-1) == 6);
+    ctx.PushGlobal("limit");
+    REQUIRE(ctx.GetFloat(-1) == 2.5f);
+    ctx.PushGlobal("added");
+    REQUIRE(ctx.GetInt(-1) == 7);
+}
+
+TEST_CASE("Runtime Hot Reload From A Thread") {
+    const char* module = "Runtime Hot Reload From A Thread";
+
+    // F0() to F15() each add their index and the offset, so r is 120 plus 16 times the offset
+    auto makeSource = [](int offset) {
+        std::string source;
+        std::string sum = "int r = 0";
+
+        for (int i = 0; i < 16; i++) {
+            source += "int F" + std::to_string(i) + "(int a) { return a + " + std::to_string(i + offset) + "; } ";
+            sum += " + F" + std::to_string(i) + "(0)";
+        }
+
+        return source + sum + ";";
+    };
+
+    // Only the functions that run get emitted, so the reloads diff against byte code the runs keep appending to
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.SetLazyCodeGen(true);
+    ctx.CompileString(makeSource(0), module);
+
+    std::atomic<bool> done = false;
+    std::atomic<bool> failed = false;
+
+    std::thread reloader([&]() {
+        for (int i = 1; !done; i++) {
+            if (!ctx.ReloadModule(module, makeSource(i % 2)).Success) { failed = true; }
+        }
+    });
+
+    for (int i = 0; i < 50; i++) {
+        ctx.Run(module);
+
+        // Modules coming and going on this thread must not disturb the reloads either
+        std::string other = "Runtime Hot Reload From A Thread " + std::to_string(i);
+        ctx.CompileString("int other = 1;", other);
+        ctx.FreeModule(other);
+    }
+
+    done = true;
+    reloader.join();
+    REQUIRE(!failed);
+
+    ctx.Run(module);
+    ctx.PushGlobal("r", module);
+    int32_t r = ctx.GetInt(-1, module);
+    REQUIRE((r == 120 || r == 136));
+}
+
+TEST_CASE("Runtime Lazy Code Generation") {
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.SetLazyCodeGen(true);
+    ctx.CompileString("int Used(int a) { return a + 1; } int Unused(int a) { return a * 2; } int r = Used(4);", "Runtime Lazy Code Generation");
+
+    REQUIRE(ctx.Disassemble("Runtime Lazy Code Generation").find(".function Used()") == std::string::npos);
+
+    ctx.Run("Runtime Lazy Code Generation");
+    ctx.PushGlobal("r");
+    REQUIRE(ctx.GetInt(-1) == 5);
+
+    std::string disassembly = ctx.Disassemble("Runtime Lazy Code Generation");
+    REQUIRE(disassembly.find(".function Used()") != std::string::npos);
+    REQUIRE(disassembly.find(".function Unused()") == std::string::npos);
+
+    // Running again goes through the already emitted function
+    ctx.Run("Runtime Lazy Code Generation");
+    ctx.PushGlobal("r");
+    REQUIRE(ctx.GetInt(-1) == 5);
+    REQUIRE(ctx.Disassemble("Runtime Lazy Code Generation") == disassembly);
+
+    // Bytecode images always contain every function
+    std::string path = (std::filesystem::temp_directory_path() / "runtime_lazy_code_generation.ariac").string();
+    REQUIRE(ctx.SaveImage("Runtime Lazy Code Generation", path));
+    REQUIRE(ctx.Disassemble("Runtime Lazy Code Generation").find(".function Unused()") != std::string::npos);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Runtime Dead Code Elimination") {
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.EnableDeadCodeElimination({ "Exported()", "r" });
+    ctx.CompileString("int used = 1; int unused = 2; int Helper(int a) { return a + used; } int Dead(int a) { return a; } int Exported(int a) { return a * 2; } int r = Helper(4);", "Runtime Dead Code Elimination");
+
+    std::string disassembly = ctx.Disassemble("Runtime Dead Code Elimination");
+    REQUIRE(disassembly.find(".function Dead()") == std::string::npos);
+    REQUIRE(disassembly.find(".function Helper()") != std::string::npos);
+    REQUIRE(disassembly.find(".function Exported()") != std::string::npos);
+    REQUIRE(disassembly.find("setglobal unused") == std::string::npos);
+    REQUIRE(disassembly.find("setglobal used") != std::string::npos);
+    REQUIRE(disassembly.find("_entry$") == std::string::npos);
+
+    REQUIRE(ctx.DumpCodeSizeStats("Runtime Dead Code Elimination").find("Functions  before: 4, after: 3") != std::string::npos);
+
+    ctx.Run("Runtime Dead Code Elimination");
+    ctx.PushGlobal("r");
+    REQUIRE(ctx.GetInt(-1) == 5);
+}
+
+TEST_CASE("Runtime Constant Folding") {
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.CompileString("int Get(int a) { int k = 6 * 7; int m = k; int n = 1; n = 2; return a + (k % 5 + m / 2) - n; } long l = 5; float f = (1.5 - 9.0) % 2.0; int r = Get(1);", "Runtime Constant Folding");
+
+    std::string disassembly = ctx.Disassemble("Runtime Constant Folding");
+    REQUIRE(disassembly.find("mul") == std::string::npos);
+    REQUIRE(disassembly.find("mod") == std::string::npos);
+    REQUIRE(disassembly.find("div") == std::string::npos);
+
+    ctx.Run("Runtime Constant Folding");
+    ctx.PushGlobal("r");
+    REQUIRE(ctx.GetInt(-1) == 22);
+    ctx.PushGlobal("l");
+    REQUIRE(ctx.GetLong(-1) == 5);
+    ctx.PushGlobal("f");
+    REQUIRE(ctx.GetFloat(-1) == 0.5f);
+}
+
+TEST_CASE("Runtime Negation") {
+    const char* folded = "int a = -7 % 3; int b = -7 / 2; float c = -2.5 * 2.0; long d = -(10 - 3);";
+    const char* runtime = "int Mod(int x) { return -x % 3; } int Half(int x) { return -x / 2; } float Scale(float x) { return -x * 2.0; } long Flip(long x) { return -(x - 3); } int a = Mod(7); int b = Half(7); float c = Scale(2.5); long d = Flip(10);";
+
+    for (bool ssa : { false, true }) {
+        Aria::Context ctx = Aria::Context::Create();
+        ctx.SetSSAOptimization(ssa);
+        ctx.CompileString(folded, "Folded");
+        ctx.CompileString(runtime, "Runtime");
+
+        std::string disassembly = ctx.Disassemble("Folded");
+        REQUIRE(disassembly.find("neg") == std::string::npos);
+        REQUIRE(disassembly.find("mod") == std::string::npos);
+        REQUIRE(disassembly.find("div") == std::string::npos);
+        REQUIRE(ctx.Disassemble("Runtime").find("neg") != std::string::npos);
+
+        ctx.Run("Folded");
+        ctx.Run("Runtime");
+
+        // Folding has to round the same way the VM does, both truncate towards zero
+        for (const char* module : { "Folded", "Runtime" }) {
+            ctx.PushGlobal("a", module);
+            REQUIRE(ctx.GetInt(-1, module) == -1);
+            ctx.PushGlobal("b", module);
+            REQUIRE(ctx.GetInt(-1, module) == -3);
+            ctx.PushGlobal("c", module);
+            REQUIRE(ctx.GetFloat(-1, module) == -5.0f);
+            ctx.PushGlobal("d", module);
+            REQUIRE(ctx.GetLong(-1, module) == -7);
+        }
+    }
+}
+
+TEST_CASE("Runtime SSA Optimization") {
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.SetSSAOptimization(true);
+    ctx.CompileString("int Max(int a, int b) { int m = a; if (a < b) { m = b; } return m; } int Twice(int a) { int x = a * 2; int y = a * 2; if (1 < 2) { return x + y; } else { return 0; } } int r1 = Max(3, 9); int r2 = Max(7, 2); int r3 = Twice(5);", "Runtime SSA Optimization");
+
+    std::string ir = ctx.DumpIR("Runtime SSA Optimization");
+    REQUIRE(ir.find("phi") != std::string::npos); // The two values of m merge after the if
+    REQUIRE(ir.find("mul") == ir.rfind("mul")); // a * 2 is only computed once
+    REQUIRE(ir.find("condbr") == ir.rfind("condbr")); // The constant condition got folded away
+
+    ctx.Run("Runtime SSA Optimization");
+    ctx.PushGlobal("r1");
+    REQUIRE(ctx.GetInt(-1) == 9);
+    ctx.PushGlobal("r2");
+    REQUIRE(ctx.GetInt(-1) == 7);
+    ctx.PushGlobal("r3");
+    REQUIRE(ctx.GetInt(-1) == 20);
+}
+
+TEST_CASE("Runtime Inlining") {
+    const char* source = "int Square(int x) { return x * x; } int Fact(int n) { if (n < 2) { return 1; } return n * Fact(n - 1); } int Abs(int x) { if (x < 0) { return 0 - x; } return x; } int r1 = Square(7); int r2 = Fact(5); int r3 = Abs(1 - 5) + Abs(Square(3));";
+
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.SetSSAOptimization(true);
+    ctx.SetInlineBudget(16);
+    ctx.CompileString(source, "Runtime Inlining");
+
+    std::string ir = ctx.DumpIR("Runtime Inlining");
+    REQUIRE(ir.find("call int Square()") == std::string::npos);
+    REQUIRE(ir.find("call int Abs()") == std::string::npos);
+    REQUIRE(ir.find("call int Fact()") != std::string::npos); // Recursive functions never get inlined
+
+    ctx.Run("Runtime Inlining");
+    ctx.PushGlobal("r1");
+    REQUIRE(ctx.GetInt(-1) == 49);
+    ctx.PushGlobal("r2");
+    REQUIRE(ctx.GetInt(-1) == 120);
+    ctx.PushGlobal("r3");
+    REQUIRE(ctx.GetInt(-1) == 13);
+
+    Aria::Context noInline = Aria::Context::Create();
+    noInline.SetSSAOptimization(true);
+    noInline.SetInlineBudget(0);
+    noInline.CompileString(source, "Runtime Inlining");
+    REQUIRE(noInline.DumpIR("Runtime Inlining").find("call int Square()") != std::string::npos);
+}
+
+TEST_CASE("Runtime Loops") {
+    const char* source = "int SumScaled(int n, int k) { int s = 0; int i = 0; while (i < n) { s += i * 3 + k * k; i += 1; } return s; } int Countdown(int n) { int c = 0; do { c += 1; n -= 1; } while (n > 0); return c; } int Triangle(int n) { int s = 0; for (int i = 0; i < n; i += 1) { for (int j = 0; j < i; j += 1) { s += 1; } } return s; } int r1 = SumScaled(10, 2); int r2 = Countdown(5); int r3 = Triangle(5); int r4 = SumScaled(0, 2);";
+
+    for (bool ssa : { false, true }) {
+        Aria::Context ctx = Aria::Context::Create();
+        ctx.SetSSAOptimization(ssa);
+        ctx.SetInlineBudget(0);
+        ctx.CompileString(source, "Runtime Loops");
+
+        if (ssa) {
+            std::string ir = ctx.DumpIR("Runtime Loops");
+
+            size_t mul = ir.find("mul");
+            REQUIRE(mul != std::string::npos);
+            REQUIRE(ir.find("mul", mul + 1) == std::string::npos); // i * 3 became an induction variable of its own
+
+            size_t terminator = ir.find("br", mul);
+            REQUIRE(ir[terminator - 1] == ' '); // k * k got hoisted into the preheader, which ends in a br instead of a condbr
+        }
+
+        ctx.Run("Runtime Loops");
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 175);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetInt(-1) == 5);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetInt(-1) == 10);
+        ctx.PushGlobal("r4");
+        REQUIRE(ctx.GetInt(-1) == 0);
+    }
+}
+
+TEST_CASE("Runtime Tail Calls") {
+    // Deep enough to run out of stack if every call kept its frame around
+    const char* source = "int Count(int n, int acc) { if (n == 0) { return acc; } return Count(n - 1, acc + 1); } int IsOdd(int n); int IsEven(int n) { if (n == 0) { return 1; } return IsOdd(n - 1); } int IsOdd(int n) { if (n == 0) { return 0; } return IsEven(n - 1); } int r1 = Count(1000000, 0); int r2 = IsEven(300001); int r3 = IsOdd(300001);";
+
+    for (bool ssa : { false, true }) {
+        Aria::Context ctx = Aria::Context::Create();
+        ctx.SetSSAOptimization(ssa);
+        ctx.CompileString(source, "Runtime Tail Calls");
+
+        std::string disassembly = ctx.Disassemble("Runtime Tail Calls");
+        REQUIRE(disassembly.find("tailcall fn(Count())") != std::string::npos);
+        REQUIRE(disassembly.find("tailcall fn(IsOdd())") != std::string::npos);
+        REQUIRE(disassembly.find("tailcall fn(IsEven())") != std::string::npos);
+
+        ctx.Run("Runtime Tail Calls");
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 1000000);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetInt(-1) == 0);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetInt(-1) == 1);
+    }
+}
+
+TEST_CASE("Runtime JIT") {
+    const char* source = "extern int Twice(int a); int Fib(int n) { if (n < 2) { return n; } return Fib(n - 1) + Fib(n - 2); } int Count(int n, int acc) { if (n == 0) { return acc; } return Count(n - 1, acc + 1); } float Scale(float d, int n) { float s = 0.0; for (int i = 0; i < n; i += 1) { s += d * 0.5; } return s; } int CallsExtern(int a) { return Twice(a) + 1; } int r1 = Fib(20); int r2 = Count(100000, 0); float r3 = Scale(3.0, 4); int r4 = CallsExtern(20);";
+
+    RunInEveryConfiguration("Runtime JIT", source, [&](Aria::Context& ctx) {
+        ctx.SetJitThreshold(10);
+        ctx.AddExternalFunction("Twice()", [](Aria::Context* ctx) {
+            ctx->StoreInt(-2, ctx->GetInt(-1) * 2);
+        }, "Runtime JIT");
+    }, [&](Aria::Context& ctx, Aria::JitMode mode) {
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 6765);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetInt(-1) == 100000);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetFloat(-1) == 6.0f);
+        ctx.PushGlobal("r4");
+        REQUIRE(ctx.GetInt(-1) == 41);
+
+        std::string stats = ctx.DumpJitStats("Runtime JIT");
+        if (!Aria::Context::IsJitAvailable() || mode == Aria::JitMode::Disabled) {
+            REQUIRE(stats.empty());
+            return;
+        }
+
+        // Only the functions called often enough get compiled in tiered mode, eager mode compiles all of them
+        bool eager = mode == Aria::JitMode::Eager;
+        REQUIRE(stats.find("Fib()") != std::string::npos);
+        REQUIRE(stats.find("Count()") != std::string::npos);
+        REQUIRE((stats.find("Scale()") != std::string::npos) == eager);
+        REQUIRE((stats.find("CallsExtern()") != std::string::npos) == eager);
+    }, { Aria::JitMode::Disabled, Aria::JitMode::Tiered, Aria::JitMode::Eager });
+}
+
+TEST_CASE("Runtime JIT Across Runs") {
+    const char* module = "Runtime JIT Across Runs";
+
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.SetInlineBudget(0);
+    ctx.SetJitMode(Aria::JitMode::Tiered);
+    ctx.SetJitThreshold(10);
+    ctx.CompileString("int Twice(int a) { return a + a; } int r = Twice(1) + Twice(2) + Twice(3) + Twice(4) + Twice(5) + Twice(6);", module);
+
+    // Six calls per run, so only the calls counted in the first run get Twice() past the threshold
+    ctx.Run(module);
+    REQUIRE(ctx.DumpJitStats(module).empty());
+
+    ctx.Run(module);
+    ctx.PushGlobal("r", module);
+    REQUIRE(ctx.GetInt(-1, module) == 42);
+    REQUIRE((ctx.DumpJitStats(module).find("Twice()") != std::string::npos) == Aria::Context::IsJitAvailable());
+
+    // Different byte code starts counting from scratch
+    REQUIRE(ctx.ReloadModule(module, "int Twice(int a) { return a * 2; } int r = Twice(1) + Twice(2) + Twice(3) + Twice(4) + Twice(5) + Twice(6);").Success);
+    ctx.Run(module);
+    ctx.PushGlobal("r", module);
+    REQUIRE(ctx.GetInt(-1, module) == 42);
+    REQUIRE(ctx.DumpJitStats(module).empty());
+}
+
+TEST_CASE("Runtime Feedback") {
+    const char* source = "int Fib(int n) { if (n < 2) { return n; } return Fib(n - 1) + Fib(n - 2); } int r1 = Fib(10);";
+
+    RunInEveryConfiguration("Runtime Feedback", source, [&](Aria::Context& ctx, Aria::JitMode) {
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 55);
+
+        std::string feedback = ctx.DumpFeedback("Runtime Feedback");
+        if (!Aria::Context::IsFeedbackAvailable()) {
+            REQUIRE(feedback.empty());
+            return;
+        }
+
+        REQUIRE(feedback.find("Fib()                    invocations: 177") != std::string::npos);
+        REQUIRE(feedback.find("_start$()                invocations: 1") != std::string::npos);
+
+        // Which way the branch goes depends on whether the condition got emitted as a jt or a jf
+        bool branch = feedback.find("taken: 89, not taken: 88") != std::string::npos ||
+                      feedback.find("taken: 88, not taken: 89") != std::string::npos;
+        REQUIRE(branch);
+
+        REQUIRE(feedback.find("Fib(): 1\n") != std::string::npos);
+        REQUIRE(feedback.find("Fib(): 88\n") != std::string::npos);
+
+        // The counts add up across runs of the same byte code
+        ctx.Run("Runtime Feedback");
+        feedback = ctx.DumpFeedback("Runtime Feedback");
+        REQUIRE(feedback.find("Fib()                    invocations: 354") != std::string::npos);
+        REQUIRE(feedback.find("_start$()                invocations: 2") != std::string::npos);
+    });
+}
+
+TEST_CASE("Runtime Immediate Operands") {
+    const char* source = "int g = 0; int Count(int n) { int c = 0; for (int i = 0; i < n; i += 1) { c += 2; } g = 7; return c; } float Half(float f) { return f * 0.5; } int Sub(int x) { return 10 - x; } int Triple(int x) { return 3 * x; } int r1 = Count(6); float r2 = Half(3.0); int r3 = Sub(4); int r4 = Triple(5);";
+
+    RunInEveryConfiguration("Runtime Immediate Operands", source, [&](Aria::Context& ctx, Aria::JitMode) {
+        std::string disassembly = ctx.Disassemble("Runtime Immediate Operands");
+        REQUIRE(disassembly.find("addimmi32") != std::string::npos);
+        REQUIRE(disassembly.find("mulimmi32") != std::string::npos); // 3 * x with the operands swapped
+        REQUIRE(disassembly.find("mulimmf32") != std::string::npos);
+        REQUIRE(disassembly.find("storeimmi32 g(g) 7") != std::string::npos);
+
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 12);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetFloat(-1) == 1.5f);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetInt(-1) == 6);
+        ctx.PushGlobal("r4");
+        REQUIRE(ctx.GetInt(-1) == 15);
+        ctx.PushGlobal("g");
+        REQUIRE(ctx.GetInt(-1) == 7);
+    });
+}
+
+TEST_CASE("Runtime Compare And Branch") {
+    const char* source = "int Count(int n) { int c = 0; for (int i = 0; i < n; i += 1) { if (3 < i) { c += 2; } } return c; } int Find(int n) { int i = 0; while (i != n) { i += 1; } return i; } float Halve(float f) { while (f > 1.0) { f = f * 0.5; } return f; } int r1 = Count(10); int r2 = Find(7); float r3 = Halve(12.0);";
+
+    RunInEveryConfiguration("Runtime Compare And Branch", source, [&](Aria::Context& ctx, Aria::JitMode) {
+        // The loop tests jump on their comparison directly, the if jumps over its body on the negated one
+        // No integer comparison gets materialized, only float ones under a jf do since negating them would get NaN wrong
+        std::string disassembly = ctx.Disassemble("Runtime Compare And Branch");
+        REQUIRE(disassembly.find("jlti32") != std::string::npos);
+        REQUIRE(disassembly.find("jlteimmi32") != std::string::npos);
+        REQUIRE(disassembly.find("jncmpi32") != std::string::npos);
+        REQUIRE(disassembly.find("jgtimmf32") != std::string::npos);
+        REQUIRE(disassembly.find(" lti32") == std::string::npos);
+        REQUIRE(disassembly.find(" gtimmi32") == std::string::npos);
+        REQUIRE(disassembly.find(" ncmpi32") == std::string::npos);
+
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 12);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetInt(-1) == 7);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetFloat(-1) == 0.75f);
+    });
+}
+
+TEST_CASE("Runtime Comparison Values") {
+    const char* source = "int Widened(int a) { return a < 4; } bool Less(int a) { return a < 4; } int Stored(long a) { bool equal = a == 5; if (equal) { return 1; } return 2; } int r1 = Widened(1); int r2 = Widened(9); bool r3 = Less(1); bool r4 = Less(9); int r5 = Stored(5); int r6 = Stored(6); long big = 5; bool r7 = big == 5; bool r8 = 2.5 < 1.0; float f = 1.5; bool r9 = f >= 1.5;";
+
+    RunInEveryConfiguration("Runtime Comparison Values", source, [&](Aria::Context& ctx, Aria::JitMode) {
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 1);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetInt(-1) == 0);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("r4");
+        REQUIRE(!ctx.GetBool(-1));
+        ctx.PushGlobal("r5");
+        REQUIRE(ctx.GetInt(-1) == 1);
+        ctx.PushGlobal("r6");
+        REQUIRE(ctx.GetInt(-1) == 2);
+        ctx.PushGlobal("r7");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("r8");
+        REQUIRE(!ctx.GetBool(-1));
+        ctx.PushGlobal("r9");
+        REQUIRE(ctx.GetBool(-1));
+    });
+}
+
+TEST_CASE("Runtime Implicit Casts") {
+    // The operand of the smaller type gets promoted to the other one, no matter which side it is on
+    const char* source = "int a = 9; short c = 5; float b = 2.0; double d = 0.5; long l = 300000; float Half(int x) { return x / 2.0; } long Wide(short s) { return s * 3; } float r1 = a + 2.5; float r2 = 2.5 + a; float r3 = 5 * b / c; float r4 = 7 / 2; float r5 = 7 / 2.0; long r6 = c * 100000; long r7 = l * a + c; double r8 = d + b; float r9 = Half(3); long r10 = Wide(c); bool r11 = 3 > 2.5; bool r12 = c < b; bool r13 = d < b; bool r14 = (a < b) == (c > 1);";
+
+    RunInEveryConfiguration("Runtime Implicit Casts", source, [&](Aria::Context& ctx, Aria::JitMode) {
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetFloat(-1) == 11.5f);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetFloat(-1) == 11.5f);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetFloat(-1) == 2.0f);
+        ctx.PushGlobal("r4");
+        REQUIRE(ctx.GetFloat(-1) == 3.0f); // Both operands are ints, so the division truncates before the result gets converted
+        ctx.PushGlobal("r5");
+        REQUIRE(ctx.GetFloat(-1) == 3.5f);
+        ctx.PushGlobal("r6");
+        REQUIRE(ctx.GetLong(-1) == 500000);
+        ctx.PushGlobal("r7");
+        REQUIRE(ctx.GetLong(-1) == 2700005);
+        ctx.PushGlobal("r8");
+        REQUIRE(ctx.GetDouble(-1) == 2.5);
+        ctx.PushGlobal("r9");
+        REQUIRE(ctx.GetFloat(-1) == 1.5f);
+        ctx.PushGlobal("r10");
+        REQUIRE(ctx.GetLong(-1) == 15);
+        ctx.PushGlobal("r11");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("r12");
+        REQUIRE(!ctx.GetBool(-1));
+        ctx.PushGlobal("r13");
+        REQUIRE(ctx.GetBool(-1));
+        ctx.PushGlobal("r14");
+        REQUIRE(!ctx.GetBool(-1));
+    });
+}
+
+TEST_CASE("Runtime Native Modules") {
+    const char* source = "extern int Twice(int a); int offset = 5; int Fib(int n) { if (n < 2) { return n; } return Fib(n - 1) + Fib(n - 2); } int Count(int n, int acc) { if (n == 0) { return acc; } return Count(n - 1, acc + 1); } float Half(float f) { return f * 0.5; } int Sum(int n) { int s = 0; for (int i = 0; i < n; i += 1) { s += i % 7; } return s; } int CallsExtern(int a) { return Twice(a) + offset; } int r1 = Fib(15); int r2 = Count(1000000, 0); float r3 = Half(3.0); int r4 = Sum(100); int r5 = CallsExtern(20);";
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "runtime_native_modules";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    std::string cPath = (dir / "module.c").string();
+    std::string libPath = (dir / "module.so").string();
+
+    Aria::Context ctx = Aria::Context::Create();
+    ctx.CompileString(source, "Runtime Native Modules");
+    REQUIRE(ctx.EmitC("Runtime Native Modules", cPath));
+
+    std::stringstream c;
+    c << std::ifstream(cPath).rdbuf();
+    REQUIRE(c.str().find("aria_native_functions") != std::string::npos);
+    REQUIRE(c.str().find("goto aria_entry;") != std::string::npos); // Count() calls itself in tail position
+
+    // Building the library needs a C compiler, without one only the translation gets checked
+    if (std::system("cc --version > /dev/null 2>&1") == 0) {
+        REQUIRE(std::system(("cc -O2 -shared -fPIC " + cPath + " -o " + libPath + " -lm").c_str()) == 0);
+
+        REQUIRE(ctx.LoadNative(libPath, "Runtime Native Modules Loaded"));
+        ctx.AddExternalFunction("Twice()", [](Aria::Context* ctx) {
+            ctx->StoreInt(-2, ctx->GetInt(-1) * 2);
+        }, "Runtime Native Modules Loaded");
+
+        ctx.Run("Runtime Native Modules Loaded");
+        ctx.PushGlobal("r1");
+        REQUIRE(ctx.GetInt(-1) == 610);
+        ctx.PushGlobal("r2");
+        REQUIRE(ctx.GetInt(-1) == 1000000);
+        ctx.PushGlobal("r3");
+        REQUIRE(ctx.GetFloat(-1) == 1.5f);
+        ctx.PushGlobal("r4");
+        REQUIRE(ctx.GetInt(-1) == 295);
+        ctx.PushGlobal("r5");
+        REQUIRE(ctx.GetInt(-1) == 45);
+
+        ctx.FreeModule("Runtime Native Modules Loaded");
+    }
+
+    std::filesystem::remove_all(dir);
 }